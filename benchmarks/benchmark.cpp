@@ -0,0 +1,355 @@
+/*!
+ * \file benchmarks/benchmark.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Minimal microbenchmark harness modelled on Google Benchmark
+ */
+#include <unistd.h>
+#include <time.h>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+#include "flame2/exceptions/all.hpp"
+#include "benchmark.hpp"
+
+namespace flame { namespace bench {
+
+//! Upper limit on the iterations of a run
+static const size_t kMaxIterations = 1000000000;
+
+//! Values passed to DoNotOptimize()
+static volatile double sink;
+
+//! \brief Returns wall clock time in nanoseconds
+static boost::int64_t WallTime() {
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0 && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<boost::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+  static const boost::posix_time::ptime epoch =
+      boost::posix_time::microsec_clock::universal_time();
+  return (boost::posix_time::microsec_clock::universal_time() - epoch)
+      .total_microseconds() * 1000;
+#endif
+}
+
+//! \brief Returns CPU time used by the process in seconds
+static double CPUTime() {
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+State::State(size_t max_iterations, const std::vector<long>& args)
+    : iterations_(0), max_iterations_(max_iterations), args_(args),
+      running_(false), real_start_(0), cpu_start_(0.0), real_time_(0.0),
+      cpu_time_(0.0), items_(0.0), bytes_(0.0) {}
+
+void State::StartTimer() {
+  running_ = true;
+  real_start_ = WallTime();
+  cpu_start_ = CPUTime();
+}
+
+void State::StopTimer() {
+  if (!running_) return;
+  running_ = false;
+  real_time_ += (WallTime() - real_start_) * 1e-9;
+  cpu_time_ += CPUTime() - cpu_start_;
+}
+
+//! \brief Stops the timer, e.g. while resetting data between iterations
+void State::PauseTiming() {
+  StopTimer();
+}
+
+//! \brief Restarts the timer after PauseTiming()
+void State::ResumeTiming() {
+  StartTimer();
+}
+
+/*!
+ * \brief Returns the value of an argument of the benchmark
+ *
+ * Throws flame::exceptions::out_of_range if the benchmark was not given
+ * that many arguments.
+ */
+long State::range(size_t index) const {
+  if (index >= args_.size()) {
+    throw flame::exceptions::out_of_range("benchmark argument not given");
+  }
+  return args_[index];
+}
+
+Benchmark::Benchmark(const std::string& name, Function func)
+    : name_(name), function_(func) {}
+
+//! \brief Adds a run with a single argument
+Benchmark* Benchmark::Arg(long a) {
+  arg_sets_.push_back(std::vector<long>(1, a));
+  return this;
+}
+
+//! \brief Adds a run with two arguments
+Benchmark* Benchmark::Args(long a, long b) {
+  std::vector<long> args;
+  args.push_back(a);
+  args.push_back(b);
+  arg_sets_.push_back(args);
+  return this;
+}
+
+//! Returns lo, multiples of 10 of lo below hi, and hi
+static std::vector<long> RangeValues(long lo, long hi) {
+  if (lo < 1 || hi < lo) {
+    throw flame::exceptions::invalid_argument("invalid benchmark range");
+  }
+  std::vector<long> values;
+  for (long v = lo; v < hi; v *= 10) values.push_back(v);
+  values.push_back(hi);
+  return values;
+}
+
+/*!
+ * \brief Adds runs with arguments from lo to hi in multiples of 10
+ *
+ * Throws flame::exceptions::invalid_argument if lo < 1 or hi < lo.
+ */
+Benchmark* Benchmark::Range(long lo, long hi) {
+  std::vector<long> values = RangeValues(lo, hi);
+  for (size_t i = 0; i < values.size(); ++i) Arg(values[i]);
+  return this;
+}
+
+/*!
+ * \brief Adds runs for every pair of arguments in two ranges
+ *
+ * Throws flame::exceptions::invalid_argument if a range is invalid.
+ */
+Benchmark* Benchmark::RangePair(long lo1, long hi1, long lo2, long hi2) {
+  std::vector<long> first = RangeValues(lo1, hi1);
+  std::vector<long> second = RangeValues(lo2, hi2);
+  for (size_t i = 0; i < first.size(); ++i) {
+    for (size_t j = 0; j < second.size(); ++j) Args(first[i], second[j]);
+  }
+  return this;
+}
+
+//! \brief Sets names of arguments shown in results
+Benchmark* Benchmark::ArgNames(const std::string& a, const std::string& b) {
+  arg_names_.clear();
+  arg_names_.push_back(a);
+  if (!b.empty()) arg_names_.push_back(b);
+  return this;
+}
+
+//! \brief Applies a function that adds arguments
+Benchmark* Benchmark::Apply(void (*apply)(Benchmark*)) {
+  apply(this);
+  return this;
+}
+
+//! \brief Returns the name of a run, e.g. BM_Sync/messages:1000/writers:4
+std::string Benchmark::GetRunName(const std::vector<long>& args) const {
+  std::string name = name_;
+  for (size_t i = 0; i < args.size(); ++i) {
+    name += "/";
+    if (i < arg_names_.size()) name += arg_names_[i] + ":";
+    name += boost::lexical_cast<std::string>(args[i]);
+  }
+  return name;
+}
+
+/*!
+ * \brief Prevents the compiler from discarding a computed value
+ *
+ * Defined out of line so the value must be computed before the call.
+ */
+void DoNotOptimize(double value) {
+  sink = value;
+}
+
+//! \brief Returns all registered benchmarks
+std::vector<Benchmark*>& GetBenchmarks() {
+  static std::vector<Benchmark*> benchmarks;
+  return benchmarks;
+}
+
+//! \brief Registers a benchmark function, see FLAME_BENCHMARK()
+Benchmark* RegisterBenchmark(const std::string& name, Function function) {
+  Benchmark* b = new Benchmark(name, function);
+  GetBenchmarks().push_back(b);
+  return b;
+}
+
+//! Formats a rate with a metric prefix, e.g. 12.5M
+static std::string FormatRate(double rate) {
+  const char* prefixes[] = {"", "k", "M", "G", "T"};
+  size_t p = 0;
+  while (rate >= 1000.0 && p < 4) {
+    rate /= 1000.0;
+    ++p;
+  }
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.4g%s", rate, prefixes[p]);
+  return buf;
+}
+
+//! Prints a result as a row of the results table
+static void PrintResult(const Result& r, std::ostream& out) {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%-52s %13.0f ns %13.0f ns %10lu",
+           r.name.c_str(), r.real_time, r.cpu_time,
+           static_cast<unsigned long>(r.iterations));
+  out << buf;
+  if (r.bytes_per_second > 0.0) {
+    out << " " << FormatRate(r.bytes_per_second) << "B/s";
+  }
+  if (r.items_per_second > 0.0) {
+    out << " " << FormatRate(r.items_per_second) << " items/s";
+  }
+  if (!r.label.empty()) out << " " << r.label;
+  out << std::endl;
+}
+
+/*!
+ * \brief Runs a benchmark with enough iterations to take min_time seconds
+ *
+ * Like Google Benchmark, runs are repeated with more iterations until one
+ * takes at least min_time, and only the last run is reported.
+ */
+static Result RunBenchmark(const Benchmark& b, const std::vector<long>& args,
+                           double min_time) {
+  size_t iterations = 1;
+  for (;;) {
+    State state(iterations, args);
+    b.function()(state);
+    if (state.real_time() >= min_time || iterations >= kMaxIterations) {
+      Result r;
+      r.name = b.GetRunName(args);
+      r.iterations = state.iterations();
+      r.real_time = state.real_time() * 1e9 / r.iterations;
+      r.cpu_time = state.cpu_time() * 1e9 / r.iterations;
+      r.items_per_second = (state.real_time() > 0.0) ?
+          state.items() / state.real_time() : 0.0;
+      r.bytes_per_second = (state.real_time() > 0.0) ?
+          state.bytes() / state.real_time() : 0.0;
+      r.label = state.label();
+      return r;
+    }
+
+    // aim past min_time so the next run is likely to be the last
+    double multiplier = 10.0;
+    if (state.real_time() > min_time / 10.0) {
+      multiplier = std::min(10.0, 1.4 * min_time / state.real_time());
+    }
+    size_t next = static_cast<size_t>(iterations * multiplier);
+    iterations = std::min(kMaxIterations, std::max(iterations + 1, next));
+  }
+}
+
+/*!
+ * \brief Runs registered benchmarks whose run names contain the filter
+ * \param[in] filter Text run names must contain, empty to run all
+ * \param[in] min_time Minimum seconds each benchmark run should take
+ * \param[in] out Stream results are printed to as they complete
+ *
+ * Benchmarks that throw are reported and skipped.
+ */
+std::vector<Result> RunBenchmarks(const std::string& filter,
+                                  double min_time, std::ostream& out) {
+  char header[256];
+  snprintf(header, sizeof(header), "%-52s %16s %16s %10s",
+           "Benchmark", "Time", "CPU", "Iterations");
+  out << header << std::endl
+      << std::string(std::string(header).size(), '-') << std::endl;
+
+  std::vector<Result> results;
+  std::vector<Benchmark*>& benchmarks = GetBenchmarks();
+  for (size_t i = 0; i < benchmarks.size(); ++i) {
+    const Benchmark& b = *benchmarks[i];
+    std::vector<std::vector<long> > arg_sets = b.arg_sets();
+    if (arg_sets.empty()) arg_sets.push_back(std::vector<long>());
+
+    for (size_t j = 0; j < arg_sets.size(); ++j) {
+      std::string name = b.GetRunName(arg_sets[j]);
+      if (name.find(filter) == std::string::npos) continue;
+      try {
+        results.push_back(RunBenchmark(b, arg_sets[j], min_time));
+        PrintResult(results.back(), out);
+      } catch(const std::exception& E) {
+        out << name << " failed: " << E.what() << std::endl;
+      }
+    }
+  }
+  return results;
+}
+
+//! Writes a string as a JSON string literal
+static void WriteJSONString(std::ostream& out, const std::string& s) {
+  out << '"';
+  for (std::string::const_iterator it = s.begin(); it != s.end(); ++it) {
+    if (*it == '"' || *it == '\\') out << '\\';
+    if (static_cast<unsigned char>(*it) >= 0x20) out << *it;
+  }
+  out << '"';
+}
+
+//! Returns the type of library build benchmarks were compiled against
+static const char* BuildType() {
+#if defined(PRODBUILD)
+  return "release";
+#elif defined(DBGBUILD)
+  return "debug";
+#else
+  return "test";
+#endif
+}
+
+/*!
+ * \brief Writes results in the JSON format of Google Benchmark
+ *
+ * Times are in nanoseconds per iteration, so results can be compared
+ * across runs with tools written for Google Benchmark output.
+ */
+void WriteJSON(const std::vector<Result>& results, std::ostream& out) {
+  std::streamsize precision = out.precision(10);
+  out << "{\n  \"context\": {\n"
+      << "    \"date\": \"" << boost::posix_time::to_iso_extended_string(
+          boost::posix_time::second_clock::local_time()) << "\",\n"
+      << "    \"num_cpus\": " << boost::thread::hardware_concurrency() << ",\n"
+      << "    \"library_build_type\": \"" << BuildType() << "\"\n"
+      << "  },\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    out << (i == 0 ? "\n" : ",\n") << "    {\n      \"name\": ";
+    WriteJSONString(out, r.name);
+    out << ",\n      \"iterations\": " << r.iterations
+        << ",\n      \"real_time\": " << r.real_time
+        << ",\n      \"cpu_time\": " << r.cpu_time
+        << ",\n      \"time_unit\": \"ns\"";
+    if (r.bytes_per_second > 0.0) {
+      out << ",\n      \"bytes_per_second\": " << r.bytes_per_second;
+    }
+    if (r.items_per_second > 0.0) {
+      out << ",\n      \"items_per_second\": " << r.items_per_second;
+    }
+    if (!r.label.empty()) {
+      out << ",\n      \"label\": ";
+      WriteJSONString(out, r.label);
+    }
+    out << "\n    }";
+  }
+  out << "\n  ]\n}\n";
+  out.precision(precision);
+}
+
+}}  // namespace flame::bench
@@ -0,0 +1,172 @@
+/*!
+ * \file benchmarks/benchmark.hpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Minimal microbenchmark harness modelled on Google Benchmark
+ */
+#ifndef BENCHMARKS__BENCHMARK_HPP_
+#define BENCHMARKS__BENCHMARK_HPP_
+#include <ostream>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace flame { namespace bench {
+
+/*!
+ * \brief Controls the timed loop of a benchmark run
+ *
+ * A benchmark function sets up its data, then repeats the code to measure
+ * while KeepRunning() returns true. Only the time spent within the loop is
+ * counted, less any time between PauseTiming() and ResumeTiming().
+ */
+class State {
+  public:
+    State(size_t max_iterations, const std::vector<long>& args);
+
+    //! \brief Returns true while more iterations should be run
+    bool KeepRunning() {
+      if (iterations_ == 0) StartTimer();
+      if (iterations_ < max_iterations_) {
+        ++iterations_;
+        return true;
+      }
+      StopTimer();
+      return false;
+    }
+
+    //! \brief Stops the timer, e.g. while resetting data between iterations
+    void PauseTiming();
+
+    //! \brief Restarts the timer after PauseTiming()
+    void ResumeTiming();
+
+    //! \brief Returns the value of an argument of the benchmark
+    long range(size_t index) const;
+
+    //! \brief Returns the number of iterations run
+    size_t iterations() const { return iterations_; }
+
+    //! \brief Sets the number of items processed in all iterations
+    void SetItemsProcessed(double items) { items_ = items; }
+
+    //! \brief Sets the number of bytes processed in all iterations
+    void SetBytesProcessed(double bytes) { bytes_ = bytes; }
+
+    //! \brief Sets a label shown with the results
+    void SetLabel(const std::string& label) { label_ = label; }
+
+    double real_time() const { return real_time_; }
+    double cpu_time() const { return cpu_time_; }
+    double items() const { return items_; }
+    double bytes() const { return bytes_; }
+    const std::string& label() const { return label_; }
+
+  private:
+    void StartTimer();
+    void StopTimer();
+
+    size_t iterations_;  //! Iterations started
+    size_t max_iterations_;  //! Iterations to run
+    std::vector<long> args_;  //! Arguments of the benchmark
+    bool running_;  //! Timer is running
+    boost::int64_t real_start_;  //! Wall clock time the timer was started
+    double cpu_start_;  //! CPU time the timer was started
+    double real_time_;  //! Seconds of wall clock time measured
+    double cpu_time_;  //! Seconds of CPU time measured
+    double items_;  //! Items processed
+    double bytes_;  //! Bytes processed
+    std::string label_;  //! Label shown with the results
+};
+
+//! Signature of benchmark functions
+typedef void (*Function)(State&);
+
+/*!
+ * \brief A benchmark function and the sets of arguments it is run with
+ *
+ * Arguments are added using chained calls on the object returned by
+ * FLAME_BENCHMARK(), e.g.
+ *
+ *   FLAME_BENCHMARK(BM_Post)->Arg(1000)->Arg(100000);
+ */
+class Benchmark {
+  public:
+    Benchmark(const std::string& name, Function func);
+
+    //! \brief Adds a run with a single argument
+    Benchmark* Arg(long a);
+
+    //! \brief Adds a run with two arguments
+    Benchmark* Args(long a, long b);
+
+    //! \brief Adds runs with arguments from lo to hi in multiples of 10
+    Benchmark* Range(long lo, long hi);
+
+    //! \brief Adds runs for every pair of arguments in two ranges
+    Benchmark* RangePair(long lo1, long hi1, long lo2, long hi2);
+
+    //! \brief Sets names of arguments shown in results
+    Benchmark* ArgNames(const std::string& a, const std::string& b = "");
+
+    //! \brief Applies a function that adds arguments
+    Benchmark* Apply(void (*apply)(Benchmark*));
+
+    const std::string& name() const { return name_; }
+    Function function() const { return function_; }
+    const std::vector<std::vector<long> >& arg_sets() const {
+      return arg_sets_;
+    }
+
+    //! \brief Returns the name of a run with the given arguments
+    std::string GetRunName(const std::vector<long>& args) const;
+
+  private:
+    std::string name_;  //! Name of the benchmark
+    Function function_;  //! Function that is run
+    std::vector<std::vector<long> > arg_sets_;  //! Arguments of each run
+    std::vector<std::string> arg_names_;  //! Names of arguments
+};
+
+//! Result of a benchmark run
+struct Result {
+  std::string name;  //! Benchmark name and arguments
+  size_t iterations;  //! Iterations run
+  double real_time;  //! Nanoseconds of wall clock time per iteration
+  double cpu_time;  //! Nanoseconds of CPU time per iteration
+  double items_per_second;  //! Items processed per second, 0 if not set
+  double bytes_per_second;  //! Bytes processed per second, 0 if not set
+  std::string label;  //! Label set by the benchmark
+};
+
+//! \brief Registers a benchmark function, see FLAME_BENCHMARK()
+Benchmark* RegisterBenchmark(const std::string& name, Function func);
+
+//! \brief Returns all registered benchmarks
+std::vector<Benchmark*>& GetBenchmarks();
+
+//! \brief Runs registered benchmarks whose run names contain the filter
+std::vector<Result> RunBenchmarks(const std::string& filter,
+                                  double min_time, std::ostream& out);
+
+//! \brief Writes results in the JSON format of Google Benchmark
+void WriteJSON(const std::vector<Result>& results, std::ostream& out);
+
+//! \brief Prevents the compiler from discarding a computed value
+void DoNotOptimize(double value);
+
+}}  // namespace flame::bench
+
+#define FLAME_BENCHMARK_CONCAT_(a, b) a ## b
+#define FLAME_BENCHMARK_NAME_(line) \
+  FLAME_BENCHMARK_CONCAT_(flame_benchmark_, line)
+
+//! Registers a benchmark function, arguments can be chained on the result
+#define FLAME_BENCHMARK(func) \
+  static ::flame::bench::Benchmark* FLAME_BENCHMARK_NAME_(__LINE__) = \
+      ::flame::bench::RegisterBenchmark(#func, &func)
+
+#endif  // BENCHMARKS__BENCHMARK_HPP_
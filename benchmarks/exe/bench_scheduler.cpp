@@ -0,0 +1,129 @@
+/*!
+ * \file benchmarks/exe/bench_scheduler.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Benchmarks of task bookkeeping and task queue throughput
+ */
+#include <string>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+#include "flame2/mem/memory_manager.hpp"
+#include "flame2/exe/task_manager.hpp"
+#include "flame2/exe/fifo_task_queue.hpp"
+#include "flame2/exe/splitting_fifo_task_queue.hpp"
+#include "flame2/exe/scheduler.hpp"
+#include "flame2/api/flame2.hpp"
+#include "../benchmark.hpp"
+
+namespace exe = flame::exe;
+namespace mem = flame::mem;
+namespace bench = flame::bench;
+
+//! Number of layers of tasks in the benchmark task graph
+static const size_t kLayers = 8;
+//! Number of tasks in each layer of the benchmark task graph
+static const size_t kWidth = 8;
+
+FLAME_AGENT_FUNCTION(bench_read_x) {
+  double x = FLAME.GetMem<double>("x_dbl");
+  return (x < 0.0) ? FLAME_AGENT_DEAD : FLAME_AGENT_ALIVE;
+}
+
+/*!
+ * \brief Registers the task graph shared by all exe benchmarks
+ *
+ * There is only one task manager and it can only be reset in test builds,
+ * so the graph is registered once: kLayers layers of kWidth agent tasks,
+ * each depending on every task of the layer before.
+ */
+static void InitTaskGraph() {
+  static bool initialised = false;
+  if (initialised) return;
+  initialised = true;
+
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mgr.RegisterAgent("Bench");
+  mgr.RegisterAgentVar<double>("Bench", "x_dbl");
+
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  for (size_t layer = 0; layer < kLayers; ++layer) {
+    for (size_t i = 0; i < kWidth; ++i) {
+      std::string name = "t" + boost::lexical_cast<std::string>(layer) +
+                         "_" + boost::lexical_cast<std::string>(i);
+      tm.CreateAgentTask(name, "Bench", &bench_read_x).AllowAccess("x_dbl");
+      if (layer == 0) continue;
+      for (size_t j = 0; j < kWidth; ++j) {
+        tm.AddDependency(name, "t" + boost::lexical_cast<std::string>(
+            layer - 1) + "_" + boost::lexical_cast<std::string>(j));
+      }
+    }
+  }
+  tm.Finalise();
+}
+
+//! Sets the population of the agent the benchmark tasks run on
+static void SetPopulation(size_t population) {
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mgr.GetVector<double>("Bench", "x_dbl")->assign(population, 1.0);
+}
+
+//! Pops and completes every task of an iteration without running them
+static void BM_TaskManagerIterTaskDone(bench::State& state) {
+  InitTaskGraph();
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    tm.IterReset();
+    state.ResumeTiming();
+    while (!tm.IterCompleted()) {
+      tm.IterTaskDone(tm.IterTaskPop());
+    }
+  }
+  state.SetItemsProcessed(static_cast<double>(state.iterations()) *
+                          tm.GetTaskCount());
+}
+FLAME_BENCHMARK(BM_TaskManagerIterTaskDone);
+
+//! Runs iterations of the task graph on a queue of the given type
+template <typename QueueType>
+static void QueueThroughput(bench::State& state, bool splittable) {
+  size_t population = state.range(0);
+  size_t threads = state.range(1);
+  InitTaskGraph();
+  SetPopulation(population);
+
+  exe::Scheduler s;
+  exe::Scheduler::QueueId q = s.CreateQueue<QueueType>(threads);
+  s.AssignType(q, exe::Task::AGENT_FUNCTION);
+  if (splittable) s.SetSplittable(exe::Task::AGENT_FUNCTION);
+  while (state.KeepRunning()) {
+    s.RunIteration();
+  }
+
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  state.SetItemsProcessed(static_cast<double>(state.iterations()) *
+                          tm.GetTaskCount() * population);
+}
+
+//! Runs queues with 1, 2, 4 and 8 threads for each population size
+static void QueueArgs(bench::Benchmark* b) {
+  b->ArgNames("agents", "threads");
+  for (long agents = 1000; agents <= 100000; agents *= 10) {
+    for (long threads = 1; threads <= 8; threads *= 2) {
+      b->Args(agents, threads);
+    }
+  }
+}
+
+static void BM_FIFOTaskQueue(bench::State& state) {
+  QueueThroughput<exe::FIFOTaskQueue>(state, false);
+}
+FLAME_BENCHMARK(BM_FIFOTaskQueue)->Apply(QueueArgs);
+
+static void BM_SplittingFIFOTaskQueue(bench::State& state) {
+  QueueThroughput<exe::SplittingFIFOTaskQueue>(state, true);
+}
+FLAME_BENCHMARK(BM_SplittingFIFOTaskQueue)->Apply(QueueArgs);
@@ -0,0 +1,307 @@
+#!/bin/bash
+# $Id$
+# ===========================================================================
+#
+# Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+# Author: Shawn Chin
+# Date  : Oct 2012
+#
+# File  : generate_model.sh
+# Desc  : Generates a synthetic model for benchmarking: the model
+#         definition, its agent functions and an initial population.
+#
+#         Every agent type has a chain of functions that alternate between
+#         posting and reading messages. Agent types that share a message
+#         type read each other's messages, as they would in a real model.
+#
+# ===========================================================================
+
+###--- Parameters -----------------------------------------------------------
+
+# Exit codes
+SUCCESS=0
+ERR_USAGE=1
+PROG_NAME=`basename $0`
+
+# Defaults
+NUM_AGENTS=2       # agent types
+NUM_FUNCTIONS=4    # functions per agent type
+NUM_MESSAGES=2     # message types
+POPULATION=1000    # agents per agent type
+FANOUT=1           # messages posted per agent by each posting function
+READS=0            # messages read per agent by each reading function, 0: all
+
+###--- Functions ------------------------------------------------------------
+
+print_usage() {
+  cat << EOF
+Usage: $PROG_NAME [OPTIONS] OUTPUT_DIR
+
+Writes model.xml, functions.cpp and 0.xml to OUTPUT_DIR.
+
+Options:
+  -a NUM   Number of agent types (default: $NUM_AGENTS)
+  -f NUM   Number of functions per agent type (default: $NUM_FUNCTIONS)
+  -m NUM   Number of message types (default: $NUM_MESSAGES)
+  -p NUM   Population of each agent type (default: $POPULATION)
+  -o NUM   Messages posted per agent by each posting function (default: $FANOUT)
+  -r NUM   Messages read per agent by each reading function, 0 for all
+           (default: $READS)
+  -h       Print this help
+EOF
+}
+
+die() {
+  echo "$PROG_NAME: $1" >&2
+  exit $ERR_USAGE
+}
+
+# check_number NAME VALUE MIN
+check_number() {
+  case "$2" in
+    ''|*[!0-9]*) die "$1 must be a number" ;;
+  esac
+  if [ "$2" -lt "$3" ]; then die "$1 must be >= $3"; fi
+}
+
+# state_name AGENT FUNCTION: current state of a function in the chain
+state_name() {
+  if [ "$2" -eq 0 ]; then echo "start"; else echo "s$2"; fi
+}
+
+# message_of AGENT FUNCTION: message posted or read by a function, if any.
+# Posting function 2j and reading function 2j+1 form pair j. Each message
+# type belongs to a single pair, otherwise the reads of a pair would depend
+# on posts of a later pair and the task graph would have cycles. Agent types
+# of a pair with several message types are spread across them, pairs with
+# no message type only update agent memory.
+message_of() {
+  local pairs=$(( (NUM_FUNCTIONS + 1) / 2 )) pair=$(( $2 / 2 ))
+  if [ $pair -ge $NUM_MESSAGES ]; then return; fi
+  local count=$(( (NUM_MESSAGES - 1 - pair) / pairs + 1 ))
+  echo "msg$(( pair + pairs * ($1 % count) ))"
+}
+
+write_model() {
+  cat << EOF
+<xmodel version="2">
+<name>Synthetic</name>
+<version>01</version>
+<description>Generated by $PROG_NAME -a $NUM_AGENTS -f $NUM_FUNCTIONS -m $NUM_MESSAGES -p $POPULATION -o $FANOUT -r $READS</description>
+
+<environment>
+<functionFiles>
+  <file>functions.cpp</file>
+</functionFiles>
+</environment>
+
+<agents>
+EOF
+  for (( a = 0; a < NUM_AGENTS; a++ )); do
+    cat << EOF
+
+<xagent>
+<name>Agent$a</name>
+<description></description>
+<memory>
+  <variable><type>int</type><name>id</name><description></description></variable>
+  <variable><type>double</type><name>x</name><description></description></variable>
+  <variable><type>double</type><name>value</name><description></description></variable>
+</memory>
+<functions>
+EOF
+    for (( f = 0; f < NUM_FUNCTIONS; f++ )); do
+      local current=`state_name $a $f`
+      local next="s$(( f + 1 ))"
+      if [ $(( f + 1 )) -eq $NUM_FUNCTIONS ]; then next="end"; fi
+      local msg=`message_of $a $f`
+      echo "<function><name>Agent${a}_f$f</name>"
+      echo "<description></description>"
+      echo "<currentState>$current</currentState>"
+      echo "<nextState>$next</nextState>"
+      echo "<memoryAccess>"
+      echo "<readOnly>"
+      echo "<variableName>id</variableName>"
+      echo "<variableName>x</variableName>"
+      if [ $(( f % 2 )) -eq 0 ]; then
+        echo "<variableName>value</variableName>"
+        echo "</readOnly>"
+        echo "<readWrite>"
+        echo "</readWrite>"
+        echo "</memoryAccess>"
+        if [ -n "$msg" ]; then
+          echo "<outputs>"
+          echo "  <output><messageName>$msg</messageName></output>"
+          echo "</outputs>"
+        fi
+      else
+        echo "</readOnly>"
+        echo "<readWrite>"
+        echo "<variableName>value</variableName>"
+        echo "</readWrite>"
+        echo "</memoryAccess>"
+        if [ -n "$msg" ]; then
+          echo "<inputs>"
+          echo "  <input><messageName>$msg</messageName></input>"
+          echo "</inputs>"
+        fi
+      fi
+      echo "</function>"
+      echo ""
+    done
+    echo "</functions>"
+    echo "</xagent>"
+  done
+  cat << EOF
+
+</agents>
+
+<messages>
+EOF
+  for (( m = 0; m < NUM_MESSAGES; m++ )); do
+    cat << EOF
+
+<message>
+<name>msg$m</name>
+<description></description>
+<variables>
+<variable><type>int</type><name>id</name><description></description></variable>
+<variable><type>double</type><name>x</name><description></description></variable>
+<variable><type>double</type><name>value</name><description></description></variable>
+</variables>
+</message>
+EOF
+  done
+  cat << EOF
+
+</messages>
+
+</xmodel>
+EOF
+}
+
+write_functions() {
+  cat << EOF
+/*!
+ * \\brief Agent functions of a synthetic benchmark model
+ *
+ * Generated by $PROG_NAME. Posting functions post $FANOUT message(s) per
+ * agent, reading functions read up to $READS message(s) per agent (0 for all).
+ */
+#include "flame_api.hpp"
+
+#define FANOUT $FANOUT
+#define READS $READS
+EOF
+  for (( a = 0; a < NUM_AGENTS; a++ )); do
+    for (( f = 0; f < NUM_FUNCTIONS; f++ )); do
+      local msg=`message_of $a $f`
+      if [ -z "$msg" ] && [ $(( f % 2 )) -eq 0 ]; then
+        cat << EOF
+
+FLAME_AGENT_FUNCTION(Agent${a}_f$f) {
+  double value = FLAME.GetMem<double>("value");
+  return (value < 0.0) ? FLAME_AGENT_DEAD : FLAME_AGENT_ALIVE;
+}
+EOF
+      elif [ -z "$msg" ]; then
+        cat << EOF
+
+FLAME_AGENT_FUNCTION(Agent${a}_f$f) {
+  double x = FLAME.GetMem<double>("x");
+  double value = FLAME.GetMem<double>("value");
+  FLAME.SetMem<double>("value", 0.5 * value + 1.0e-6 * x);
+  return FLAME_AGENT_ALIVE;
+}
+EOF
+      elif [ $(( f % 2 )) -eq 0 ]; then
+        cat << EOF
+
+FLAME_AGENT_FUNCTION(Agent${a}_f$f) {
+  ${msg}_message_t msg;
+  msg.id = FLAME.GetMem<int>("id");
+  msg.x = FLAME.GetMem<double>("x");
+  msg.value = FLAME.GetMem<double>("value");
+  for (int i = 0; i < FANOUT; ++i) {
+    FLAME.PostMessage<${msg}_message_t>("$msg", msg);
+  }
+  return FLAME_AGENT_ALIVE;
+}
+EOF
+      else
+        cat << EOF
+
+FLAME_AGENT_FUNCTION(Agent${a}_f$f) {
+  int id = FLAME.GetMem<int>("id");
+  double x = FLAME.GetMem<double>("x");
+  double sum = 0.0;
+  int count = 0;
+  MessageIterator iter = FLAME.GetMessageIterator("$msg");
+  for (; !iter.AtEnd() && (READS == 0 || count < READS); iter.Next()) {
+    ${msg}_message_t msg = iter.GetMessage<${msg}_message_t>();
+    if (msg.id != id) sum += msg.value * (msg.x - x);
+    ++count;
+  }
+  double value = FLAME.GetMem<double>("value");
+  FLAME.SetMem<double>("value", 0.5 * value + 1.0e-6 * sum);
+  return FLAME_AGENT_ALIVE;
+}
+EOF
+      fi
+    done
+  done
+}
+
+write_population() {
+  awk -v agents=$NUM_AGENTS -v population=$POPULATION 'BEGIN {
+    print "<states>"
+    print "<itno>0</itno>"
+    id = 0
+    for (a = 0; a < agents; a++) {
+      for (i = 0; i < population; i++) {
+        printf "<xagent>\n<name>Agent%d</name>\n", a
+        printf "  <id>%d</id>\n  <x>%.6f</x>\n  <value>%.6f</value>\n",
+               id, i / population, (id % 100) / 100.0
+        print "</xagent>"
+        ++id
+      }
+    }
+    print "</states>"
+  }'
+}
+
+###--- Main -----------------------------------------------------------------
+
+while getopts "a:f:m:p:o:r:h" opt; do
+  case $opt in
+    a) NUM_AGENTS=$OPTARG ;;
+    f) NUM_FUNCTIONS=$OPTARG ;;
+    m) NUM_MESSAGES=$OPTARG ;;
+    p) POPULATION=$OPTARG ;;
+    o) FANOUT=$OPTARG ;;
+    r) READS=$OPTARG ;;
+    h) print_usage; exit $SUCCESS ;;
+    *) print_usage >&2; exit $ERR_USAGE ;;
+  esac
+done
+shift $(( OPTIND - 1 ))
+
+if [ $# -ne 1 ]; then
+  print_usage >&2
+  exit $ERR_USAGE
+fi
+OUTPUT_DIR=$1
+
+check_number "number of agent types" "$NUM_AGENTS" 1
+check_number "number of functions" "$NUM_FUNCTIONS" 1
+check_number "number of message types" "$NUM_MESSAGES" 1
+check_number "population" "$POPULATION" 1
+check_number "fan-out" "$FANOUT" 0
+check_number "reads" "$READS" 0
+
+mkdir -p "$OUTPUT_DIR" || die "could not create $OUTPUT_DIR"
+write_model > "$OUTPUT_DIR/model.xml"
+write_functions > "$OUTPUT_DIR/functions.cpp"
+write_population > "$OUTPUT_DIR/0.xml"
+
+exit $SUCCESS
@@ -0,0 +1,105 @@
+/*!
+ * \file benchmarks/mb/bench_message_board.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Benchmarks of posting, syncing and reading messages
+ */
+#include <ostream>
+#include <boost/scoped_ptr.hpp>
+#include "flame2/mb/message_board.hpp"
+#include "../benchmark.hpp"
+
+namespace mb = flame::mb;
+namespace bench = flame::bench;
+
+typedef boost::scoped_ptr<mb::MessageBoard> board_ptr_type;
+
+//! Message of a typical size
+struct location_message {
+  double x, y, z;
+  int id;
+};
+
+//! Message boards require messages to be printable
+std::ostream& operator<<(std::ostream& os, const location_message& msg) {
+  return os << "(" << msg.x << ", " << msg.y << ", " << msg.z << ", "
+            << msg.id << ")";
+}
+
+//! Returns a message with values derived from i
+static location_message MakeMessage(long i) {
+  location_message msg;
+  msg.x = i * 1.0;
+  msg.y = i * 2.0;
+  msg.z = i * 3.0;
+  msg.id = static_cast<int>(i);
+  return msg;
+}
+
+//! Posts messages to a single board writer
+static void BM_BoardWriterPost(bench::State& state) {
+  long count = state.range(0);
+  board_ptr_type board(mb::MessageBoard::create<location_message>("loc"));
+  location_message msg = MakeMessage(1);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    board->Clear();
+    mb::MessageBoard::writer writer = board->GetBoardWriter();
+    state.ResumeTiming();
+    for (long i = 0; i < count; ++i) writer->Post<location_message>(msg);
+  }
+  state.SetItemsProcessed(static_cast<double>(state.iterations()) * count);
+  state.SetBytesProcessed(static_cast<double>(state.iterations()) * count *
+                          sizeof(location_message));
+}
+FLAME_BENCHMARK(BM_BoardWriterPost)->Range(1000, 1000000);
+
+//! Syncs messages posted to a number of board writers, as posted by
+//! worker threads running split agent tasks
+static void BM_MessageBoardSync(bench::State& state) {
+  long count = state.range(0);
+  long writers = state.range(1);
+  board_ptr_type board(mb::MessageBoard::create<location_message>("loc"));
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    board->Clear();
+    for (long w = 0; w < writers; ++w) {
+      mb::MessageBoard::writer writer = board->GetBoardWriter();
+      for (long i = w; i < count; i += writers) {
+        writer->Post<location_message>(MakeMessage(i));
+      }
+    }
+    state.ResumeTiming();
+    board->Sync();
+  }
+  state.SetItemsProcessed(static_cast<double>(state.iterations()) * count);
+  state.SetBytesProcessed(static_cast<double>(state.iterations()) * count *
+                          sizeof(location_message));
+}
+FLAME_BENCHMARK(BM_MessageBoardSync)
+    ->RangePair(1000, 1000000, 1, 16)->ArgNames("messages", "writers");
+
+//! Reads all messages of a board through an iterator
+static void BM_MessageIteratorNextGet(bench::State& state) {
+  long count = state.range(0);
+  board_ptr_type board(mb::MessageBoard::create<location_message>("loc"));
+  mb::MessageBoard::writer writer = board->GetBoardWriter();
+  for (long i = 0; i < count; ++i) {
+    writer->Post<location_message>(MakeMessage(i));
+  }
+  board->Sync();
+
+  mb::MessageBoard::iterator iter = board->GetMessages();
+  double sum = 0.0;
+  while (state.KeepRunning()) {
+    for (iter->Rewind(); !iter->AtEnd(); iter->Next()) {
+      sum += iter->Get<location_message>().x;
+    }
+  }
+  bench::DoNotOptimize(sum);
+  state.SetItemsProcessed(static_cast<double>(state.iterations()) * count);
+}
+FLAME_BENCHMARK(BM_MessageIteratorNextGet)->Range(1000, 1000000);
@@ -0,0 +1,93 @@
+/*!
+ * \file benchmarks/mem/bench_memory_iterator.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Benchmarks of iterating through agent memory
+ */
+#include <string>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+#include "flame2/mem/memory_manager.hpp"
+#include "flame2/mem/memory_iterator.hpp"
+#include "../benchmark.hpp"
+
+namespace mem = flame::mem;
+namespace bench = flame::bench;
+
+//! Returns the shadow of an agent with the given population, registering
+//! the agent on first use. Managers can only be reset in test builds so
+//! each population size gets an agent of its own.
+static mem::AgentShadowPtr GetShadow(size_t population) {
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  std::string agent_name =
+      "Circle" + boost::lexical_cast<std::string>(population);
+  if (!mgr.IsRegisteredAgent(agent_name)) {
+    mgr.RegisterAgent(agent_name);
+    mgr.RegisterAgentVar<int>(agent_name, "x_int");
+    mgr.RegisterAgentVar<double>(agent_name, "y_dbl");
+    mgr.HintPopulationSize(agent_name, population);
+    std::vector<int>* x = mgr.GetVector<int>(agent_name, "x_int");
+    std::vector<double>* y = mgr.GetVector<double>(agent_name, "y_dbl");
+    for (size_t i = 0; i < population; ++i) {
+      x->push_back(static_cast<int>(i));
+      y->push_back(i * 0.5);
+    }
+  }
+  mem::AgentShadowPtr shadow = mgr.GetAgentShadow(agent_name);
+  shadow->AllowAccess("x_int");
+  shadow->AllowAccess("y_dbl");
+  return shadow;
+}
+
+//! Steps through all agents without accessing memory
+static void BM_MemoryIteratorStep(bench::State& state) {
+  size_t population = state.range(0);
+  mem::AgentShadowPtr shadow = GetShadow(population);
+  mem::MemoryIteratorPtr iter = shadow->GetMemoryIterator();
+  while (state.KeepRunning()) {
+    for (iter->Rewind(); !iter->AtEnd(); iter->Step()) {}
+  }
+  state.SetItemsProcessed(
+      static_cast<double>(state.iterations()) * population);
+}
+FLAME_BENCHMARK(BM_MemoryIteratorStep)->Range(1000, 1000000);
+
+//! Reads two variables of every agent using var ids
+static void BM_MemoryIteratorGetReadPtr(bench::State& state) {
+  size_t population = state.range(0);
+  mem::AgentShadowPtr shadow = GetShadow(population);
+  mem::MemoryIteratorPtr iter = shadow->GetMemoryIterator();
+  size_t x_id = iter->GetVarId("x_int");
+  size_t y_id = iter->GetVarId("y_dbl");
+  double sum = 0.0;
+  while (state.KeepRunning()) {
+    for (iter->Rewind(); !iter->AtEnd(); iter->Step()) {
+      sum += *iter->GetReadPtr<int>(x_id) + *iter->GetReadPtr<double>(y_id);
+    }
+  }
+  bench::DoNotOptimize(sum);
+  state.SetItemsProcessed(
+      static_cast<double>(state.iterations()) * population);
+}
+FLAME_BENCHMARK(BM_MemoryIteratorGetReadPtr)->Range(1000, 1000000);
+
+//! Reads two variables of every agent looking vars up by name
+static void BM_MemoryIteratorGetReadPtrByName(bench::State& state) {
+  size_t population = state.range(0);
+  mem::AgentShadowPtr shadow = GetShadow(population);
+  mem::MemoryIteratorPtr iter = shadow->GetMemoryIterator();
+  double sum = 0.0;
+  while (state.KeepRunning()) {
+    for (iter->Rewind(); !iter->AtEnd(); iter->Step()) {
+      sum += *iter->GetReadPtr<int>("x_int") +
+             *iter->GetReadPtr<double>("y_dbl");
+    }
+  }
+  bench::DoNotOptimize(sum);
+  state.SetItemsProcessed(
+      static_cast<double>(state.iterations()) * population);
+}
+FLAME_BENCHMARK(BM_MemoryIteratorGetReadPtrByName)->Range(1000, 1000000);
@@ -0,0 +1,89 @@
+/*!
+ * \file benchmarks/run_benchmarks.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Driver file for running all benchmarks
+ *
+ * Options follow those of Google Benchmark:
+ *   --benchmark_filter=TEXT    only run benchmarks whose names contain TEXT
+ *   --benchmark_min_time=SECS  minimum time of each run (default 0.5)
+ *   --benchmark_out=FILE       also write results to FILE as JSON
+ *   --benchmark_list_tests     list benchmark names and exit
+ */
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "benchmark.hpp"
+
+namespace bench = flame::bench;
+
+//! Returns true and sets value if arg is --name=value
+static bool ParseOption(const std::string& arg, const std::string& name,
+                        std::string* value) {
+  std::string prefix = "--" + name + "=";
+  if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+  *value = arg.substr(prefix.size());
+  return true;
+}
+
+static void PrintUsage(const char* exe) {
+  std::cerr << "Usage: " << exe << " [--benchmark_filter=TEXT]"
+            << " [--benchmark_min_time=SECS]" << std::endl
+            << "       [--benchmark_out=FILE] [--benchmark_list_tests]"
+            << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  std::string filter, out_file, value;
+  double min_time = 0.5;
+  bool list_only = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (ParseOption(arg, "benchmark_filter", &value)) {
+      filter = value;
+    } else if (ParseOption(arg, "benchmark_min_time", &value)) {
+      min_time = std::atof(value.c_str());
+    } else if (ParseOption(arg, "benchmark_out", &value)) {
+      out_file = value;
+    } else if (arg == "--benchmark_list_tests") {
+      list_only = true;
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (list_only) {
+    std::vector<bench::Benchmark*>& benchmarks = bench::GetBenchmarks();
+    for (size_t i = 0; i < benchmarks.size(); ++i) {
+      std::vector<std::vector<long> > arg_sets = benchmarks[i]->arg_sets();
+      if (arg_sets.empty()) arg_sets.push_back(std::vector<long>());
+      for (size_t j = 0; j < arg_sets.size(); ++j) {
+        std::string name = benchmarks[i]->GetRunName(arg_sets[j]);
+        if (name.find(filter) != std::string::npos) {
+          std::cout << name << std::endl;
+        }
+      }
+    }
+    return 0;
+  }
+
+  std::vector<bench::Result> results =
+      bench::RunBenchmarks(filter, min_time, std::cout);
+
+  if (!out_file.empty()) {
+    std::ofstream out(out_file.c_str());
+    bench::WriteJSON(results, out);
+    if (!out) {
+      std::cerr << "Could not write " << out_file << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
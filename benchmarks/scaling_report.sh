@@ -0,0 +1,196 @@
+#!/bin/bash
+# $Id$
+# ===========================================================================
+#
+# Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+# Author: Shawn Chin
+# Date  : Oct 2012
+#
+# File  : scaling_report.sh
+# Desc  : Generates a synthetic model with generate_model.sh, builds it
+#         with xparser and runs strong and weak scaling sweeps over the
+#         number of cores. Writes a report of iteration time, speedup,
+#         parallel efficiency and memory high-water mark.
+#
+#         Strong scaling runs the same population on every core count.
+#         Weak scaling grows the population with the number of cores.
+#         Efficiency is relative to the first core count of the sweep.
+#
+#         xparser, flame2-config and flame2-libtool must be on the PATH.
+#
+# ===========================================================================
+
+###--- Parameters -----------------------------------------------------------
+
+# Exit codes
+SUCCESS=0
+ERR_USAGE=1
+ERR_RUN=2
+PROG_NAME=`basename $0`
+SCRIPT_DIR=`cd \`dirname $0\` && pwd`
+
+# Defaults
+CORES="1 2 4"
+ITERATIONS=10
+SWEEPS="strong weak"
+WORK_DIR=scaling
+XPARSER=xparser
+POPULATION=1000
+GEN_OPTS=""  # options passed on to generate_model.sh
+
+###--- Functions ------------------------------------------------------------
+
+print_usage() {
+  cat << EOF
+Usage: $PROG_NAME [OPTIONS]
+
+Options:
+  -c LIST  Core counts to run, e.g. "1 2 4 8" (default: "$CORES")
+  -i NUM   Iterations per run (default: $ITERATIONS)
+  -s TYPE  Sweeps to run: strong, weak or both (default: both)
+  -d DIR   Working directory, the report is written to DIR/report.csv
+           (default: $WORK_DIR)
+  -x PATH  xparser executable (default: $XPARSER)
+  -h       Print this help
+
+Model options, passed on to generate_model.sh:
+  -a NUM   Number of agent types
+  -f NUM   Number of functions per agent type
+  -m NUM   Number of message types
+  -p NUM   Population of each agent type, per core for weak scaling
+           (default: $POPULATION)
+  -o NUM   Messages posted per agent by each posting function
+  -r NUM   Messages read per agent by each reading function, 0 for all
+EOF
+}
+
+die() {
+  echo "$PROG_NAME: $1" >&2
+  exit $2
+}
+
+# run_model DIR POPULATION CORES: runs the model on an initial population
+# and appends a row to the report
+run_model() {
+  local dir=$1 population=$2 cores=$3
+  mkdir -p "$dir"
+  rm -f "$dir"/*.xml
+  if ! "$SCRIPT_DIR/generate_model.sh" $GEN_OPTS -p $population "$dir/gen" \
+      > /dev/null; then
+    die "could not generate population in $dir" $ERR_RUN
+  fi
+  mv "$dir/gen/0.xml" "$dir/0.xml" && rm -rf "$dir/gen"
+
+  echo "Running $SWEEP sweep: $cores core(s), population $population" >&2
+  if ! "$WORK_DIR/model/run" "$dir/0.xml" $ITERATIONS $cores \
+      > "$dir/output.log" 2>&1; then
+    die "run failed, see $dir/output.log" $ERR_RUN
+  fi
+
+  local seconds=`sed -n \
+      's/^Execution time - \([0-9]*\):\([0-9]*\):\([0-9]*\).*/\1 \2 \3/p' \
+      "$dir/output.log" | awk '{ printf "%.3f", $1 * 60 + $2 + $3 / 1000 }'`
+  local peak_kb=`sed -n 's/^Memory high-water mark - \([0-9]*\) kB/\1/p' \
+      "$dir/output.log"`
+  if [ -z "$seconds" ]; then
+    die "no execution time in $dir/output.log" $ERR_RUN
+  fi
+  echo "$SWEEP,$cores,$population,$ITERATIONS,$seconds,${peak_kb:-0}" \
+      >> "$WORK_DIR/runs.csv"
+  rm -f "$dir"/[1-9]*.xml  # population output of each iteration
+}
+
+# write_report: adds per iteration time, speedup and efficiency to the runs
+write_report() {
+  awk -F, '
+    NR == 1 {
+      print "sweep,cores,population,iterations,total_s,iteration_s," \
+            "speedup,efficiency,peak_kb"
+      next
+    }
+    {
+      sweep = $1; cores = $2; seconds = $5
+      if (!(sweep in base_time)) {
+        base_time[sweep] = seconds
+        base_cores[sweep] = cores
+      }
+      speedup = (seconds > 0) ? base_time[sweep] / seconds : 0
+      if (sweep == "strong") {
+        efficiency = speedup * base_cores[sweep] / cores
+      } else {
+        efficiency = speedup
+      }
+      printf "%s,%d,%d,%d,%.3f,%.6f,%.3f,%.3f,%d\n", sweep, cores, $3, $4,
+             seconds, seconds / $4, speedup, efficiency, $6
+    }' "$WORK_DIR/runs.csv" > "$WORK_DIR/report.csv"
+  rm -f "$WORK_DIR/runs.csv"
+
+  awk -F, '
+    NR == 1 {
+      printf "%-7s %6s %11s %12s %8s %10s %12s\n", "Sweep", "Cores",
+             "Population", "s/iteration", "Speedup", "Efficiency",
+             "Peak mem/kB"
+      next
+    }
+    {
+      printf "%-7s %6d %11d %12.4f %8.2f %9.1f%% %12d\n", $1, $2, $3, $6,
+             $7, $8 * 100, $9
+    }' "$WORK_DIR/report.csv"
+}
+
+###--- Main -----------------------------------------------------------------
+
+while getopts "c:i:s:d:x:a:f:m:p:o:r:h" opt; do
+  case $opt in
+    c) CORES=$OPTARG ;;
+    i) ITERATIONS=$OPTARG ;;
+    s) case $OPTARG in
+         strong|weak) SWEEPS=$OPTARG ;;
+         both) SWEEPS="strong weak" ;;
+         *) die "sweep must be strong, weak or both" $ERR_USAGE ;;
+       esac ;;
+    d) WORK_DIR=$OPTARG ;;
+    x) XPARSER=$OPTARG ;;
+    p) POPULATION=$OPTARG ;;
+    a|f|m|o|r) GEN_OPTS="$GEN_OPTS -$opt $OPTARG" ;;
+    h) print_usage; exit $SUCCESS ;;
+    *) print_usage >&2; exit $ERR_USAGE ;;
+  esac
+done
+shift $(( OPTIND - 1 ))
+if [ $# -ne 0 ]; then
+  print_usage >&2
+  exit $ERR_USAGE
+fi
+
+for cores in $CORES; do
+  case "$cores" in
+    ''|*[!0-9]*|0) die "invalid core count: $cores" $ERR_USAGE ;;
+  esac
+done
+
+# Generate and build the model once, only the population differs per run
+mkdir -p "$WORK_DIR" || die "could not create $WORK_DIR" $ERR_USAGE
+WORK_DIR=`cd "$WORK_DIR" && pwd`
+"$SCRIPT_DIR/generate_model.sh" $GEN_OPTS -p $POPULATION "$WORK_DIR/model" \
+    || exit $ERR_USAGE
+echo "Building model in $WORK_DIR/model" >&2
+if ! (cd "$WORK_DIR/model" && "$XPARSER" model.xml && make production) \
+    > "$WORK_DIR/build.log" 2>&1; then
+  die "build failed, see $WORK_DIR/build.log" $ERR_RUN
+fi
+
+echo "sweep,cores,population,iterations,total_s,peak_kb" \
+    > "$WORK_DIR/runs.csv"
+for SWEEP in $SWEEPS; do
+  for cores in $CORES; do
+    population=$POPULATION
+    if [ $SWEEP = "weak" ]; then population=$(( POPULATION * cores )); fi
+    run_model "$WORK_DIR/${SWEEP}_$cores" $population $cores
+  done
+done
+
+write_report
+echo "" >&2
+echo "Report written to $WORK_DIR/report.csv" >&2
+exit $SUCCESS
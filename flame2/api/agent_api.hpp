@@ -11,7 +11,9 @@
 
 #ifndef FLAME2__API__AGENT_API_HPP_
 #define FLAME2__API__AGENT_API_HPP_
+#include <cstring>
 #include <string>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include "flame2/mem/memory_iterator.hpp"
 #include "flame2/mb/client.hpp"
@@ -74,9 +76,9 @@ class AgentAPI {
      *  - flame::exceptions::flame_api_access_denied (No read access to var)
      */
     template <typename T>
-    inline T GetMem(const std::string& var_name) {
+    inline T GetMem(const char* var_name) {
       try {
-        return mem_->Get<T>(var_name);
+        return mem_->Get<T>(GetVarId(var_name));
       } catch(const flame::exceptions::invalid_type& E) {
         throw flame::exceptions::flame_api_invalid_type(
           "GetMem",
@@ -107,9 +109,9 @@ class AgentAPI {
      *  - flame::exceptions::flame_api_access_denied (No write access to var)
      */
     template <typename T>
-    inline void SetMem(const std::string& var_name, T value) {
+    inline void SetMem(const char* var_name, T value) {
       try {
-        mem_->Set<T>(var_name, value);
+        mem_->Set<T>(GetVarId(var_name), value);
       } catch(const flame::exceptions::invalid_type& E) {
         throw flame::exceptions::flame_api_invalid_type(
           "SetMem",
@@ -129,6 +131,114 @@ class AgentAPI {
       }
     }
 
+    /*!
+     * \brief Returns an element of a fixed size array agent memory variable
+     * \param var_name Name of memory variable to retrieve
+     * \param index Index of the array element
+     *
+     * Members of user defined data types are accessed as separate
+     * variables named "<var_name>.<member_name>".
+     *
+     * Possible exceptions:
+     *  - flame::exceptions::flame_api_invalid_type (Invalid type specified)
+     *  - flame::exceptions::flame_api_unknown_param (Unknown variable name)
+     *  - flame::exceptions::flame_api_access_denied (No read access to var)
+     *  - flame::exceptions::flame_api_out_of_range (Invalid array index)
+     */
+    template <typename T>
+    inline T GetMem(const char* var_name, size_t index) {
+      try {
+        return mem_->Get<T>(GetVarId(var_name), index);
+      } catch(const flame::exceptions::invalid_type& E) {
+        throw flame::exceptions::flame_api_invalid_type(
+          "GetMem",
+          "Invalid type specified. Check that the type used when calling "
+          "'.GetMem<DATATYPE>()' matches the type of the agent memory "
+          "variable.");
+      } catch(const flame::exceptions::invalid_variable& E) {
+        throw flame::exceptions::flame_api_unknown_param(
+          "GetMem",
+          std::string("Unknown memory variable. Agent does not have memory "
+          "variable with name '") + var_name + "'.");
+      } catch(const flame::exceptions::invalid_operation& E) {
+        throw flame::exceptions::flame_api_access_denied(
+          "GetMem",
+          std::string("No access. This function has not been given read "
+          "access to memory variable '") + var_name + "'.");
+      } catch(const flame::exceptions::out_of_range& E) {
+        throw flame::exceptions::flame_api_out_of_range(
+          "GetMem",
+          std::string("Invalid index. The index is beyond the size of "
+          "memory variable '") + var_name + "'.");
+      }
+    }
+
+    /*!
+     * \brief Sets an element of a fixed size array agent memory variable
+     * \param var_name Name of memory variable to set
+     * \param index Index of the array element
+     * \param value Value to set it to
+     *
+     * Possible exceptions:
+     *  - flame::exceptions::flame_api_invalid_type (Invalid type specified)
+     *  - flame::exceptions::flame_api_unknown_param (Unknown variable name)
+     *  - flame::exceptions::flame_api_access_denied (No write access to var)
+     *  - flame::exceptions::flame_api_out_of_range (Invalid array index)
+     */
+    template <typename T>
+    inline void SetMem(const char* var_name, size_t index, T value) {
+      try {
+        mem_->Set<T>(GetVarId(var_name), index, value);
+      } catch(const flame::exceptions::invalid_type& E) {
+        throw flame::exceptions::flame_api_invalid_type(
+          "SetMem",
+          "Invalid type specified. Check that the type used when calling "
+          "'.SetMem<DATATYPE>()' matches the type of the agent memory "
+          "variable.");
+      } catch(const flame::exceptions::invalid_variable& E) {
+        throw flame::exceptions::flame_api_unknown_param(
+          "SetMem",
+          std::string("Unknown memory variable. Agent does not have memory "
+          "variable with name '") + var_name + "'.");
+      } catch(const flame::exceptions::invalid_operation& E) {
+        throw flame::exceptions::flame_api_access_denied(
+          "SetMem",
+          std::string("No access. This function has not been given write "
+          "access to memory variable '") + var_name + "'.");
+      } catch(const flame::exceptions::out_of_range& E) {
+        throw flame::exceptions::flame_api_out_of_range(
+          "SetMem",
+          std::string("Invalid index. The index is beyond the size of "
+          "memory variable '") + var_name + "'.");
+      }
+    }
+
+    //! \brief Returns an agent memory value (see above)
+    template <typename T>
+    inline T GetMem(const std::string& var_name) {
+      return GetMem<T>(var_name.c_str());
+    }
+
+    //! \brief Sets an agent memory value (see above)
+    template <typename T>
+    inline void SetMem(const std::string& var_name, T value) {
+      SetMem<T>(var_name.c_str(), value);
+    }
+
+    //! \brief Returns an element of a fixed size array agent memory variable
+    //! (see above)
+    template <typename T>
+    inline T GetMem(const std::string& var_name, size_t index) {
+      return GetMem<T>(var_name.c_str(), index);
+    }
+
+    //! \brief Sets an element of a fixed size array agent memory variable
+    //! (see above)
+    template <typename T>
+    inline void SetMem(const std::string& var_name, size_t index, T value) {
+      SetMem<T>(var_name.c_str(), index, value);
+    }
+
     /*!
      * \brief Post a message
      * \param msg_name Name of message to post
@@ -191,8 +301,52 @@ class AgentAPI {
     }
 
   private:
+    //! A variable name used by the agent function and its var id
+    struct VarIdEntry {
+      const char* key;  //! Address of the name as passed in
+      std::string name;  //! Name the id was looked up for
+      size_t var_id;
+    };
+
+    //! Maximum number of names remembered by GetVarId()
+    static const size_t kVarIdCacheSize = 32;
+
+    /*!
+     * \brief Returns the var id of a memory variable
+     *
+     * An AgentAPI is created for each run of a task, and agent functions
+     * name their variables with string literals, which keep their address.
+     * Ids are therefore remembered by the address of the name, so the
+     * variable map is only searched the first time a name is used. The
+     * name is compared in case the same address is reused for another.
+     *
+     * Throws flame::exceptions::invalid_variable for unknown names.
+     */
+    inline size_t GetVarId(const char* var_name) {
+      std::vector<VarIdEntry>::iterator it;
+      for (it = var_ids_.begin(); it != var_ids_.end(); ++it) {
+        if (it->key == var_name) {
+          if (std::strcmp(it->name.c_str(), var_name) != 0) {
+            it->var_id = mem_->GetVarId(var_name);
+            it->name = var_name;
+          }
+          return it->var_id;
+        }
+      }
+
+      VarIdEntry entry;
+      entry.var_id = mem_->GetVarId(var_name);
+      if (var_ids_.size() < kVarIdCacheSize) {
+        entry.key = var_name;
+        entry.name = var_name;
+        var_ids_.push_back(entry);
+      }
+      return entry.var_id;
+    }
+
     MemIterPtr mem_;  //! Store shared pointer to agent memory iterator
     MBClient mb_;  //! Store shared pointer to message board client
+    std::vector<VarIdEntry> var_ids_;  //! Ids of variables used so far
 };
 }}  // namespace flame2::api
 
@@ -7,14 +7,19 @@
  * \copyright GNU Lesser General Public License
  * \brief Agent function task
  */
+#include <algorithm>
+#include <map>
 #include <utility>
 #include <string>
+#include <vector>
 #include "flame2/config.hpp"
 #include "flame2/exceptions/all.hpp"
 #include "flame2/exceptions/api.hpp"
 #include "flame2/api/agent_api.hpp"
 #include "flame2/mem/memory_manager.hpp"
 #include "agent_task.hpp"
+#include "metrics.hpp"
+#include "profiler.hpp"
 #include "task_splitter.hpp"
 
 namespace flame { namespace exe {
@@ -41,17 +46,51 @@ typedef std::pair<std::string, mem::VectorWrapperBase*>  VectorMapValue;
  */
 AgentTask::AgentTask(std::string task_name, std::string agent_name,
                      TaskFunction func)
-    : agent_name_(agent_name), func_(func),
-      is_split_(false), offset_(0), count_(0) {
+    : agent_name_(agent_name), funcs_(1, func),
+      is_split_(false), offset_(0), count_(0),
+      range_times_(new RangeTimes) {
   task_name_ = task_name;
+  Init();
+}
+
+/*!
+ * \brief Constructor for a task that runs several functions
+ *
+ * Used for agent functions fused into a single task. Each function is run
+ * in turn for an agent before moving on to the next agent, so agent memory
+ * is iterated once for all functions.
+ *
+ * Throws flame::exceptions::invalid_argument if no functions are provided
+ * or any function pointer is invalid.
+ */
+AgentTask::AgentTask(std::string task_name, std::string agent_name,
+                     const std::vector<TaskFunction>& funcs)
+    : agent_name_(agent_name), funcs_(funcs),
+      is_split_(false), offset_(0), count_(0),
+      range_times_(new RangeTimes) {
+  task_name_ = task_name;
+  if (funcs.empty()) {
+    throw flame::exceptions::invalid_argument("No functions provided");
+  }
+  Init();
+}
+
+void AgentTask::Init() {
   mem::MemoryManager& mm = mem::MemoryManager::GetInstance();
-  if (!mm.IsRegisteredAgent(agent_name)) {
+  if (!mm.IsRegisteredAgent(agent_name_)) {
     throw flame::exceptions::invalid_agent("Invalid agent");
   }
-  if (!func) {
-    throw flame::exceptions::invalid_argument("NULL function provided");
+  std::vector<TaskFunction>::const_iterator f;
+  for (f = funcs_.begin(); f != funcs_.end(); ++f) {
+    if (!*f) {
+      throw flame::exceptions::invalid_argument("NULL function provided");
+    }
   }
-  shadow_ptr_ = mm.GetAgentShadow(agent_name);
+  shadow_ptr_ = mm.GetAgentShadow(agent_name_);
+
+  Metrics& metrics = Metrics::GetInstance();
+  agents_counter_ = metrics.RegisterCounter(task_name_ + ".agents");
+  time_counter_ = metrics.RegisterCounter(task_name_ + ".time_s");
 }
 
 /*!
@@ -60,15 +99,19 @@ AgentTask::AgentTask(std::string task_name, std::string agent_name,
  * Copies all internal variables but changes the values for offset_ and count_.
  *
  * is_split_ is set to true to indicate that this is split from a parent task.
+ * Run times of the subtask are recorded with those of the parent task.
  */
 AgentTask::AgentTask(const AgentTask& parent, size_t offset, size_t count)
     : is_split_(true), offset_(offset), count_(count) {
-  func_ = parent.func_;
+  funcs_ = parent.funcs_;
   task_id_ = parent.task_id_;
   mb_proxy_ = parent.mb_proxy_;
   task_name_ = parent.task_name_;
   agent_name_ = parent.agent_name_;
   shadow_ptr_ = parent.shadow_ptr_;
+  agents_counter_ = parent.agents_counter_;
+  time_counter_ = parent.time_counter_;
+  range_times_ = parent.range_times_;
 }
 
 /*!
@@ -97,19 +140,31 @@ void AgentTask::AllowAccess(const std::string& var_name, bool writeable) {
  *
  * A memory iterator is retrived and a message board client is created.
  *
- * The agent memory is then iterated, and each attached function is run for
- * each agent. The memory iterator and message board client is passed to the
+ * The agent memory is then iterated, and the attached functions are run in
+ * turn for each agent. The memory iterator and message board client is passed to the
  * function to all them controlled access to memory and messages.
  *
+ * Subtasks record their run time so the next split can balance the run
+ * times of subtasks (see SPLIT_BALANCED).
+ *
  * \todo (lsc) Mark agent for deletion if the function returns FLAME_AGENT_DEAD.
  */
 void AgentTask::Run() {
+  Metrics& metrics = Metrics::GetInstance();
+  bool counting = metrics.IsEnabled();
+  boost::int64_t start = (counting || is_split_) ? Profiler::Now() : 0;
+  size_t agents = 0;
+
   mem::MemoryIteratorPtr m = GetMemoryIterator();
-  api::AgentAPI agent(m, GetMessageBoardClient());
+  MessageBoardClient client = GetMessageBoardClient();
+  client->CountReads(counting);
+  api::AgentAPI agent(m, client);
 
-  while (!m->AtEnd()) {  // run function for each agent
+  std::vector<TaskFunction>::const_iterator f;
+  std::vector<TaskFunction>::const_iterator f_end = funcs_.end();
+  while (!m->AtEnd()) {  // run functions for each agent
     try {
-      func_(agent);
+      for (f = funcs_.begin(); f != f_end; ++f) (*f)(agent);
     } catch(const flame::exceptions::flame_api_exception& E) {
       // throw new exception and tag on agent/task name
       throw flame::exceptions::flame_task_exception(agent_name_,
@@ -119,13 +174,127 @@ void AgentTask::Run() {
 
     // TODO(lsc): check rc == 0 to handle agent death
     m->Step();
+    ++agents;
+  }
+
+  if (is_split_) {
+    double seconds = static_cast<double>(Profiler::Now() - start) * 1e-6;
+    boost::lock_guard<boost::mutex> lock(range_times_->mutex);
+    range_times_->times[offset_] = std::make_pair(count_, seconds);
+  }
+
+  if (counting) {
+    metrics.Add(agents_counter_, static_cast<double>(agents));
+    metrics.Add(time_counter_,
+                static_cast<double>(Profiler::Now() - start) * 1e-6);
+    mb::count_map_type::const_iterator it;
+    mb::count_map_type posted = client->GetPostCounts();
+    for (it = posted.begin(); it != posted.end(); ++it) {
+      if (it->second > 0) {
+        metrics.Add(it->first + ".posted", static_cast<double>(it->second));
+      }
+    }
+    const mb::count_map_type& read = client->GetReadCounts();
+    for (it = read.begin(); it != read.end(); ++it) {
+      metrics.Add(it->first + ".read", static_cast<double>(it->second));
+    }
+  }
+}
+
+//! Divides a population into num_splits ranges of near equal size
+static void GetEvenCounts(size_t population, size_t num_splits,
+                          std::vector<size_t>* counts) {
+  size_t size_per_task = population / num_splits;
+  size_t remainder = population % num_splits;
+  for (size_t i = 0; i < num_splits; ++i) {
+    counts->push_back(((i < remainder) ? 1 : 0) + size_per_task);
+  }
+}
+
+//! Divides a population into ranges that each hold 1/max_tasks of the
+//! agents not yet in a range, and at least min_task_size agents
+static void GetGuidedCounts(size_t population, size_t max_tasks,
+                            size_t min_task_size,
+                            std::vector<size_t>* counts) {
+  size_t remaining = population;
+  while (remaining > 0) {
+    size_t s = std::max((remaining + max_tasks - 1) / max_tasks,
+                        min_task_size);
+    if (s + min_task_size > remaining) s = remaining;  // too few to leave
+    counts->push_back(s);
+    remaining -= s;
+  }
+}
+
+/*!
+ * \brief Divides agents into ranges of equal run time
+ * \return false if the last split does not cover the population or took
+ * no measurable time
+ *
+ * Agents within each range of the last split are taken to have equal run
+ * times. Every range keeps at least min_task_size agents.
+ */
+bool AgentTask::GetBalancedCounts(size_t population, size_t num_splits,
+                                  size_t min_task_size,
+                                  std::vector<size_t>* counts) const {
+  std::vector<size_t> offsets, sizes;
+  std::vector<double> seconds;
+  {
+    boost::lock_guard<boost::mutex> lock(range_times_->mutex);
+    std::map<size_t, std::pair<size_t, double> >::const_iterator it;
+    for (it = range_times_->times.begin();
+         it != range_times_->times.end(); ++it) {
+      offsets.push_back(it->first);
+      sizes.push_back(it->second.first);
+      seconds.push_back(it->second.second);
+    }
+  }
+
+  // ranges have to cover the population without gaps
+  size_t end = 0;
+  double total = 0.0;
+  for (size_t r = 0; r < offsets.size(); ++r) {
+    if (offsets[r] != end) return false;
+    end += sizes[r];
+    total += seconds[r];
+  }
+  if (end != population || total <= 0.0) return false;
+
+  // place each boundary where the run time before it reaches its share
+  size_t r = 0, begin = 0, b;
+  double before = 0.0;  // run time of ranges before r
+  for (size_t i = 1; i < num_splits; ++i) {
+    double goal = total * static_cast<double>(i) / num_splits;
+    while (r < offsets.size() && before + seconds[r] < goal) {
+      before += seconds[r++];
+    }
+    if (r == offsets.size()) {
+      b = population;
+    } else {
+      b = offsets[r] + static_cast<size_t>(
+          (goal - before) / seconds[r] * static_cast<double>(sizes[r]) + 0.5);
+    }
+    // leave at least min_task_size agents for this and each later range
+    b = std::max(b, begin + min_task_size);
+    b = std::min(b, population - (num_splits - i) * min_task_size);
+    counts->push_back(b - begin);
+    begin = b;
   }
+  counts->push_back(population - begin);
+  return true;
+}
+
+//! Forgets the run times of the last split
+void AgentTask::ClearRangeTimes() {
+  boost::lock_guard<boost::mutex> lock(range_times_->mutex);
+  range_times_->times.clear();
 }
 
 /*!
  * \brief Split this task based on population size arguments provided
  * \param[in] max_tasks Maximum subtasks that should be created
  * \param[in] min_task_size Minimum population size per task after split
+ * \param[in] policy How agents are divided between subtasks
  * \return A handle to a TaskSplitter object (or null handle if no split)
  *
  * Task splitting which allows task to be executed in segments. If the vectors
@@ -133,9 +302,20 @@ void AgentTask::Run() {
  *
  * If a split is possible, subtasks are created using the alternative
  * constructor and wrapped up in a TaskSplitter instance.
+ *
+ * SPLIT_EVEN gives subtasks equal numbers of agents. SPLIT_BALANCED gives
+ * them equal run times, based on the run times of the subtasks of the last
+ * split, which suits agents whose cost varies with their position, e.g.
+ * with the number of messages in range. It splits evenly if the task was
+ * not split last time or its population has changed. SPLIT_GUIDED creates
+ * more subtasks of decreasing size, each holding 1/max_tasks of the agents
+ * left, so idle workers take on smaller and smaller pieces of work (guided
+ * self-scheduling). The number of subtasks is then not limited by
+ * max_tasks.
  */
 TaskSplitterHandle AgentTask::SplitTask(size_t max_tasks,
-                                          size_t min_task_size) {
+                                        size_t min_task_size,
+                                        SplitPolicy policy) {
   if (max_tasks < 2) {  // no splitting required
     return TaskSplitterHandle();  // return null handle
   }
@@ -147,29 +327,73 @@ TaskSplitterHandle AgentTask::SplitTask(size_t max_tasks,
     return TaskSplitterHandle();  // return null handle
   }
 
-  size_t num_splits, size_per_task, remainder;
+  size_t num_splits;
   if (population >= (min_task_size * max_tasks)) {
     num_splits = max_tasks;
   } else {
     num_splits = population / min_task_size;
   }
-  size_per_task = population / num_splits;
-  remainder = population % num_splits;
+
+  std::vector<size_t> counts;
+  if (policy == SPLIT_GUIDED) {
+    GetGuidedCounts(population, max_tasks, min_task_size, &counts);
+  } else if (policy != SPLIT_BALANCED || is_split_ ||
+             !GetBalancedCounts(population, num_splits, min_task_size,
+                                &counts)) {
+    GetEvenCounts(population, num_splits, &counts);
+  }
+  if (!is_split_) ClearRangeTimes();  // times of the new split replace them
 
   // Create TaskSplitter::TaskVector and populate using internal constructor
   Task::Handle t;
   TaskSplitter::TaskVector vec;
-  vec.reserve(num_splits);
-  size_t s;
-  for (size_t i = 0; i < num_splits; ++i) {
-    s = ((i < remainder) ? 1 : 0) + size_per_task;
-    t = Task::Handle(new AgentTask(*this, offset, s));
+  vec.reserve(counts.size());
+  for (size_t i = 0; i < counts.size(); ++i) {
+    t = Task::Handle(new AgentTask(*this, offset, counts[i]));
     vec.push_back(t);
-    offset += s;
+    offset += counts[i];
   }
 
   // Construct and return TaskSplitter
   return TaskSplitterHandle(new TaskSplitter(task_id_, vec));
 }
 
+/*!
+ * \brief Split this task into the same agent ranges as another split task
+ * \param[in] splitter TaskSplitter of a split task of the same agent
+ * \return A handle to a gated TaskSplitter (or null handle if no split)
+ *
+ * Subtask i covers the same agents as subtask i of the given splitter, so
+ * it can run as soon as that subtask is done (see
+ * TaskManager::AddRangeDependency). Subtasks are only returned once released.
+ *
+ * A null handle is returned if the subtasks of the splitter do not cover
+ * the population of this task.
+ */
+TaskSplitterHandle AgentTask::SplitTaskAs(const TaskSplitter& splitter) {
+  if (is_split_) {  // subtasks are not split further
+    return TaskSplitterHandle();  // return null handle
+  }
+
+  size_t offset, count, end = 0;
+  Task::Handle t;
+  TaskSplitter::TaskVector vec;
+  vec.reserve(splitter.GetNumTasks());
+  for (size_t i = 0; i < splitter.GetNumTasks(); ++i) {
+    if (!splitter.GetSubtask(i).GetSubtaskRange(&offset, &count) ||
+        offset != end) {
+      return TaskSplitterHandle();
+    }
+    t = Task::Handle(new AgentTask(*this, offset, count));
+    vec.push_back(t);
+    end = offset + count;
+  }
+  if (vec.empty() || end != shadow_ptr_->get_size()) {
+    return TaskSplitterHandle();
+  }
+  ClearRangeTimes();  // times of the new split replace them
+
+  return TaskSplitterHandle(new TaskSplitter(task_id_, vec, true));
+}
+
 }}  // namespace flame::exe
@@ -11,8 +11,11 @@
 #define EXE__AGENT_TASK_HPP_
 #include <string>
 #include <utility>
+#include <vector>
 #include <map>
 #include <set>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include "flame2/mem/memory_manager.hpp"
 #include "flame2/mem/memory_iterator.hpp"
 #include "task_interface.hpp"
@@ -32,6 +35,9 @@ class AgentTask : public Task {
     //! Returns the name of the task
     std::string get_task_name() const;
 
+    //! Returns the name of the associated agent
+    std::string get_agent_name() const { return agent_name_; }
+
     //! Returns the the task type
     TaskType get_task_type() const { return Task::AGENT_FUNCTION; }
 
@@ -39,25 +45,63 @@ class AgentTask : public Task {
     void Run();
 
     //! \brief Split this task based on population size arguments provided
-    TaskSplitterHandle SplitTask(size_t max_tasks, size_t min_task_size);
+    TaskSplitterHandle SplitTask(size_t max_tasks, size_t min_task_size,
+                                 SplitPolicy policy = SPLIT_EVEN);
+
+    //! \brief Split this task into the same agent ranges as another split
+    TaskSplitterHandle SplitTaskAs(const TaskSplitter& splitter);
+
+    //! \brief Returns the agent range of a split task
+    bool GetSubtaskRange(size_t* offset, size_t* count) const {
+      if (!is_split_) return false;
+      *offset = offset_;
+      *count = count_;
+      return true;
+    }
 
   protected:
+    //! Run times of the agent ranges of the last split of a task
+    struct RangeTimes {
+      boost::mutex mutex;  //! Subtasks record their times concurrently
+      //! Number of agents and run time in seconds, keyed by range offset
+      std::map<size_t, std::pair<size_t, double> > times;
+    };
+    typedef boost::shared_ptr<RangeTimes> RangeTimesPtr;
+
     // Tasks should only be created via Task Manager
     AgentTask(std::string task_name, std::string agent_name,
               TaskFunction func_ptr);
 
+    //! Constructor for a task that runs several functions for each agent
+    AgentTask(std::string task_name, std::string agent_name,
+              const std::vector<TaskFunction>& funcs);
+
     std::string agent_name_;  //! Name of associated agent
-    TaskFunction func_;  //! Function associated with task
+    std::vector<TaskFunction> funcs_;  //! Functions run for each agent
     flame::mem::AgentShadowPtr shadow_ptr_;  //! Pointer to AgentShadow
 
     bool is_split_;  //! Flag indicating task is a subtask (split task)
     size_t offset_;  //! Memory iterator offset (only used if is_split_)
     size_t count_;  //! Number of agents to iterate (only used if is_split_)
+    size_t agents_counter_;  //! Metrics counter of agents processed
+    size_t time_counter_;  //! Metrics counter of run time
+    RangeTimesPtr range_times_;  //! Shared by a task and its subtasks
 
     //! Constructor used internally to produce split task
     AgentTask(const AgentTask& parent, size_t offset, size_t count);
 
   private:
+    //! Checks the agent and functions and gets the agent shadow
+    void Init();
+
+    //! Divides agents into ranges of equal run time using range_times_
+    bool GetBalancedCounts(size_t population, size_t num_splits,
+                           size_t min_task_size,
+                           std::vector<size_t>* counts) const;
+
+    //! Forgets the run times of the last split
+    void ClearRangeTimes();
+
     //! Derive and return the transition function name from task name
     std::string get_transition_function_name(void) const {
       // Since we're yet to determine how task names are actually
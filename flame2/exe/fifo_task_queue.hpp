@@ -57,6 +57,18 @@ class FIFOTaskQueue : public TaskQueue {
       throw flame::exceptions::not_implemented("Non-splitting queue");
     }
 
+    //! \brief Specify how agents are divided between split tasks
+    //! (not applicable)
+    void SetSplitPolicy(Task::SplitPolicy /*policy*/) {
+      throw flame::exceptions::not_implemented("Non-splitting queue");
+    }
+
+    //! \brief Returns how agents are divided between split tasks
+    //! (not applicable)
+    Task::SplitPolicy GetSplitPolicy(void) const {
+      throw flame::exceptions::not_implemented("Non-splitting queue");
+    }
+
     //! \brief Returns the next available task.
     Task::id_type GetNextTask();
 
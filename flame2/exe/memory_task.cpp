@@ -0,0 +1,49 @@
+/*!
+ * \file flame2/exe/memory_task.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Task that runs agent memory functions
+ */
+#include <string>
+#include "flame2/config.hpp"
+#include "flame2/mem/memory_manager.hpp"
+#include "flame2/exceptions/all.hpp"
+#include "memory_task.hpp"
+
+namespace flame { namespace exe {
+
+/*!
+ * \brief constructor
+ *
+ * Initialies agent_name_ and op_, and checks that the agent exists.
+ */
+MemoryTask::MemoryTask(std::string task_name,
+                       std::string agent_name,
+                       Operation op)
+    : agent_name_(agent_name), op_(op) {
+  if (!flame::mem::MemoryManager::GetInstance().IsRegisteredAgent(
+          agent_name)) {
+    throw flame::exceptions::invalid_argument("Unknown agent name");
+  }
+  task_name_ = task_name;
+}
+
+/*!
+ * \brief Operations to perform when task is executed
+ *
+ * Runs memory operations defined by op_ on the named agent. OP_SWAP publishes
+ * values written to double-buffered variables during this iteration.
+ */
+void MemoryTask::Run(void) {
+  switch (op_) {
+    case OP_SWAP:
+      flame::mem::MemoryManager::GetInstance().SwapBuffers(agent_name_);
+      break;
+    default:
+      throw flame::exceptions::not_implemented("Operation not implemented");
+  }
+}
+}}  // namespace flame::exe
@@ -0,0 +1,61 @@
+/*!
+ * \file flame2/exe/memory_task.hpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Task that runs agent memory functions
+ */
+#ifndef EXE__MEMORY_TASK_HPP_
+#define EXE__MEMORY_TASK_HPP_
+#include <string>
+#include "flame2/exceptions/all.hpp"
+#include "task_interface.hpp"
+
+namespace flame { namespace exe {
+
+class MemoryTask : public Task {
+  friend class TaskManager;
+  public:
+    //! Allowed operation types
+    enum Operation {
+      OP_SWAP
+    };
+
+    //! Returns the task type
+    TaskType get_task_type(void) const { return Task::MEM_FUNCTION; }
+
+    //! Returns a memory iterator for this task
+    flame::mem::MemoryIteratorPtr GetMemoryIterator(void) const {
+      throw flame::exceptions::not_implemented("method not applicable");
+    }
+
+    //! Enable access to a specific agent var (not applicable)
+    void AllowAccess(const std::string& /*var_name*/, bool /*writeable*/) {
+      throw flame::exceptions::not_implemented("method not applicable");
+    }
+
+    //! Returns a task splitter (not supported by memory task)
+    TaskSplitterHandle SplitTask(size_t /*max_tasks*/,
+                                 size_t /*min_task_size*/,
+                                 SplitPolicy /*policy*/) {
+      throw flame::exceptions::not_implemented("method not applicable");
+    }
+
+    //! Runs the task
+    void Run(void);
+
+  protected:
+    //! Constructor (Limited to TaskManager)
+    MemoryTask(std::string task_name,
+               std::string agent_name,
+               Operation op);
+
+  private:
+    std::string agent_name_;  //! Agent name
+    Operation op_;  //! Opearation to perform
+};
+
+}}  // namespace flame::exe
+#endif  // EXE__MEMORY_TASK_HPP_
@@ -11,6 +11,7 @@
 #include "flame2/config.hpp"
 #include "flame2/mb/message_board_manager.hpp"
 #include "flame2/exceptions/all.hpp"
+#include "metrics.hpp"
 #include "message_board_task.hpp"
 
 namespace flame { namespace exe {
@@ -36,12 +37,24 @@ MessageBoardTask::MessageBoardTask(std::string task_name,
  * Runs board operations defined by op_ on named message board.
  */
 void MessageBoardTask::Run(void) {
+  flame::mb::MessageBoardManager& mgr =
+      flame::mb::MessageBoardManager::GetInstance();
+  Metrics& metrics = Metrics::GetInstance();
+  size_t count;
+
   switch (op_) {
     case OP_SYNC:
-      flame::mb::MessageBoardManager::GetInstance().Sync(msg_name_);
+      count = mgr.GetCount(msg_name_);
+      mgr.Sync(msg_name_);
+      if (metrics.IsEnabled()) {  // count messages copied into the board
+        count = mgr.GetCount(msg_name_) - count;
+        metrics.Add(msg_name_ + ".synced", static_cast<double>(count));
+        metrics.Add(msg_name_ + ".sync_bytes",
+                    static_cast<double>(count * mgr.GetMessageSize(msg_name_)));
+      }
       break;
     case OP_CLEAR:
-      flame::mb::MessageBoardManager::GetInstance().Clear(msg_name_);
+      mgr.Clear(msg_name_);
       break;
     default:
       throw flame::exceptions::not_implemented("Operation not implemented");
@@ -39,7 +39,8 @@ class MessageBoardTask : public Task {
 
     //! Returns a task splitter (not supported by MB task)
     TaskSplitterHandle SplitTask(size_t /*max_tasks*/,
-                                 size_t /*min_task_size*/) {
+                                 size_t /*min_task_size*/,
+                                 SplitPolicy /*policy*/) {
       throw flame::exceptions::not_implemented("method not applicable");
     }
 
@@ -0,0 +1,194 @@
+/*!
+ * \file flame2/exe/metrics.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Metrics: named performance counters totalled per iteration
+ */
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/foreach.hpp>
+#include "flame2/config.hpp"
+#include "flame2/exceptions/all.hpp"
+#include "metrics.hpp"
+
+namespace flame { namespace exe {
+
+Metrics::Metrics()
+    : enabled_(false), json_(false),
+      local_(&Metrics::KeepThreadCounters) {}
+
+//! \brief Starts counting
+void Metrics::Enable() {
+  enabled_ = true;
+}
+
+//! \brief Stops counting and closes the output file
+void Metrics::Disable() {
+  enabled_ = false;
+  out_.reset();
+}
+
+/*!
+ * \brief Sets the file totals are written to at the end of iterations
+ * \param[in] file_name Path of the file, empty for no output
+ *
+ * Files ending in .json get one JSON object per iteration with the totals
+ * of all counters, any other file gets CSV rows of iteration, counter and
+ * total.
+ *
+ * Throws flame::exceptions::flame_exception if the file cannot be opened.
+ */
+void Metrics::SetOutputFile(const std::string& file_name) {
+  out_.reset();
+  if (file_name.empty()) return;
+  out_.reset(new std::ofstream(file_name.c_str()));
+  if (!*out_) {
+    out_.reset();
+    throw flame::exceptions::flame_exception(
+        "Could not open metrics file: " + file_name);
+  }
+  json_ = file_name.size() >= 5 &&
+      file_name.compare(file_name.size() - 5, 5, ".json") == 0;
+  if (!json_) *out_ << "iteration,counter,value\n";
+}
+
+//! \brief Returns the id of a counter, registering it if needed
+Metrics::CounterId Metrics::RegisterCounter(const std::string& name) {
+  boost::lock_guard<boost::mutex> lock(mutex_);
+  std::map<std::string, CounterId>::iterator it = ids_.lower_bound(name);
+  if (it != ids_.end() && it->first == name) return it->second;
+  CounterId id = names_.size();
+  names_.push_back(name);
+  ids_.insert(it, std::make_pair(name, id));
+  return id;
+}
+
+//! \brief Returns the counters of the calling thread, creating them
+Metrics::ThreadCounters* Metrics::GetThreadCounters() {
+  ThreadCounters* counters = local_.get();
+  if (counters == 0) {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    counters = new ThreadCounters();
+    threads_.push_back(counters);
+    local_.reset(counters);
+  }
+  return counters;
+}
+
+/*!
+ * \brief Adds to a counter of the calling thread
+ *
+ * Takes no lock once the thread has added to any counter.
+ */
+void Metrics::Add(Metrics::CounterId id, double value) {
+  if (!enabled_) return;
+  std::vector<double>& values = GetThreadCounters()->values;
+  if (id >= values.size()) values.resize(id + 1, 0.0);
+  values[id] += value;
+}
+
+/*!
+ * \brief Adds to a counter of the calling thread given its name
+ *
+ * The id of the name is cached by the thread, so the counter is only
+ * looked up under the lock the first time the thread adds to it.
+ */
+void Metrics::Add(const std::string& name, double value) {
+  if (!enabled_) return;
+  ThreadCounters* counters = GetThreadCounters();
+  std::map<std::string, CounterId>::iterator it =
+      counters->ids.lower_bound(name);
+  if (it == counters->ids.end() || it->first != name)
+    it = counters->ids.insert(it, std::make_pair(name, RegisterCounter(name)));
+  Add(it->second, value);
+}
+
+//! \brief Writes a counter name as a JSON string
+static void WriteJSONString(std::ostream* out, const std::string& str) {
+  static const char hex[] = "0123456789abcdef";
+  *out << '"';
+  for (std::string::const_iterator c = str.begin(); c != str.end(); ++c) {
+    unsigned char ch = static_cast<unsigned char>(*c);
+    if (ch == '"' || ch == '\\') {
+      *out << '\\' << *c;
+    } else if (ch < 0x20) {  // control characters must be escaped
+      *out << "\\u00" << hex[ch >> 4] << hex[ch & 0xf];
+    } else {
+      *out << *c;
+    }
+  }
+  *out << '"';
+}
+
+/*!
+ * \brief Totals counters of all threads and writes them out
+ * \param[in] iteration The iteration that has just ended
+ *
+ * Thread counters are cleared for the next iteration. Only counters that
+ * have been added to since the last iteration are written out.
+ */
+void Metrics::EndIteration(size_t iteration) {
+  if (!enabled_) return;
+  boost::lock_guard<boost::mutex> lock(mutex_);
+  std::vector<bool> updated(names_.size(), false);
+  totals_.assign(names_.size(), 0.0);
+  BOOST_FOREACH(ThreadCounters& counters, threads_) {
+    std::vector<double>& values = counters.values;
+    for (size_t i = 0; i < values.size() && i < names_.size(); ++i) {
+      if (values[i] == 0.0) continue;
+      totals_[i] += values[i];
+      updated[i] = true;
+      values[i] = 0.0;
+    }
+  }
+  if (!out_) return;
+
+  if (json_) *out_ << "{\"iteration\":" << iteration << ",\"counters\":{";
+  bool first = true;
+  for (size_t i = 0; i < names_.size(); ++i) {
+    if (!updated[i]) continue;
+    if (json_) {
+      if (!first) *out_ << ",";
+      WriteJSONString(out_.get(), names_[i]);
+      *out_ << ":" << totals_[i];
+    } else {
+      *out_ << iteration << "," << names_[i] << "," << totals_[i] << "\n";
+    }
+    first = false;
+  }
+  if (json_) *out_ << "}}\n";
+  out_->flush();
+}
+
+/*!
+ * \brief Returns the total of a counter in the last iteration ended
+ *
+ * Returns 0 for counters that were not added to or are not registered.
+ */
+double Metrics::GetTotal(const std::string& name) const {
+  std::map<std::string, CounterId>::const_iterator it = ids_.find(name);
+  if (it == ids_.end() || it->second >= totals_.size()) return 0.0;
+  return totals_[it->second];
+}
+
+//! \brief Removes all counters and their values, must not be called while
+//! tasks are running
+void Metrics::Reset() {
+  boost::lock_guard<boost::mutex> lock(mutex_);
+  names_.clear();
+  ids_.clear();
+  totals_.clear();
+  BOOST_FOREACH(ThreadCounters& counters, threads_) {
+    counters.values.assign(counters.values.size(), 0.0);
+    counters.ids.clear();  // ids are handed out again
+  }
+}
+
+}}  // namespace flame::exe
@@ -0,0 +1,118 @@
+/*!
+ * \file flame2/exe/metrics.hpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Metrics: named performance counters totalled per iteration
+ */
+#ifndef EXE__METRICS_HPP_
+#define EXE__METRICS_HPP_
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace flame { namespace exe {
+
+/*!
+ * \brief Registry of named performance counters
+ *
+ * Counters are registered by name and then updated by id. Every thread
+ * adds to counters of its own, and keeps the ids of the names it added to,
+ * so updates take no locks once a thread has used a counter. At the end of each
+ * iteration the counters of all threads are totalled and, if an output
+ * file is set, written out as one row per counter.
+ *
+ * Counters kept by the runtime are:
+ *   - \<task\>.agents and \<task\>.time_s per agent function task
+ *   - \<board\>.posted and \<board\>.read for messages posted to and handed
+ *     out in iterators of each message board
+ *   - \<board\>.synced and \<board\>.sync_bytes per message board sync
+ *   - scheduler.wait_s, time the scheduler waited for tasks to complete
+ *
+ * Nothing is counted unless Enable() has been called. Counter values must
+ * only be totalled or read while no tasks are running.
+ *
+ * This is a singleton class. Instances are accessed using
+ * Metrics::GetInstance().
+ */
+class Metrics {
+  public:
+    typedef size_t CounterId;
+
+    //! \brief Returns instance of singleton object
+    static Metrics& GetInstance() {
+      static Metrics instance;
+      return instance;
+    }
+
+    //! \brief Starts counting
+    void Enable();
+
+    //! \brief Stops counting and closes the output file
+    void Disable();
+
+    //! \brief Returns true if counters are updated
+    bool IsEnabled() const { return enabled_; }
+
+    //! \brief Sets the file totals are written to at the end of iterations
+    void SetOutputFile(const std::string& file_name);
+
+    //! \brief Returns the id of a counter, registering it if needed
+    CounterId RegisterCounter(const std::string& name);
+
+    //! \brief Adds to a counter of the calling thread
+    void Add(CounterId id, double value);
+
+    //! \brief Adds to a counter of the calling thread given its name
+    void Add(const std::string& name, double value);
+
+    //! \brief Totals counters of all threads and writes them out
+    void EndIteration(size_t iteration);
+
+    //! \brief Returns the total of a counter in the last iteration ended
+    double GetTotal(const std::string& name) const;
+
+    //! \brief Removes all counters and their values
+    void Reset();
+
+  private:
+    //! Counter values of a thread and the ids of names it has added to
+    struct ThreadCounters {
+      std::vector<double> values;  //! Counter values by id
+      std::map<std::string, CounterId> ids;  //! Cached counter ids by name
+    };
+
+    // This is a singleton class. Disable manual instantiation
+    Metrics();
+    // This is a singleton class. Disable copy constructor
+    Metrics(const Metrics&);
+    // This is a singleton class. Disable assignment operation
+    void operator=(const Metrics&);
+
+    //! \brief Returns the counters of the calling thread, creating them
+    ThreadCounters* GetThreadCounters();
+
+    //! \brief Thread counters are owned by threads_, not by the thread
+    static void KeepThreadCounters(ThreadCounters* /*counters*/) {}
+
+    bool enabled_;  //! Counting has been enabled
+    bool json_;  //! Output is JSON lines rather than CSV
+    boost::scoped_ptr<std::ofstream> out_;  //! Output file, if set
+    boost::mutex mutex_;  //! Guards names_, ids_ and threads_
+    std::vector<std::string> names_;  //! Counter names by id
+    std::map<std::string, CounterId> ids_;  //! Counter ids by name
+    std::vector<double> totals_;  //! Totals of the last iteration ended
+    boost::ptr_vector<ThreadCounters> threads_;  //! Counters of all threads
+    //! Counters of each thread, owned by threads_
+    boost::thread_specific_ptr<ThreadCounters> local_;
+};
+
+}}  // namespace flame::exe
+#endif  // EXE__METRICS_HPP_
@@ -0,0 +1,76 @@
+/*!
+ * \file flame2/exe/priority_task_queue.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Task Queue that runs the highest priority task first
+ */
+#include <limits>
+#include "flame2/config.hpp"
+#include "task_manager.hpp"
+#include "task_interface.hpp"
+#include "priority_task_queue.hpp"
+
+namespace flame { namespace exe {
+
+/*!
+ * \brief Constructor
+ * \param[in] slots Number of slots
+ *
+ * Initialises the worker threads.
+ *
+ * Throws flame::exceptions::invalid_argument if an invalid value is given
+ * for slots.
+ */
+PriorityTaskQueue::PriorityTaskQueue(size_t slots)
+    : SplittingTaskQueue(slots), seq_(0) {
+  StartWorkers();
+}
+
+/*!
+ * \brief Destructor
+ *
+ * Signals worker threads to wrap up and waits for them to complete before
+ * destroying this object.
+ */
+PriorityTaskQueue::~PriorityTaskQueue() {
+  StopWorkers();
+}
+
+//! \brief Returns true if the queue is empty
+bool PriorityTaskQueue::empty() const {
+  return queue_.empty();
+}
+
+/*!
+ * \brief Adds a task to the task heap
+ *
+ * The termination task has the lowest priority so queued tasks are still
+ * run before worker threads end.
+ */
+void PriorityTaskQueue::PushTask(Task::id_type task_id) {
+  Entry entry;
+  entry.task_id = task_id;
+  if (Task::IsTermTask(task_id)) {
+    entry.priority = -std::numeric_limits<double>::max();
+  } else {
+    entry.priority = TaskManager::GetInstance().GetTask(task_id)
+        .get_priority();
+  }
+  entry.seq = seq_++;
+  queue_.push(entry);
+}
+
+//! \brief Returns the queued task with the highest priority
+Task::id_type PriorityTaskQueue::FrontTask() const {
+  return queue_.top().task_id;
+}
+
+//! \brief Removes the queued task with the highest priority
+void PriorityTaskQueue::PopTask() {
+  queue_.pop();
+}
+
+}}  // namespace flame::exe
@@ -0,0 +1,65 @@
+/*!
+ * \file flame2/exe/priority_task_queue.hpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Task Queue that runs the highest priority task first
+ */
+#ifndef EXE__PRIORITY_TASK_QUEUE_HPP_
+#define EXE__PRIORITY_TASK_QUEUE_HPP_
+#include <queue>
+#include <vector>
+#include "splitting_task_queue.hpp"
+
+namespace flame { namespace exe {
+
+/*!
+ * \brief Task queue ordered by task priority
+ *
+ * Task priorities are the critical path lengths set by the TaskManager, so
+ * the tasks heading the longest chains of dependent tasks are run first.
+ * Tasks of equal priority are run in the order they were enqueued.
+ *
+ * Tasks of the types set with SetSplittable() are split as in
+ * SplittingFIFOTaskQueue. A split task stays in the queue until
+ * all its subtasks have been handed out.
+ */
+class PriorityTaskQueue : public SplittingTaskQueue {
+  public:
+    explicit PriorityTaskQueue(size_t slots);
+    ~PriorityTaskQueue();
+
+    //! \brief Returns true if the queue is empty
+    bool empty() const;
+
+  protected:
+    //! Adds a task to the task heap
+    void PushTask(Task::id_type task_id);
+
+    //! Returns the queued task with the highest priority
+    Task::id_type FrontTask() const;
+
+    //! Removes the queued task with the highest priority
+    void PopTask();
+
+  private:
+    //! Queued task with its priority and arrival order
+    struct Entry {
+      double priority;
+      size_t seq;
+      Task::id_type task_id;
+      //! Orders entries so the top of the heap is the entry to run next
+      bool operator<(const Entry& other) const {
+        if (priority != other.priority) return priority < other.priority;
+        return seq > other.seq;
+      }
+    };
+
+    std::priority_queue<Entry> queue_;  //! Task heap
+    size_t seq_;  //! Number of tasks enqueued so far
+};
+
+}}  // namespace flame::exe
+#endif  // EXE__PRIORITY_TASK_QUEUE_HPP_
@@ -0,0 +1,250 @@
+/*!
+ * \file flame2/exe/profiler.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Profiler: records task runs and writes them as a Chrome trace
+ */
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include "flame2/config.hpp"
+#include "flame2/exceptions/all.hpp"
+#include "task_manager.hpp"
+#include "profiler.hpp"
+
+namespace flame { namespace exe {
+
+const size_t Profiler::kDefaultBufferSize;
+
+//! Orders records by start time
+static bool StartsBefore(const Profiler::Record& a,
+                         const Profiler::Record& b) {
+  return a.start < b.start;
+}
+
+//! Writes a string as a JSON string literal
+static void WriteJSONString(std::ostream& out, const std::string& s) {
+  out << '"';
+  for (std::string::const_iterator it = s.begin(); it != s.end(); ++it) {
+    if (*it == '"' || *it == '\\') out << '\\';
+    if (static_cast<unsigned char>(*it) >= 0x20) out << *it;
+  }
+  out << '"';
+}
+
+//! Returns the name of a task, or its id if it is no longer registered
+static std::string TaskName(Task::id_type task_id) {
+  TaskManager& tm = TaskManager::GetInstance();
+  if (task_id < tm.GetTaskCount()) return tm.GetTask(task_id).get_task_name();
+  return "task " + boost::lexical_cast<std::string>(task_id);
+}
+
+//! Returns the trace category of a task type
+static const char* TaskCategory(Task::id_type task_id) {
+  TaskManager& tm = TaskManager::GetInstance();
+  if (task_id >= tm.GetTaskCount()) return "task";
+  switch (tm.GetTask(task_id).get_task_type()) {
+    case Task::AGENT_FUNCTION: return "agent";
+    case Task::IO_FUNCTION: return "io";
+    case Task::MB_FUNCTION: return "mb";
+    case Task::MEM_FUNCTION: return "mem";
+  }
+  return "task";
+}
+
+Profiler::Profiler()
+    : enabled_(false), recording_(false), first_iteration_(1),
+      last_iteration_(0), iteration_(0), buffer_size_(kDefaultBufferSize),
+      local_(&Profiler::KeepThreadBuffer) {}
+
+//! \brief Returns the time in microseconds since the profiler was created
+boost::int64_t Profiler::Now() {
+  static const boost::posix_time::ptime epoch =
+      boost::posix_time::microsec_clock::universal_time();
+  return (boost::posix_time::microsec_clock::universal_time() - epoch)
+      .total_microseconds();
+}
+
+/*!
+ * \brief Starts recording task runs of the given iterations
+ * \param[in] first_iteration First iteration to record
+ * \param[in] last_iteration Last iteration to record, 0 for all
+ * \param[in] buffer_size Number of records held per thread
+ *
+ * Discards existing records. Must not be called while tasks are running.
+ *
+ * Throws flame::exceptions::invalid_argument if buffer_size is 0 or the
+ * range of iterations is empty.
+ */
+void Profiler::Enable(size_t first_iteration, size_t last_iteration,
+                      size_t buffer_size) {
+  if (buffer_size < 1) {
+    throw flame::exceptions::invalid_argument("buffer_size must be > 0");
+  }
+  if (last_iteration != 0 && last_iteration < first_iteration) {
+    throw flame::exceptions::invalid_argument("empty range of iterations");
+  }
+  Now();  // start the clock
+  first_iteration_ = first_iteration;
+  last_iteration_ = last_iteration;
+  buffer_size_ = buffer_size;
+  Clear();
+  enabled_ = true;
+}
+
+//! \brief Stops recording task runs, records are kept
+void Profiler::Disable() {
+  enabled_ = false;
+  recording_ = false;
+}
+
+/*!
+ * \brief Indicates that a new iteration is about to begin
+ * \param[in] iteration The iteration number
+ * \param[in] task_count Number of registered tasks
+ *
+ * Called by the Scheduler before any task of the iteration is enqueued.
+ */
+void Profiler::BeginIteration(size_t iteration, size_t task_count) {
+  iteration_ = iteration;
+  recording_ = enabled_ && iteration >= first_iteration_ &&
+      (last_iteration_ == 0 || iteration <= last_iteration_);
+  if (recording_ && enqueued_.size() < task_count)
+    enqueued_.resize(task_count, 0);
+}
+
+//! \brief Notes the time a task was handed to a task queue
+void Profiler::TaskEnqueued(Task::id_type task_id) {
+  if (recording_ && task_id < enqueued_.size()) enqueued_[task_id] = Now();
+}
+
+/*!
+ * \brief Records a run of a task by the calling thread
+ * \param[in] task The task, or subtask, that was run
+ * \param[in] task_id Id of the task
+ * \param[in] start Time the run started, see Now()
+ * \param[in] stop Time the run stopped, see Now()
+ *
+ * Called by worker threads. Takes no lock once the thread has a buffer.
+ */
+void Profiler::RecordTask(const Task& task, Task::id_type task_id,
+                          boost::int64_t start, boost::int64_t stop) {
+  if (!recording_) return;
+  ThreadBuffer& buffer = GetThreadBuffer();
+  Record& r = buffer.records[buffer.next];
+  r.task_id = task_id;
+  r.thread = buffer.index;
+  r.iteration = iteration_;
+  r.start = start;
+  r.stop = stop;
+  r.wait = (task_id < enqueued_.size() && enqueued_[task_id] <= start) ?
+      start - enqueued_[task_id] : 0;
+  if (!task.GetSubtaskRange(&r.offset, &r.count)) {
+    r.offset = 0;
+    r.count = 0;
+  }
+  if (++buffer.next == buffer.records.size()) {
+    buffer.next = 0;
+    buffer.full = true;
+  }
+}
+
+//! \brief Returns the buffer of the calling thread, creating it if needed
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer() {
+  ThreadBuffer* buffer = local_.get();
+  if (buffer == 0) {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    buffer = new ThreadBuffer(buffers_.size(), buffer_size_);
+    buffers_.push_back(buffer);
+    local_.reset(buffer);
+  }
+  return *buffer;
+}
+
+//! \brief Returns the records of all threads in order of start time
+std::vector<Profiler::Record> Profiler::GetRecords() {
+  boost::lock_guard<boost::mutex> lock(mutex_);
+  std::vector<Record> records;
+  BOOST_FOREACH(ThreadBuffer& buffer, buffers_) {
+    if (buffer.full) {
+      records.insert(records.end(),
+          buffer.records.begin() + buffer.next, buffer.records.end());
+    }
+    records.insert(records.end(),
+        buffer.records.begin(), buffer.records.begin() + buffer.next);
+  }
+  std::stable_sort(records.begin(), records.end(), &StartsBefore);
+  return records;
+}
+
+/*!
+ * \brief Writes all records to a file in Chrome trace format
+ *
+ * Each task run is a complete ("X") event on the row of the thread that
+ * ran it, with the iteration, queue wait time and subtask range as
+ * arguments.
+ *
+ * Throws flame::exceptions::flame_exception if the file cannot be written.
+ */
+void Profiler::WriteChromeTrace(const std::string& file_name) {
+  std::ofstream out(file_name.c_str());
+  if (!out) {
+    throw flame::exceptions::flame_exception(
+        "Could not open trace file: " + file_name);
+  }
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    BOOST_FOREACH(ThreadBuffer& buffer, buffers_) {
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+          << buffer.index << ",\"args\":{\"name\":\"worker "
+          << buffer.index << "\"}}";
+    }
+  }
+
+  std::vector<Record> records = GetRecords();
+  BOOST_FOREACH(const Record& r, records) {
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << "{\"name\":";
+    WriteJSONString(out, TaskName(r.task_id));
+    out << ",\"cat\":\"" << TaskCategory(r.task_id) << "\""
+        << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << r.thread
+        << ",\"ts\":" << r.start << ",\"dur\":" << (r.stop - r.start)
+        << ",\"args\":{\"iteration\":" << r.iteration
+        << ",\"wait_us\":" << r.wait;
+    if (r.count > 0) {
+      out << ",\"offset\":" << r.offset << ",\"count\":" << r.count;
+    }
+    out << "}}";
+  }
+  out << "\n]}\n";
+  if (!out) {
+    throw flame::exceptions::flame_exception(
+        "Could not write trace file: " + file_name);
+  }
+}
+
+//! \brief Discards all records, must not be called while tasks are running
+void Profiler::Clear() {
+  boost::lock_guard<boost::mutex> lock(mutex_);
+  BOOST_FOREACH(ThreadBuffer& buffer, buffers_) {
+    buffer.records.assign(buffer_size_, Record());
+    buffer.next = 0;
+    buffer.full = false;
+  }
+  enqueued_.clear();
+}
+
+}}  // namespace flame::exe
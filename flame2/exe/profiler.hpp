@@ -0,0 +1,132 @@
+/*!
+ * \file flame2/exe/profiler.hpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Profiler: records task runs and writes them as a Chrome trace
+ */
+#ifndef EXE__PROFILER_HPP_
+#define EXE__PROFILER_HPP_
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include "task_interface.hpp"
+
+namespace flame { namespace exe {
+
+/*!
+ * \brief Records when tasks run, on which thread and how long they waited
+ *
+ * Every thread that runs tasks records into a ring buffer of its own so
+ * recording takes no locks. When a buffer is full the oldest records are
+ * overwritten. Recording is off unless Enable() is called, which can limit
+ * recording to a range of iterations.
+ *
+ * Records are written in the Chrome trace event format, which can be
+ * viewed with chrome://tracing or Perfetto. Each worker thread is shown as
+ * a row of task runs. Buffers must only be written out or cleared while no
+ * tasks are running, i.e. between iterations.
+ *
+ * This is a singleton class. Instances are accessed using
+ * Profiler::GetInstance().
+ */
+class Profiler {
+  public:
+    //! Number of records held per thread by default
+    static const size_t kDefaultBufferSize = 1 << 16;
+
+    //! A run of a task or subtask
+    struct Record {
+      Task::id_type task_id;  //! Task that was run
+      size_t thread;  //! Thread that ran the task
+      size_t iteration;  //! Iteration the task was run in
+      boost::int64_t start;  //! Start time in microseconds
+      boost::int64_t stop;  //! Stop time in microseconds
+      boost::int64_t wait;  //! Time spent queued in microseconds
+      size_t offset;  //! First agent of a subtask
+      size_t count;  //! Number of agents of a subtask, 0 if not split
+    };
+
+    //! \brief Returns instance of singleton object
+    static Profiler& GetInstance() {
+      static Profiler instance;
+      return instance;
+    }
+
+    //! \brief Returns the time in microseconds since the profiler was created
+    static boost::int64_t Now();
+
+    //! \brief Starts recording task runs of the given iterations
+    void Enable(size_t first_iteration = 1, size_t last_iteration = 0,
+                size_t buffer_size = kDefaultBufferSize);
+
+    //! \brief Stops recording task runs
+    void Disable();
+
+    //! \brief Returns true if task runs are recorded
+    bool IsEnabled() const { return enabled_; }
+
+    //! \brief Indicates that a new iteration is about to begin
+    void BeginIteration(size_t iteration, size_t task_count);
+
+    //! \brief Notes the time a task was handed to a task queue
+    void TaskEnqueued(Task::id_type task_id);
+
+    //! \brief Records a run of a task by the calling thread
+    void RecordTask(const Task& task, Task::id_type task_id,
+                    boost::int64_t start, boost::int64_t stop);
+
+    //! \brief Returns the records of all threads in order of start time
+    std::vector<Record> GetRecords();
+
+    //! \brief Writes all records to a file in Chrome trace format
+    void WriteChromeTrace(const std::string& file_name);
+
+    //! \brief Discards all records
+    void Clear();
+
+  private:
+    //! Fixed size buffer of records of a thread
+    struct ThreadBuffer {
+      ThreadBuffer(size_t thread_index, size_t size)
+          : index(thread_index), records(size), next(0), full(false) {}
+      size_t index;  //! Thread number shown in traces
+      std::vector<Record> records;  //! Records, oldest at next if full
+      size_t next;  //! Where the next record is written
+      bool full;  //! Buffer has wrapped around
+    };
+
+    // This is a singleton class. Disable manual instantiation
+    Profiler();
+    // This is a singleton class. Disable copy constructor
+    Profiler(const Profiler&);
+    // This is a singleton class. Disable assignment operation
+    void operator=(const Profiler&);
+
+    //! \brief Returns the buffer of the calling thread
+    ThreadBuffer& GetThreadBuffer();
+
+    //! \brief Thread buffers are owned by buffers_, not by the thread
+    static void KeepThreadBuffer(ThreadBuffer* /*buffer*/) {}
+
+    bool enabled_;  //! Recording has been enabled
+    bool recording_;  //! Current iteration is recorded
+    size_t first_iteration_;  //! First iteration recorded
+    size_t last_iteration_;  //! Last iteration recorded, 0 for no limit
+    size_t iteration_;  //! Current iteration
+    size_t buffer_size_;  //! Number of records per thread
+    //! Time each task was last enqueued
+    std::vector<boost::int64_t> enqueued_;
+    boost::mutex mutex_;  //! Guards buffers_
+    boost::ptr_vector<ThreadBuffer> buffers_;  //! Buffers of all threads
+    //! Buffer of each thread, owned by buffers_
+    boost::thread_specific_ptr<ThreadBuffer> local_;
+};
+
+}}  // namespace flame::exe
+#endif  // EXE__PROFILER_HPP_
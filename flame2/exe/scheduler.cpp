@@ -19,6 +19,8 @@
 #include "flame2/io/io_manager.hpp"
 #include "flame2/exceptions/all.hpp"
 #include "task_manager.hpp"
+#include "metrics.hpp"
+#include "profiler.hpp"
 #include "scheduler.hpp"
 
 namespace flame { namespace exe {
@@ -127,6 +129,40 @@ size_t Scheduler::GetMinVectorSize(Task::TaskType type) const {
   }
 }
 
+/*!
+ * \brief Specifies how agents are divided between split tasks
+ * \param[in] type Task type
+ * \param[in] policy Split policy
+ *
+ * Throws flame::exceptions::invalid_argument if type has not yet been assigned
+ * to a queue.
+ */
+void Scheduler::SetSplitPolicy(Task::TaskType type,
+                               Task::SplitPolicy policy) {
+  RouteMap::iterator iter = route_.find(type);
+  if (iter == route_.end()) {
+    throw flame::exceptions::invalid_argument("unassigned type");
+  } else {
+    queues_[iter->second].SetSplitPolicy(policy);
+  }
+}
+
+/*!
+ * \brief Returns how agents are divided between split tasks
+ * \param[in] type Task type
+ *
+ * Throws flame::exceptions::invalid_argument if type has not yet been assigned
+ * to a queue.
+ */
+Task::SplitPolicy Scheduler::GetSplitPolicy(Task::TaskType type) const {
+  RouteMap::const_iterator iter = route_.find(type);
+  if (iter == route_.end()) {
+    throw flame::exceptions::invalid_argument("unassigned type");
+  } else {
+    return queues_[iter->second].GetSplitPolicy();
+  }
+}
+
 //! \brief Returns true if the given id is a valid queue id
 bool Scheduler::IsValidQueueId(QueueId id) {
   return (id < queues_.size());
@@ -159,12 +195,14 @@ void Scheduler::RunIteration() {
   // inform IO manager of the current iteration count
   flame::io::IOManager &io = flame::io::IOManager::GetInstance();
   io.setIteration(iter_count_);
+  Profiler::GetInstance().BeginIteration(iter_count_, tm.GetTaskCount());
 
   // sanity check. avoid deadlock if no ready tasks
   if (!tm.IterTaskAvailable()) {
     throw flame::exceptions::flame_exe_exception("No runnable tasks");
   }
 
+  boost::int64_t waited = 0;  // time spent waiting for workers
   while (!tm.IterCompleted()) {  // repeat till all tasks completed
     while (tm.IterTaskAvailable()) {  // schedule ready tasks
       EnqueueTask(tm.IterTaskPop());
@@ -173,7 +211,9 @@ void Scheduler::RunIteration() {
     { // deal with tasks that have been completed by workers
       boost::unique_lock<boost::mutex> lock(doneq_mutex_);
       if (doneq_.empty()) {
+        boost::int64_t start = Profiler::Now();
         doneq_cond_.wait(lock);
+        waited += Profiler::Now() - start;
       }
       while (!doneq_.empty()) {
         tm.IterTaskDone(doneq_.back());
@@ -182,6 +222,10 @@ void Scheduler::RunIteration() {
     }  // lock freed on exiting block scope
   }
 
+  Metrics& metrics = Metrics::GetInstance();
+  metrics.Add("scheduler.wait_s", static_cast<double>(waited) * 1e-6);
+  metrics.EndIteration(iter_count_);  // total counters of this iteration
+
   tm.IterReset();  // prepare for next iteration
   ++iter_count_;  // increment iteration count (for next iter)
 }
@@ -192,6 +236,9 @@ void Scheduler::RunIteration() {
   * The queue is selected based on the task type and contents of
   * route_ map which is populated by AssignType().
   *
+  * If the queue supports range dependencies, tasks that are range dependent
+  * on the task are made ready so they can be enqueued before it completes.
+  *
   * Throws flame::exceptions::invalid_type if a tasks with an unregistered
   * type is encountered.
   */
@@ -201,7 +248,13 @@ void Scheduler::EnqueueTask(Task::id_type task_id) {
 
   try {
     QueueId qid = route_.at(task.get_task_type());  // identify queue
-    queues_.at(qid).Enqueue(task.get_task_id());
+    Profiler::GetInstance().TaskEnqueued(task_id);
+    TaskQueue& queue = queues_.at(qid);
+    queue.Enqueue(task.get_task_id());
+    // range dependents can be handed to the same queue straight away
+    if (queue.SupportsRangeDependencies()) {
+      tm.IterReleaseRangeDependents(task_id);
+    }
   } catch(const std::out_of_range& E) {
     throw flame::exceptions::invalid_type("unassigned task type");
   }
@@ -73,6 +73,12 @@ class Scheduler {
     //! \brief Returns the minimum vector size to maintain when splitting task
     size_t GetMinVectorSize(Task::TaskType type) const;
 
+    //! \brief Specifies how agents are divided between split tasks
+    void SetSplitPolicy(Task::TaskType type, Task::SplitPolicy policy);
+
+    //! \brief Returns how agents are divided between split tasks
+    Task::SplitPolicy GetSplitPolicy(Task::TaskType type) const;
+
     /*! 
      * \brief Callback function used to indicate that a task is completed
      *
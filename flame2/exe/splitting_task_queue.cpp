@@ -0,0 +1,352 @@
+/*!
+ * \file flame2/exe/splitting_task_queue.cpp
+ * \author Shawn Chin
+ * \date Oct 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Implementation of SplittingTaskQueue
+ */
+#include <utility>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/foreach.hpp>
+#include "flame2/config.hpp"
+#include "task_manager.hpp"
+#include "splitting_task_queue.hpp"
+
+namespace flame { namespace exe {
+
+/*!
+ * \brief Constructor
+ *
+ * Sets the max_split_ to the number of slots,
+ * min_vector_size to DEFAULT_MIN_VECTOR_SIZE and split_policy_ to
+ * Task::SPLIT_EVEN.
+ *
+ * Throws flame::exceptions::invalid_argument if an invalid value for slot is
+ * given.
+ */
+SplittingTaskQueue::SplittingTaskQueue(size_t slots)
+    : slots_(slots),
+      max_splits_(slots),
+      min_vector_size_(DEFAULT_MIN_VECTOR_SIZE),
+      split_policy_(Task::SPLIT_EVEN) {
+  if (slots < 1) {
+    throw flame::exceptions::invalid_argument("slots must be > 0");
+  }
+}
+
+//! \brief Populates the vector of worker threads and starts the threads
+void SplittingTaskQueue::StartWorkers() {
+  workers_.reserve(slots_);
+  for (size_t i = 0; i < slots_; ++i) {
+    WorkerThread *t = new WorkerThread(this);
+    t->Init();
+    workers_.push_back(t);
+  }
+}
+
+/*!
+ * \brief Ends the worker threads
+ *
+ * Enqueue a termination tasks for each worker thread and wait for them to
+ * complete.
+ */
+void SplittingTaskQueue::StopWorkers() {
+  for (size_t i = 0; i < slots_; ++i) {
+    Enqueue(Task::GetTermTaskId());
+  }
+  BOOST_FOREACH(WorkerThread &thread, workers_) {
+    thread.join();  // block till thread actually ends
+  }
+}
+
+//! \brief Addes to set of task type than can be split.
+void SplittingTaskQueue::SetSplittable(Task::TaskType task_type) {
+  splittable_.insert(task_type);
+}
+
+//! \brief Sets the value of max_splits_
+void SplittingTaskQueue::SetMaxTasksPerSplit(size_t max_splits) {
+  if (max_splits < 1) {
+    throw flame::exceptions::invalid_argument("max_splits must be > 0");
+  }
+  max_splits_ = max_splits;
+}
+
+//! \brief Returns the value of max_splits_
+size_t SplittingTaskQueue::GetMaxTasksPerSplit(void) const {
+  return max_splits_;
+}
+
+//! \brief Sets the value of min_vector_size_
+void SplittingTaskQueue::SetMinVectorSize(size_t min_vector_size) {
+  if (min_vector_size < 1) {
+    throw flame::exceptions::invalid_argument("min_vector_size must be > 0");
+  }
+  min_vector_size_ = min_vector_size;
+}
+
+//! \brief Returns the value of min_vector_size_
+size_t SplittingTaskQueue::GetMinVectorSize(void) const {
+  return min_vector_size_;
+}
+
+/*!
+ * \brief Sets the value of split_policy_
+ *
+ * Task::SPLIT_BALANCED uses the run times of the subtasks of the last split
+ * of a task, so suits tasks that are split on every iteration.
+ * Task::SPLIT_GUIDED creates more subtasks than max_splits_, which workers
+ * take in turn as they become free.
+ */
+void SplittingTaskQueue::SetSplitPolicy(Task::SplitPolicy policy) {
+  split_policy_ = policy;
+}
+
+//! \brief Returns the value of split_policy_
+Task::SplitPolicy SplittingTaskQueue::GetSplitPolicy(void) const {
+  return split_policy_;
+}
+
+/*!
+ * \brief Adds a task to the queue
+ *
+ * This method is meant to be called by the Scheduler
+ *
+ * Appends the tasks to the queue. If the task is a splittable task,
+ * attempt the split the task. If the split is successful, add the resulting
+ * TaskSplitter instance to the split_map_ with the task_id as key.
+ *
+ * A range dependent task (see TaskManager::AddRangeDependency) may be
+ * enqueued before the task it depends on has completed. If that task has
+ * been split, the new task is split into the same ranges and each subtask is
+ * queued once the matching subtask it depends on is done. Otherwise the
+ * task waits until the task it depends on has completed.
+ */
+void SplittingTaskQueue::Enqueue(Task::id_type task_id) {
+  boost::lock_guard<boost::mutex> lock(mutex_);
+
+  // TERM task id is virtual and has no corresponding task obj.
+  if (!Task::IsTermTask(task_id)) {
+    unfinished_.insert(task_id);
+    Task::id_type dep_id;
+    if (TaskManager::GetInstance().GetRangeDependency(task_id, &dep_id) &&
+        unfinished_.find(dep_id) != unfinished_.end()) {
+      if (!SplitAsDependency(task_id, dep_id)) {
+        waiting_.insert(DependentMap::value_type(dep_id, task_id));
+      }
+      return;
+    }
+  }
+  Push(task_id);
+}
+
+//! \brief Appends a task to the queue and splits it if possible
+void SplittingTaskQueue::Push(Task::id_type task_id) {
+  PushTask(task_id);
+  ready_.notify_one();  // wake up one worker thread
+
+  // TERM task id is virtual and has no corresponding task obj.
+  if (Task::IsTermTask(task_id)) return;   // Nothing left to do.
+
+  // Check if task is splittable
+  Task& t = TaskManager::GetInstance().GetTask(task_id);
+  if (splittable_.find(t.get_task_type()) == splittable_.end()) return;  // no
+
+  // Attempt to split atoms^H^H^H^H^H task
+  TaskSplitterHandle ts = t.SplitTask(max_splits_, min_vector_size_,
+                                      split_policy_);
+  if (ts) {  // successfully split. Add to split_map_
+    SplitMap::iterator lb = split_map_.lower_bound(task_id);
+    if (lb != split_map_.end() &&
+        !(split_map_.key_comp()(task_id, lb->first))) {  // key exists
+      throw flame::exceptions::logic_error("task id conflict");
+    } else {
+      // register subtasks. Wake ALL workers and return
+      split_map_.insert(SplitMap::value_type(task_id, ts));
+      // wake up more workers
+      for (size_t i = 0; i < ts->GetNumTasks() -1; ++i) {
+        ready_.notify_one();
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Splits a range dependent task into the ranges of its dependency
+ * \return false if the dependency has not been split or the task cannot be
+ * split into the same ranges
+ *
+ * The new splitter is gated. Subtasks matching subtasks of the dependency
+ * that are already done are released and queued straight away, the rest
+ * are released by SubtaskDone().
+ */
+bool SplittingTaskQueue::SplitAsDependency(Task::id_type task_id,
+                                               Task::id_type dep_id) {
+  SplitMap::iterator dep = split_map_.find(dep_id);
+  if (dep == split_map_.end()) return false;  // dependency not split
+
+  Task& t = TaskManager::GetInstance().GetTask(task_id);
+  if (splittable_.find(t.get_task_type()) == splittable_.end()) return false;
+  TaskSplitterHandle ts = t.SplitTaskAs(*dep->second);
+  if (!ts) return false;
+  if (!split_map_.insert(SplitMap::value_type(task_id, ts)).second) {
+    throw flame::exceptions::logic_error("task id conflict");
+  }
+  dependents_.insert(DependentMap::value_type(dep_id, task_id));
+
+  BOOST_FOREACH(size_t index, dep->second->GetDoneSubtasks()) {
+    ts->Release(index);
+    PushTask(task_id);
+    ready_.notify_one();
+  }
+  return true;
+}
+
+/*!
+ * \brief Indicate that a task has been completed
+ *
+ * This method is meant to be called by a Worker Thread.
+ *
+ * If the task does not have an entry in split_map_, run the callback function
+ * and return.
+ *
+ * If the task has an entry in split_map_, retrieve the task splitter instance
+ * and indicate that a task segment has been completed. If there are still
+ * pending or running subtasks, do nothing else.
+ *
+ * If all subtasks have been completed, remove the task from the split_map_ and
+ * run the scheduler callback function to signal that the whole task has been
+ * completed.
+ *
+ * Subtasks of range dependent tasks are only released by SubtaskDone().
+ */
+void SplittingTaskQueue::TaskDone(Task::id_type task_id) {
+  // mutex required since we're accessing split_map_
+  boost::lock_guard<boost::mutex> lock(mutex_);
+
+  // determine if this is a split task
+  SplitMap::iterator it = split_map_.find(task_id);
+  if (it != split_map_.end()) {  // it is
+    bool all_completed = it->second->OneTaskDone();
+    if (!all_completed) {
+      return;  // still more to go.  callback should not go upsteam
+    }
+  }
+
+  Completed(task_id);
+}
+
+/*!
+ * \brief Indicate that a task or a subtask of a split task has been completed
+ *
+ * This method is meant to be called by a Worker Thread.
+ *
+ * As TaskDone(), but the matching subtasks of tasks that are range dependent
+ * on a split task are released and queued as each of its subtasks is done.
+ */
+void SplittingTaskQueue::SubtaskDone(Task::id_type task_id,
+                                         const Task& task) {
+  boost::lock_guard<boost::mutex> lock(mutex_);
+
+  SplitMap::iterator it = split_map_.find(task_id);
+  if (it != split_map_.end()) {  // split task
+    size_t index = it->second->GetSubtaskIndex(task);
+    bool all_completed = it->second->OneTaskDone(index);
+
+    // run the subtasks that were waiting for this one
+    std::pair<DependentMap::iterator, DependentMap::iterator> range =
+        dependents_.equal_range(task_id);
+    for (DependentMap::iterator d = range.first; d != range.second; ++d) {
+      split_map_[d->second]->Release(index);
+      PushTask(d->second);
+      ready_.notify_one();
+    }
+    if (!all_completed) {
+      return;  // still more to go.  callback should not go upsteam
+    }
+  }
+
+  Completed(task_id);
+}
+
+/*!
+ * \brief Handles the completion of a whole task
+ *
+ * Removes the task from split_map_, queues range dependent tasks that were
+ * waiting for it and runs the scheduler callback function.
+ */
+void SplittingTaskQueue::Completed(Task::id_type task_id) {
+  split_map_.erase(task_id);
+  dependents_.erase(task_id);
+  unfinished_.erase(task_id);
+
+  std::pair<DependentMap::iterator, DependentMap::iterator> range =
+      waiting_.equal_range(task_id);
+  std::vector<Task::id_type> waiting;
+  for (DependentMap::iterator d = range.first; d != range.second; ++d) {
+    waiting.push_back(d->second);
+  }
+  waiting_.erase(task_id);
+  BOOST_FOREACH(Task::id_type id, waiting) {
+    Push(id);
+  }
+
+  callback_(task_id);
+}
+
+/*!
+ * \brief Returns the next available task.
+ *
+ * If there are none available, the calling thread will be blocked
+ *
+ * This method is meant to be called by a Worker Thread.
+ *
+ * If the task is split (has an entry in split_map_), only pop the task from
+ * the queue when all subtasks have been assigned.
+ */
+Task::id_type SplittingTaskQueue::GetNextTask(void) {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (empty()) {
+    ready_.wait(lock);
+  }
+
+  // Peek at next candidate
+  Task::id_type task_id = FrontTask();
+
+  // determine if this is a split task
+  SplitMap::iterator it = split_map_.find(task_id);
+  if (it != split_map_.end()) {  // it is
+    bool none_remaining = it->second->OneTaskAssigned();
+    // gated tasks are queued once for each released subtask
+    if (none_remaining || it->second->IsGated()) {
+      PopTask();  // all tasks assigned. dequeue.
+    }
+  } else {  // not a split task. dequeue as usual
+    PopTask();
+  }
+
+  return task_id;
+}
+
+/*!
+ * \brief Returns a task reference given a task id
+ *
+ * This is used by the worker thread to get at the actual task.
+ *
+ * If the task is a split task (has an entry in split_map_) we return a
+ * reference to a subtask. Otherwise, request for the task from the
+ * Task Manager.
+ */
+Task& SplittingTaskQueue::GetTaskById(Task::id_type task_id) {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  SplitMap::iterator it = split_map_.find(task_id);
+  if (it != split_map_.end()) {  // it is
+    return it->second->GetTask();
+  } else {  // normal task
+    return TaskManager::GetInstance().GetTask(task_id);
+  }
+}
+}}  // namespace flame::exe
@@ -0,0 +1,135 @@
+/*!
+ * \file flame2/exe/splitting_task_queue.hpp
+ * \author Shawn Chin
+ * \date Oct 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Declaration of SplittingTaskQueue
+ */
+#ifndef EXE__SPLITTING_TASK_QUEUE_HPP_
+#define EXE__SPLITTING_TASK_QUEUE_HPP_
+#include <map>
+#include <set>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include "task_queue_interface.hpp"
+#include "worker_thread.hpp"
+#include "task_splitter.hpp"
+
+namespace flame { namespace exe {
+
+/*!
+ * \brief Base class of task queues that split tasks
+ *
+ * Splits tasks, hands out their subtasks and runs the subtasks of range
+ * dependent tasks as soon as the matching subtasks they depend on are done.
+ * Derived classes decide the order in which queued tasks are run by
+ * implementing PushTask(), FrontTask(), PopTask() and empty(). They start
+ * the worker threads once constructed and stop them before they are
+ * destroyed, as workers use those methods.
+ */
+class SplittingTaskQueue : public TaskQueue {
+  public:
+    //! Default value for minimum vector size for each split task
+    static size_t const DEFAULT_MIN_VECTOR_SIZE = 50;
+
+    //! Specify tasks than can be split
+    void SetSplittable(Task::TaskType task_type);
+
+    //! Specify maximum splits per task
+    void SetMaxTasksPerSplit(size_t max_tasks_per_split);
+
+    //! Returns maximum splits per task
+    size_t GetMaxTasksPerSplit(void) const;
+
+    //! Specify minimum vector size after split
+    void SetMinVectorSize(size_t min_vector_size);
+
+    //! Returns minimum vector size after split
+    size_t GetMinVectorSize(void) const;
+
+    //! Specify how agents are divided between split tasks
+    void SetSplitPolicy(Task::SplitPolicy policy);
+
+    //! Returns how agents are divided between split tasks
+    Task::SplitPolicy GetSplitPolicy(void) const;
+
+    //! \brief Adds a task to the queue
+    //!
+    //! This method is meant to be called by the Scheduler
+    void Enqueue(Task::id_type task_id);
+
+    //! \brief Indicate that a task has been completed
+    //!
+    //! This method is meant to be called by a Worker Thread
+    void TaskDone(Task::id_type task_id);
+
+    //! \brief Indicate that a task or subtask has been completed
+    //!
+    //! This method is meant to be called by a Worker Thread
+    void SubtaskDone(Task::id_type task_id, const Task& task);
+
+    //! \brief Returns true, subtasks of range dependent tasks are run as
+    //! soon as the matching subtasks they depend on are done
+    bool SupportsRangeDependencies() const { return true; }
+
+    //! \brief Returns the next available task.
+    //! If there are none available, the calling thread will be blocked
+    //!
+    //! This method is meant to be called by a Worker Thread
+    Task::id_type GetNextTask();
+
+    //! Returns a task reference given a task id
+    //! Overload so we can intercept calls
+    Task& GetTaskById(Task::id_type task_id);
+
+  protected:
+    explicit SplittingTaskQueue(size_t slots);
+
+    //! Starts the worker threads
+    void StartWorkers();
+
+    //! Ends the worker threads and waits for them to complete
+    void StopWorkers();
+
+    //! Adds a task to the back of the queue. mutex_ must be held.
+    virtual void PushTask(Task::id_type task_id) = 0;
+
+    //! Returns the task to run next. mutex_ must be held.
+    virtual Task::id_type FrontTask() const = 0;
+
+    //! Removes the task to run next. mutex_ must be held.
+    virtual void PopTask() = 0;
+
+    size_t slots_;  //! Number of processing slots (worker threads)
+
+  private:
+    typedef boost::ptr_vector<WorkerThread> WorkerVector;
+    typedef std::map<Task::id_type, TaskSplitterHandle> SplitMap;
+    typedef std::multimap<Task::id_type, Task::id_type> DependentMap;
+
+    //! Queues a task, splitting it if possible. mutex_ must be held.
+    void Push(Task::id_type task_id);
+
+    //! Splits a range dependent task into the ranges of its split
+    //! dependency. mutex_ must be held.
+    bool SplitAsDependency(Task::id_type task_id, Task::id_type dep_id);
+
+    //! Handles the completion of a whole task. mutex_ must be held.
+    void Completed(Task::id_type task_id);
+
+    std::set<Task::TaskType> splittable_;  //! Types of task to split
+    WorkerVector workers_;  //! Collection of worker threads
+    SplitMap split_map_;  //! Collection of tasks that have been split
+    //! Range dependent tasks split into the ranges of each split task
+    DependentMap dependents_;
+    //! Range dependent tasks waiting for the whole of each task
+    DependentMap waiting_;
+    std::set<Task::id_type> unfinished_;  //! Tasks enqueued but not done
+    size_t max_splits_;  //! Maximum number of tasks per split
+    size_t min_vector_size_;  //! Minimum vector size after split
+    Task::SplitPolicy split_policy_;  //! How agents are divided in a split
+};
+
+}}  // namespace flame::exe
+#endif  // EXE__SPLITTING_TASK_QUEUE_HPP_
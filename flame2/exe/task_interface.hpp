@@ -36,9 +36,18 @@ class Task {
     enum TaskType {
       AGENT_FUNCTION,
       IO_FUNCTION,
-      MB_FUNCTION
+      MB_FUNCTION,
+      MEM_FUNCTION
     };
 
+    //! How the agents of a task are divided between subtasks when split
+    enum SplitPolicy {
+      SPLIT_EVEN,      //! Equal numbers of agents
+      SPLIT_BALANCED,  //! Equal run times, as measured in the last split run
+      SPLIT_GUIDED     //! Decreasing numbers of agents (guided scheduling)
+    };
+
+    Task() : priority_(0) {}
     virtual ~Task() {}
 
     //! Runs the task
@@ -59,7 +68,20 @@ class Task {
     //! Returns a task splitter which allows task to be exected in segments
     //! Should return null handle if cannot be split.
     virtual TaskSplitterHandle SplitTask(size_t max_tasks,
-                                         size_t min_task_size) = 0;
+                                         size_t min_task_size,
+                                         SplitPolicy policy = SPLIT_EVEN) = 0;
+
+    //! Returns a task splitter whose subtasks cover the same agent ranges
+    //! as those of the given splitter, or a null handle if not possible
+    virtual TaskSplitterHandle SplitTaskAs(const TaskSplitter& /*splitter*/) {
+      return TaskSplitterHandle();
+    }
+
+    //! Returns true and the agent range if the task is a subtask of a
+    //! split task
+    virtual bool GetSubtaskRange(size_t* /*offset*/, size_t* /*count*/) const {
+      return false;
+    }
 
     //! Adds read access to message board
     //! TODO(lsc) Move this into AgentTask?
@@ -97,6 +119,12 @@ class Task {
     //! Returns the task name
     std::string get_task_name() const { return task_name_; }
 
+    //! Returns the scheduling priority, higher priority tasks run first
+    double get_priority() const { return priority_; }
+
+    //! Sets the scheduling priority
+    void set_priority(double priority) { priority_ = priority; }
+
     //! Returns true if the given task id is a termination signal
     inline static bool IsTermTask(id_type task_id) {
       return (task_id == GetTermTaskId());
@@ -113,6 +141,8 @@ class Task {
     id_type task_id_;
     std::string task_name_;
     ProxyHandle mb_proxy_;
+    //! Length of the longest chain of tasks starting with this task
+    double priority_;
 };
 
 
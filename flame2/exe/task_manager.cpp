@@ -7,9 +7,11 @@
  * \copyright GNU Lesser General Public License
  * \brief DESCRIPTION
  */
+#include <algorithm>
 #include <set>
 #include <stack>
 #include <string>
+#include <vector>
 #include <stdexcept>
 #include <boost/foreach.hpp>
 #include "flame2/config.hpp"
@@ -34,6 +36,9 @@ static inline void check_finalised(bool finalised) {
 
 namespace flame { namespace exe {
 
+//! Weight of the latest run time when smoothing task costs
+static const double kCostSmoothing = 0.5;
+
 //! \brief Instantiates, registers and returns a new Agent Task
 Task& TaskManager::CreateAgentTask(std::string task_name,
                                    std::string agent_name,
@@ -50,6 +55,23 @@ Task& TaskManager::CreateAgentTask(std::string task_name,
   return *task_ptr;
 }
 
+//! \brief Instantiates, registers and returns a new Agent Task that runs
+//! several functions
+Task& TaskManager::CreateAgentTask(std::string task_name,
+                                   std::string agent_name,
+                                   const std::vector<TaskFunction>& funcs) {
+  AgentTask* task_ptr = new AgentTask(task_name, agent_name, funcs);
+
+  try {  // register new task with manager
+    RegisterTask(task_name, task_ptr);
+  } catch(const flame::exceptions::logic_error& E) {
+    delete task_ptr;  // free memory if registration failed.
+    throw E;  // rethrow exception
+  }
+
+  return *task_ptr;
+}
+
 //! \brief Instantiates, registers and returns a new MessageBoard Task
 Task& TaskManager::CreateMessageBoardTask(std::string task_name,
                                          std::string msg_name,
@@ -65,6 +87,21 @@ Task& TaskManager::CreateMessageBoardTask(std::string task_name,
   return *task_ptr;
 }
 
+//! \brief Instantiates, registers and returns a new Memory Task
+Task& TaskManager::CreateMemoryTask(std::string task_name,
+                                    std::string agent_name,
+                                    MemoryTask::Operation op) {
+  MemoryTask* task_ptr = new MemoryTask(task_name, agent_name, op);
+  try {  // register new task with manager
+    RegisterTask(task_name, task_ptr);
+  } catch(const flame::exceptions::logic_error& E) {
+    delete task_ptr;  // free memory if registration failed.
+    throw E;  // rethrow exception
+  }
+
+  return *task_ptr;
+}
+
 //! \brief Registers and returns a new IO Task
 Task& TaskManager::CreateIOTask(std::string task_name,
                                 std::string agent_name,
@@ -124,6 +161,8 @@ void TaskManager::RegisterTask(std::string task_name, Task* task_ptr) {
   // initialise entries for dependency management
   parents_.push_back(IdSet());
   children_.push_back(IdSet());
+  iter_durations_.push_back(0.0);
+  task_costs_.push_back(-1.0);
   roots_.insert(id);
   leaves_.insert(id);
 }
@@ -183,6 +222,59 @@ void TaskManager::AddDependency(TaskManager::TaskId task_id,
   leaves_.erase(dependency_id);
 }
 
+//! Adds a range dependency between two registered tasks (by name)
+void TaskManager::AddRangeDependency(std::string task_name,
+                                     std::string dependency_name) {
+  AddRangeDependency(GetId(task_name), GetId(dependency_name));
+}
+
+/*!
+ * \brief Adds a range dependency between two registered tasks (by id)
+ *
+ * A range dependency is a dependency between agent tasks of the same agent
+ * where each agent only depends on its own results of the dependency. When
+ * both tasks are split into the same agent ranges, each subtask of the task
+ * only has to wait for the matching subtask of the dependency. Queues that
+ * support this (see TaskQueue::SupportsRangeDependencies) are given the task
+ * once the dependency has been assigned. Otherwise it is an ordinary
+ * dependency.
+ *
+ * Throws flame::exceptions::invalid_argument if either task is not an agent
+ * task or the tasks are of different agents.
+ *
+ * Throws flame::exceptions::logic_error if the task already has a range
+ * dependency.
+ */
+void TaskManager::AddRangeDependency(TaskManager::TaskId task_id,
+                                     TaskManager::TaskId dependency_id) {
+  if (!IsValidID(task_id) || !IsValidID(dependency_id)) {
+    throw flame::exceptions::invalid_argument("Invalid id");
+  }
+  AgentTask* task = dynamic_cast<AgentTask*>(&tasks_[task_id]);
+  AgentTask* dependency = dynamic_cast<AgentTask*>(&tasks_[dependency_id]);
+  if (!task || !dependency ||
+      task->get_agent_name() != dependency->get_agent_name()) {
+    throw flame::exceptions::invalid_argument(
+                 "Range dependencies need agent tasks of the same agent");
+  }
+  if (range_parents_.find(task_id) != range_parents_.end()) {
+    throw flame::exceptions::logic_error("Task has a range dependency");
+  }
+
+  AddDependency(task_id, dependency_id);
+  boost::lock_guard<boost::mutex> lock(mutex_task_);
+  range_parents_[task_id] = dependency_id;
+}
+
+//! Returns true and the range dependency of a task if it has one
+bool TaskManager::GetRangeDependency(TaskManager::TaskId task_id,
+                                     TaskManager::TaskId* dependency_id) const {
+  std::map<TaskId, TaskId>::const_iterator it = range_parents_.find(task_id);
+  if (it == range_parents_.end()) return false;
+  *dependency_id = it->second;
+  return true;
+}
+
 //! Returns dependencies of the task as a set of ids
 TaskManager::IdSet& TaskManager::GetDependencies(std::string task_name) {
   return GetDependencies(GetId(task_name));
@@ -274,8 +366,12 @@ void TaskManager::IterReset() {
   check_finalised(finalised_);
   boost::lock_guard<boost::mutex> lock(mutex_task_);
 
+  UpdatePriorities();  // use run times of the iteration just completed
+
   pending_deps_ = parents_;  // create copy of dependency tree
   assigned_tasks_.clear();
+  range_released_.clear();
+  early_tasks_.clear();
   ready_tasks_ = IdVector(roots_.begin(), roots_.end());  // tasks with no deps
 
   // reset and initialise
@@ -322,7 +418,9 @@ size_t TaskManager::IterGetAssignedCount() const {
 }
 
 /*!
- * \brief Pops and returns a task that is ready for execution
+ * \brief Pops and returns the ready task with the highest priority
+ *
+ * Of tasks with equal priority the one made ready last is returned.
  *
  * Throws flame::exceptions::none_available if the queue is empty
  */
@@ -334,8 +432,13 @@ TaskManager::TaskId TaskManager::IterTaskPop() {
     throw flame::exceptions::none_available("No available tasks");
   }
 
-  TaskManager::TaskId task_id = ready_tasks_.back();
-  ready_tasks_.pop_back();
+  size_t best = ready_tasks_.size() - 1;
+  for (size_t i = best; i-- > 0;) {
+    if (tasks_[ready_tasks_[i]].get_priority() >
+        tasks_[ready_tasks_[best]].get_priority()) best = i;
+  }
+  TaskManager::TaskId task_id = ready_tasks_[best];
+  ready_tasks_.erase(ready_tasks_.begin() + best);
   assigned_tasks_.insert(task_id);
   return task_id;
 }
@@ -357,12 +460,121 @@ void TaskManager::IterTaskDone(TaskManager::TaskId task_id) {
     IdSet& d = pending_deps_.at(*it);  // get pending deps for each dependency
     d.erase(task_id);  // this dependency is now fulfilled
     if (d.empty()) {  // all dependencies met?
-      ready_tasks_.push_back(*it);  // new task ready for execution
-      pending_tasks_.erase(*it);
+      if (early_tasks_.erase(*it) == 0) {  // not already made ready
+        ready_tasks_.push_back(*it);  // new task ready for execution
+        pending_tasks_.erase(*it);
+      }
+    } else {
+      IterCheckRangeReady(*it);
     }
   }
 }
 
+/*!
+ * \brief Indicates that a task has been assigned to a queue that supports
+ * range dependencies
+ *
+ * Tasks that are range dependent on the task and have no other outstanding
+ * dependencies are made ready, as are those whose other dependencies are
+ * met later on. The queue holds back their subtasks until the matching
+ * subtasks of the task are done.
+ */
+void TaskManager::IterReleaseRangeDependents(TaskManager::TaskId task_id) {
+  check_finalised(finalised_);
+  boost::lock_guard<boost::mutex> lock(mutex_task_);
+  range_released_.insert(task_id);
+  BOOST_FOREACH(TaskId child, children_.at(task_id)) {
+    IterCheckRangeReady(child);
+  }
+}
+
+/*!
+ * \brief Makes a task ready if it only waits on a released range dependency
+ *
+ * Must be called with mutex_task_ held.
+ */
+void TaskManager::IterCheckRangeReady(TaskManager::TaskId task_id) {
+  std::map<TaskId, TaskId>::const_iterator r = range_parents_.find(task_id);
+  if (r == range_parents_.end()) return;  // no range dependency
+  IdSet& d = pending_deps_.at(task_id);
+  if (d.size() != 1 || *d.begin() != r->second) return;  // other deps left
+  if (range_released_.find(r->second) == range_released_.end()) return;
+  if (pending_tasks_.erase(task_id) == 0) return;  // already ready
+  ready_tasks_.push_back(task_id);
+  early_tasks_.insert(task_id);
+}
+
+/*!
+ * \brief Records the time taken by a run of a task
+ *
+ * Called by worker threads once a task, or a segment of a split task, has
+ * been run. Run times of a task are summed until the end of the iteration.
+ * Unknown task ids are ignored.
+ */
+void TaskManager::RecordTaskDuration(TaskManager::TaskId task_id,
+                                     double seconds) {
+  boost::lock_guard<boost::mutex> lock(mutex_timing_);
+  if (task_id < iter_durations_.size()) iter_durations_[task_id] += seconds;
+}
+
+//! \brief Returns the smoothed measured run time of a task
+double TaskManager::GetTaskCost(TaskManager::TaskId task_id) const {
+  if (!IsValidID(task_id)) {
+    throw flame::exceptions::invalid_argument("Invalid id");
+  }
+  return task_costs_[task_id];
+}
+
+/*!
+ * \brief Sets task priorities to their critical path lengths
+ *
+ * Run times recorded since the last call are blended into the cost of each
+ * task. The priority of a task then becomes the cost of the most expensive
+ * chain of dependent tasks starting with it, so tasks at the head of long
+ * chains are started first. Tasks are visited from the leaves upwards.
+ *
+ * Priorities are left as registered (see XGraph) until tasks have been
+ * timed. Must be called with mutex_task_ held.
+ */
+void TaskManager::UpdatePriorities() {
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_timing_);
+    bool timed = false;
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+      if (iter_durations_[i] <= 0.0) continue;
+      if (task_costs_[i] < 0.0) {
+        task_costs_[i] = iter_durations_[i];
+      } else {
+        task_costs_[i] = kCostSmoothing * iter_durations_[i] +
+                         (1.0 - kCostSmoothing) * task_costs_[i];
+      }
+      iter_durations_[i] = 0.0;
+      timed = true;
+    }
+    if (!timed) return;
+  }
+
+  std::vector<double> length(tasks_.size(), 0.0);
+  std::vector<size_t> remaining(tasks_.size());
+  std::stack<TaskId> ready;
+  for (size_t i = 0; i < tasks_.size(); ++i) {
+    remaining[i] = children_[i].size();
+    if (remaining[i] == 0) ready.push(i);
+  }
+  while (!ready.empty()) {
+    TaskId id = ready.top();
+    ready.pop();
+    double longest = 0.0;
+    BOOST_FOREACH(TaskId child, children_[id]) {
+      if (length[child] > longest) longest = length[child];
+    }
+    length[id] = longest + std::max(task_costs_[id], 0.0);
+    tasks_[id].set_priority(length[id]);
+    BOOST_FOREACH(TaskId parent, parents_[id]) {
+      if (--remaining[parent] == 0) ready.push(parent);
+    }
+  }
+}
 
 #ifdef TESTBUILD
 void TaskManager::Reset() {
@@ -379,6 +591,11 @@ void TaskManager::Reset() {
   ready_tasks_.clear();
   pending_tasks_.clear();
   pending_deps_.clear();
+  range_parents_.clear();
+  range_released_.clear();
+  early_tasks_.clear();
+  iter_durations_.clear();
+  task_costs_.clear();
 }
 #endif
 
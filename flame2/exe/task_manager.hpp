@@ -20,6 +20,7 @@
 #include <boost/ptr_container/ptr_map.hpp>
 #include <boost/thread/mutex.hpp>
 #include "message_board_task.hpp"
+#include "memory_task.hpp"
 #include "io_task.hpp"
 #include "task_interface.hpp"
 
@@ -52,11 +53,22 @@ class TaskManager {
                           std::string agent_name,
                           TaskFunction func_ptr);
 
+    //! \brief Registers and returns a new Agent Task that runs several
+    //! functions in turn for each agent
+    Task& CreateAgentTask(std::string task_name,
+                          std::string agent_name,
+                          const std::vector<TaskFunction>& funcs);
+
     //! \brief Registers and returns a new MessageBoard Task
     Task& CreateMessageBoardTask(std::string task_name,
                                  std::string msg_name,
                                  MessageBoardTask::Operation op);
 
+    //! \brief Registers and returns a new Memory Task
+    Task& CreateMemoryTask(std::string task_name,
+                           std::string agent_name,
+                           MemoryTask::Operation op);
+
     //! \brief Registers and returns a new IO Task
     Task& CreateIOTask(std::string task_name,
                        std::string agent_name,
@@ -78,6 +90,18 @@ class TaskManager {
     //! \brief Adds a dependency to a task
     void AddDependency(TaskId task_id, TaskId dependency_id);
 
+    //! \brief Adds a dependency between agent tasks of the same agent that
+    //! only holds for each agent.
+    void AddRangeDependency(std::string task_name,
+                            std::string dependency_name);
+
+    //! \brief Adds a dependency between agent tasks of the same agent that
+    //! only holds for each agent.
+    void AddRangeDependency(TaskId task_id, TaskId dependency_id);
+
+    //! \brief Returns true and the range dependency of a task if it has one
+    bool GetRangeDependency(TaskId task_id, TaskId* dependency_id) const;
+
     //! \brief Retrieves a set of dependencies for a given task
     IdSet& GetDependencies(TaskId task_id);
     //! \brief Retrieves a set of dependencies for a given task
@@ -120,9 +144,21 @@ class TaskManager {
     //! \brief Indicates that a specific task has been completed
     void IterTaskDone(TaskId task_id);
 
-    //! \brief Pops and returns a task that is ready for execution
+    //! \brief Indicates that a task has been assigned to a queue that
+    //! supports range dependencies, so tasks that are range dependent on it
+    //! can be made ready before it completes
+    void IterReleaseRangeDependents(TaskId task_id);
+
+    //! \brief Pops and returns the ready task with the highest priority
     TaskId IterTaskPop();
 
+    //! \brief Records the time taken by a run of a task (thread-safe)
+    void RecordTaskDuration(TaskId task_id, double seconds);
+
+    //! \brief Returns the smoothed measured run time of a task in seconds,
+    //! or a negative value if the task has not been timed yet
+    double GetTaskCost(TaskId task_id) const;
+
 
 #ifdef TESTBUILD
     //! \brief Delete all tasks
@@ -155,6 +191,14 @@ class TaskManager {
     //! \brief Returns the corresponding task id given a task name
     TaskId GetId(std::string task_name) const;
 
+    //! \brief Folds the run times of the last iteration into the task costs
+    //! and sets task priorities to their critical path lengths
+    void UpdatePriorities();
+
+    //! \brief Makes a pending task ready if it only waits on a range
+    //! dependency that has been released
+    void IterCheckRangeReady(TaskId task_id);
+
 #ifdef DEBUG
     //! \brief Determines whether the proposed dependency will create a cycle
     bool WillCauseCyclicDependency(TaskId task_id, TaskId dependency_id);
@@ -186,9 +230,21 @@ class TaskManager {
     //! Adjacency list representing the directed acyclic dependency graph
     std::vector<IdSet> children_;  // set of dependents for each node
 
+    //! \brief Range dependency of each task that has one
+    std::map<TaskId, TaskId> range_parents_;
+
     //! \brief Flag indicating whether Finalise() has been called
     bool finalised_;
 
+    //! \brief Mutex used to control access to task run times
+    boost::mutex mutex_timing_;
+
+    //! \brief Run time of each task during the current iteration
+    std::vector<double> iter_durations_;
+
+    //! \brief Smoothed run time of each task over previous iterations
+    std::vector<double> task_costs_;
+
     // ---- data used for managing task iteration -------
     //! \brief dependencies for pending tasks
     std::vector<IdSet> pending_deps_;
@@ -201,6 +257,12 @@ class TaskManager {
 
     //! \brief tasks that have been assigned but not completed
     IdSet assigned_tasks_;
+
+    //! \brief tasks whose range dependents can be made ready early
+    IdSet range_released_;
+
+    //! \brief tasks made ready before their range dependency completed
+    IdSet early_tasks_;
 };
 
 }}  // namespace flame::exe
@@ -29,6 +29,16 @@ class TaskQueue {
     //! Indicates that a task has been completed
     virtual void TaskDone(Task::id_type task_id) = 0;
 
+    //! Indicates that a task, or a subtask of a split task, has been
+    //! completed. Queues that track subtasks can override this.
+    virtual void SubtaskDone(Task::id_type task_id, const Task& /*task*/) {
+      TaskDone(task_id);
+    }
+
+    //! Returns true if the queue runs subtasks of range dependent tasks
+    //! as soon as the matching subtasks they depend on are done
+    virtual bool SupportsRangeDependencies() const { return false; }
+
     //! Waits for and returns the next available task
     virtual Task::id_type GetNextTask() = 0;
 
@@ -50,6 +60,12 @@ class TaskQueue {
     //! Returns minimum vector size after split
     virtual size_t GetMinVectorSize(void) const = 0;
 
+    //! Specify how agents are divided between split tasks
+    virtual void SetSplitPolicy(Task::SplitPolicy policy) = 0;
+
+    //! Returns how agents are divided between split tasks
+    virtual Task::SplitPolicy GetSplitPolicy(void) const = 0;
+
     //! Returns a task reference given a task id
     //! This usually forward the call to the TaskManager but it gives the queue
     //! an opportunity to intercept the call
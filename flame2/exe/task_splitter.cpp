@@ -8,13 +8,20 @@
  * \brief DESCRIPTION
  */
 #include "flame2/config.hpp"
+#include "flame2/exceptions/all.hpp"
 #include "task_splitter.hpp"
 
 namespace flame { namespace exe {
 
-//! Constructor
-TaskSplitter::TaskSplitter(Task::id_type id, const TaskVector& tasks)
-    : id_(id), running_(0), next_(0), tasks_(tasks) {
+/*!
+ * \brief Constructor
+ *
+ * If gated is true, subtasks are returned by GetTask() in the order they
+ * are released by Release() rather than in the order they are held.
+ */
+TaskSplitter::TaskSplitter(Task::id_type id, const TaskVector& tasks,
+                           bool gated)
+    : id_(id), running_(0), next_(0), tasks_(tasks), gated_(gated) {
   pending_ = tasks_.size();
 }
 
@@ -59,6 +66,18 @@ bool TaskSplitter::OneTaskDone(void) {
   return IsComplete();
 }
 
+/*!
+ * \brief Indicate that the subtask at the given index has been completed
+ * \return true if IsComplete()
+ *
+ * The index is recorded so that subtasks waiting on this one can be
+ * released (see GetDoneSubtasks()).
+ */
+bool TaskSplitter::OneTaskDone(size_t index) {
+  done_.push_back(index);
+  return OneTaskDone();
+}
+
 /*!
  * \brief Indicate that a task instance has been completed
  * \return true if NonePending()
@@ -80,12 +99,24 @@ bool TaskSplitter::OneTaskAssigned(void) {
  * \brief Returns reference to the next task
  *
  * Return a reference to a task within tasks_ indexed by next_. Then,
- * increments next_.
+ * increments next_. If the splitter is gated, the earliest released task
+ * that has not yet been returned is returned instead.
  *
  * Throws flame::exceptions::flame_exception if called after all tasks
- * have been returned.
+ * have been returned, or before a task of a gated splitter is released.
  */
 Task& TaskSplitter::GetTask() {
+  if (gated_) {
+#ifdef DEBUG
+    if (released_.empty()) {
+      throw flame::exceptions::flame_exception("None released");
+    }
+#endif
+    Task* t_ptr = tasks_[released_.front()].get();
+    released_.pop_front();
+    ++next_;
+    return *t_ptr;
+  }
 #ifdef DEBUG
   if (next_ >= tasks_.size()) {
     throw flame::exceptions::flame_exception("All taken");
@@ -96,8 +127,41 @@ Task& TaskSplitter::GetTask() {
 }
 
 //! Returns the number of subtasks generated by split
-size_t TaskSplitter::GetNumTasks(void) {
+size_t TaskSplitter::GetNumTasks(void) const {
   return tasks_.size();
 }
 
+//! Returns the subtask at the given index
+const Task& TaskSplitter::GetSubtask(size_t index) const {
+  return *tasks_.at(index);
+}
+
+/*!
+ * \brief Returns the index of a subtask
+ *
+ * Throws flame::exceptions::invalid_argument if the task is not one of the
+ * subtasks of this splitter.
+ */
+size_t TaskSplitter::GetSubtaskIndex(const Task& task) const {
+  for (size_t i = 0; i < tasks_.size(); ++i) {
+    if (tasks_[i].get() == &task) return i;
+  }
+  throw flame::exceptions::invalid_argument("Not a subtask");
+}
+
+/*!
+ * \brief Allows the subtask at the given index to be returned by GetTask()
+ *
+ * Only used by gated splitters, whose subtasks each wait on the matching
+ * subtask of another split task (see TaskManager::AddRangeDependency).
+ */
+void TaskSplitter::Release(size_t index) {
+#ifdef DEBUG
+  if (!gated_ || index >= tasks_.size()) {
+    throw flame::exceptions::flame_exception("Invalid release");
+  }
+#endif
+  released_.push_back(index);
+}
+
 }}  // namespace flame::exe
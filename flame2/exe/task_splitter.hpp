@@ -13,6 +13,7 @@
 #ifndef EXE__TASK_SPLITTER_HPP_
 #define EXE__TASK_SPLITTER_HPP_
 #include <vector>
+#include <deque>
 #include "task_interface.hpp"
 
 namespace flame { namespace exe {
@@ -20,7 +21,8 @@ namespace flame { namespace exe {
 class TaskSplitter {
   public:
     typedef std::vector<Task::Handle> TaskVector;
-    TaskSplitter(Task::id_type id, const TaskVector& tasks);
+    TaskSplitter(Task::id_type id, const TaskVector& tasks,
+                 bool gated = false);
 
     //! Returns true of no more pending or running tasks
     bool IsComplete(void) const;
@@ -34,11 +36,30 @@ class TaskSplitter {
     //! Decrements running_ and returns true if IsComplete()
     bool OneTaskDone(void);
 
+    //! Records the subtask at the given index as done and returns
+    //! OneTaskDone()
+    bool OneTaskDone(size_t index);
+
+    //! Returns the indices of completed subtasks in order of completion
+    const std::vector<size_t>& GetDoneSubtasks(void) const { return done_; }
+
     //! Returns reference to the next task and decrements next_
     Task& GetTask();
 
     //! Returns the number of subtasks generated by split
-    size_t GetNumTasks(void);
+    size_t GetNumTasks(void) const;
+
+    //! Returns the subtask at the given index
+    const Task& GetSubtask(size_t index) const;
+
+    //! Returns the index of a subtask
+    size_t GetSubtaskIndex(const Task& task) const;
+
+    //! Returns true if subtasks are only returned once released
+    bool IsGated(void) const { return gated_; }
+
+    //! Allows the subtask at the given index to be returned by GetTask()
+    void Release(size_t index);
 
   private:
     Task::id_type id_;  //! ID of the parent task
@@ -46,6 +67,9 @@ class TaskSplitter {
     size_t running_;  //! Number of running tasks (assigned but not done)
     size_t next_;  //! The next task to return from tasks_
     TaskVector tasks_;  //! Vector of task handles
+    bool gated_;  //! Flag indicating subtasks have to be released
+    std::deque<size_t> released_;  //! Released subtasks not yet returned
+    std::vector<size_t> done_;  //! Indices of subtasks recorded as done
 };
 
 }}  // namespace flame::exe
@@ -11,6 +11,8 @@
 #include <cstdlib>
 #include <boost/thread/mutex.hpp>
 #include "flame2/config.hpp"
+#include "profiler.hpp"
+#include "task_manager.hpp"
 #include "task_queue_interface.hpp"
 #include "worker_thread.hpp"
 namespace flame { namespace exe {
@@ -47,8 +49,8 @@ void WorkerThread::ProcessQueue() {
   Task::id_type task_id = tq_->GetNextTask();  // calls wait() if queue empty
 
   while (!Task::IsTermTask(task_id)) {
-    RunTask(task_id);
-    tq_->TaskDone(task_id);  // register completed task
+    Task& task = RunTask(task_id);
+    tq_->SubtaskDone(task_id, task);  // register completed task
     task_id = tq_->GetNextTask();  // calls wait() if queue empty
   }
   // #ifdef TESTBUILD
@@ -56,13 +58,17 @@ void WorkerThread::ProcessQueue() {
   // #endif
 }
 
-//! Runs a given task
-void WorkerThread::RunTask(Task::id_type task_id) {
-  // #ifdef TESTBUILD
-  //   std::cout << " - " << boost::this_thread::get_id()
-  //            << " running task " << task_id << std::endl;
-  // #endif
-  tq_->GetTaskById(task_id).Run();
+//! Runs a given task and records how long it took with the TaskManager
+//! and, if enabled, the Profiler
+Task& WorkerThread::RunTask(Task::id_type task_id) {
+  Task& task = tq_->GetTaskById(task_id);
+  boost::int64_t start = Profiler::Now();
+  task.Run();
+  boost::int64_t stop = Profiler::Now();
+  TaskManager::GetInstance().RecordTaskDuration(task_id,
+      static_cast<double>(stop - start) * 1e-6);
+  Profiler::GetInstance().RecordTask(task, task_id, start, stop);
+  return task;
 }
 
 }}  // namespace flame::exe
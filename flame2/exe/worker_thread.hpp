@@ -29,8 +29,8 @@ class WorkerThread {
     //! Business logic for the thread
     void ProcessQueue();
 
-    //! Runs a given task
-    void RunTask(Task::id_type task_id);
+    //! Runs a given task and returns the task or subtask that was run
+    Task& RunTask(Task::id_type task_id);
 
   private:
     boost::thread thread_;  //! Thread instance
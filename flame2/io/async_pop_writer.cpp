@@ -0,0 +1,112 @@
+/*!
+ * \file flame2/io/async_pop_writer.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief AsyncPopWriter: writes population snapshots in a background thread
+ */
+#include <exception>
+#include <string>
+#include <utility>
+#include "flame2/config.hpp"
+#include "flame2/exceptions/io.hpp"
+#include "async_pop_writer.hpp"
+
+namespace exc = flame::exceptions;
+
+namespace flame { namespace io {
+
+/*!
+ * \brief Constructor
+ * \param[in] max_pending Max number of snapshots held at any one time
+ *
+ * Starts the writer thread.
+ */
+AsyncPopWriter::AsyncPopWriter(size_t max_pending)
+    : max_pending_(max_pending), busy_(false), stop_(false) {
+  if (max_pending_ < 1) {
+    throw exc::invalid_argument("max_pending must be > 0");
+  }
+  thread_ = boost::thread(&AsyncPopWriter::ProcessQueue, this);
+}
+
+/*!
+ * \brief Destructor
+ *
+ * Signals the writer thread to end once all pending snapshots are written
+ * and waits for it to complete. Errors raised at this point are lost, call
+ * Flush() beforehand to have them reported.
+ */
+AsyncPopWriter::~AsyncPopWriter() {
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    stop_ = true;
+    cond_.notify_all();
+  }
+  thread_.join();
+}
+
+void AsyncPopWriter::Enqueue(PopSnapshotPtr snapshot, SnapshotWriter write) {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  CheckError();
+  while (queue_.size() + (busy_ ? 1 : 0) >= max_pending_) {
+    cond_.wait(lock);
+    CheckError();
+  }
+  queue_.push_back(std::make_pair(snapshot, write));
+  cond_.notify_all();
+}
+
+void AsyncPopWriter::Flush() {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (busy_ || !queue_.empty()) {
+    cond_.wait(lock);
+  }
+  CheckError();
+}
+
+void AsyncPopWriter::CheckError() {
+  if (!error_.empty()) {
+    std::string msg = error_;
+    error_.clear();
+    throw exc::flame_io_exception(msg);
+  }
+}
+
+/*!
+ * \brief Business logic for the writer thread
+ *
+ * Writes snapshots until signalled to stop and the queue has been drained.
+ * The mutex is released while a snapshot is being serialised.
+ */
+void AsyncPopWriter::ProcessQueue() {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (true) {
+    while (queue_.empty() && !stop_) {
+      cond_.wait(lock);
+    }
+    if (queue_.empty()) break;  // stop_ set and nothing left to write
+
+    PendingOutput output = queue_.front();
+    queue_.pop_front();
+    busy_ = true;
+    lock.unlock();
+
+    std::string error;
+    try {
+      output.second(output.first.get());
+    } catch(const std::exception& E) {
+      error = E.what();
+    }
+    output.first.reset();  // release memory before taking the lock
+
+    lock.lock();
+    busy_ = false;
+    if (!error.empty() && error_.empty()) error_ = error;
+    cond_.notify_all();
+  }
+}
+
+}}  // namespace flame::io
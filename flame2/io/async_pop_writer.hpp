@@ -0,0 +1,73 @@
+/*!
+ * \file flame2/io/async_pop_writer.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief AsyncPopWriter: writes population snapshots in a background thread
+ */
+#ifndef IO__ASYNC_POP_WRITER_HPP_
+#define IO__ASYNC_POP_WRITER_HPP_
+#include <deque>
+#include <string>
+#include <utility>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "pop_snapshot.hpp"
+
+namespace flame { namespace io {
+
+/*!
+ * \brief Writes population snapshots in a background thread
+ *
+ * Snapshots are serialised in the order they were enqueued, each by the
+ * writer it was enqueued with. At most
+ * max_pending snapshots are held at any one time; Enqueue() blocks when the
+ * limit is reached so memory use stays bounded when output is slower than
+ * the simulation.
+ *
+ * Errors raised by the writer thread are reported as
+ * flame::exceptions::flame_io_exception by the next call to Enqueue() or
+ * Flush().
+ */
+class AsyncPopWriter {
+  public:
+    //! Function used to serialise a snapshot
+    typedef boost::function<void (PopSnapshot*)> SnapshotWriter;
+
+    explicit AsyncPopWriter(size_t max_pending);
+    ~AsyncPopWriter();
+
+    //! Hands a snapshot over to the writer thread
+    void Enqueue(PopSnapshotPtr snapshot, SnapshotWriter write);
+
+    //! Blocks until all enqueued snapshots have been written
+    void Flush();
+
+  private:
+    typedef std::pair<PopSnapshotPtr, SnapshotWriter> PendingOutput;
+
+    size_t max_pending_;  //! Max number of snapshots held
+    std::deque<PendingOutput> queue_;  //! Snapshots waiting to be written
+    bool busy_;  //! Writer thread is serialising a snapshot
+    bool stop_;  //! Writer thread should end once queue is empty
+    std::string error_;  //! Error message from writer thread
+    boost::mutex mutex_;  //! Mutex guarding the members above
+    boost::condition_variable cond_;  //! Signals changes in queue state
+    boost::thread thread_;  //! Writer thread
+
+    //! Business logic for the writer thread
+    void ProcessQueue();
+
+    //! Throws pending errors from the writer thread. Mutex must be held.
+    void CheckError();
+
+    AsyncPopWriter(const AsyncPopWriter&);  //! Disable copy ctor
+    void operator=(const AsyncPopWriter&);  //! Disable assignment
+};
+
+}}  // namespace flame::io
+#endif  // IO__ASYNC_POP_WRITER_HPP_
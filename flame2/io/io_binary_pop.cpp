@@ -0,0 +1,502 @@
+/*!
+ * \file flame2/io/io_binary_pop.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief IOBinaryPop: reading and writing of binary population files
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include "flame2/config.hpp"
+#include "flame2/mem/memory_manager.hpp"
+#include "flame2/mem/data_type.hpp"
+#include "flame2/exceptions/io.hpp"
+#include "mapped_file.hpp"
+#include "io_binary_pop.hpp"
+
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+
+namespace mem = flame::mem;
+namespace exc = flame::exceptions;
+
+namespace flame { namespace io { namespace binary {
+
+const size_t IOBinaryPop::kBlockAlignment;
+
+//! Magic number at the start of every binary population file
+static const char kMagic[8] = {'F', 'L', 'A', 'M', 'E', 'P', 'O', 'P'};
+//! Written in native byte order to detect files from other machines
+static const boost::uint32_t kByteOrderMark = 0x01020304;
+//! Version of the file layout, version 2 added the header flags
+static const boost::uint32_t kVersion = 2;
+//! Header flag of files only holding variables written by agent functions
+static const boost::uint64_t kDeltaFlag = 1;
+//! Size of magic number, byte order mark, version and header size
+static const size_t kPrefixSize = 24;
+
+//! A memory column to be written out
+struct BinaryColumn {
+  BinaryColumn(const std::string& n, mem::VectorWrapperBase* v)
+      : name(n), vec(v) {}
+  std::string name;
+  mem::VectorWrapperBase* vec;
+};
+
+//! The memory columns of an agent type to be written out
+struct BinaryAgent {
+  explicit BinaryAgent(const std::string& n) : name(n), size(0) {}
+  std::string name;
+  size_t size;
+  std::vector<BinaryColumn> columns;
+};
+
+//! Closes a file descriptor when going out of scope
+class FileDescriptor {
+  public:
+    explicit FileDescriptor(int fd) : fd_(fd) {}
+    ~FileDescriptor() { if (fd_ >= 0) close(fd_); }
+    int get() const { return fd_; }
+    //! Closes the file, returns false on error
+    bool Close() {
+      int fd = fd_;
+      fd_ = -1;
+      return close(fd) == 0;
+    }
+  private:
+    int fd_;
+    FileDescriptor(const FileDescriptor&);
+    void operator=(const FileDescriptor&);
+};
+
+static size_t alignOffset(size_t offset) {
+  size_t rem = offset % IOBinaryPop::kBlockAlignment;
+  return (rem == 0) ? offset : offset + IOBinaryPop::kBlockAlignment - rem;
+}
+
+static void putU64(std::string * buffer, boost::uint64_t value) {
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void putString(std::string * buffer, const std::string& value) {
+  putU64(buffer, value.size());
+  buffer->append(value);
+}
+
+/*!
+ * \brief Writes all buffers to a file
+ *
+ * Buffers are handed to writev() in as few calls as possible, advancing
+ * over partially written buffers.
+ */
+static void writeBuffers(int fd, std::vector<struct iovec> * iov) {
+  size_t first = 0;
+  while (first < iov->size()) {
+    size_t count = iov->size() - first;
+    if (count > IOV_MAX) count = IOV_MAX;
+    ssize_t n = writev(fd, &(*iov)[first], static_cast<int>(count));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      throw exc::flame_io_exception("Could not write binary pop file");
+    }
+    size_t written = static_cast<size_t>(n);
+    while (first < iov->size() && written >= (*iov)[first].iov_len) {
+      written -= (*iov)[first].iov_len;
+      ++first;
+    }
+    if (written > 0) {
+      (*iov)[first].iov_base = static_cast<char*>((*iov)[first].iov_base)
+          + written;
+      (*iov)[first].iov_len -= written;
+    }
+  }
+}
+
+/*!
+ * \brief Writes memory columns to a binary population file
+ *
+ * The header is assembled in memory and written together with the columns,
+ * which are passed to writev() straight from agent memory. The file is
+ * written under a temporary name and renamed once complete so an existing
+ * checkpoint is never left half written.
+ */
+static void writePopFile(const std::string& file_name, size_t iteration,
+    bool delta, std::vector<BinaryAgent> * agents) {
+  static const char padding[IOBinaryPop::kBlockAlignment] = {0};
+  std::vector<BinaryAgent>::iterator a;
+  std::vector<BinaryColumn>::iterator c;
+  std::vector<size_t> offset_pos;
+  std::string header;
+
+  // header with placeholders for the column offsets
+  header.append(kMagic, sizeof(kMagic));
+  header.append(reinterpret_cast<const char*>(&kByteOrderMark),
+      sizeof(kByteOrderMark));
+  header.append(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+  putU64(&header, 0);
+  putU64(&header, iteration);
+  putU64(&header, delta ? kDeltaFlag : 0);
+  putU64(&header, agents->size());
+  for (a = agents->begin(); a != agents->end(); ++a) {
+    putString(&header, (*a).name);
+    putU64(&header, (*a).size);
+    putU64(&header, (*a).columns.size());
+    for (c = (*a).columns.begin(); c != (*a).columns.end(); ++c) {
+      const mem::DataTypeBase* type = mem::DataTypeRegistry::GetInstance().
+          GetTypeByDataType(*((*c).vec->GetDataType()));
+      if (type == 0)
+        throw exc::flame_io_exception(std::string("Variable ").append(
+            (*c).name).append(" has no registered data type"));
+      putString(&header, (*c).name);
+      putString(&header, type->get_name());
+      putU64(&header, (*c).vec->stride());
+      putU64(&header, (*c).vec->element_size());
+      offset_pos.push_back(header.size());
+      putU64(&header, 0);
+    }
+  }
+  boost::uint64_t value = header.size();
+  memcpy(&header[kPrefixSize - sizeof(value)], &value, sizeof(value));
+
+  // lay out the column blocks after the header
+  std::vector<struct iovec> iov;
+  struct iovec v;
+  v.iov_base = &header[0];
+  v.iov_len = header.size();
+  iov.push_back(v);
+  size_t offset = header.size();
+  size_t ii = 0;
+  for (a = agents->begin(); a != agents->end(); ++a) {
+    for (c = (*a).columns.begin(); c != (*a).columns.end(); ++c, ++ii) {
+      size_t start = alignOffset(offset);
+      size_t bytes = (*a).size * (*c).vec->stride() * (*c).vec->element_size();
+      if (start > offset) {
+        v.iov_base = const_cast<char*>(padding);
+        v.iov_len = start - offset;
+        iov.push_back(v);
+      }
+      if (bytes > 0) {
+        v.iov_base = (*c).vec->GetRawPtr(0);
+        v.iov_len = bytes;
+        iov.push_back(v);
+      }
+      value = start;
+      memcpy(&header[offset_pos[ii]], &value, sizeof(value));
+      offset = start + bytes;
+    }
+  }
+
+#ifndef TESTBUILD
+  printf("Writing file: %s\n", file_name.c_str());
+#endif
+
+  std::string tmp_name = file_name + ".tmp";
+  FileDescriptor fd(open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+      0644));
+  if (fd.get() < 0)
+    throw exc::flame_io_exception("Could not open binary population "
+                                  "file for writing");
+  try {
+    writeBuffers(fd.get(), &iov);
+  } catch(...) {
+    fd.Close();
+    remove(tmp_name.c_str());
+    throw;
+  }
+  if (!fd.Close() || rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+    remove(tmp_name.c_str());
+    throw exc::flame_io_exception("Could not write binary pop file");
+  }
+}
+
+/*!
+ * \brief Reads n bytes at offset from a file
+ * \return False if the file ended before n bytes were read
+ */
+static bool readAt(int fd, void * ptr, size_t n, size_t offset) {
+  char * p = static_cast<char*>(ptr);
+  while (n > 0) {
+    ssize_t r = pread(fd, p, n, static_cast<off_t>(offset));
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      throw exc::flame_io_exception("Could not read binary pop file");
+    }
+    if (r == 0) return false;
+    p += r;
+    n -= static_cast<size_t>(r);
+    offset += static_cast<size_t>(r);
+  }
+  return true;
+}
+
+//! Reads values from the header of a binary population file
+class HeaderReader {
+  public:
+    HeaderReader(const char * begin, const char * end)
+        : p_(begin), end_(end) {}
+
+    boost::uint64_t GetU64() {
+      boost::uint64_t value;
+      Get(&value, sizeof(value));
+      return value;
+    }
+
+    std::string GetString() {
+      boost::uint64_t size = GetU64();
+      if (size > static_cast<boost::uint64_t>(end_ - p_)) Truncated();
+      std::string value(p_, static_cast<size_t>(size));
+      p_ += size;
+      return value;
+    }
+
+  private:
+    const char * p_;
+    const char * end_;
+
+    void Get(void * value, size_t size) {
+      if (size > static_cast<size_t>(end_ - p_)) Truncated();
+      memcpy(value, p_, size);
+      p_ += size;
+    }
+
+    static void Truncated() {
+      throw exc::unparseable_file("Binary pop file header is truncated");
+    }
+};
+
+//! A column of a binary population file matched to agent memory
+struct ColumnBlock {
+  mem::VectorWrapperBase* vec;
+  size_t size;
+  size_t offset;
+};
+
+IOBinaryPop::IOBinaryPop()
+    : pop_path_is_set_(false), iteration_(0), mapped_(true) {}
+
+bool IOBinaryPop::isBinaryPopFile(std::string const& file_name) {
+  char magic[sizeof(kMagic)];
+  FileDescriptor fd(open(file_name.c_str(), O_RDONLY));
+  if (fd.get() < 0) return false;
+  return readAt(fd.get(), magic, sizeof(magic), 0) &&
+      memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+/*!
+ * \brief Reads a binary population file into agent memory
+ *
+ * The file is memory mapped, or read into a buffer if it cannot be mapped,
+ * the header is parsed in place and each column is appended to agent memory
+ * with a single copy from the mapped region.
+ * The whole header is checked against agent memory before any data is
+ * copied so a mismatching file leaves agent memory untouched. Agents are
+ * appended to any existing population.
+ */
+void IOBinaryPop::readPop(std::string file_name) {
+  mem::MemoryManager& mm = mem::MemoryManager::GetInstance();
+  std::vector<ColumnBlock> blocks;
+  std::set<std::string> agents_read;
+  boost::uint32_t bom, version;
+  boost::uint64_t header_size;
+
+  MappedFile file(file_name, mapped_);
+  const char * data = file.data();
+  size_t file_size = file.size();
+
+#ifndef TESTBUILD
+  printf("Reading file: %s\n", file_name.c_str());
+#endif
+
+  if (file_size < kPrefixSize || memcmp(data, kMagic, sizeof(kMagic)) != 0)
+    throw exc::invalid_pop_file("Not a binary pop file");
+  memcpy(&bom, data + 8, sizeof(bom));
+  memcpy(&version, data + 12, sizeof(version));
+  memcpy(&header_size, data + 16, sizeof(header_size));
+  if (bom != kByteOrderMark)
+    throw exc::invalid_pop_file("Binary pop file has a different byte order");
+  if (version != 1 && version != kVersion)
+    throw exc::invalid_pop_file("Unsupported binary pop file version");
+  if (header_size < kPrefixSize || header_size > file_size)
+    throw exc::unparseable_file("Binary pop file header is truncated");
+  HeaderReader reader(data + kPrefixSize,
+      data + static_cast<size_t>(header_size));
+
+  reader.GetU64();  // iteration
+  if (version > 1 && (reader.GetU64() & kDeltaFlag) != 0)
+    throw exc::invalid_pop_file(
+        "Delta pop files only hold written variables and cannot be read");
+  boost::uint64_t agent_count = reader.GetU64();
+  for (boost::uint64_t ii = 0; ii < agent_count; ++ii) {
+    std::string agent_name = reader.GetString();
+    boost::uint64_t size = reader.GetU64();
+    boost::uint64_t var_count = reader.GetU64();
+    if (!mm.IsRegisteredAgent(agent_name))
+      throw exc::invalid_pop_file(
+          std::string("Unknown agent in binary pop file: ") + agent_name);
+    if (!agents_read.insert(agent_name).second)
+      throw exc::invalid_pop_file(
+          std::string("Agent repeated in binary pop file: ") + agent_name);
+
+    const std::vector<std::string>& var_names = mm.GetVarNames(agent_name);
+    std::set<std::string> vars_read;
+    for (boost::uint64_t jj = 0; jj < var_count; ++jj) {
+      std::string var_name = reader.GetString();
+      std::string type_name = reader.GetString();
+      boost::uint64_t stride = reader.GetU64();
+      boost::uint64_t element_size = reader.GetU64();
+      boost::uint64_t offset = reader.GetU64();
+      std::string var = agent_name + "." + var_name;
+
+      std::vector<std::string>::const_iterator it;
+      for (it = var_names.begin(); it != var_names.end(); ++it)
+        if (*it == var_name) break;
+      if (it == var_names.end() || !vars_read.insert(var_name).second)
+        throw exc::invalid_pop_file(
+            std::string("Unknown variable in binary pop file: ") + var);
+      mem::VectorWrapperBase* vec = mm.GetVectorWrapper(agent_name,
+          static_cast<size_t>(it - var_names.begin()));
+      const mem::DataTypeBase* type =
+          mem::DataTypeRegistry::GetInstance().GetType(type_name);
+      if (type == 0 || *(type->GetDataType()) != *(vec->GetDataType()) ||
+          element_size != vec->element_size() || stride != vec->stride())
+        throw exc::invalid_pop_file(
+            std::string("Mismatching variable type in binary pop file: ") +
+            var);
+      if (offset > file_size ||
+          (size > 0 && (file_size - offset) / size / stride / element_size
+              < 1))
+        throw exc::unparseable_file(
+            std::string("Binary pop file is truncated: ") + var);
+      // columns are read in place as typed values, the writer aligns them
+      if (offset % element_size != 0)
+        throw exc::unparseable_file(
+            std::string("Misaligned column in binary pop file: ") + var);
+
+      ColumnBlock block;
+      block.vec = vec;
+      block.size = static_cast<size_t>(size);
+      block.offset = static_cast<size_t>(offset);
+      blocks.push_back(block);
+    }
+    if (vars_read.size() != var_names.size())
+      throw exc::invalid_pop_file(
+          std::string("Missing variables in binary pop file for agent: ") +
+          agent_name);
+  }
+
+  // copy each column from the mapped file straight into agent memory
+  std::vector<ColumnBlock>::iterator b;
+  for (b = blocks.begin(); b != blocks.end(); ++b) {
+    if ((*b).size > 0) (*b).vec->AppendRaw(data + (*b).offset, (*b).size);
+  }
+}
+
+void IOBinaryPop::setMappedInput(bool mapped) {
+  mapped_ = mapped;
+}
+
+std::string IOBinaryPop::outputFileName() {
+  /* Check a path has been set */
+  if (!popPathIsSet()) {
+    throw exc::flame_io_exception("Path not set");
+  }
+  std::string file_name = pop_path_;
+  file_name.append(boost::lexical_cast<std::string>(iteration_));
+  file_name.append(".bin");
+  return file_name;
+}
+
+void IOBinaryPop::finaliseData() {
+  mem::MemoryManager& mm = mem::MemoryManager::GetInstance();
+  std::string file_name = outputFileName();
+  std::vector<BinaryAgent> agents;
+  std::vector<std::string> agent_names = mm.GetAgentNames();
+  std::vector<std::string>::iterator a;
+  for (a = agent_names.begin(); a != agent_names.end(); ++a) {
+    agents.push_back(BinaryAgent(*a));
+    BinaryAgent& agent = agents.back();
+    const std::vector<std::string>& var_names = mm.GetVarNames(*a);
+    for (size_t ii = 0; ii < var_names.size(); ++ii) {
+      mem::VectorWrapperBase* vec = mm.GetVectorWrapper(*a, ii);
+      agent.columns.push_back(BinaryColumn(var_names[ii], vec));
+      agent.size = vec->size();
+    }
+  }
+  writePopFile(file_name, iteration_, false, &agents);
+}
+
+/*!
+ * \brief Takes a copy of all agent memory to be written out
+ *
+ * The snapshot is self contained so it can be written out by
+ * writeSnapshot() in a different thread while agent memory is modified.
+ */
+PopSnapshotPtr IOBinaryPop::createSnapshot(const WrittenVariables * written) {
+  mem::MemoryManager& mm = mem::MemoryManager::GetInstance();
+  PopSnapshotPtr snapshot(new PopSnapshot(outputFileName(), iteration_));
+  snapshot->set_delta(written != 0);
+  std::vector<std::string> agent_names = mm.GetAgentNames();
+  std::vector<std::string>::iterator a;
+  for (a = agent_names.begin(); a != agent_names.end(); ++a) {
+    if (written)
+      snapshot->AddAgent(*a, mm.GetVarNames(*a), *written);
+    else
+      snapshot->AddAgent(*a, mm.GetVarNames(*a));
+  }
+  return snapshot;
+}
+
+void IOBinaryPop::writeSnapshot(PopSnapshot * snapshot) {
+  std::vector<BinaryAgent> agents;
+  PopSnapshot::AgentVector::iterator a;
+  for (a = snapshot->get_agents().begin();
+      a != snapshot->get_agents().end(); ++a) {
+    agents.push_back(BinaryAgent((*a).get_agent_name()));
+    agents.back().size = (*a).get_size();
+    for (size_t ii = 0; ii < (*a).get_var_names().size(); ++ii) {
+      agents.back().columns.push_back(BinaryColumn((*a).get_var_names()[ii],
+          &((*a).get_columns()[ii])));
+    }
+  }
+  writePopFile(snapshot->get_file_name(), snapshot->get_iteration(),
+      snapshot->is_delta(), &agents);
+}
+
+bool IOBinaryPop::popPathIsSet() {
+  return pop_path_is_set_;
+}
+
+std::string IOBinaryPop::popPath() {
+  return pop_path_;
+}
+
+void IOBinaryPop::setPopPath(std::string path) {
+  /* Set the pop path to the directory of the opened file.
+   * This path is then used as the root directory to write pop to. */
+  boost::filesystem::path p(path);
+  pop_path_ = p.parent_path().string();
+  if (pop_path_ != "")
+    pop_path_.append("/");
+  pop_path_is_set_ = true;
+}
+
+void IOBinaryPop::setIteration(size_t i) {
+  iteration_ = i;
+}
+
+}}}  // namespace flame::io::binary
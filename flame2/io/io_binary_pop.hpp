@@ -0,0 +1,76 @@
+/*!
+ * \file flame2/io/io_binary_pop.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief IOBinaryPop: reading and writing of binary population files
+ */
+#ifndef IO__IO_BINARY_POP_HPP_
+#define IO__IO_BINARY_POP_HPP_
+#include <string>
+#include "output_backend.hpp"
+#include "pop_snapshot.hpp"
+
+namespace flame { namespace io { namespace binary {
+
+/*!
+ * \brief Reads and writes populations in a binary columnar format
+ *
+ * A binary population file holds a header describing every agent type and
+ * its memory variables followed by the raw contents of each memory column.
+ * Columns are written and read in single blocks straight from and into
+ * agent memory so no values are converted. Files are only portable between
+ * machines with the same byte order and type sizes, which is checked when
+ * they are read. Delta output, which only holds written variables, is
+ * rejected when read.
+ *
+ * File layout, all integers are uint64 unless stated otherwise:
+ *   - magic "FLAMEPOP", uint32 byte order mark, uint32 version,
+ *     header size in bytes
+ *   - iteration, flags (from version 2, bit 0 set if the file only holds
+ *     variables written by agent functions), number of agent types
+ *   - for each agent type: name, population size, number of variables
+ *     - for each variable: name, data type name, stride, element size,
+ *       offset of the column in the file
+ *   - column blocks, each aligned to kBlockAlignment bytes
+ *
+ * Strings are stored as their length followed by the characters.
+ */
+class IOBinaryPop : public OutputBackend {
+  public:
+    IOBinaryPop();
+    //! Checks if a file starts with the binary population magic number
+    static bool isBinaryPopFile(std::string const& file_name);
+    //! Reads a binary population file into agent memory
+    void readPop(std::string file_name);
+    //! Reads files through a memory mapping, or into a buffer if false as
+    //! when the file cannot be mapped
+    void setMappedInput(bool mapped);
+    //! Writes all agent memory straight from the memory columns
+    void finaliseData();
+    //! Takes a copy of all agent memory, or if written is given of the
+    //! variables written by agent functions only
+    PopSnapshotPtr createSnapshot(const WrittenVariables * written = 0);
+    void writeSnapshot(PopSnapshot * snapshot);
+    bool popPathIsSet();
+    std::string popPath();
+    void setPopPath(std::string path);
+    void setIteration(size_t i);
+    //! Returns the name of the file output of the current iteration is
+    //! written to
+    std::string outputFileName();
+
+    //! Alignment of column blocks within the file
+    static const size_t kBlockAlignment = 64;
+
+  private:
+    std::string pop_path_;  //! Directory population files are written to
+    bool pop_path_is_set_;  //! Output directory has been set
+    size_t iteration_;  //! Current iteration number
+    bool mapped_;  //! Read files through a memory mapping
+};
+
+}}}  // namespace flame::io::binary
+#endif  // IO__IO_BINARY_POP_HPP_
@@ -8,7 +8,9 @@
  * \brief IOManager: management for I/O Backend
  */
 #include <string>
+#include <boost/bind.hpp>
 #include "flame2/config.hpp"
+#include "flame2/mem/memory_manager.hpp"
 #include "io_manager.hpp"
 
 namespace flame { namespace io {
@@ -20,56 +22,249 @@ void IOManager::loadModel(std::string const& file,
   ioxmlmodel.readXMLModel(file, model);
 }
 
-int removeFile(std::string file) {
-  if (remove(file.c_str()) != 0) {
-    fprintf(stderr, "Warning: Could not delete the file: %s\n", file.c_str());
-    return 1;
-  } else {
-#ifndef TESTBUILD
-    printf("Removing file: %s\n", file.c_str());
-#endif
-  }
-
-  return 0;
-}
-
 void IOManager::readPop(std::string file_name,
     model::XModel * model,
     FileType fileType) {
-  std::string xmlpopxsd;
+  /* Output is written to the pop location in either format */
+  ioxmlpop.setXmlPopPath(file_name);
+  iobinarypop.setPopPath(file_name);
+  iotimeseries.setPopPath(file_name);
 
   if (fileType == xml) {
-    /* Set path to xml pop location */
-    ioxmlpop.setXmlPopPath(file_name);
-    /* Validate xml first */
-    xmlpopxsd = std::string(ioxmlpop.xmlPopPath()).append("xmlpop.xsd");
-    /* Create data schema */
-    ioxmlpop.createDataSchema(xmlpopxsd, model);
-    /* Validate data using schema */
-    ioxmlpop.validateData(file_name, xmlpopxsd);
-    removeFile(xmlpopxsd);
-    /* Read validated pop xml */
+    /* Read pop xml, validating it while it is read */
     ioxmlpop.readPop(file_name, model);
+  } else if (fileType == binary) {
+    iobinarypop.readPop(file_name);
+    /* Agent variables written to pop xml are taken from the model */
+    ioxmlpop.saveAgentVariableData(model);
   } else {
     throw exc::flame_io_exception("unknown file type");
   }
+
+  /* Write buffers of double-buffered vars start as a copy of the pop */
+  flame::mem::MemoryManager::GetInstance().ResetBuffers();
+  fullOutputWritten_ = false;
+  columns_.clear();
+}
+
+IOManager::FileType IOManager::getFileType(std::string const& file_name) {
+  return binary::IOBinaryPop::isBinaryPopFile(file_name) ? binary : xml;
 }
 
+bool IOManager::isOutputIteration() const {
+  return iteration_ % outputFrequency_ == 0;
+}
+
+/*!
+ * \brief Checks if a memory variable holds a variable in written
+ *
+ * Members of data type variables are held in memory variables named
+ * after the model variable, e.g. pos.x. A NULL written set holds every
+ * variable.
+ */
+bool IOManager::isWritten(const WrittenVariables * written,
+    const std::string& agent_name, const std::string& var_name) const {
+  if (written == 0) return true;
+  WrittenVariables::const_iterator w = written->find(agent_name);
+  return w != written->end() &&
+      (*w).second.count(var_name.substr(0, var_name.find('.'))) > 0;
+}
+
+/*!
+ * \brief Copies the columns holding an agent variable for output
+ *
+ * Output tasks run as soon as the last writer of their variable has
+ * finished, so columns are copied while the rest of the iteration is still
+ * running rather than all at once by finaliseData(). A data type variable
+ * is held in one column per member.
+ */
 void IOManager::writePop(std::string agent_name, std::string var_name) {
-  ioxmlpop.writePop(agent_name, var_name);
+  flame::mem::MemoryManager& mm = flame::mem::MemoryManager::GetInstance();
+  const std::vector<std::string>& var_names = mm.GetVarNames(agent_name);
+  std::vector<size_t> var_ids;
+  for (size_t ii = 0; ii < var_names.size(); ++ii) {
+    const std::string& name = var_names[ii];
+    if (name == var_name || (name.size() > var_name.size() &&
+        name.compare(0, var_name.size(), var_name) == 0 &&
+        name[var_name.size()] == '.')) var_ids.push_back(ii);
+  }
+  if (var_ids.empty())
+    throw exc::invalid_variable("unknown memory variable name");
+
+  if (!isOutputIteration() || (deltaOutput_ && fullOutputWritten_ &&
+      !isWritten(&writtenVars_, agent_name, var_name))) return;
+
+  /* Copy outside the lock so output tasks can copy concurrently */
+  boost::ptr_vector<flame::mem::VectorWrapperBase> copies;
+  for (size_t ii = 0; ii < var_ids.size(); ++ii)
+    copies.push_back(mm.GetVectorWrapper(agent_name, var_ids[ii])->clone());
+
+  boost::lock_guard<boost::mutex> lock(columns_mutex_);
+  for (size_t ii = copies.size(); ii > 0; --ii) {
+    std::pair<std::string, std::string> key(agent_name,
+        var_names[var_ids[ii - 1]]);
+    columns_.erase(key);
+    columns_.insert(key, copies.pop_back().release());
+  }
 }
 
 void IOManager::initialiseData() {
   ioxmlpop.initialiseData();
 }
 
+OutputBackend * IOManager::outputBackend() {
+  if (backend_) return backend_;
+  if (outputType_ == binary) return &iobinarypop;
+  if (outputType_ == timeseries) return &iotimeseries;
+  return &ioxmlpop;
+}
+
+OutputBackend * IOManager::timeSeriesBackend() {
+  if (!timeSeriesOutput_ || outputBackend() == &iotimeseries) return 0;
+  return &iotimeseries;
+}
+
+/*!
+ * \brief Builds the snapshot of the current iteration
+ *
+ * Takes the columns copied by writePop() and copies any other column to
+ * be written from agent memory. Agents and variables are kept in memory
+ * manager order so output does not depend on the order tasks ran in.
+ */
+PopSnapshotPtr IOManager::completeSnapshot(const WrittenVariables * written) {
+  flame::mem::MemoryManager& mm = flame::mem::MemoryManager::GetInstance();
+  PopSnapshotPtr snapshot(new PopSnapshot(outputBackend()->outputFileName(),
+      iteration_));
+  snapshot->set_delta(written != 0);
+  boost::lock_guard<boost::mutex> lock(columns_mutex_);
+  std::vector<std::string> agent_names = mm.GetAgentNames();
+  std::vector<std::string>::iterator a;
+  for (a = agent_names.begin(); a != agent_names.end(); ++a) {
+    const std::vector<std::string>& var_names = mm.GetVarNames(*a);
+    AgentSnapshot * agent = 0;
+    for (size_t ii = 0; ii < var_names.size(); ++ii) {
+      if (!isWritten(written, *a, var_names[ii])) continue;
+      if (agent == 0) {
+        agent = new AgentSnapshot(*a);
+        snapshot->AddAgentSnapshot(agent);
+      }
+      ColumnMap::iterator c = columns_.find(std::make_pair(*a, var_names[ii]));
+      if (c != columns_.end())
+        agent->AddColumn(var_names[ii], columns_.release(c).release());
+      else
+        agent->AddColumn(var_names[ii], mm.GetVectorWrapper(*a, ii)->clone());
+    }
+  }
+  columns_.clear();
+  return snapshot;
+}
+
+/*!
+ * \brief Writes out the population
+ *
+ * Output is only written every outputFrequency_ iterations. In delta mode
+ * every output after the first one only holds the variables written by
+ * agent functions.
+ *
+ * Columns already copied by output tasks are taken as they are. If output
+ * is asynchronous the snapshot is handed over to the background writer so
+ * the simulation can proceed while it is written. Time series, if enabled,
+ * are written from the same snapshot.
+ */
 void IOManager::finaliseData() {
-  ioxmlpop.finaliseData();
+  if (!isOutputIteration()) return;
+  const WrittenVariables * written =
+      (deltaOutput_ && fullOutputWritten_) ? &writtenVars_ : 0;
+  fullOutputWritten_ = true;
+
+  bool copied;
+  {
+    boost::lock_guard<boost::mutex> lock(columns_mutex_);
+    copied = !columns_.empty();
+  }
+
+  OutputBackend * backend = outputBackend();
+  OutputBackend * series = timeSeriesBackend();
+  if (writer_) {
+    PopSnapshotPtr snapshot = completeSnapshot(written);
+    writer_->Enqueue(snapshot, boost::bind(
+        &OutputBackend::writeSnapshot, backend, _1));
+    if (series) writer_->Enqueue(snapshot, boost::bind(
+        &OutputBackend::writeSnapshot, series, _1));
+  } else if (written || copied) {
+    PopSnapshotPtr snapshot = completeSnapshot(written);
+    backend->writeSnapshot(snapshot.get());
+    if (series) series->writeSnapshot(snapshot.get());
+  } else {
+    /* Nothing copied yet, write straight from agent memory */
+    backend->finaliseData();
+    if (series) series->finaliseData();
+  }
 }
 
 void IOManager::setIteration(size_t i) {
   iteration_ = i;
+  /* Drop columns copied for output that was never finalised */
+  {
+    boost::lock_guard<boost::mutex> lock(columns_mutex_);
+    columns_.clear();
+  }
   ioxmlpop.setIteration(i);
+  iobinarypop.setIteration(i);
+  iotimeseries.setIteration(i);
+  if (backend_) backend_->setIteration(i);
+}
+
+void IOManager::setOutputType(FileType fileType) {
+  if (fileType != xml && fileType != binary && fileType != timeseries)
+    throw exc::flame_io_exception("unknown file type");
+  outputType_ = fileType;
+}
+
+void IOManager::setOutputBackend(OutputBackend * backend) {
+  /* Pending output may still use the current backend */
+  flushOutput();
+  backend_ = backend;
+  if (backend_) backend_->setIteration(iteration_);
+}
+
+void IOManager::setTimeSeriesOutput(bool enable) {
+  /* Pending output may still use the time series backend */
+  flushOutput();
+  timeSeriesOutput_ = enable;
+}
+
+void IOManager::setAsynchronousOutput(bool async, size_t max_pending) {
+  if (writer_) {  // flush and end current writer
+    boost::scoped_ptr<AsyncPopWriter> writer;
+    writer.swap(writer_);
+    writer->Flush();
+  }
+  if (async) {
+    writer_.reset(new AsyncPopWriter(max_pending));
+  }
+}
+
+void IOManager::flushOutput() {
+  if (writer_) writer_->Flush();
+}
+
+void IOManager::setOutputFrequency(size_t n) {
+  if (n < 1)
+    throw exc::flame_io_exception("output frequency must be at least 1");
+  outputFrequency_ = n;
+}
+
+void IOManager::setOutputCompression(int level) {
+  ioxmlpop.setCompression(level);
+}
+
+void IOManager::setDeltaOutput(bool delta) {
+  deltaOutput_ = delta;
+}
+
+void IOManager::setWrittenVariables(const WrittenVariables& vars) {
+  writtenVars_ = vars;
 }
 
 }}  // namespace flame::io
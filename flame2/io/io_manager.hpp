@@ -11,16 +11,25 @@
 #define IO__IO_MANAGER_HPP_
 #include <string>
 #include <vector>
+#include <utility>
+#include <boost/ptr_container/ptr_map.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include "flame2/model/xmodel.hpp"
 #include "flame2/exceptions/io.hpp"
 #include "io_xml_model.hpp"
 #include "io_xml_pop.hpp"
+#include "io_binary_pop.hpp"
+#include "io_timeseries.hpp"
+#include "output_backend.hpp"
+#include "async_pop_writer.hpp"
 
 namespace flame { namespace io {
 
 class IOManager {
   public:
-    enum FileType { xml = 0 };
+    //! File types of populations, time series are only written
+    enum FileType { xml = 0, binary = 1, timeseries = 2 };
 
     static IOManager& GetInstance() {
       static IOManager instance;
@@ -31,14 +40,57 @@ class IOManager {
     void readPop(std::string file_name,
         model::XModel * model,
         FileType fileType);
+    //! Returns the type of a population file, judged by its contents
+    FileType getFileType(std::string const& file_name);
+    //! Copies the columns of an agent variable to the output of the current
+    //! iteration, called once the last writer of the variable has finished
     void writePop(std::string agent_name, std::string var_name);
     void initialiseData();
     void finaliseData();
     void setIteration(size_t i);
+    //! Sets the file type population output is written in. Time series
+    //! output replaces the population files, so a simulation cannot be
+    //! restarted from it, see setTimeSeriesOutput().
+    void setOutputType(FileType fileType);
+    FileType getOutputType() const { return outputType_; }
+    //! Sets a backend output is written with instead of the output type,
+    //! NULL restores the output type. The backend is not owned.
+    void setOutputBackend(OutputBackend * backend);
+    //! Also writes every population output as time series, alongside the
+    //! population files the simulation can be restarted from
+    void setTimeSeriesOutput(bool enable);
+    //! Writes population output in a background thread using at most
+    //! max_pending population snapshots
+    void setAsynchronousOutput(bool async, size_t max_pending = 2);
+    //! Blocks until all pending population output has been written
+    void flushOutput();
+    //! Writes population output only at iterations that are a multiple of n
+    void setOutputFrequency(size_t n);
+    //! Compresses xml population output with gzip at the given level,
+    //! 0 for no compression
+    void setOutputCompression(int level);
+    //! Writes only variables written by agent functions after the first
+    //! population output, other variables cannot have changed. Delta files
+    //! are marked as such and rejected by readPop(), a simulation can only
+    //! be restarted from the first, complete, output.
+    void setDeltaOutput(bool delta);
+    //! Sets the variables written by the agent functions of each agent
+    void setWrittenVariables(const WrittenVariables& vars);
 
   private:
     //! This is a singleton class. Disable manual instantiation
-    IOManager() : iteration_(0) {}
+    IOManager() : iteration_(0), outputType_(xml), backend_(0),
+        timeSeriesOutput_(false), outputFrequency_(1),
+        deltaOutput_(false), fullOutputWritten_(false) {}
+    PopSnapshotPtr completeSnapshot(const WrittenVariables * written);
+    //! Returns the backend output is written with
+    OutputBackend * outputBackend();
+    //! Returns the backend time series are written with alongside the
+    //! output backend, NULL if none
+    OutputBackend * timeSeriesBackend();
+    bool isOutputIteration() const;
+    bool isWritten(const WrittenVariables * written,
+        const std::string& agent_name, const std::string& var_name) const;
     //! This is a singleton class. Disable copy constructor
     IOManager(const IOManager&);
     //! This is a singleton class. Disable assignment operation
@@ -46,7 +98,32 @@ class IOManager {
 
     xml::IOXMLModel ioxmlmodel;
     xml::IOXMLPop   ioxmlpop;
+    binary::IOBinaryPop iobinarypop;
+    timeseries::IOTimeSeries iotimeseries;
     size_t iteration_;
+    //! File type population output is written in
+    FileType outputType_;
+    //! Backend set instead of the output type, not owned
+    OutputBackend * backend_;
+    //! Write time series alongside population output
+    bool timeSeriesOutput_;
+    //! Number of iterations between population outputs
+    size_t outputFrequency_;
+    //! Only write variables written by agent functions
+    bool deltaOutput_;
+    //! A complete population has been written since the pop was read
+    bool fullOutputWritten_;
+    //! Variables written by agent functions, by agent name
+    WrittenVariables writtenVars_;
+    //! Columns copied by writePop in the current iteration, by agent and
+    //! memory variable name
+    typedef boost::ptr_map<std::pair<std::string, std::string>,
+        flame::mem::VectorWrapperBase> ColumnMap;
+    ColumnMap columns_;
+    //! Serialises access to the copied columns
+    boost::mutex columns_mutex_;
+    //! Background writer, only set if output is asynchronous
+    boost::scoped_ptr<AsyncPopWriter> writer_;
 };
 }}  // namespace flame::io
 #endif  // IO__IO_MANAGER_HPP_
@@ -0,0 +1,239 @@
+/*!
+ * \file flame2/io/io_timeseries.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief IOTimeSeries: time series output of agent variables
+ */
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include "flame2/config.hpp"
+#include "flame2/mem/memory_manager.hpp"
+#include "flame2/mem/data_type.hpp"
+#include "flame2/exceptions/io.hpp"
+#include "io_timeseries.hpp"
+
+namespace mem = flame::mem;
+namespace exc = flame::exceptions;
+
+namespace flame { namespace io { namespace timeseries {
+
+const size_t IOTimeSeries::kChunkAgents;
+
+//! Magic number at the start of every time series file
+static const char kMagic[8] = {'F', 'L', 'A', 'M', 'E', 'T', 'S', '\0'};
+//! Written in native byte order to detect files from other machines
+static const boost::uint32_t kByteOrderMark = 0x01020304;
+//! Version of the file layout
+static const boost::uint32_t kVersion = 1;
+
+static void putU64(std::string * buffer, boost::uint64_t value) {
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void putString(std::string * buffer, const std::string& value) {
+  putU64(buffer, value.size());
+  buffer->append(value);
+}
+
+//! Closes a file when going out of scope
+class File {
+  public:
+    explicit File(FILE * file) : file_(file) {}
+    ~File() { if (file_) fclose(file_); }
+    FILE * get() const { return file_; }
+    //! Closes the file, returns false on error
+    bool Close() {
+      FILE * file = file_;
+      file_ = 0;
+      return fclose(file) == 0;
+    }
+  private:
+    FILE * file_;
+    File(const File&);
+    void operator=(const File&);
+};
+
+IOTimeSeries::IOTimeSeries() : pop_path_is_set_(false), iteration_(0) {}
+
+void IOTimeSeries::setIteration(size_t i) {
+  iteration_ = i;
+}
+
+std::string IOTimeSeries::outputFileName() {
+  /* Check a path has been set */
+  if (!popPathIsSet()) {
+    throw exc::flame_io_exception("Path not set");
+  }
+  return pop_path_;
+}
+
+bool IOTimeSeries::popPathIsSet() {
+  return pop_path_is_set_;
+}
+
+void IOTimeSeries::setPopPath(std::string path) {
+  boost::filesystem::path p(path);
+  pop_path_ = p.parent_path().string();
+  if (pop_path_ != "") pop_path_.append("/");
+  pop_path_is_set_ = true;
+  started_.clear();
+}
+
+std::string IOTimeSeries::seriesFileName(const std::string& agent_name,
+    const std::string& var_name) {
+  return outputFileName() + agent_name + "." + var_name + ".ts";
+}
+
+/*!
+ * \brief Appends the values of a memory column to its time series file
+ *
+ * The file is started afresh, with a header, the first time it is written
+ * after the output directory was set.
+ */
+void IOTimeSeries::writeColumn(const std::string& agent_name,
+    const std::string& var_name, size_t iteration,
+    mem::VectorWrapperBase * vec) {
+  std::string file_name = seriesFileName(agent_name, var_name);
+  bool start = started_.find(file_name) == started_.end();
+  File file(fopen(file_name.c_str(), start ? "wb" : "ab"));
+  if (file.get() == 0)
+    throw exc::flame_io_exception("Could not open time series file " +
+        file_name);
+
+  std::string buffer;
+  if (start) {
+    const mem::DataTypeBase * type = mem::DataTypeRegistry::GetInstance().
+        GetTypeByDataType(*(vec->GetDataType()));
+    if (type == 0)
+      throw exc::flame_io_exception("Unknown data type of " + var_name);
+    buffer.append(kMagic, sizeof(kMagic));
+    buffer.append(reinterpret_cast<const char*>(&kByteOrderMark),
+        sizeof(kByteOrderMark));
+    buffer.append(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+    putString(&buffer, type->get_name());
+    putU64(&buffer, vec->element_size());
+    putU64(&buffer, vec->stride());
+  }
+
+  size_t agents = vec->size();
+  size_t agent_bytes = vec->element_size() * vec->stride();
+  const char * data = static_cast<const char*>(vec->GetRawPtr());
+  size_t first = 0;
+  do {
+    size_t count = std::min(kChunkAgents, agents - first);
+    putU64(&buffer, iteration);
+    putU64(&buffer, first);
+    putU64(&buffer, count);
+    if (fwrite(buffer.data(), 1, buffer.size(), file.get()) != buffer.size()
+        || (count > 0 && fwrite(data + first * agent_bytes, agent_bytes,
+            count, file.get()) != count))
+      throw exc::flame_io_exception("Could not write time series file " +
+          file_name);
+    buffer.clear();
+    first += count;
+  } while (first < agents);
+
+  if (!file.Close())
+    throw exc::flame_io_exception("Could not write time series file " +
+        file_name);
+  started_.insert(file_name);
+}
+
+void IOTimeSeries::finaliseData() {
+  mem::MemoryManager& mm = mem::MemoryManager::GetInstance();
+  std::vector<std::string> agent_names = mm.GetAgentNames();
+  std::vector<std::string>::iterator a;
+  for (a = agent_names.begin(); a != agent_names.end(); ++a) {
+    const std::vector<std::string>& var_names = mm.GetVarNames(*a);
+    for (size_t ii = 0; ii < var_names.size(); ++ii)
+      writeColumn(*a, var_names[ii], iteration_,
+          mm.GetVectorWrapper(*a, ii));
+  }
+}
+
+void IOTimeSeries::writeSnapshot(PopSnapshot * snapshot) {
+  PopSnapshot::AgentVector::iterator a;
+  for (a = snapshot->get_agents().begin();
+      a != snapshot->get_agents().end(); ++a) {
+    for (size_t ii = 0; ii < (*a).get_var_names().size(); ++ii)
+      writeColumn((*a).get_agent_name(), (*a).get_var_names()[ii],
+          snapshot->get_iteration(), &((*a).get_columns()[ii]));
+  }
+}
+
+/*!
+ * \brief Reads a value from a file
+ * \return False if the end of the file was reached
+ */
+static bool readValue(FILE * file, void * ptr, size_t n) {
+  return fread(ptr, 1, n, file) == n;
+}
+
+static bool readU64(FILE * file, boost::uint64_t * value) {
+  return readValue(file, value, sizeof(*value));
+}
+
+TimeSeriesReader::TimeSeriesReader(const std::string& file_name)
+    : file_(0), file_name_(file_name), element_size_(0), stride_(0) {
+  file_ = fopen(file_name.c_str(), "rb");
+  if (file_ == 0)
+    throw exc::inaccessable_file("Unable to open time series file " +
+        file_name);
+
+  char magic[sizeof(kMagic)];
+  boost::uint32_t bom, version;
+  boost::uint64_t length, element_size, stride;
+  bool ok = readValue(file_, magic, sizeof(magic)) &&
+      memcmp(magic, kMagic, sizeof(kMagic)) == 0 &&
+      readValue(file_, &bom, sizeof(bom)) && bom == kByteOrderMark &&
+      readValue(file_, &version, sizeof(version)) && version == kVersion &&
+      readU64(file_, &length) && length < 256;
+  if (ok) {
+    type_name_.resize(static_cast<size_t>(length));
+    ok = (length == 0 || readValue(file_, &type_name_[0],
+        static_cast<size_t>(length))) &&
+        readU64(file_, &element_size) && readU64(file_, &stride) &&
+        element_size > 0 && stride > 0;
+  }
+  if (!ok) {
+    fclose(file_);
+    throw exc::unparseable_file("Invalid time series file " + file_name);
+  }
+  element_size_ = static_cast<size_t>(element_size);
+  stride_ = static_cast<size_t>(stride);
+}
+
+TimeSeriesReader::~TimeSeriesReader() {
+  fclose(file_);
+}
+
+bool TimeSeriesReader::nextChunk(size_t * iteration, size_t * first_agent,
+    std::vector<char> * data) {
+  boost::uint64_t it, first, count;
+  if (!readU64(file_, &it)) return false;
+  if (!readU64(file_, &first) || !readU64(file_, &count) ||
+      count > IOTimeSeries::kChunkAgents)
+    throw exc::unparseable_file("Truncated time series file " + file_name_);
+  data->resize(static_cast<size_t>(count) * element_size_ * stride_);
+  if (!data->empty() && !readValue(file_, &(*data)[0], data->size()))
+    throw exc::unparseable_file("Truncated time series file " + file_name_);
+  *iteration = static_cast<size_t>(it);
+  *first_agent = static_cast<size_t>(first);
+  return true;
+}
+
+void TimeSeriesReader::throw_type_error() const {
+  throw exc::flame_io_exception("Values of time series file " + file_name_ +
+      " have a different size");
+}
+
+}}}  // namespace flame::io::timeseries
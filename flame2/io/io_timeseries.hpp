@@ -0,0 +1,113 @@
+/*!
+ * \file flame2/io/io_timeseries.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief IOTimeSeries: time series output of agent variables
+ */
+#ifndef IO__IO_TIMESERIES_HPP_
+#define IO__IO_TIMESERIES_HPP_
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+#include "flame2/mem/vector_wrapper.hpp"
+#include "output_backend.hpp"
+
+namespace flame { namespace io { namespace timeseries {
+
+/*!
+ * \brief Writes agent variables as time series
+ *
+ * Each memory variable of each agent type is written to its own file,
+ * <agent>.<variable>.ts, in the output directory. Every output appends
+ * chunks of at most kChunkAgents agents to the files, so one variable can
+ * be read across all iterations without touching other variables.
+ *
+ * File layout, all integers are uint64 unless stated otherwise:
+ *   - magic "FLAMETS", uint32 byte order mark, uint32 version
+ *   - data type name, element size, elements per agent
+ *   - chunks: iteration, index of first agent, number of agents, followed
+ *     by the raw values of the agents
+ *
+ * Strings are stored as their length followed by the characters. Files
+ * are only portable between machines with the same byte order.
+ */
+class IOTimeSeries : public OutputBackend {
+  public:
+    IOTimeSeries();
+    void setIteration(size_t i);
+    std::string outputFileName();
+    void finaliseData();
+    void writeSnapshot(PopSnapshot * snapshot);
+    bool popPathIsSet();
+    //! Sets the output directory to the directory of the given file, files
+    //! written from then on are started afresh
+    void setPopPath(std::string path);
+    //! Returns the name of the time series file of an agent variable
+    std::string seriesFileName(const std::string& agent_name,
+        const std::string& var_name);
+
+    //! Max number of agents in a chunk
+    static const size_t kChunkAgents = 1 << 16;
+
+  private:
+    void writeColumn(const std::string& agent_name,
+        const std::string& var_name, size_t iteration,
+        flame::mem::VectorWrapperBase * vec);
+    std::string pop_path_;  //! Directory time series are written to
+    bool pop_path_is_set_;  //! Output directory has been set
+    size_t iteration_;  //! Current iteration number
+    std::set<std::string> started_;  //! Files written since path was set
+};
+
+//! Reads a time series file written by IOTimeSeries
+class TimeSeriesReader {
+  public:
+    explicit TimeSeriesReader(const std::string& file_name);
+    ~TimeSeriesReader();
+    //! Returns the data type name of the values
+    const std::string& get_type_name() const { return type_name_; }
+    //! Returns the size of a value in bytes
+    size_t get_element_size() const { return element_size_; }
+    //! Returns the number of values per agent
+    size_t get_stride() const { return stride_; }
+
+    /*!
+     * \brief Reads the next chunk
+     * \param[out] iteration Iteration the chunk was written at
+     * \param[out] first_agent Index of the first agent in the chunk
+     * \param[out] data Raw values of the agents in the chunk
+     * \return False at the end of the file
+     */
+    bool nextChunk(size_t * iteration, size_t * first_agent,
+        std::vector<char> * data);
+
+    //! Reads the next chunk as values of type T
+    template <typename T>
+    bool nextChunk(size_t * iteration, size_t * first_agent,
+        std::vector<T> * values) {
+      if (sizeof(T) != element_size_) throw_type_error();
+      std::vector<char> data;
+      if (!nextChunk(iteration, first_agent, &data)) return false;
+      values->resize(data.size() / sizeof(T));
+      if (!data.empty()) memcpy(&(*values)[0], &data[0], data.size());
+      return true;
+    }
+
+  private:
+    FILE * file_;
+    std::string file_name_;
+    std::string type_name_;
+    size_t element_size_;
+    size_t stride_;
+    void throw_type_error() const;
+    TimeSeriesReader(const TimeSeriesReader&);
+    void operator=(const TimeSeriesReader&);
+};
+
+}}}  // namespace flame::io::timeseries
+#endif  // IO__IO_TIMESERIES_HPP_
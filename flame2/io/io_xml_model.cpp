@@ -383,6 +383,12 @@ void IOXMLModel::readVariable(xmlNode * node,
         /* Read the string ready to be validated later */
         xvariable->setConstantString(
             getElementValue(cur_node));
+      } else if (name == "buffered") {
+        /* Indicate that buffered is set */
+        xvariable->setBufferedSet(true);
+        /* Read the string ready to be validated later */
+        xvariable->setBufferedString(
+            getElementValue(cur_node));
       } else {
         readUnknownElement(cur_node);
       }
@@ -9,16 +9,25 @@
  */
 #include <libxml/xmlreader.h>
 #include <libxml/xmlwriter.h>
+#include <libxml/xmlschemas.h>
 #include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread.hpp>
 #include <boost/variant.hpp>
 #include <string>
 #include <vector>
+#include <map>
+#include <cctype>
+#include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <utility>
 #include "flame2/config.hpp"
 #include "flame2/mem/vector_wrapper.hpp"
+#include "flame2/mem/data_type.hpp"
 #include "flame2/exceptions/io.hpp"
+#include "parallel_pop_reader.hpp"
 #include "io_xml_pop.hpp"
 
 namespace model = flame::model;
@@ -30,12 +39,8 @@ namespace io {
 namespace xml {
 
 IOXMLPop::IOXMLPop()
-    : iteration_(0), xml_pop_path_is_set(false) {
-}
-
-// This method is empty because you can't (without a lot of difficulty)
-// write xml row-wise
-void IOXMLPop::writePop(std::string /*agent_name*/, std::string /*var_name*/) {
+    : iteration_(0), compression_(0), xml_pop_path_is_set(false), model_(0),
+      current_layout_(0), schema_hash_(0) {
 }
 
 void IOXMLPop::initialiseData() {
@@ -51,38 +56,142 @@ struct VarVecData {
   flame::mem::VectorWrapperBase* vw;
 };
 
-void IOXMLPop::writeAgents(xmlTextWriterPtr writer) {
-  std::vector<std::string>::iterator sit;
+typedef std::map<std::string, VarVecData*> ColumnMap;
 
-  // for each agent type in the model
-  agentVarMap::iterator it;
-  for (it = agentVarMap_.begin(); it != agentVarMap_.end(); ++it) {
+/*!
+ * \brief Part of the text of a variable value
+ *
+ * Text is written first followed by the value of an element of a memory
+ * variable if type is set.
+ */
+struct OutputItem {
+  OutputItem() : type(0), column(0), index(0) {}
+  std::string text;
+  const mem::DataTypeBase* type;
+  VarVecData* column;
+  size_t index;
+};
+
+//! Items used to write the value of a variable for any agent
+struct VarOutput {
+  explicit VarOutput(std::string n) : name(n) {}
+  std::string name;
+  std::vector<OutputItem> items;
+};
+
+static void appendOutputText(std::vector<OutputItem> * items,
+    std::string text) {
+  if (items->empty() || items->back().type != 0)
+    items->push_back(OutputItem());
+  items->back().text.append(text);
+}
+
+/*!
+ * \brief Compiles the items used to write the value of a variable
+ * \param[out] items Items the variable value is appended to
+ * \param[in] variable The model variable
+ * \param[in] name Name of the memory variable holding the value
+ * \param[in] element Index of the enclosing data type instance
+ * \param[in] columns Memory variables of the agent
+ * \param[in] model The model holding data type definitions
+ * \return False if the variable is not held in agent memory
+ *
+ * Static arrays and data types are written within braces, e.g. {1, 2}.
+ * The layout of a variable is the same for every agent so items are compiled
+ * once and only the data pointers are advanced from agent to agent.
+ */
+static bool compileOutput(std::vector<OutputItem> * items,
+    model::XVariable * variable, std::string name, size_t element,
+    const ColumnMap& columns, model::XModel * model) {
+  boost::ptr_vector<model::XVariable>::iterator vit;
+  size_t ii, count = 1;
+
+  if (variable->isStaticArray()) {
+    count = variable->getStaticArraySize();
+    appendOutputText(items, "{");
+  }
+  for (ii = 0; ii < count; ++ii) {
+    if (ii > 0) appendOutputText(items, ", ");
+    if (variable->hasADTType()) {
+      model::XADT * adt = model->getADT(variable->getType());
+      appendOutputText(items, "{");
+      for (vit = adt->getVariables()->begin();
+          vit != adt->getVariables()->end(); ++vit) {
+        if (vit != adt->getVariables()->begin()) appendOutputText(items, ", ");
+        if (!compileOutput(items, &(*vit), name + "." + (*vit).getName(),
+            element * count + ii, columns, model)) return false;
+      }
+      appendOutputText(items, "}");
+    } else {
+      ColumnMap::const_iterator c = columns.find(name);
+      const mem::DataTypeBase* type =
+          mem::DataTypeRegistry::GetInstance().GetType(variable->getType());
+      if (c == columns.end() || type == 0) return false;
+      if (items->empty() || items->back().type != 0)
+        items->push_back(OutputItem());
+      items->back().type = type;
+      items->back().column = (*c).second;
+      items->back().index = element * count + ii;
+    }
+  }
+  if (variable->isStaticArray()) appendOutputText(items, "}");
+  return true;
+}
+
+void IOXMLPop::writeAgents(xmlTextWriterPtr writer, PopSnapshot * snapshot) {
+  boost::ptr_vector<model::XVariable>::iterator vit;
+  std::vector<OutputItem>::iterator i;
+  std::vector<VarOutput>::iterator o;
+  std::string value;
+  // for each agent type in the snapshot
+  PopSnapshot::AgentVector::iterator it;
+  for (it = snapshot->get_agents().begin();
+      it != snapshot->get_agents().end(); ++it) {
     // for each agent variable save name, pointer to data and
     // pointer to vector wrapper
     std::vector<VarVecData> dataMap;
     std::vector<VarVecData>::iterator d;
+    ColumnMap columns;
     bool stillData = true;
-    for (sit = (*it).second.begin(); sit != (*it).second.end(); ++sit) {
-      mem::VectorWrapperBase* vw = mem::MemoryManager::GetInstance().
-          GetVectorWrapper((*it).first, (*sit));
-      dataMap.push_back(VarVecData((*sit), vw->GetRawPtr(), vw));
+    for (size_t ii = 0; ii < (*it).get_var_names().size(); ++ii) {
+      mem::VectorWrapperBase* vw = &((*it).get_columns()[ii]);
+      dataMap.push_back(VarVecData((*it).get_var_names()[ii],
+          vw->GetRawPtr(), vw));
       if (vw->GetRawPtr() == NULL) stillData = false;
     }
+    if (dataMap.empty()) stillData = false;
+    for (d = dataMap.begin(); d != dataMap.end(); ++d)
+      columns.insert(std::make_pair((*d).varName, &(*d)));
+
+    // compile output of each variable held in agent memory
+    std::vector<VarOutput> outputs;
+    model::XMachine * agent = model_->getAgent((*it).get_agent_name());
+    if (agent == 0) continue;
+    for (vit = agent->getVariables()->begin();
+        vit != agent->getVariables()->end(); ++vit) {
+      VarOutput output((*vit).getName());
+      if (compileOutput(&output.items, &(*vit), (*vit).getName(), 0,
+          columns, model_))
+        outputs.push_back(output);
+    }
 
     // while there is still data write out each agent to xml
     while (stillData) {
       // open root tag
       writeXMLTag(writer, "xagent");
       // write agent name
-      writeXMLTag(writer, "name", (*it).first);
+      writeXMLTag(writer, "name", (*it).get_agent_name());
+      for (o = outputs.begin(); o != outputs.end(); ++o) {
+        value.clear();
+        for (i = (*o).items.begin(); i != (*o).items.end(); ++i) {
+          value.append((*i).text);
+          if ((*i).type) (*i).type->Format((*i).column->p, (*i).index, &value);
+        }
+        writeXMLTag(writer, (*o).name, value);
+      }
       for (d = dataMap.begin(); d != dataMap.end(); ++d) {
-        if (strcmp((*d).vw->GetDataType()->name(), "i") == 0)
-          writeXMLTag(writer, (*d).varName, *reinterpret_cast<int*>((*d).p));
-        if (strcmp((*d).vw->GetDataType()->name(), "d") == 0)
-          writeXMLTag(writer, (*d).varName,
-              *reinterpret_cast<double*>((*d).p));
         (*d).p = (*d).vw->StepRawPtr((*d).p);
-        if ((*d).p == NULL && d + 1 == dataMap.end()) stillData = false;
+        if ((*d).p == NULL) stillData = false;
       }
       // close the element named xagent
       writeXMLEndTag(writer);
@@ -90,26 +199,45 @@ void IOXMLPop::writeAgents(xmlTextWriterPtr writer) {
   }
 }
 
+/*!
+ * \brief Takes a copy of the population to be written out
+ *
+ * The snapshot is self contained so it can be written out by
+ * writeSnapshot() in a different thread while agent memory is modified.
+ */
+PopSnapshotPtr IOXMLPop::createSnapshot(const WrittenVariables * written) {
+  PopSnapshotPtr snapshot(new PopSnapshot(outputFileName(), iteration_));
+  snapshot->set_delta(written != 0);
+  agentVarMap::iterator it;
+  for (it = agentVarMap_.begin(); it != agentVarMap_.end(); ++it) {
+    if (written)
+      snapshot->AddAgent((*it).first, (*it).second, *written);
+    else
+      snapshot->AddAgent((*it).first, (*it).second);
+  }
+  return snapshot;
+}
+
 void IOXMLPop::finaliseData() {
+  writeSnapshot(createSnapshot().get());
+}
+
+void IOXMLPop::writeSnapshot(PopSnapshot * snapshot) {
   // Write out agent data and xml finish
   /* The xml text writer */
   xmlTextWriterPtr writer;
-
-  /* Check a path has been set */
-  if (!xmlPopPathIsSet()) {
-    throw exc::flame_io_exception("Path not set");
-  }
-
-  std::string file_name = xml_pop_path;
-  file_name.append(boost::lexical_cast<std::string>(iteration_));
-  file_name.append(".xml");
+  std::string file_name = snapshot->get_file_name();
 
 #ifndef TESTBUILD
   printf("Writing file: %s\n", file_name.c_str());
 #endif
 
-  /* Open file to write to, with no compression */
-  writer = xmlNewTextWriterFilename(file_name.c_str(), 0);
+  /* Open file to write to, compressed if the file name says so */
+  int compression = 0;
+  if (file_name.size() > 3 &&
+      file_name.compare(file_name.size() - 3, 3, ".gz") == 0)
+    compression = (compression_ > 0) ? compression_ : 6;
+  writer = xmlNewTextWriterFilename(file_name.c_str(), compression);
   if (writer == NULL)
     throw exc::flame_io_exception("Could not open xml population "
                                   "file for writing");
@@ -119,13 +247,15 @@ void IOXMLPop::finaliseData() {
   /* Open root tag */
   writeXMLTag(writer, "states");
   // if (rc != 0) return rc;
+  /* Mark files only holding written variables, they cannot be read */
+  if (snapshot->is_delta()) writeXMLTagAttribute(writer, "delta", "true");
 
   /* Write itno tag with iteration number */
-  writeXMLTag(writer, "itno", static_cast<int>(iteration_));
+  writeXMLTag(writer, "itno", static_cast<int>(snapshot->get_iteration()));
   // if (rc != 0) return rc;
 
   // Write agent memory out
-  writeAgents(writer);
+  writeAgents(writer, snapshot);
 
   /* End xml file, automatically ends states tag */
   endXMLDoc(writer);
@@ -135,54 +265,187 @@ void IOXMLPop::finaliseData() {
 }
 
 void IOXMLPop::saveAgentVariableData(model::XModel * model) {
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
   agentVarMap_.clear();
+  model_ = model;
   boost::ptr_vector<model::XMachine>::iterator agent_it;
-  boost::ptr_vector<model::XVariable>::iterator var_it;
-  std::pair<agentVarMap::iterator, bool> avm;
   for (agent_it = model->getAgents()->begin();
       agent_it != model->getAgents()->end(); ++agent_it) {
-    // Add agent to agent var map for use when writing
-    avm = agentVarMap_.insert(
-        std::make_pair((*agent_it).getName(), std::vector<std::string>()));
-    for (var_it = (*agent_it).getVariables()->begin();
-        var_it != (*agent_it).getVariables()->end(); ++var_it) {
-      (*avm.first).second.push_back((*var_it).getName());
-    }
+    // Add agent memory variables to agent var map for use when writing,
+    // this includes the members of data type variables
+    if (memoryManager.IsRegisteredAgent((*agent_it).getName()))
+      agentVarMap_.insert(std::make_pair((*agent_it).getName(),
+          memoryManager.GetVarNames((*agent_it).getName())));
   }
 }
 
+/*!
+ * \brief Keeps the first schema validation error message
+ */
+static void schemaValidityError(void * ctx, const char * msg, ...) {
+  std::string * error = static_cast<std::string*>(ctx);
+  if (!error->empty()) return;
+  char buffer[512];
+  va_list args;
+  va_start(args, msg);
+  vsnprintf(buffer, sizeof(buffer), msg, args);
+  va_end(args);
+  error->append(buffer);
+}
+
+/*!
+ * \brief Ignores schema validation warnings
+ */
+static void schemaValidityWarning(void * /*ctx*/, const char * /*msg*/, ...) {
+}
+
+/*!
+ * \brief Data schema used to validate a pop file while it is read
+ *
+ * Owns the schema document and frees all libxml2 schema structures when
+ * going out of scope, including when reading is aborted by an exception.
+ */
+class DataSchema {
+  public:
+    explicit DataSchema(xmlDocPtr doc)
+        : doc_(doc), parser_ctxt_(NULL), schema_(NULL), valid_ctxt_(NULL) {
+      parser_ctxt_ = xmlSchemaNewDocParserCtxt(doc_);
+      if (parser_ctxt_ != NULL) schema_ = xmlSchemaParse(parser_ctxt_);
+      if (schema_ != NULL) valid_ctxt_ = xmlSchemaNewValidCtxt(schema_);
+      if (valid_ctxt_ != NULL)
+        xmlSchemaSetValidErrors(valid_ctxt_, schemaValidityError,
+            schemaValidityWarning, &error_);
+    }
+    ~DataSchema() {
+      if (valid_ctxt_ != NULL) xmlSchemaFreeValidCtxt(valid_ctxt_);
+      if (schema_ != NULL) xmlSchemaFree(schema_);
+      if (parser_ctxt_ != NULL) xmlSchemaFreeParserCtxt(parser_ctxt_);
+      xmlFreeDoc(doc_);
+    }
+    //! Returns the validation context, NULL if the schema is invalid
+    xmlSchemaValidCtxtPtr get_valid_ctxt() { return valid_ctxt_; }
+    //! Returns the first validation error message
+    const std::string& get_error() const { return error_; }
+    //! Clears the validation error message before the schema is reused
+    void clear_error() { error_.clear(); }
+
+  private:
+    xmlDocPtr doc_;
+    xmlSchemaParserCtxtPtr parser_ctxt_;
+    xmlSchemaPtr schema_;
+    xmlSchemaValidCtxtPtr valid_ctxt_;
+    std::string error_;
+    //! Disable copy constructor
+    DataSchema(const DataSchema&);
+    //! Disable assignment operation
+    void operator=(const DataSchema&);
+};
+
+/*!
+ * \brief Reads a pop file into agent memory
+ *
+ * Files in the plain layout written by IOXMLPop are read by the
+ * ParallelPopReader. Other files, and files with errors, are validated
+ * against the data schema of the model while they are streamed so they are
+ * only parsed once and never held in memory as a whole. The schema is built
+ * in memory and kept for reading further files of models with the same
+ * agents and variables, e.g. for ensemble runs.
+ */
 void IOXMLPop::readPop(std::string file_name, model::XModel * model) {
   xmlTextReaderPtr reader;
-  int ret;
+  int ret, valid;
   /* Using vector instead of stack as need to access earlier tags */
   std::vector<std::string> tags;
   /* Pointer to current agent type, 0 if invalid */
   model::XMachine * agent = 0;
 
+  /* Read plain pop files using multiple threads */
+  ParallelPopReader parallel(model, boost::thread::hardware_concurrency());
+  if (parallel.readPop(file_name)) {
+    saveAgentVariableData(model);
+    return;
+  }
+
+  /* Compile the agent layouts and appenders to agent memory once, so
+   * values are parsed without per value lookups or allocations */
+  layouts_.clear();
+  appenders_.clear();
+  compileLayouts(&layouts_, model);
+  for (size_t ii = 0; ii < layouts_.size(); ++ii) {
+    appenders_.push_back(new ColumnAppenders());
+    createAppenders(layouts_[ii], layouts_[ii].columns, &appenders_.back());
+  }
+
+  /* Create data schema in memory, unless the schema of the last model read
+   * is the same. The hash is only a quick check, the keys must also match */
+  std::string key = dataSchemaKey(model);
+  size_t hash = boost::hash<std::string>()(key);
+  if (!schema_ || schema_hash_ != hash || schema_key_ != key) {
+    schema_.reset();
+    schema_.reset(new DataSchema(createDataSchemaDoc(model)));
+    schema_hash_ = hash;
+    schema_key_ = key;
+  }
+  DataSchema& schema = *schema_;
+  if (schema.get_valid_ctxt() == NULL) {
+    schema_.reset();
+    throw exc::flame_io_exception("Could not create data schema");
+  }
+  schema.clear_error();
+
   /* Open file to read */
   reader = xmlReaderForFile(file_name.c_str(), NULL, 0);
   /* Check if file opened successfully */
   if (reader == NULL)
     throw exc::inaccessable_file("Unable to open xml pop file");
 
+  /* Validate against data schema while reading */
+  if (xmlTextReaderSchemaValidateCtxt(reader,
+      schema.get_valid_ctxt(), 0) != 0) {
+    xmlFreeTextReader(reader);
+    throw exc::flame_io_exception("Could not use data schema");
+  }
+
 #ifndef TESTBUILD
   printf("Reading file: %s\n", file_name.c_str());
 #endif
 
-  /* Read the first node */
-  ret = xmlTextReaderRead(reader);
-  /* Continue reading nodes until end */
-  while (ret == 1) {
-    /* Process node */
-    processNode(reader, model, &tags, &agent);
-    /* Read next node */
+  /* Agents are appended while the file is validated, remember the sizes
+   * of the columns so a file that fails part way through leaves agent
+   * memory unchanged */
+  std::vector<size_t> sizes;
+  for (size_t ii = 0; ii < layouts_.size(); ++ii)
+    for (size_t c = 0; c < layouts_[ii].columns.size(); ++c)
+      sizes.push_back(layouts_[ii].columns[c]->size());
+
+  try {
+    /* Read the first node */
     ret = xmlTextReaderRead(reader);
+    /* Continue reading nodes until end */
+    while (ret == 1) {
+      /* Process node */
+      processNode(reader, model, &tags, &agent);
+      /* Read next node */
+      ret = xmlTextReaderRead(reader);
+    }
+    valid = xmlTextReaderIsValid(reader);
+    /* Clean up */
+    xmlFreeTextReader(reader);
+    /* If error reading node return */
+    if (ret != 0 && schema.get_error().empty())
+      throw exc::unparseable_file("Failed to parse xml pop file");
+    if (ret != 0 || valid != 1)
+      throw exc::flame_io_exception(std::string(
+          "Error validating pop file: ").append(schema.get_error()));
+  } catch(...) {
+    /* Drop the agents read before the failure */
+    std::vector<size_t>::const_iterator size = sizes.begin();
+    for (size_t ii = 0; ii < layouts_.size(); ++ii)
+      for (size_t c = 0; c < layouts_[ii].columns.size(); ++c)
+        layouts_[ii].columns[c]->truncate(*size++);
+    throw;
   }
-  /* Clean up */
-  xmlFreeTextReader(reader);
-  /* If error reading node return */
-  if (ret != 0)
-    throw exc::unparseable_file("Failed to parse xml pop file");
 
   /* Save agent vars to a structure */
   saveAgentVariableData(model);
@@ -263,20 +526,25 @@ void IOXMLPop::createDataSchemaAgentVarChoice(xmlTextWriterPtr writer,
   writeXMLEndTag(writer);
 }
 
+/*!
+ * \brief Returns the schema data type of a variable
+ *
+ * Arrays and data types are held in braces so are strings.
+ */
+static std::string schemaVarType(model::XVariable * variable) {
+  const mem::DataTypeBase * dataType =
+      mem::DataTypeRegistry::GetInstance().GetType(variable->getType());
+  if (variable->isStaticArray() || variable->hasADTType() || !dataType)
+    return "xs:string";
+  return dataType->get_schema_type();
+}
+
 void IOXMLPop::createDataSchemaAgentVar(xmlTextWriterPtr writer,
     boost::ptr_vector<model::XVariable>::iterator variable) {
-  std::string type;
   // Write tag
   writeXMLTagAndAttribute(writer, "xs:element", "name", (*variable).getName());
-  // Select correct schema data type
-  if ((*variable).getType() == "int")
-    type = "xs:integer";
-  else if ((*variable).getType() == "double")
-    type = "xs:double";
-  else
-    type = "xs:string";
   // Write schema data type attribute
-  writeXMLTagAttribute(writer, "type", type);
+  writeXMLTagAttribute(writer, "type", schemaVarType(&(*variable)));
   // Close the element named xs:element
   writeXMLEndTag(writer);
 }
@@ -336,26 +604,38 @@ void IOXMLPop::createDataSchemaDefineTags(xmlTextWriterPtr writer) {
   writeXMLEndTag(writer, 2);
   writeXMLTagAndAttribute(writer, "xs:element", "ref", "xagent", "minOccurs",
       "0", "maxOccurs", "unbounded");
-  /* Close the element named xs:element, xs:sequence,
-   * xs:complexType, xs:element */
-  writeXMLEndTag(writer, 4);
+  /* Close the element named xs:element, xs:sequence */
+  writeXMLEndTag(writer, 2);
+  /* Delta output only holds written variables */
+  writeXMLTagAndAttribute(writer, "xs:attribute", "name", "delta", "type",
+      "xs:boolean");
+  /* Close the element named xs:attribute, xs:complexType, xs:element */
+  writeXMLEndTag(writer, 3);
 }
 
-void IOXMLPop::createDataSchema(std::string const& file,
-    flame::model::XModel * model) {
-  std::vector<model::XMachine*>::iterator agent;
-  std::vector<model::XVariable*>::iterator variable;
-  /* The xml text writer */
-  xmlTextWriterPtr writer;
+std::string IOXMLPop::dataSchemaKey(flame::model::XModel * model) {
+  boost::ptr_vector<model::XMachine>::iterator agent;
+  boost::ptr_vector<model::XVariable>::iterator variable;
+  std::string key;
+  // The schema only depends on agent names, variable names and their types,
+  // one per line as names cannot contain white space
+  for (agent = model->getAgents()->begin(); agent != model->getAgents()->end();
+      ++agent) {
+    key.append("agent ").append((*agent).getName()).append("\n");
+    for (variable = (*agent).getVariables()->begin();
+        variable != (*agent).getVariables()->end(); ++variable)
+      key.append((*variable).getName()).append(" ").append(
+          schemaVarType(&(*variable))).append("\n");
+  }
+  return key;
+}
 
-#ifndef TESTBUILD
-  printf("Writing file: %s\n", file.c_str());
-#endif
+size_t IOXMLPop::dataSchemaHash(flame::model::XModel * model) {
+  return boost::hash<std::string>()(dataSchemaKey(model));
+}
 
-  /* Open file to write to, with no compression */
-  writer = xmlNewTextWriterFilename(file.c_str(), 0);
-  if (writer == NULL)
-    throw exc::flame_io_exception("Could not load data schema file");
+void IOXMLPop::writeDataSchema(xmlTextWriterPtr writer,
+    flame::model::XModel * model) {
   /* Write tags on new lines */
   xmlTextWriterSetIndent(writer, 1);
   createDataSchemaHead(writer);
@@ -366,79 +646,56 @@ void IOXMLPop::createDataSchema(std::string const& file,
   createDataSchemaDefineTags(writer);
   /* End xml file, automatically ends schema tag */
   endXMLDoc(writer);
-
-  /* Free the xml writer */
-  xmlFreeTextWriter(writer);
-}
-
-void IOXMLPop::openXMLDoc(xmlDocPtr * doc, std::string const& data_file) {
-  *doc = xmlReadFile(data_file.c_str(), NULL, 0);
-  /* Return error if the file was not successfully parsed */
-  if (*doc == NULL)
-    throw exc::flame_io_exception("Parsing of XML file failed");
 }
 
-int IOXMLPop::openXMLSchema(xmlSchemaValidCtxtPtr * valid_ctxt,
-    std::string const& schema_file, xmlSchemaParserCtxtPtr * parser_ctxt,
-    xmlSchemaPtr * schema, xmlDocPtr * schema_doc) {
-  *schema_doc = xmlReadFile(schema_file.c_str(), NULL, XML_PARSE_NONET);
-  /* the schema cannot be loaded or is not well-formed */
-  if (*schema_doc == NULL)
-    return -1;
-
-  *parser_ctxt = xmlSchemaNewDocParserCtxt(*schema_doc);
-  /* unable to create a parser context for the schema */
-  if (*parser_ctxt == NULL)
-    return -2;
+void IOXMLPop::createDataSchema(std::string const& file,
+    flame::model::XModel * model) {
+  /* The xml text writer */
+  xmlTextWriterPtr writer;
 
-  *schema = xmlSchemaParse(*parser_ctxt);
-  /* the schema itself is not valid */
-  if (schema == NULL)
-    return -3;
+#ifndef TESTBUILD
+  printf("Writing file: %s\n", file.c_str());
+#endif
 
-  *valid_ctxt = xmlSchemaNewValidCtxt(*schema);
-  /* unable to create a validation context for the schema */
-  if (*valid_ctxt == NULL)
-    return -4;
+  /* Open file to write to, with no compression */
+  writer = xmlNewTextWriterFilename(file.c_str(), 0);
+  if (writer == NULL)
+    throw exc::flame_io_exception("Could not load data schema file");
+  writeDataSchema(writer, model);
 
-  return 0;
+  /* Free the xml writer */
+  xmlFreeTextWriter(writer);
 }
 
-void IOXMLPop::validateData(std::string const& data_file,
-    std::string const& schema_file) {
+xmlDocPtr IOXMLPop::createDataSchemaDoc(flame::model::XModel * model) {
   xmlDocPtr doc = NULL;
-  xmlSchemaValidCtxtPtr valid_ctxt = NULL;
-  xmlSchemaParserCtxtPtr parser_ctxt = NULL;
-  xmlSchemaPtr schema = NULL;
-  xmlDocPtr schema_doc = NULL;
-  int rc;
+  /* The xml text writer, building a document in memory */
+  xmlTextWriterPtr writer = xmlNewTextWriterDoc(&doc, 0);
+  if (writer == NULL)
+    throw exc::flame_io_exception("Could not create data schema");
+  writeDataSchema(writer, model);
 
-  /* Try and open pop data xml */
-  openXMLDoc(&doc, data_file);
-  /* If successful try and open schema */
-  openXMLSchema(&valid_ctxt, schema_file, &parser_ctxt, &schema, &schema_doc);
-
-  /* 0 if valid, positive error code otherwise
-   * -1 in case of internal or API error */
-  rc = xmlSchemaValidateDoc(valid_ctxt, doc);
-
-  /* Free all pointers */
-  xmlSchemaFreeValidCtxt(valid_ctxt);
-  xmlSchemaFree(schema);
-  xmlSchemaFreeParserCtxt(parser_ctxt);
-  xmlFreeDoc(schema_doc);
-  xmlFreeDoc(doc);
-
-  // check error code from validation
-  if (rc == -1) {
-    throw exc::flame_io_exception("Internal error validating pop file");
-  } else if (rc != 0) {
-    throw exc::flame_io_exception("Error validating pop file");
-  }
+  /* Free the xml writer, this leaves the document */
+  xmlFreeTextWriter(writer);
+  if (doc == NULL)
+    throw exc::flame_io_exception("Could not create data schema");
+  return doc;
 }
 
 void IOXMLPop::processStartNode(std::vector<std::string> * tags,
     std::string name, xmlTextReaderPtr reader) {
+  /* Delta output does not hold the whole population */
+  if (tags->size() == 0 && name == "states") {
+    xmlChar * delta = xmlTextReaderGetAttribute(reader, BAD_CAST "delta");
+    bool is_delta = delta != NULL && (xmlStrEqual(delta, BAD_CAST "true") ||
+        xmlStrEqual(delta, BAD_CAST "1"));
+    xmlFree(delta);
+    if (is_delta) {
+      xmlFreeTextReader(reader);
+      throw exc::invalid_pop_file(
+          "Delta pop files only hold written variables and cannot be read");
+    }
+  }
   /* If correct tag at correct depth with
    * correct tag name */
   if ((tags->size() == 0 && name == "states")
@@ -452,54 +709,26 @@ void IOXMLPop::processStartNode(std::vector<std::string> * tags,
   }
 }
 
-template<class T>
-int IOXMLPop::processTextVariableCast(std::string value,
-    std::vector<std::string> * tags, model::XMachine ** agent,
-    xmlTextReaderPtr reader) {
-  flame::mem::MemoryManager& memoryManager =
-      flame::mem::MemoryManager::GetInstance();
-  T typeValue;
-  // Try and cast string to type
-  try {
-    typeValue = boost::lexical_cast<T>(value);
-    // Catch exception
-  } catch(const boost::bad_lexical_cast&) {
+int IOXMLPop::processTextVariable(const char * value,
+    std::vector<std::string> * tags, xmlTextReaderPtr reader) {
+  const std::string& name = tags->back();
+  const VarLayout * var =
+      layouts_[current_layout_].getVar(name.data(), name.size());
+  /* Check if variable is part of the agent */
+  if (var == 0) {
     xmlFreeTextReader(reader);
     throw exc::invalid_pop_file(
-        std::string("Variable could not be cast to correct type: ").append(
-            value).append(" in ").append(tags->back()));
+        std::string("Agent variable is not recognised: ").append(name));
   }
-  // Add value to memory manager
-  std::vector<T>* vec = memoryManager.GetVector<T>((*agent)->getName(),
-      tags->back());
-  vec->push_back(typeValue);
-
-  return 0;
-}
-
-int IOXMLPop::processTextVariable(std::string value,
-    std::vector<std::string> * tags, model::XMachine ** agent,
-    xmlTextReaderPtr reader) {
-  int rc;
-  /* Get pointer to variable type */
-  model::XVariable * var = (*agent)->getVariable(tags->back());
-  /* Check if variable is part of the agent */
-  if (var) {
-    /* Check variable type for casting and
-     * use appropriate casting function */
-    if (var->getType() == "int") {
-      rc = processTextVariableCast<int>(value, tags, agent, reader);
-      if (rc != 0)
-        return rc;
-    } else if (var->getType() == "double") {
-      rc = processTextVariableCast<double>(value, tags, agent, reader);
-      if (rc != 0)
-        return rc;
-    }
-  } else {
+  /* Dynamic arrays are not held in agent memory */
+  if (var->skip) return 0;
+  /* Append values to agent memory */
+  if (!parseValue(value, value + strlen(value), *var,
+      &appenders_[current_layout_])) {
     xmlFreeTextReader(reader);
     throw exc::invalid_pop_file(
-        std::string("Agent variable is not recognised: ").append(tags->back()));
+        std::string("Variable could not be parsed: ").append(
+            value).append(" in ").append(name));
   }
 
   return 0;
@@ -510,8 +739,8 @@ int IOXMLPop::processTextAgent(std::vector<std::string> * tags,
   int rc = 0;
 
   /* Read value */
-  std::string value = reinterpret_cast<const char*>(xmlTextReaderConstValue(
-      reader));
+  const char * value = reinterpret_cast<const char*>(
+      xmlTextReaderConstValue(reader));
   /* If tag is the agent name */
   if (tags->back() == "name") {
     /* Check if agent is part of this model */
@@ -522,9 +751,16 @@ int IOXMLPop::processTextAgent(std::vector<std::string> * tags,
       throw exc::invalid_pop_file(
           std::string("Agent type is not recognised: ").append(value));
     }
+    /* Find the layout of the agent in agent memory */
+    current_layout_ = findLayout(layouts_, value, strlen(value));
+    if (current_layout_ == layouts_.size()) {
+      xmlFreeTextReader(reader);
+      throw exc::invalid_pop_file(
+          std::string("Agent type is not held in memory: ").append(value));
+    }
   } else {
     if (*agent) /* Check if agent exists */
-      rc = processTextVariable(value, tags, agent, reader);
+      rc = processTextVariable(value, tags, reader);
   }
 
   return rc;
@@ -679,4 +915,23 @@ void IOXMLPop::endXMLDoc(xmlTextWriterPtr writer) {
 void IOXMLPop::setIteration(size_t i) {
   iteration_ = i;
 }
+
+std::string IOXMLPop::outputFileName() {
+  /* Check a path has been set */
+  if (!xmlPopPathIsSet()) {
+    throw exc::flame_io_exception("Path not set");
+  }
+  std::string file_name = xml_pop_path;
+  file_name.append(boost::lexical_cast<std::string>(iteration_));
+  file_name.append(".xml");
+  /* Compressed files are read back transparently by libxml2 */
+  if (compression_ > 0) file_name.append(".gz");
+  return file_name;
+}
+
+void IOXMLPop::setCompression(int level) {
+  if (level < 0 || level > 9)
+    throw exc::flame_io_exception("compression level must be 0 to 9");
+  compression_ = level;
+}
 }}}  // namespace flame::io::xml
@@ -11,12 +11,16 @@
 #define IO__XML_POP_HPP_
 #include <libxml/xmlreader.h>
 #include <libxml/xmlwriter.h>
+#include <boost/shared_ptr.hpp>
 #include <boost/variant.hpp>
 #include <string>
 #include <vector>
 #include <map>
 #include "flame2/mem/memory_manager.hpp"
 #include "flame2/model/xmodel.hpp"
+#include "pop_layout.hpp"
+#include "output_backend.hpp"
+#include "pop_snapshot.hpp"
 
 namespace model = flame::model;
 
@@ -26,26 +30,42 @@ typedef std::vector<int>* intVecPtr;
 typedef std::vector<double>* doubleVecPtr;
 typedef std::map<std::string, std::vector<std::string> > agentVarMap;
 
-class IOXMLPop {
+class DataSchema;
+
+class IOXMLPop : public OutputBackend {
   public:
     IOXMLPop();
     void readPop(std::string file_name,
         model::XModel * model);
-    void writePop(std::string agent_name, std::string var_name);
     void initialiseData();
     void finaliseData();
+    //! Takes a copy of the population, or if written is given of the
+    //! variables written by agent functions only
+    PopSnapshotPtr createSnapshot(const WrittenVariables * written = 0);
+    void writeSnapshot(PopSnapshot * snapshot);
     void createDataSchema(std::string const& file,
         flame::model::XModel * model);
-    void validateData(std::string const& data_file,
-        std::string const& schema_file);
     bool xmlPopPathIsSet();
     std::string xmlPopPath();
     void setXmlPopPath(std::string path);
     void setIteration(size_t i);
+    //! Returns the name of the file output of the current iteration is
+    //! written to
+    std::string outputFileName();
+    //! Sets the gzip compression level of output, 0 for no compression
+    void setCompression(int level);
+    //! Sets the agent variables written out from the model
+    void saveAgentVariableData(model::XModel * model);
+    //! Returns the parts of a model the data schema depends on as a string
+    static std::string dataSchemaKey(flame::model::XModel * model);
+    //! Returns a hash of the data schema key of a model
+    static size_t dataSchemaHash(flame::model::XModel * model);
 
   private:
-    void saveAgentVariableData(model::XModel * model);
-    void writeAgents(xmlTextWriterPtr writer);
+    void writeAgents(xmlTextWriterPtr writer, PopSnapshot * snapshot);
+    void writeDataSchema(xmlTextWriterPtr writer,
+        flame::model::XModel * model);
+    xmlDocPtr createDataSchemaDoc(flame::model::XModel * model);
     void createDataSchemaHead(xmlTextWriterPtr writer);
     void createDataSchemaAgentNameType(xmlTextWriterPtr writer,
         flame::model::XModel * model);
@@ -76,18 +96,10 @@ class IOXMLPop {
         std::string name2, std::string value2,
         std::string name3, std::string value3);
     void endXMLDoc(xmlTextWriterPtr writer);
-    void openXMLDoc(xmlDocPtr * doc, std::string const& data_file);
-    int openXMLSchema(xmlSchemaValidCtxtPtr * valid_ctxt, std::string
-        const& schema_file, xmlSchemaParserCtxtPtr * parser_ctxt,
-        xmlSchemaPtr * schema, xmlDocPtr * schema_doc);
     void processStartNode(std::vector<std::string> * tags, std::string name,
         xmlTextReaderPtr reader);
-    template <class T>
-    int processTextVariableCast(std::string value,
-        std::vector<std::string> * tags,
-        model::XMachine ** agent, xmlTextReaderPtr reader);
-    int processTextVariable(std::string value, std::vector<std::string> * tags,
-        model::XMachine ** agent, xmlTextReaderPtr reader);
+    int processTextVariable(const char * value,
+        std::vector<std::string> * tags, xmlTextReaderPtr reader);
     int processTextAgent(std::vector<std::string> * tags,
         xmlTextReaderPtr reader,
         model::XMachine ** agent, model::XModel * model);
@@ -97,8 +109,24 @@ class IOXMLPop {
         std::vector<std::string> * tags, model::XMachine ** agent);
     std::string xml_pop_path;
     size_t iteration_;
+    //! Compression level of output files
+    int compression_;
     bool xml_pop_path_is_set;
     agentVarMap agentVarMap_;
+    //! Model of the population, used to format compound variables
+    model::XModel * model_;
+    //! Layouts of the agents held in memory, compiled when reading
+    AgentLayouts layouts_;
+    //! Appenders to the memory columns of each agent layout
+    boost::ptr_vector<ColumnAppenders> appenders_;
+    //! Layout of the agent being read
+    size_t current_layout_;
+    //! Data schema of the last model read, kept for reading more files
+    boost::shared_ptr<DataSchema> schema_;
+    //! Hash of the model the data schema was created for
+    size_t schema_hash_;
+    //! Data schema key of the model the data schema was created for
+    std::string schema_key_;
 };
 }}}  // namespace flame::io::xml
 #endif  // IO__XML_POP_HPP_
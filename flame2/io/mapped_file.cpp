@@ -0,0 +1,68 @@
+/*!
+ * \file flame2/io/mapped_file.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief MappedFile: read-only view of the contents of a file
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <string>
+#include "flame2/config.hpp"
+#include "flame2/exceptions/io.hpp"
+#include "mapped_file.hpp"
+
+namespace exc = flame::exceptions;
+
+namespace flame { namespace io {
+
+MappedFile::MappedFile(const std::string& file_name, bool map)
+    : map_(NULL), size_(0) {
+  struct stat st;
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) throw exc::inaccessable_file("Unable to open file");
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw exc::inaccessable_file("Unable to open file");
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0) {
+    void* region = map ? mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0)
+                       : MAP_FAILED;
+    if (region != MAP_FAILED) {
+      map_ = region;
+      /* Files are generally processed front to back */
+      madvise(map_, size_, MADV_SEQUENTIAL);
+    } else {
+      buffer_.resize(size_);
+      size_t pos = 0;
+      while (pos < size_) {
+        ssize_t r = read(fd, &buffer_[pos], size_ - pos);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+          close(fd);
+          throw exc::inaccessable_file("Unable to read file");
+        }
+        pos += static_cast<size_t>(r);
+      }
+    }
+  }
+  /* A mapping stays valid after the file is closed */
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (map_) munmap(map_, size_);
+}
+
+const char* MappedFile::data() const {
+  if (map_) return static_cast<const char*>(map_);
+  return buffer_.empty() ? NULL : &buffer_[0];
+}
+
+}}  // namespace flame::io
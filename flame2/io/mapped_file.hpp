@@ -0,0 +1,50 @@
+/*!
+ * \file flame2/io/mapped_file.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief MappedFile: read-only view of the contents of a file
+ */
+#ifndef IO__MAPPED_FILE_HPP_
+#define IO__MAPPED_FILE_HPP_
+#include <string>
+#include <vector>
+
+namespace flame { namespace io {
+
+/*!
+ * \brief Read-only view of the contents of a whole file
+ *
+ * The file is mapped privately so pages are only read in from disk when
+ * they are accessed, without read() calls or intermediate buffers. If the
+ * file cannot be mapped, or map is false, it is read into a buffer instead.
+ *
+ * Throws flame::exceptions::inaccessable_file if the file cannot be opened.
+ */
+class MappedFile {
+  public:
+    explicit MappedFile(const std::string& file_name, bool map = true);
+    ~MappedFile();
+
+    //! Returns true if the file is mapped rather than read into a buffer
+    bool is_mapped() const { return map_ != NULL; }
+
+    //! Returns the contents of the file, NULL if it is empty
+    const char* data() const;
+
+    //! Returns the size of the file
+    size_t size() const { return size_; }
+
+  private:
+    void* map_;  //! Mapped file, NULL if not mapped
+    size_t size_;  //! Size of file
+    std::vector<char> buffer_;  //! File contents if file is not mapped
+
+    MappedFile(const MappedFile&);  //! Disable copy ctor
+    void operator=(const MappedFile&);  //! Disable assignment
+};
+
+}}  // namespace flame::io
+#endif  // IO__MAPPED_FILE_HPP_
@@ -0,0 +1,39 @@
+/*!
+ * \file flame2/io/output_backend.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief OutputBackend: interface of population output formats
+ */
+#ifndef IO__OUTPUT_BACKEND_HPP_
+#define IO__OUTPUT_BACKEND_HPP_
+#include <string>
+#include "pop_snapshot.hpp"
+
+namespace flame { namespace io {
+
+/*!
+ * \brief Writer of population output in a given format
+ *
+ * The IOManager decides when output is written and which variables it
+ * holds, backends only serialise it. writeSnapshot() may be called from the
+ * background writer thread, one snapshot at a time.
+ */
+class OutputBackend {
+  public:
+    virtual ~OutputBackend() {}
+    //! Sets the iteration output is written for
+    virtual void setIteration(size_t i) = 0;
+    //! Returns the name of the file, or directory, output of the current
+    //! iteration is written to
+    virtual std::string outputFileName() = 0;
+    //! Writes the population straight from agent memory
+    virtual void finaliseData() = 0;
+    //! Writes a snapshot of the population
+    virtual void writeSnapshot(PopSnapshot * snapshot) = 0;
+};
+
+}}  // namespace flame::io
+#endif  // IO__OUTPUT_BACKEND_HPP_
@@ -0,0 +1,254 @@
+/*!
+ * \file flame2/io/parallel_pop_reader.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief ParallelPopReader: multithreaded reading of population XML files
+ */
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include "flame2/config.hpp"
+#include "flame2/mem/memory_manager.hpp"
+#include "flame2/mem/data_type.hpp"
+#include "flame2/exceptions/io.hpp"
+#include "mapped_file.hpp"
+#include "pop_layout.hpp"
+#include "parallel_pop_reader.hpp"
+
+namespace model = flame::model;
+namespace mem = flame::mem;
+namespace exc = flame::exceptions;
+
+namespace flame { namespace io { namespace xml {
+
+const size_t ParallelPopReader::kDefaultMinChunkSize;
+
+typedef boost::ptr_vector<mem::VectorWrapperBase> Columns;
+
+//! Minimal scanner for the plain population XML layout
+class Scanner {
+  public:
+    Scanner(const char * begin, const char * end) : p_(begin), end_(end) {}
+
+    bool AtEnd() {
+      SkipSpace();
+      return p_ == end_;
+    }
+
+    //! Matches an opening or closing tag with the given name
+    bool Tag(const std::string& name, bool close) {
+      SkipSpace();
+      size_t n = name.size();
+      size_t prefix = close ? 2 : 1;
+      if (static_cast<size_t>(end_ - p_) < n + prefix + 1) return false;
+      if (p_[0] != '<' || (close && p_[1] != '/')) return false;
+      if (memcmp(p_ + prefix, name.data(), n) != 0) return false;
+      if (p_[prefix + n] != '>') return false;
+      p_ += prefix + n + 1;
+      return true;
+    }
+
+    //! Matches the text up to the next tag, text with entities is rejected
+    bool Text(const char ** begin, const char ** end) {
+      const char * lt = static_cast<const char*>(
+          memchr(p_, '<', static_cast<size_t>(end_ - p_)));
+      if (lt == 0) return false;
+      if (memchr(p_, '&', static_cast<size_t>(lt - p_)) != 0) return false;
+      *begin = p_;
+      *end = lt;
+      p_ = lt;
+      return true;
+    }
+
+    //! Skips an XML declaration if present
+    bool SkipDeclaration() {
+      SkipSpace();
+      if (end_ - p_ < 5 || memcmp(p_, "<?xml", 5) != 0) return true;
+      const char * q = std::search(p_, end_, "?>", "?>" + 2);
+      if (q == end_) return false;
+      p_ = q + 2;
+      return true;
+    }
+
+  private:
+    const char * p_;
+    const char * end_;
+
+    void SkipSpace() {
+      while (p_ < end_ && isspace(static_cast<unsigned char>(*p_))) ++p_;
+    }
+};
+
+//! Agents parsed from a range of a pop file
+struct ChunkResult {
+  ChunkResult() : ok(false) {}
+  bool ok;  //! Range was parsed successfully
+  std::vector<Columns*> columns;  //! Columns of each agent layout
+  //! Appenders to the columns of each agent layout
+  std::vector<ColumnAppenders*> appenders;
+  ~ChunkResult() {
+    for (size_t ii = 0; ii < columns.size(); ++ii) delete columns[ii];
+    for (size_t ii = 0; ii < appenders.size(); ++ii) delete appenders[ii];
+  }
+};
+
+//! Parses the agents in a range of a pop file
+static void parseChunk(const char * begin, const char * end,
+    const AgentLayouts * layouts, ChunkResult * result) {
+  try {
+    AgentLayouts::const_iterator a;
+    std::vector<VarLayout>::const_iterator v;
+    for (a = layouts->begin(); a != layouts->end(); ++a) {
+      Columns * columns = new Columns();
+      result->columns.push_back(columns);
+      std::vector<mem::VectorWrapperBase*> clones;
+      for (size_t ii = 0; ii < (*a).columns.size(); ++ii) {
+        columns->push_back((*a).columns[ii]->clone_empty());
+        clones.push_back(&columns->back());
+      }
+      ColumnAppenders * appenders = new ColumnAppenders();
+      result->appenders.push_back(appenders);
+      createAppenders(*a, clones, appenders);
+    }
+
+    Scanner s(begin, end);
+    const char * tb;
+    const char * te;
+    while (!s.AtEnd()) {
+      if (!s.Tag("xagent", false) || !s.Tag("name", false) ||
+          !s.Text(&tb, &te) || !s.Tag("name", true)) return;
+      size_t index = findLayout(*layouts, tb, static_cast<size_t>(te - tb));
+      if (index == layouts->size()) return;
+      const AgentLayout& layout = (*layouts)[index];
+      for (v = layout.vars.begin(); v != layout.vars.end(); ++v) {
+        if (!s.Tag((*v).name, false) || !s.Text(&tb, &te) ||
+            !s.Tag((*v).name, true)) return;
+        if (!(*v).skip &&
+            !parseValue(tb, te, *v, result->appenders[index])) return;
+      }
+      if (!s.Tag("xagent", true)) return;
+    }
+    result->ok = true;
+  } catch(...) {
+    result->ok = false;
+  }
+}
+
+//! Checks the text before the first agent, i.e. XML declaration, states
+//! and itno tags
+static bool checkPrologue(const char * begin, const char * end) {
+  Scanner s(begin, end);
+  const char * tb;
+  const char * te;
+  if (!s.SkipDeclaration() || !s.Tag("states", false)) return false;
+  if (!s.AtEnd()) {
+    if (!s.Tag("itno", false) || !s.Text(&tb, &te) || !s.Tag("itno", true))
+      return false;
+    long itno;
+    if (!mem::ParseLong(tb, te, &itno)) return false;
+  }
+  return s.AtEnd();
+}
+
+//! Checks the text after the last agent
+static bool checkEpilogue(const char * begin, const char * end) {
+  Scanner s(begin, end);
+  return s.Tag("states", true) && s.AtEnd();
+}
+
+ParallelPopReader::ParallelPopReader(model::XModel * model,
+    size_t max_threads, size_t min_chunk_size)
+    : model_(model), max_threads_(max_threads),
+      min_chunk_size_(min_chunk_size) {
+  if (max_threads_ < 1) max_threads_ = 1;
+  if (min_chunk_size_ < 1) min_chunk_size_ = 1;
+}
+
+bool ParallelPopReader::readPop(const std::string& file_name) {
+  static const std::string open_tag = "<xagent>";
+  static const std::string close_tag = "</xagent>";
+
+  boost::scoped_ptr<MappedFile> file;
+  try {
+    file.reset(new MappedFile(file_name));
+  } catch(const exc::flame_io_exception&) {
+    return false;
+  }
+  if (file->size() == 0) return false;
+  const char * data = file->data();
+  const char * data_end = data + file->size();
+
+  /* Find the agents */
+  const char * first = std::search(data, data_end,
+      open_tag.begin(), open_tag.end());
+  const char * last = std::find_end(data, data_end,
+      close_tag.begin(), close_tag.end());
+  if (first == data_end || last == data_end) {
+    first = last = std::search(data, data_end, "</states>",
+        "</states>" + 9);
+  } else {
+    last += close_tag.size();
+  }
+  if (first > last || !checkPrologue(data, first) ||
+      !checkEpilogue(last, data_end)) return false;
+
+  AgentLayouts layouts;
+  compileLayouts(&layouts, model_);
+
+#ifndef TESTBUILD
+  printf("Reading file: %s\n", file_name.c_str());
+#endif
+
+  /* Split agents into ranges aligned on agent tags */
+  size_t size = static_cast<size_t>(last - first);
+  size_t chunks = std::min(max_threads_, size / min_chunk_size_);
+  if (chunks < 1) chunks = 1;
+  std::vector<const char*> bounds(1, first);
+  for (size_t ii = 1; ii < chunks; ++ii) {
+    const char * target = first + ii * (size / chunks);
+    if (target < bounds.back()) continue;
+    const char * b = std::search(target, last,
+        open_tag.begin(), open_tag.end());
+    if (b != last) bounds.push_back(b);
+  }
+  bounds.push_back(last);
+
+  /* Parse ranges concurrently, the first one on this thread */
+  size_t count = bounds.size() - 1;
+  boost::ptr_vector<ChunkResult> results;
+  for (size_t ii = 0; ii < count; ++ii) results.push_back(new ChunkResult());
+  boost::thread_group threads;
+  for (size_t ii = 1; ii < count; ++ii)
+    threads.create_thread(boost::bind(&parseChunk, bounds[ii],
+        bounds[ii + 1], &layouts, &results[ii]));
+  parseChunk(bounds[0], bounds[1], &layouts, &results[0]);
+  threads.join_all();
+  for (size_t ii = 0; ii < count; ++ii)
+    if (!results[ii].ok) return false;
+
+  /* Append ranges to agent memory in file order */
+  for (size_t a = 0; a < layouts.size(); ++a) {
+    std::vector<mem::VectorWrapperBase*>& columns = layouts[a].columns;
+    for (size_t c = 0; c < columns.size(); ++c) {
+      size_t total = columns[c]->size();
+      for (size_t ii = 0; ii < count; ++ii)
+        total += (*results[ii].columns[a])[c].size();
+      columns[c]->reserve(total);
+      for (size_t ii = 0; ii < count; ++ii)
+        columns[c]->Extend(&(*results[ii].columns[a])[c]);
+    }
+  }
+  return true;
+}
+
+}}}  // namespace flame::io::xml
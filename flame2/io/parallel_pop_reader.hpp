@@ -0,0 +1,56 @@
+/*!
+ * \file flame2/io/parallel_pop_reader.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief ParallelPopReader: multithreaded reading of population XML files
+ */
+#ifndef IO__PARALLEL_POP_READER_HPP_
+#define IO__PARALLEL_POP_READER_HPP_
+#include <string>
+#include "flame2/model/xmodel.hpp"
+
+namespace flame { namespace io { namespace xml {
+
+/*!
+ * \brief Reads population XML files using multiple threads
+ *
+ * The file is mapped into memory and split into byte ranges aligned on
+ * \c \<xagent\> tags. Ranges are parsed concurrently into per-thread copies
+ * of the agent memory columns which are then appended to agent memory in
+ * file order, so agents end up in the same order as when read serially.
+ *
+ * Only the plain layout written by IOXMLPop is handled: tags without
+ * attributes, no comments, entities or CDATA sections, and agent variables
+ * in the order they are defined in the model. readPop() returns false for
+ * any other file, or for a file that is not valid for the model, without
+ * modifying agent memory so it can be read by the validating serial reader
+ * instead, which reports errors.
+ */
+class ParallelPopReader {
+  public:
+    //! Files are split in ranges of at least this many bytes by default
+    static const size_t kDefaultMinChunkSize = 1 << 20;
+
+    /*!
+     * \param[in] model The model of the population
+     * \param[in] max_threads Max number of threads used to parse a file
+     * \param[in] min_chunk_size Min number of bytes parsed by a thread
+     */
+    ParallelPopReader(model::XModel * model, size_t max_threads,
+        size_t min_chunk_size = kDefaultMinChunkSize);
+
+    //! Reads a pop file into agent memory, returns false if the file could
+    //! not be read and agent memory was left untouched
+    bool readPop(const std::string& file_name);
+
+  private:
+    model::XModel * model_;  //! Model of the population
+    size_t max_threads_;  //! Max number of threads
+    size_t min_chunk_size_;  //! Min number of bytes per thread
+};
+
+}}}  // namespace flame::io::xml
+#endif  // IO__PARALLEL_POP_READER_HPP_
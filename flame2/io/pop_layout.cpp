@@ -0,0 +1,179 @@
+/*!
+ * \file flame2/io/pop_layout.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Layout of agent variable values in population XML files
+ */
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "flame2/config.hpp"
+#include "flame2/mem/memory_manager.hpp"
+#include "flame2/exceptions/base.hpp"
+#include "pop_layout.hpp"
+
+namespace model = flame::model;
+namespace mem = flame::mem;
+namespace exc = flame::exceptions;
+
+namespace flame { namespace io { namespace xml {
+
+const VarLayout * AgentLayout::getVar(const char * var_name,
+    size_t length) const {
+  std::vector<VarLayout>::const_iterator v;
+  for (v = vars.begin(); v != vars.end(); ++v)
+    if ((*v).name.size() == length &&
+        memcmp((*v).name.data(), var_name, length) == 0) return &(*v);
+  return 0;
+}
+
+/*!
+ * \brief Compiles the layout of a variable value
+ * \return False if the variable does not match agent memory
+ *
+ * Follows the brace format of static arrays and data types used by
+ * IOXMLPop, e.g. {1, {2, 3}}.
+ */
+static bool compileTokens(std::vector<LayoutToken> * tokens,
+    model::XVariable * variable, const std::string& name,
+    const std::string& agent_name, model::XModel * model) {
+  mem::MemoryManager& mm = mem::MemoryManager::GetInstance();
+  boost::ptr_vector<model::XVariable>::iterator vit;
+  size_t ii, count = 1;
+
+  if (variable->isStaticArray()) {
+    count = variable->getStaticArraySize();
+    tokens->push_back(LayoutToken(LayoutToken::kOpen, false, 0));
+  }
+  for (ii = 0; ii < count; ++ii) {
+    if (ii > 0) tokens->push_back(LayoutToken(LayoutToken::kComma, false, 0));
+    if (variable->hasADTType()) {
+      model::XADT * adt = model->getADT(variable->getType());
+      if (adt == 0) return false;
+      tokens->push_back(LayoutToken(LayoutToken::kOpen, false, 0));
+      for (vit = adt->getVariables()->begin();
+          vit != adt->getVariables()->end(); ++vit) {
+        if (vit != adt->getVariables()->begin())
+          tokens->push_back(LayoutToken(LayoutToken::kComma, false, 0));
+        if (!compileTokens(tokens, &(*vit), name + "." + (*vit).getName(),
+            agent_name, model)) return false;
+      }
+      tokens->push_back(LayoutToken(LayoutToken::kClose, false, 0));
+    } else {
+      const mem::DataTypeBase * type =
+          mem::DataTypeRegistry::GetInstance().GetType(variable->getType());
+      size_t var_id = 0;
+      if (type) {
+        try {
+          var_id = mm.GetVarId(agent_name, name);
+        } catch(const exc::flame_exception&) {
+          return false;
+        }
+        if (*(mm.GetVectorWrapper(agent_name, var_id)->GetDataType()) !=
+            *(type->GetDataType())) return false;
+      }
+      tokens->push_back(LayoutToken(LayoutToken::kValue, type != 0, var_id));
+    }
+  }
+  if (variable->isStaticArray())
+    tokens->push_back(LayoutToken(LayoutToken::kClose, false, 0));
+  return true;
+}
+
+void compileLayouts(AgentLayouts * layouts, model::XModel * model) {
+  mem::MemoryManager& mm = mem::MemoryManager::GetInstance();
+  mem::DataTypeRegistry& registry = mem::DataTypeRegistry::GetInstance();
+  boost::ptr_vector<model::XMachine>::iterator agent;
+  boost::ptr_vector<model::XVariable>::iterator vit;
+
+  for (agent = model->getAgents()->begin();
+      agent != model->getAgents()->end(); ++agent) {
+    const std::string& agent_name = (*agent).getName();
+    if (!mm.IsRegisteredAgent(agent_name)) continue;
+    AgentLayout * layout = new AgentLayout();
+    layouts->push_back(layout);
+    layout->name = agent_name;
+    bool valid = true;
+    for (vit = (*agent).getVariables()->begin();
+        vit != (*agent).getVariables()->end() && valid; ++vit) {
+      layout->vars.push_back(VarLayout((*vit).getName()));
+      VarLayout& var = layout->vars.back();
+      /* Dynamic arrays are not held in agent memory */
+      if ((*vit).isDynamicArray() || (*vit).holdsDynamicArray())
+        var.skip = true;
+      else
+        valid = compileTokens(&var.tokens, &(*vit), (*vit).getName(),
+            agent_name, model);
+    }
+    const std::vector<std::string>& var_names = mm.GetVarNames(agent_name);
+    for (size_t ii = 0; ii < var_names.size() && valid; ++ii) {
+      mem::VectorWrapperBase * column = mm.GetVectorWrapper(agent_name, ii);
+      const mem::DataTypeBase * type =
+          registry.GetTypeByDataType(*(column->GetDataType()));
+      /* Columns of unregistered types cannot be parsed */
+      if (type == 0) valid = false;
+      layout->columns.push_back(column);
+      layout->types.push_back(type);
+    }
+    if (!valid) layouts->pop_back();
+  }
+}
+
+size_t findLayout(const AgentLayouts& layouts,
+    const char * name, size_t length) {
+  size_t ii;
+  for (ii = 0; ii < layouts.size(); ++ii)
+    if (layouts[ii].name.size() == length &&
+        memcmp(layouts[ii].name.data(), name, length) == 0) break;
+  return ii;
+}
+
+void createAppenders(const AgentLayout& layout,
+    const std::vector<mem::VectorWrapperBase*>& columns,
+    ColumnAppenders * appenders) {
+  for (size_t ii = 0; ii < columns.size(); ++ii)
+    appenders->push_back(layout.types[ii]->CreateAppender(columns[ii]));
+}
+
+static const char * skipSpace(const char * p, const char * end) {
+  while (p < end && isspace(static_cast<unsigned char>(*p))) ++p;
+  return p;
+}
+
+bool parseValue(const char * p, const char * end,
+    const VarLayout& var, ColumnAppenders * appenders) {
+  std::vector<LayoutToken>::const_iterator t;
+  for (t = var.tokens.begin(); t != var.tokens.end(); ++t) {
+    p = skipSpace(p, end);
+    switch ((*t).kind) {
+      case LayoutToken::kOpen:
+        if (p == end || *p != '{') return false;
+        ++p;
+        break;
+      case LayoutToken::kClose:
+        if (p == end || *p != '}') return false;
+        ++p;
+        break;
+      case LayoutToken::kComma:
+        if (p == end || *p != ',') return false;
+        ++p;
+        break;
+      case LayoutToken::kValue:
+        {
+          const char * e = p;
+          while (e < end && *e != ',' && *e != '}') ++e;
+          if ((*t).held && !(*appenders)[(*t).var_id].ParseAppend(p, e))
+            return false;
+          p = e;
+        }
+        break;
+    }
+  }
+  return skipSpace(p, end) == end;
+}
+
+}}}  // namespace flame::io::xml
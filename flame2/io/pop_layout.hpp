@@ -0,0 +1,82 @@
+/*!
+ * \file flame2/io/pop_layout.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Layout of agent variable values in population XML files
+ */
+#ifndef IO__POP_LAYOUT_HPP_
+#define IO__POP_LAYOUT_HPP_
+#include <string>
+#include <vector>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include "flame2/mem/vector_wrapper.hpp"
+#include "flame2/mem/column_appender.hpp"
+#include "flame2/mem/data_type.hpp"
+#include "flame2/model/xmodel.hpp"
+
+namespace flame { namespace io { namespace xml {
+
+//! Part of the layout of a variable value
+struct LayoutToken {
+  enum Kind { kOpen, kClose, kComma, kValue };
+  LayoutToken(Kind k, bool h, size_t id) : kind(k), held(h), var_id(id) {}
+  Kind kind;
+  //! Value is held in agent memory
+  bool held;
+  //! Memory variable a value is appended to
+  size_t var_id;
+};
+
+//! Layout of the value of an agent variable
+struct VarLayout {
+  explicit VarLayout(const std::string& n) : name(n), skip(false) {}
+  std::string name;  //! Tag name
+  bool skip;  //! Value is not held in agent memory
+  std::vector<LayoutToken> tokens;  //! Layout of value
+};
+
+//! Layout of an agent and its memory columns
+struct AgentLayout {
+  std::string name;
+  std::vector<VarLayout> vars;  //! Variables in model order
+  std::vector<mem::VectorWrapperBase*> columns;  //! Columns by var id
+  std::vector<const mem::DataTypeBase*> types;  //! Column types by var id
+
+  //! Returns the layout of a variable given its tag name, or NULL
+  const VarLayout * getVar(const char * var_name, size_t length) const;
+};
+
+typedef boost::ptr_vector<AgentLayout> AgentLayouts;
+//! Appenders to the memory columns of an agent, by var id
+typedef boost::ptr_vector<mem::ColumnAppenderBase> ColumnAppenders;
+
+/*!
+ * \brief Compiles the layouts of all agents held in agent memory
+ *
+ * Agents whose model variables do not match agent memory are left out.
+ */
+void compileLayouts(AgentLayouts * layouts, model::XModel * model);
+
+//! Returns the index of the layout of an agent, or layouts.size()
+size_t findLayout(const AgentLayouts& layouts,
+    const char * name, size_t length);
+
+//! Creates appenders for an agent to the given columns, which must
+//! match the layout columns
+void createAppenders(const AgentLayout& layout,
+    const std::vector<mem::VectorWrapperBase*>& columns,
+    ColumnAppenders * appenders);
+
+/*!
+ * \brief Parses the text of a variable value in [begin, end) and appends
+ * the values held in agent memory
+ * \return False if the text does not match the layout
+ */
+bool parseValue(const char * begin, const char * end,
+    const VarLayout& var, ColumnAppenders * appenders);
+
+}}}  // namespace flame::io::xml
+#endif  // IO__POP_LAYOUT_HPP_
@@ -0,0 +1,58 @@
+/*!
+ * \file flame2/io/pop_snapshot.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief PopSnapshot: copy of agent memory taken for output
+ */
+#include <string>
+#include <vector>
+#include "flame2/config.hpp"
+#include "flame2/mem/memory_manager.hpp"
+#include "pop_snapshot.hpp"
+
+namespace flame { namespace io {
+
+/*!
+ * \brief Copies the given variables of an agent from the Memory Manager
+ *
+ * Variable names are resolved to ids once and each column is copied in
+ * one go, which is a straight memory copy for the fundamental types.
+ */
+void PopSnapshot::AddAgent(const std::string& agent_name,
+                           const std::vector<std::string>& var_names) {
+  flame::mem::MemoryManager& mm = flame::mem::MemoryManager::GetInstance();
+  AgentSnapshot* agent = new AgentSnapshot(agent_name);
+  agents_.push_back(agent);
+
+  std::vector<std::string>::const_iterator it;
+  for (it = var_names.begin(); it != var_names.end(); ++it) {
+    size_t var_id = mm.GetVarId(agent_name, *it);
+    agent->AddColumn(*it, mm.GetVectorWrapper(agent_name, var_id)->clone());
+  }
+}
+
+/*!
+ * \brief Copies the variables of an agent written by agent functions
+ *
+ * Members of data type variables are held in memory variables named
+ * after the model variable, e.g. pos.x, and are copied if the model
+ * variable is written.
+ */
+void PopSnapshot::AddAgent(const std::string& agent_name,
+                           const std::vector<std::string>& var_names,
+                           const WrittenVariables& written) {
+  WrittenVariables::const_iterator w = written.find(agent_name);
+  if (w == written.end()) return;
+  std::vector<std::string> changed;
+  std::vector<std::string>::const_iterator it;
+  for (it = var_names.begin(); it != var_names.end(); ++it) {
+    std::string model_var = (*it).substr(0, (*it).find('.'));
+    if ((*w).second.count(model_var) > 0) changed.push_back(*it);
+  }
+  if (!changed.empty()) AddAgent(agent_name, changed);
+}
+
+}}  // namespace flame::io
@@ -0,0 +1,115 @@
+/*!
+ * \file flame2/io/pop_snapshot.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief PopSnapshot: copy of agent memory taken for output
+ */
+#ifndef IO__POP_SNAPSHOT_HPP_
+#define IO__POP_SNAPSHOT_HPP_
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+#include "flame2/mem/vector_wrapper.hpp"
+
+namespace flame { namespace io {
+
+//! Model variables written by agent functions, by agent name
+typedef std::map<std::string, std::set<std::string> > WrittenVariables;
+
+//! Copy of the memory columns of a single agent type
+class AgentSnapshot {
+  public:
+    typedef boost::ptr_vector<flame::mem::VectorWrapperBase> ColumnVector;
+
+    explicit AgentSnapshot(const std::string& agent_name)
+        : agent_name_(agent_name) {}
+
+    //! Returns the agent name
+    const std::string& get_agent_name() const { return agent_name_; }
+
+    //! Returns the number of agents in the snapshot
+    size_t get_size() const {
+      return columns_.empty() ? 0 : columns_.front().size();
+    }
+
+    //! Returns the names of the copied variables
+    const std::vector<std::string>& get_var_names() const {
+      return var_names_;
+    }
+
+    //! Returns the copied columns, in the same order as the var names
+    ColumnVector& get_columns() { return columns_; }
+
+    //! Takes ownership of a copy of a memory column
+    void AddColumn(const std::string& var_name,
+                   flame::mem::VectorWrapperBase* column) {
+      var_names_.push_back(var_name);
+      columns_.push_back(column);
+    }
+
+  private:
+    std::string agent_name_;  //! Name of agent
+    std::vector<std::string> var_names_;  //! Names of copied vars
+    ColumnVector columns_;  //! Copied memory columns
+};
+
+/*!
+ * \brief Copy of the population at a given iteration
+ *
+ * A snapshot is a self contained copy of the agent memory columns that are
+ * to be written out. Once taken it no longer refers to the live agent memory
+ * so it can be serialised by a background thread while the simulation
+ * progresses.
+ */
+class PopSnapshot {
+  public:
+    typedef boost::ptr_vector<AgentSnapshot> AgentVector;
+
+    PopSnapshot(const std::string& file_name, size_t iteration)
+        : file_name_(file_name), iteration_(iteration), delta_(false) {}
+
+    //! Copies the given variables of an agent from the Memory Manager
+    void AddAgent(const std::string& agent_name,
+                  const std::vector<std::string>& var_names);
+
+    //! Copies the given variables of an agent that hold a variable written
+    //! by agent functions. Agents without written variables are left out.
+    void AddAgent(const std::string& agent_name,
+                  const std::vector<std::string>& var_names,
+                  const WrittenVariables& written);
+
+    //! Takes ownership of an agent snapshot
+    void AddAgentSnapshot(AgentSnapshot* agent) { agents_.push_back(agent); }
+
+    //! Returns the name of the file the snapshot is to be written to
+    const std::string& get_file_name() const { return file_name_; }
+
+    //! Returns the iteration the snapshot was taken at
+    size_t get_iteration() const { return iteration_; }
+
+    //! Returns the agent snapshots
+    AgentVector& get_agents() { return agents_; }
+
+    //! Marks the snapshot as only holding written variables
+    void set_delta(bool delta) { delta_ = delta; }
+
+    //! Returns true if the snapshot only holds written variables
+    bool is_delta() const { return delta_; }
+
+  private:
+    std::string file_name_;  //! Output file name
+    size_t iteration_;  //! Iteration number
+    AgentVector agents_;  //! Agent snapshots
+    bool delta_;  //! Only holds written variables
+};
+
+typedef boost::shared_ptr<PopSnapshot> PopSnapshotPtr;
+
+}}  // namespace flame::io
+#endif  // IO__POP_SNAPSHOT_HPP_
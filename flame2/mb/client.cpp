@@ -17,7 +17,7 @@
 namespace flame { namespace mb {
 
 Client::Client(acl_set_type acl_read, acl_set_type acl_post)
-    : acl_read_(acl_read) {
+    : acl_read_(acl_read), count_reads_(false) {
   // we don't cache iterators since they can be modified by users, e.g.
   // randomisation, sorting, etc.
   // Instead we keep a set of msg names with read privs(acl_read_)
@@ -52,7 +52,20 @@ MessageBoard::iterator Client::GetMessages(const std::string& msg_name) {
       throw flame::exceptions::invalid_argument("Unknown message");
     }
   }
-  return MessageBoardManager::GetInstance().GetMessages(msg_name);
+  MessageBoard::iterator iter =
+      MessageBoardManager::GetInstance().GetMessages(msg_name);
+  if (count_reads_) read_counts_[msg_name] += iter->GetCount();
+  return iter;
+}
+
+count_map_type Client::GetPostCounts(void) const {
+  count_map_type counts;
+  writer_map_type::const_iterator it = writers_.begin();
+  for (; it != writers_.end(); ++it) {
+    counts.insert(count_map_type::value_type(it->first,
+                                             it->second->GetCount()));
+  }
+  return counts;
 }
 
 }}  // namespace flame::mb
@@ -55,6 +55,9 @@ typedef std::set<std::string> acl_set_type;
 typedef boost::container::flat_map<std::string,
                                    MessageBoard::writer> writer_map_type;
 
+//! datatype to map message names to message counts
+typedef boost::container::flat_map<std::string, size_t> count_map_type;
+
 //! Message board client used by end-user API for all message board interactions
 class Client {
   public:
@@ -89,9 +92,22 @@ class Client {
 
     // TODO(lsc): GetMessages(msg_name, query);  // when filtering enabled
 
+    //! Starts or stops counting the messages handed out by GetMessages()
+    void CountReads(bool enable) { count_reads_ = enable; }
+
+    //! Returns the number of messages in iterators returned for each board
+    //! while counting was enabled with CountReads()
+    const count_map_type& GetReadCounts(void) const { return read_counts_; }
+
+    //! Returns the number of messages posted through this client to each
+    //! board since the last board sync
+    count_map_type GetPostCounts(void) const;
+
   private:
     writer_map_type writers_;  //! Cache of writers for each allowed message
     acl_set_type acl_read_;  //! Names of messages client can read from
+    bool count_reads_;  //! Whether GetMessages() updates read_counts_
+    count_map_type read_counts_;  //! Messages handed out for each board
 };
 
 }}  // namespace flame::mb
@@ -21,6 +21,10 @@ size_t MessageBoard::GetCount(void) const {
   return data_->size();
 }
 
+size_t MessageBoard::GetMessageSize(void) const {
+  return data_->element_size();
+}
+
 // This is the only method that's protected by a mutex since multiple
 // worker threads may request for a board writer at the same time.
 // The actual message posting is not locked since each thread would then
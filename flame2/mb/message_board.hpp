@@ -86,6 +86,9 @@ class MessageBoard {
      */
     size_t GetCount(void) const;
 
+    //! \brief Returns the size in bytes of a message
+    size_t GetMessageSize(void) const;
+
     /*!
      * \brief Returns an BoardWriter instance
      * 
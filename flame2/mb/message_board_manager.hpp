@@ -94,6 +94,16 @@ class MessageBoardManager {
       return _GetMessageBoard(msg_name).GetCount();
     }
 
+    /*!
+     * \brief Returns the size in bytes of messages in the specified board
+     *
+     * Throws flame::exceptions::invalid_argument if unknown message name
+     * is provided.
+     */
+    inline size_t GetMessageSize(const std::string& msg_name) {
+      return _GetMessageBoard(msg_name).GetMessageSize();
+    }
+
     //! Returns true if specified name is a registered message name
     inline bool BoardExists(const std::string& msg_name) const {
       return (map_.find(msg_name) != map_.end());
@@ -8,6 +8,7 @@
  * \brief AgentMemory: management and storage class for per-agent memory vectors
  */
 #include <string>
+#include <vector>
 #include "flame2/config.hpp"
 #include "flame2/exceptions/mem.hpp"
 #include "agent_memory.hpp"
@@ -17,31 +18,176 @@ namespace flame { namespace mem {
 namespace exc = flame::exceptions;
 
 void AgentMemory::HintPopulationSize(unsigned int size_hint) {
-  if (mem_map_.size() == 0) {
+  if (mem_vec_.empty()) {
     throw exc::invalid_agent("no agent memory variables registered");
   }
   registration_closed_ = true;  // no more new variables
 
   // iterate through all vectors and reserve size based on hint
-  MemoryMap::iterator it;
-  for (it = mem_map_.begin(); it != mem_map_.end(); ++it) {
-    it->second->reserve(size_hint);
+  MemoryVector::iterator it;
+  for (it = mem_vec_.begin(); it != mem_vec_.end(); ++it) {
+    it->reserve(size_hint);
+  }
+  BufferMap::iterator bit;
+  for (bit = buffer_map_.begin(); bit != buffer_map_.end(); ++bit) {
+    bit->second->reserve(size_hint);
   }
 }
 
+/*!
+ * \brief Returns the id assigned to a variable during registration
+ *
+ * Ids are dense and start from 0 so they can be used to index into
+ * per-variable arrays. Name lookups should be done once during setup and the
+ * id used thereafter.
+ *
+ * Throws flame::exceptions::invalid_variable if the variable is unknown.
+ */
+size_t AgentMemory::GetVarId(const std::string& var_name) const {
+  VarIdMap::const_iterator it = var_id_map_.find(var_name);
+  if (it == var_id_map_.end()) {
+    throw exc::invalid_variable("Invalid agent memory variable");
+  }
+  return it->second;
+}
+
+/*!
+ * \brief Returns the ids of a variable or of all members of a compound variable
+ *
+ * Compound variables, e.g. those of a user defined data type, are stored as
+ * one variable per member named "<var_name>.<member_name>". If var_name is
+ * not itself registered, the ids of all its members are returned in order
+ * of name.
+ *
+ * Throws flame::exceptions::invalid_variable if neither the variable nor
+ * any of its members are registered.
+ */
+std::vector<size_t> AgentMemory::GetVarIds(const std::string& var_name) const {
+  std::vector<size_t> ids;
+  VarIdMap::const_iterator it = var_id_map_.find(var_name);
+  if (it != var_id_map_.end()) {
+    ids.push_back(it->second);
+    return ids;
+  }
+
+  // var ids map is sorted so members are stored consecutively
+  std::string prefix = var_name + ".";
+  for (it = var_id_map_.lower_bound(prefix); it != var_id_map_.end(); ++it) {
+    if (it->first.compare(0, prefix.size(), prefix) != 0) break;
+    ids.push_back(it->second);
+  }
+  if (ids.empty()) {
+    throw exc::invalid_variable("Invalid agent memory variable");
+  }
+  return ids;
+}
+
+const std::string& AgentMemory::GetVarName(size_t var_id) const {
+  if (var_id >= var_names_.size()) {
+    throw exc::invalid_variable("Invalid agent memory variable id");
+  }
+  return var_names_[var_id];
+}
+
 VectorWrapperBase* AgentMemory::GetVectorWrapper(const std::string& var_name) {
+  return GetVectorWrapper(GetVarId(var_name));
+}
+
+VectorWrapperBase* AgentMemory::GetVectorWrapper(size_t var_id) {
   registration_closed_ = true;  // no more new variables
-  try {
-    return &(mem_map_.at(var_name));
+  if (var_id >= mem_vec_.size()) {
+    throw exc::invalid_variable("Invalid agent memory variable id");
   }
-  catch(const boost::bad_ptr_container_operation& E) {
-    throw exc::invalid_variable("Invalid agent memory variable");
+  return &(mem_vec_[var_id]);
+}
+
+/*!
+ * \brief Enables double-buffering for a registered variable
+ *
+ * Agent functions given write access to a double-buffered variable read
+ * values from the current buffer and write to a separate write buffer. The
+ * written values only become visible once SwapBuffers() is called, which
+ * means functions reading and writing the same variable need not be
+ * serialised.
+ *
+ * Must be called before registration is closed.
+ *
+ * Throws flame::exceptions::logic_error if registration is closed or the
+ * variable is already double-buffered.
+ */
+void AgentMemory::SetBuffered(const std::string& var_name) {
+  if (registration_closed_) {
+    throw exc::logic_error("variables can no longer be registered");
+  }
+  size_t var_id = GetVarId(var_name);
+  std::pair<BufferMap::iterator, bool> ret;
+  ret = buffer_map_.insert(var_id, mem_vec_[var_id].clone_empty());
+  if (!ret.second) {
+    throw exc::logic_error("variable already buffered");
+  }
+}
+
+bool AgentMemory::IsBuffered(size_t var_id) const {
+  return (buffer_map_.find(var_id) != buffer_map_.end());
+}
+
+VectorWrapperBase* AgentMemory::GetWriteVectorWrapper(size_t var_id) {
+  BufferMap::iterator it = buffer_map_.find(var_id);
+  if (it == buffer_map_.end()) {
+    return GetVectorWrapper(var_id);
+  }
+  registration_closed_ = true;  // no more new variables
+  return it->second;
+}
+
+/*!
+ * \brief Publishes the write buffers of double-buffered variables
+ *
+ * The current and write buffers are exchanged in constant time, after which
+ * the new write buffer is refreshed with a full copy of the new current
+ * values. The copy is needed as an agent function given write access need
+ * not write every agent, and agents it skips must keep their values rather
+ * than pick up those from two iterations back. Each call is therefore linear
+ * in the population size for every double-buffered variable.
+ *
+ * This is the price of the dependencies XGraph drops for double-buffered
+ * variables: readers no longer wait for writers and writers no longer wait
+ * for readers, so they may run concurrently. The copy runs once per
+ * iteration in the agent's swap task, which the simulation can overlap with
+ * tasks of other agents and message boards.
+ *
+ * Must not be called while tasks accessing this agent are running.
+ */
+void AgentMemory::SwapBuffers() {
+  BufferMap::iterator it;
+  for (it = buffer_map_.begin(); it != buffer_map_.end(); ++it) {
+    VectorWrapperBase* current = &(mem_vec_[it->first]);
+#ifdef DEBUG
+    if (it->second->size() != current->size()) {
+      throw exc::flame_mem_exception("write buffer out of sync");
+    }
+#endif
+    current->swap(it->second);
+    it->second->assign(current);
+  }
+}
+
+/*!
+ * \brief Resets the write buffers to a copy of the current values
+ *
+ * Should be called whenever the population is modified directly, e.g. after
+ * loading a population file.
+ */
+void AgentMemory::ResetBuffers() {
+  BufferMap::iterator it;
+  for (it = buffer_map_.begin(); it != buffer_map_.end(); ++it) {
+    it->second->assign(&(mem_vec_[it->first]));
   }
 }
 
 //! Returns true if said memory variable has been registered.
 bool AgentMemory::IsRegistered(const std::string& var_name) const {
-  return (mem_map_.find(var_name) != mem_map_.end());
+  return (var_id_map_.find(var_name) != var_id_map_.end());
 }
 
 /*!
@@ -62,18 +208,18 @@ bool AgentMemory::IsRegistered(const std::string& var_name) const {
  *
  */
 size_t AgentMemory::GetPopulationSize(void) {
-  MemoryMap::iterator iter = mem_map_.begin();
-  if (iter == mem_map_.end()) {  // no memory vars
+  MemoryVector::iterator iter = mem_vec_.begin();
+  if (iter == mem_vec_.end()) {  // no memory vars
 #ifdef DEBUG
     cached_size_ = 0;
 #endif
     return 0;
   } else {
-    size_t size = iter->second->size();
+    size_t size = iter->size();
 #ifdef DEBUG
     if (size != cached_size_) {
-      for (++iter; iter != mem_map_.end(); ++iter) {
-        if (iter->second->size() != size) {
+      for (++iter; iter != mem_vec_.end(); ++iter) {
+        if (iter->size() != size) {
           throw exc::flame_mem_exception("inconsistent vector sizes");
         }
       }
@@ -9,13 +9,16 @@
  */
 #ifndef MEM__AGENT_MEMORY_HPP_
 #define MEM__AGENT_MEMORY_HPP_
+#include <map>
 #include <string>
 #include <utility>  // for std::pair
 #include <vector>
 #include <typeinfo>
 #include <boost/ptr_container/ptr_map.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 #include "flame2/exceptions/mem.hpp"
 #include "vector_wrapper.hpp"
+#include "column_appender.hpp"
 
 // TODO(lsc): review usage of AgentMemory::registration_closed_
 // Do we need it? Is there a better way to handle access to RegisterVar?
@@ -24,8 +27,12 @@ namespace flame { namespace mem {
 
 namespace exc = flame::exceptions;
 
-//! Map container used to store memory vectors
-typedef boost::ptr_map<std::string, VectorWrapperBase> MemoryMap;
+//! Dense container used to store memory vectors, indexed by variable id
+typedef boost::ptr_vector<VectorWrapperBase> MemoryVector;
+//! Map used to resolve variable names to variable ids
+typedef std::map<std::string, size_t> VarIdMap;
+//! Map of var ids to the write buffers of double-buffered variables
+typedef boost::ptr_map<size_t, VectorWrapperBase> BufferMap;
 
 
 //! Container for memory vectors associated with an agent type
@@ -38,17 +45,26 @@ class AgentMemory {
 #endif
           registration_closed_(false) {}
 
-    //! Registers a memory variable of a specific type
+    //! Registers a memory variable of a specific type.
+    //! Variables are assigned dense ids in order of registration.
+    //! Fixed size arrays are registered with a stride equal to their
+    //! length and stored flat, i.e. without a per-agent allocation.
     template <typename T>
-    void RegisterVar(std::string var_name) {
+    void RegisterVar(std::string var_name, size_t stride = 1) {
       if (registration_closed_) {
         throw exc::logic_error("variables can no longer be registered");
       }
-      std::pair<MemoryMap::iterator, bool> ret;
-      ret = mem_map_.insert(var_name, new VectorWrapper<T>());
+      if (stride == 0) {
+        throw exc::invalid_argument("stride must be > 0");
+      }
+      std::pair<VarIdMap::iterator, bool> ret;
+      ret = var_id_map_.insert(VarIdMap::value_type(var_name,
+                                                    mem_vec_.size()));
       if (!ret.second) {  // key exists. No insertion
         throw exc::logic_error("variable already registered");
       }
+      mem_vec_.push_back(new VectorWrapper<T>(stride));
+      var_names_.push_back(var_name);
     }
 
     //! Hint at a population size so required memory can be reserved
@@ -59,22 +75,59 @@ class AgentMemory {
     //! Returns the current population size
     size_t GetPopulationSize(void);
 
+    //! Returns the id assigned to a variable during registration
+    size_t GetVarId(const std::string& var_name) const;
+
+    //! Returns the ids of a variable or, for a compound variable, the
+    //! ids of all its members
+    std::vector<size_t> GetVarIds(const std::string& var_name) const;
+
+    //! Returns the name of the variable with the given id
+    const std::string& GetVarName(size_t var_id) const;
+
+    //! Returns the names of all variables indexed by variable id
+    const std::vector<std::string>& GetVarNames() const {
+      return var_names_;
+    }
+
+    //! Returns the number of registered variables
+    size_t GetVarCount() const {
+      return mem_vec_.size();
+    }
+
     //! Returns typeless pointer to associated vector wrapper
     VectorWrapperBase* GetVectorWrapper(const std::string& var_name);
 
+    //! Returns typeless pointer to vector wrapper of the given variable id
+    VectorWrapperBase* GetVectorWrapper(size_t var_id);
+
+    //! Enables double-buffering for a registered variable
+    void SetBuffered(const std::string& var_name);
+
+    //! Returns true if the variable with the given id is double-buffered
+    bool IsBuffered(size_t var_id) const;
+
+    //! Returns the vector wrapper that writes to the given variable id
+    //! should go to. This is the write buffer for double-buffered variables.
+    VectorWrapperBase* GetWriteVectorWrapper(size_t var_id);
+
+    //! Publishes the write buffers of double-buffered variables. Copies
+    //! each double-buffered variable once to refresh its write buffer.
+    void SwapBuffers();
+
+    //! Resets the write buffers to a copy of the current values
+    void ResetBuffers();
+
     //! Returns a pointer to the actual data vector
     template <typename T>
     std::vector<T>* GetVector(const std::string& var_name) {
-      VectorWrapperBase* ptr;
-      registration_closed_ = true;  // no more new variables
-
-      try {
-        ptr = &(mem_map_.at(var_name));
-      }
-      catch(const boost::bad_ptr_container_operation& E) {
-        throw exc::invalid_variable("Invalid agent memory variable");
-      }
+      return GetVector<T>(GetVarId(var_name));
+    }
 
+    //! Returns a pointer to the actual data vector given a variable id
+    template <typename T>
+    std::vector<T>* GetVector(size_t var_id) {
+      VectorWrapperBase* ptr = GetVectorWrapper(var_id);
 #ifndef DISABLE_RUNTIME_TYPE_CHECKING
       if (*(ptr->GetDataType()) != typeid(T)) {
         throw exc::invalid_type("Invalid data type specified");
@@ -83,12 +136,27 @@ class AgentMemory {
       return static_cast<std::vector<T>*>(ptr->GetVectorPtr());
     }
 
+    //! Returns an appender of values to a variable
+    template <typename T>
+    ColumnAppender<T> GetAppender(const std::string& var_name) {
+      return ColumnAppender<T>(GetVector<T>(var_name));
+    }
+
+    //! Returns an appender of values to a variable given a variable id
+    template <typename T>
+    ColumnAppender<T> GetAppender(size_t var_id) {
+      return ColumnAppender<T>(GetVector<T>(var_id));
+    }
+
     //! Returns true if said memory variable has been registered.
     bool IsRegistered(const std::string& var_name) const;
 
   private:
     std::string agent_name_;  //! Name of agent
-    MemoryMap mem_map_;  //! Map of var names to VectorWrapper
+    MemoryVector mem_vec_;  //! VectorWrappers indexed by var id
+    VarIdMap var_id_map_;  //! Map of var names to var ids
+    std::vector<std::string> var_names_;  //! var names indexed by var id
+    BufferMap buffer_map_;  //! Write buffers of double-buffered vars
 #ifdef DEBUG
     size_t cached_size_;
 #endif
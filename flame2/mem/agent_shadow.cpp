@@ -9,6 +9,7 @@
  */
 #include <utility>
 #include <string>
+#include <vector>
 #include "flame2/config.hpp"
 #include "vector_wrapper.hpp"
 #include "memory_iterator.hpp"
@@ -19,21 +20,41 @@ namespace flame { namespace mem {
 AgentShadow::AgentShadow(AgentMemory* am)
     : am_(am) {}
 
+// Access to a compound variable grants access to all its members
 void AgentShadow::AllowAccess(const std::string& var_name,
                                       bool writeable) {
-  VectorWrapperBase* const vec_ptr = am_->GetVectorWrapper(var_name);
+  std::vector<size_t> ids = am_->GetVarIds(var_name);
+  std::vector<size_t>::const_iterator it;
+  for (it = ids.begin(); it != ids.end(); ++it) {
+    AllowAccess(*it, writeable);
+  }
+}
+
+void AgentShadow::AllowAccess(size_t var_id, bool writeable) {
+  VectorWrapperBase* const vec_ptr = am_->GetVectorWrapper(var_id);
+
+  // registration is closed at this point so the var count is final
+  if (vec_list_.size() != am_->GetVarCount()) {
+    vec_list_.resize(am_->GetVarCount(), NULL);
+    wvec_list_.resize(am_->GetVarCount(), NULL);
+  }
 
-  std::pair<ConstVectorMap::iterator, bool> ret;
-  ret = vec_map_.insert(ConstVectorMap::value_type(var_name, vec_ptr));
-  if (!ret.second) {
+  if (vec_list_[var_id] != NULL) {
     throw flame::exceptions::logic_error("variable already registered");
   }
+  vec_list_[var_id] = vec_ptr;
+  var_ids_.push_back(var_id);
 
+  // writes to double-buffered vars go to a separate write buffer
   if (writeable) {
-    rw_set_.insert(var_name);
+    wvec_list_[var_id] = am_->GetWriteVectorWrapper(var_id);
   }
 }
 
+size_t AgentShadow::GetVarId(const std::string& var_name) const {
+  return am_->GetVarId(var_name);
+}
+
 MemoryIteratorPtr AgentShadow::GetMemoryIterator() {
   return MemoryIteratorPtr(new MemoryIterator(this));
 }
@@ -50,4 +71,8 @@ bool AgentShadow::IsRegistered(const std::string& var_name) const {
   return am_->IsRegistered(var_name);
 }
 
+bool AgentShadow::IsRegistered(size_t var_id) const {
+  return var_id < am_->GetVarCount();
+}
+
 }}  //  namespace flame::mem
@@ -7,14 +7,6 @@
  * \copyright GNU Lesser General Public License
  * \brief Proxy object which only exposes selected vars of an agent
  */
-//! TODO(lsc): since the number of entries in vec_map_ and rw_set_ will be
-//! relatively small, the tree-based search used by std::map and
-//! std::set may not be ideal. Consider implementing variants that
-//! uses a sorted vector instead. See:
-//!  - AssocVector: http://loki-lib.sourceforge.net/html/a00645.html
-//!  - http://lafstern.org/matt/col1.pdf
-//!  - http://www.codeproject.com/Articles/27799/Stree
-
 //! TODO(lsc): Support task splitting. This involves:
 //!  - Creating new MemoryIterators that can be stepped through independently
 //!  - Using a counter to detect end-of-vector instead of vector::end()
@@ -23,8 +15,6 @@
 
 #ifndef MEM__AGENT_SHADOW_HPP_
 #define MEM__AGENT_SHADOW_HPP_
-#include <map>
-#include <set>
 #include <vector>
 #include <string>
 #include <utility>
@@ -36,10 +26,10 @@ class AgentMemory;  // forward declaration
 class MemoryIterator;  // forward declaration
 class VectorWrapperBase;  // forward declaration
 
-//! Map type used to store pointers to VectorWrappers
-typedef std::map<std::string, VectorWrapperBase* const> ConstVectorMap;
-//! Set type used to keep track of vars with write permission
-typedef std::set<std::string> WriteableSet;
+//! Pointers to VectorWrappers indexed by var id (NULL if not accessible)
+typedef std::vector<VectorWrapperBase*> VectorPtrList;
+//! List of var ids that have been made accessible
+typedef std::vector<size_t> VarIdList;
 //! Smart pointer type used to return MemoryIterator
 typedef boost::shared_ptr<MemoryIterator> MemoryIteratorPtr;
 
@@ -48,9 +38,13 @@ class AgentShadow {
   friend class MemoryIterator;
 
   public:
-    //! Enables access to an agent variable
+    //! Enables access to an agent variable or to all members of a
+    //! compound agent variable
     void AllowAccess(const std::string& var_name, bool writeable = false);
 
+    //! Returns the id of an agent variable
+    size_t GetVarId(const std::string& var_name) const;
+
     //! Returns the population size
     size_t get_size();
 
@@ -65,16 +59,22 @@ class AgentShadow {
     // Limit constructor to MemoryManager
     explicit AgentShadow(AgentMemory* am);
     // Accessible to MemoryIterator
-    WriteableSet rw_set_;  //! Set of var names that has write access
+    VectorPtrList vec_list_;  //! readable vars indexed by var id
     // Accessible to MemoryIterator
-    ConstVectorMap vec_map_;  //! map accessible vars
+    VectorPtrList wvec_list_;  //! writeable vars indexed by var id
+    // Accessible to MemoryIterator
+    VarIdList var_ids_;  //! ids of accessible vars in order of access
 
     bool IsRegistered(const std::string& var_name) const;
+    bool IsRegistered(size_t var_id) const;
 
   private:
     // size_t size_;  //! Size if memory vectors
     AgentMemory* am_;  //! Pointer to parent AgentMemory object
 
+    //! Enables access to an agent variable given its var id
+    void AllowAccess(size_t var_id, bool writeable);
+
     AgentShadow(const AgentShadow&);  //! Disable copy ctor
     void operator=(const AgentShadow&);  //! Disable assignment
 };
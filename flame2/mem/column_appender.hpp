@@ -0,0 +1,51 @@
+/*!
+ * \file flame2/mem/column_appender.hpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Appenders used to load values into agent memory columns
+ */
+#ifndef MEM__COLUMN_APPENDER_HPP_
+#define MEM__COLUMN_APPENDER_HPP_
+#include <vector>
+#include "value_traits.hpp"
+
+namespace flame { namespace mem {
+
+//! Type-agnostic appender of values given as text to a memory column
+class ColumnAppenderBase {
+  public:
+    virtual ~ColumnAppenderBase() {}
+
+    //! Parses the text in [begin, end) and appends the value. Returns false
+    //! if the text is not a valid value.
+    virtual bool ParseAppend(const char* begin, const char* end) = 0;
+};
+
+//! Appends values to a memory column of type T.
+//!
+//! Appenders are obtained once per column, e.g. per agent type when loading
+//! a population, so values are appended without variable lookups, type
+//! checks or per value heap allocation.
+template <typename T>
+class ColumnAppender : public ColumnAppenderBase {
+  public:
+    explicit ColumnAppender(std::vector<T>* column) : column_(column) {}
+
+    void Append(const T& value) { column_->push_back(value); }
+
+    bool ParseAppend(const char* begin, const char* end) {
+      T value;
+      if (!ValueTraits<T>::Parse(begin, end, &value)) return false;
+      column_->push_back(value);
+      return true;
+    }
+
+  private:
+    std::vector<T>* column_;  //! Column values are appended to
+};
+
+}}  // namespace flame::mem
+#endif  // MEM__COLUMN_APPENDER_HPP_
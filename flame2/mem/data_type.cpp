@@ -0,0 +1,51 @@
+/*!
+ * \file flame2/mem/data_type.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Registry of data types that can be used for agent memory variables
+ */
+#include <string>
+#include <vector>
+#include <typeinfo>
+#include <boost/cstdint.hpp>
+#include "flame2/config.hpp"
+#include "data_type.hpp"
+
+namespace flame { namespace mem {
+
+DataTypeRegistry::DataTypeRegistry() {
+  RegisterType<int>("int", "xs:integer");
+  RegisterType<double>("double", "xs:double");
+  RegisterType<float>("float", "xs:float");
+  RegisterType<boost::int64_t>("int64_t", "xs:long");
+  RegisterType<boost::uint8_t>("uint8_t", "xs:unsignedByte");
+}
+
+const DataTypeBase* DataTypeRegistry::GetType(const std::string& name) const {
+  DataTypeMap::const_iterator it = type_map_.find(name);
+  if (it == type_map_.end()) return NULL;
+  return it->second;
+}
+
+const DataTypeBase* DataTypeRegistry::GetTypeByDataType(
+    const std::type_info& type) const {
+  DataTypeMap::const_iterator it;
+  for (it = type_map_.begin(); it != type_map_.end(); ++it) {
+    if (*(it->second->GetDataType()) == type) return it->second;
+  }
+  return NULL;
+}
+
+std::vector<std::string> DataTypeRegistry::GetTypeNames() const {
+  std::vector<std::string> names;
+  DataTypeMap::const_iterator it;
+  for (it = type_map_.begin(); it != type_map_.end(); ++it) {
+    names.push_back(it->first);
+  }
+  return names;
+}
+
+}}  // namespace flame::mem
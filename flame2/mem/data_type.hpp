@@ -0,0 +1,150 @@
+/*!
+ * \file flame2/mem/data_type.hpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Registry of data types that can be used for agent memory variables
+ */
+#ifndef MEM__DATA_TYPE_HPP_
+#define MEM__DATA_TYPE_HPP_
+#include <string>
+#include <vector>
+#include <typeinfo>
+#include <boost/cstdint.hpp>
+#include <boost/ptr_container/ptr_map.hpp>
+#include "flame2/exceptions/mem.hpp"
+#include "vector_wrapper.hpp"
+#include "value_traits.hpp"
+#include "column_appender.hpp"
+#include "memory_manager.hpp"
+
+namespace flame { namespace mem {
+
+//! Type-agnostic handling of agent memory variables of a data type
+class DataTypeBase {
+  public:
+    DataTypeBase(const std::string& name, const std::string& schema_type)
+        : name_(name), schema_type_(schema_type) {}
+    virtual ~DataTypeBase() {}
+
+    //! Returns the name of the data type as used in model files
+    const std::string& get_name() const { return name_; }
+
+    //! Returns the XML schema type of values of this data type
+    const std::string& get_schema_type() const { return schema_type_; }
+
+    //! Returns the type_info of the C++ type used for storage
+    virtual const std::type_info* GetDataType() const = 0;
+
+    //! Registers an agent memory variable of this data type
+    virtual void RegisterAgentVar(const std::string& agent_name,
+                                  const std::string& var_name,
+                                  size_t stride) const = 0;
+
+    //! Parses text and appends the value to vec. Returns false if the text
+    //! is not a valid value.
+    virtual bool ParseAppend(const std::string& text,
+                             VectorWrapperBase* vec) const = 0;
+
+    //! Returns a new appender of values to vec, which must hold this type
+    virtual ColumnAppenderBase* CreateAppender(
+        VectorWrapperBase* vec) const = 0;
+
+    //! Appends the text of the element at index from ptr to out
+    virtual void Format(const void* ptr, size_t index,
+                        std::string* out) const = 0;
+
+  private:
+    std::string name_;
+    std::string schema_type_;
+};
+
+//! Handling of agent memory variables stored as type T
+template <typename T>
+class DataType : public DataTypeBase {
+  public:
+    DataType(const std::string& name, const std::string& schema_type)
+        : DataTypeBase(name, schema_type) {}
+
+    const std::type_info* GetDataType() const {
+      return &typeid(T);
+    }
+
+    void RegisterAgentVar(const std::string& agent_name,
+                          const std::string& var_name, size_t stride) const {
+      MemoryManager::GetInstance().RegisterAgentVar<T>(agent_name, var_name,
+                                                       stride);
+    }
+
+    bool ParseAppend(const std::string& text, VectorWrapperBase* vec) const {
+      if (*(vec->GetDataType()) != typeid(T)) {
+        throw flame::exceptions::invalid_type("mismatching type");
+      }
+      T value;
+      if (!ValueTraits<T>::Parse(text, &value)) return false;
+      static_cast<std::vector<T>*>(vec->GetVectorPtr())->push_back(value);
+      return true;
+    }
+
+    ColumnAppender<T>* CreateAppender(VectorWrapperBase* vec) const {
+      if (*(vec->GetDataType()) != typeid(T)) {
+        throw flame::exceptions::invalid_type("mismatching type");
+      }
+      return new ColumnAppender<T>(
+          static_cast<std::vector<T>*>(vec->GetVectorPtr()));
+    }
+
+    void Format(const void* ptr, size_t index, std::string* out) const {
+      ValueTraits<T>::Format(static_cast<const T*>(ptr)[index], out);
+    }
+};
+
+//! Map of data type names to data types
+typedef boost::ptr_map<std::string, DataTypeBase> DataTypeMap;
+
+//! Registry of data types that can be used for agent memory variables.
+//! This is a singleton class. Built-in types are registered on creation,
+//! other types should be registered before threads are spawned.
+//!
+//! Boolean flags should use uint8_t as std::vector<bool> does not provide
+//! addressable elements.
+class DataTypeRegistry {
+  public:
+    //! Returns instance of singleton object
+    static DataTypeRegistry& GetInstance() {
+      static DataTypeRegistry instance;
+      return instance;
+    }
+
+    //! Registers a data type stored as type T
+    template <typename T>
+    void RegisterType(std::string name, const std::string& schema_type) {
+      if (!type_map_.insert(name, new DataType<T>(name, schema_type)).second) {
+        throw flame::exceptions::logic_error("data type already registered");
+      }
+    }
+
+    //! Returns a data type given its name, or NULL if it is unknown
+    const DataTypeBase* GetType(const std::string& name) const;
+
+    //! Returns the data type stored as the given C++ type, or NULL if
+    //! there is none
+    const DataTypeBase* GetTypeByDataType(const std::type_info& type) const;
+
+    //! Returns the names of all registered data types
+    std::vector<std::string> GetTypeNames() const;
+
+  private:
+    //! This is a singleton class. Disable manual instantiation
+    DataTypeRegistry();
+    //! This is a singleton class. Disable copy constructor
+    DataTypeRegistry(const DataTypeRegistry&);
+    //! This is a singleton class. Disable assignment operation
+    void operator=(const DataTypeRegistry&);
+
+    DataTypeMap type_map_;  //! Registered data types
+};
+}}  // namespace flame::mem
+#endif  // MEM__DATA_TYPE_HPP_
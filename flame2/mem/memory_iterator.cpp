@@ -15,13 +15,9 @@ namespace flame { namespace mem {
 
 MemoryIterator::MemoryIterator(AgentShadow* shadow)
     : position_(0), offset_(0), shadow_(shadow) {
-  vec_map_ptr_ = &(shadow->vec_map_);
-  rw_set_ptr_ = &(shadow->rw_set_);
   size_ = shadow->get_size();
   count_ = size_;  // We're iterating through the whole population
-  BOOST_FOREACH(const ConstVectorMap::value_type& iter, *vec_map_ptr_) {
-    ptr_map_[iter.first] = iter.second->GetRawPtr();
-  }
+  InitPointers();
 }
 
 MemoryIterator::MemoryIterator(AgentShadow* shadow, size_t offset, size_t count)
@@ -33,28 +29,46 @@ MemoryIterator::MemoryIterator(AgentShadow* shadow, size_t offset, size_t count)
   if (count == 0 || (offset_ + count_) > size_) {
     throw flame::exceptions::invalid_argument("Invalid count");
   }
-  vec_map_ptr_ = &(shadow->vec_map_);
-  rw_set_ptr_ = &(shadow->rw_set_);
+  InitPointers();
+}
 
-  BOOST_FOREACH(const ConstVectorMap::value_type& iter, *vec_map_ptr_) {
-    ptr_map_[iter.first] = iter.second->GetRawPtr(offset_);
-  }
+void MemoryIterator::InitPointers() {
+  vec_list_ptr_ = &(shadow_->vec_list_);
+  wvec_list_ptr_ = &(shadow_->wvec_list_);
+  var_ids_ptr_ = &(shadow_->var_ids_);
+  ptr_list_.assign(vec_list_ptr_->size(), NULL);
+  wptr_list_.assign(wvec_list_ptr_->size(), NULL);
+  Rewind();
 }
 
+void MemoryIterator::ThrowAccessError(size_t var_id, bool write) const {
+  if (!shadow_->IsRegistered(var_id)) {
+    throw flame::exceptions::invalid_variable("invalid variable");
+  } else if (write) {
+    throw flame::exceptions::invalid_operation("no write access to var");
+  } else {
+    throw flame::exceptions::invalid_operation("no read access to var");
+  }
+}
 
 void MemoryIterator::Rewind() {
-  VoidPtrMap::iterator ptr_it = ptr_map_.begin();
-  BOOST_FOREACH(const ConstVectorMap::value_type& iter, *vec_map_ptr_) {
+  BOOST_FOREACH(size_t var_id, *var_ids_ptr_) {
+    VectorWrapperBase* vec = (*vec_list_ptr_)[var_id];
+    VectorWrapperBase* wvec = (*wvec_list_ptr_)[var_id];
 #ifdef DEBUG
-    if (iter.first != ptr_it->first) {
-      throw flame::exceptions::flame_mem_exception("internal maps out of sync");
-    }
-    if (iter.second->size() != size_) {
+    if (vec->size() != size_) {
       throw flame::exceptions::logic_error("vector sizes have changed");
     }
+    if (wvec != NULL && wvec->size() != size_) {
+      throw flame::exceptions::logic_error("write buffer size mismatch");
+    }
 #endif
-    ptr_it->second = iter.second->GetRawPtr(offset_);
-    ++ptr_it;
+    ptr_list_[var_id] = vec->GetRawPtr(offset_);
+    if (wvec == vec) {
+      wptr_list_[var_id] = ptr_list_[var_id];
+    } else if (wvec != NULL) {  // double-buffered var
+      wptr_list_[var_id] = wvec->GetRawPtr(offset_);
+    }
   }
   position_ = 0;
 }
@@ -65,18 +79,20 @@ bool MemoryIterator::AtEnd() const {
 
 bool MemoryIterator::Step() {
   if (AtEnd()) { return false; }
-  VoidPtrMap::iterator ptr_it = ptr_map_.begin();
-  BOOST_FOREACH(const ConstVectorMap::value_type& iter, *vec_map_ptr_) {
+  BOOST_FOREACH(size_t var_id, *var_ids_ptr_) {
+    VectorWrapperBase* vec = (*vec_list_ptr_)[var_id];
+    VectorWrapperBase* wvec = (*wvec_list_ptr_)[var_id];
 #ifdef DEBUG
-    if (iter.first != ptr_it->first) {
-      throw flame::exceptions::flame_mem_exception("internal maps out of sync");
-    }
-    if (iter.second->size() != size_) {
+    if (vec->size() != size_) {
       throw flame::exceptions::logic_error("vector sizes have changed");
     }
 #endif
-    ptr_it->second = iter.second->StepRawPtr(ptr_it->second);
-    ++ptr_it;
+    ptr_list_[var_id] = vec->StepRawPtr(ptr_list_[var_id]);
+    if (wvec == vec) {
+      wptr_list_[var_id] = ptr_list_[var_id];
+    } else if (wvec != NULL) {  // double-buffered var
+      wptr_list_[var_id] = wvec->StepRawPtr(wptr_list_[var_id]);
+    }
   }
   ++position_;
   return true;
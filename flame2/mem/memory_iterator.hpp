@@ -10,16 +10,15 @@
 #ifndef MEM__MEMORY_ITERATOR_HPP_
 #define MEM__MEMORY_ITERATOR_HPP_
 #include <string>
-#include <utility>
-#include <map>
+#include <vector>
 #include "flame2/exceptions/mem.hpp"
 #include "agent_shadow.hpp"
 #include "vector_wrapper.hpp"
 
 namespace flame { namespace mem {
 
-typedef std::map<std::string, void*> VoidPtrMap;
-typedef VoidPtrMap::value_type VoidPtrMapValue;
+//! Raw pointers to current var values, indexed by var id
+typedef std::vector<void*> VoidPtrList;
 
 class MemoryIterator {
   friend class AgentShadow;
@@ -46,51 +45,62 @@ class MemoryIterator {
     //! Returns the number of steps taken so far
     size_t get_position() const;
 
+    //! Returns the id of a variable. Use this to avoid name lookups when
+    //! repeatedly accessing the same variable.
+    size_t GetVarId(const std::string& var_name) const {
+      return shadow_->GetVarId(var_name);
+    }
+
     //! Returns a const pointer to the actual data location
     template <typename T>
     const T* GetReadPtr(const std::string& var_name) const {
-      try {
-#ifndef DISABLE_RUNTIME_TYPE_CHECKING
-        VectorWrapperBase* vwb = vec_map_ptr_->at(var_name);
-        if (*(vwb->GetDataType()) != typeid(T)) {
-          throw flame::exceptions::invalid_type("invalid type");
-        }
-#endif
-        return static_cast<const T* const>(ptr_map_.at(var_name));
+      return GetReadPtr<T>(shadow_->GetVarId(var_name));
+    }
+
+    //! Returns a const pointer to the actual data location given a var id
+    template <typename T>
+    const T* GetReadPtr(size_t var_id) const {
+      if (var_id >= ptr_list_.size() || (*vec_list_ptr_)[var_id] == NULL) {
+        ThrowAccessError(var_id, false);
       }
-      catch(const std::out_of_range& E) {
-        if (!shadow_->IsRegistered(var_name)) {
-          throw flame::exceptions::invalid_variable("invalid variable");
-        } else {
-          throw flame::exceptions::invalid_operation("no read access to var");
-        }
+#ifndef DISABLE_RUNTIME_TYPE_CHECKING
+      if (*((*vec_list_ptr_)[var_id]->GetDataType()) != typeid(T)) {
+        throw flame::exceptions::invalid_type("invalid type");
       }
+#endif
+      return static_cast<const T*>(ptr_list_[var_id]);
     }
 
     //! Returns a pointer to the actual data location
     template <typename T>
     T* GetWritePtr(const std::string& var_name) const {
-      if (rw_set_ptr_->find(var_name) == rw_set_ptr_->end()) {
-        if (!shadow_->IsRegistered(var_name)) {
-          throw flame::exceptions::invalid_variable("invalid variable");
-        } else {
-          throw flame::exceptions::invalid_operation("no write access to var");
-        }
-      }
+      return GetWritePtr<T>(shadow_->GetVarId(var_name));
+    }
 
+    //! Returns a pointer to the actual data location given a var id
+    template <typename T>
+    T* GetWritePtr(size_t var_id) const {
+      if (var_id >= wptr_list_.size() || (*wvec_list_ptr_)[var_id] == NULL) {
+        ThrowAccessError(var_id, true);
+      }
 #ifndef DISABLE_RUNTIME_TYPE_CHECKING
-      VectorWrapperBase* vwb = vec_map_ptr_->at(var_name);
-      if (*(vwb->GetDataType()) != typeid(T)) {
+      if (*((*wvec_list_ptr_)[var_id]->GetDataType()) != typeid(T)) {
         throw flame::exceptions::invalid_type("invalid type");
       }
 #endif
-      return static_cast<T* const>(ptr_map_.at(var_name));
+      return static_cast<T*>(wptr_list_[var_id]);
     }
 
     //! Returns the value of a given variable
     template <typename T>
     T Get(const std::string& var_name) const {
-      const T* ptr = GetReadPtr<T>(var_name);
+      return Get<T>(shadow_->GetVarId(var_name));
+    }
+
+    //! Returns the value of a given variable id
+    template <typename T>
+    T Get(size_t var_id) const {
+      const T* ptr = GetReadPtr<T>(var_id);
 #ifndef NDEBUG
       if (ptr == NULL) {
         throw flame::exceptions::out_of_range("end of iterator met");
@@ -102,7 +112,13 @@ class MemoryIterator {
     //! Sets the value of a given variable
     template <typename T>
     void Set(const std::string& var_name, T value) {
-      T* ptr = GetWritePtr<T>(var_name);
+      Set<T>(shadow_->GetVarId(var_name), value);
+    }
+
+    //! Sets the value of a given variable id
+    template <typename T>
+    void Set(size_t var_id, T value) {
+      T* ptr = GetWritePtr<T>(var_id);
 #ifndef NDEBUG
       if (ptr == NULL) {
         throw flame::exceptions::out_of_range("end of iterator met");
@@ -111,6 +127,48 @@ class MemoryIterator {
       *(ptr) = value;
     }
 
+    //! Returns an element of a given fixed size array variable
+    template <typename T>
+    T Get(const std::string& var_name, size_t index) const {
+      return Get<T>(shadow_->GetVarId(var_name), index);
+    }
+
+    //! Returns an element of a given fixed size array variable id
+    template <typename T>
+    T Get(size_t var_id, size_t index) const {
+      const T* ptr = GetReadPtr<T>(var_id);
+      if (index >= (*vec_list_ptr_)[var_id]->stride()) {
+        throw flame::exceptions::out_of_range("array index out of range");
+      }
+#ifndef NDEBUG
+      if (ptr == NULL) {
+        throw flame::exceptions::out_of_range("end of iterator met");
+      }
+#endif
+      return ptr[index];
+    }
+
+    //! Sets an element of a given fixed size array variable
+    template <typename T>
+    void Set(const std::string& var_name, size_t index, T value) {
+      Set<T>(shadow_->GetVarId(var_name), index, value);
+    }
+
+    //! Sets an element of a given fixed size array variable id
+    template <typename T>
+    void Set(size_t var_id, size_t index, T value) {
+      T* ptr = GetWritePtr<T>(var_id);
+      if (index >= (*wvec_list_ptr_)[var_id]->stride()) {
+        throw flame::exceptions::out_of_range("array index out of range");
+      }
+#ifndef NDEBUG
+      if (ptr == NULL) {
+        throw flame::exceptions::out_of_range("end of iterator met");
+      }
+#endif
+      ptr[index] = value;
+    }
+
   protected:
     // Constructor limited to AgentShadow
     explicit MemoryIterator(AgentShadow* shadow);
@@ -122,9 +180,17 @@ class MemoryIterator {
     size_t offset_;  //! Offset to start iterating from
     size_t count_;  //! Number or elements to iterate through
     AgentShadow* shadow_;  //! Pointer to agent shadow instance
-    VoidPtrMap ptr_map_;  //! map of raw pointers of vars
-    ConstVectorMap* vec_map_ptr_;  //! pointer to vec map
-    WriteableSet* rw_set_ptr_;  //! Pointer to set of writeable vars
+    VoidPtrList ptr_list_;  //! raw read pointers of vars indexed by var id
+    VoidPtrList wptr_list_;  //! raw write pointers of vars indexed by var id
+    VectorPtrList* vec_list_ptr_;  //! pointer to readable vec list of shadow
+    VectorPtrList* wvec_list_ptr_;  //! pointer to writeable vec list of shadow
+    VarIdList* var_ids_ptr_;  //! pointer to list of accessible var ids
+
+    //! Initialises raw pointers to the start of the iteration range
+    void InitPointers();
+
+    //! Throws the appropriate exception for an inaccessible var id
+    void ThrowAccessError(size_t var_id, bool write) const;
 };
 
 }}  //  namespace flame::mem
@@ -9,6 +9,7 @@
  */
 #include <utility>
 #include <string>
+#include <vector>
 #include "flame2/config.hpp"
 #include "flame2/exceptions/mem.hpp"
 #include "memory_manager.hpp"
@@ -26,12 +27,44 @@ void MemoryManager::RegisterAgent(std::string agent_name) {
   }
 }
 
+size_t MemoryManager::GetVarId(const std::string& agent_name,
+                               const std::string& var_name) {
+  return GetAgentMemory(agent_name).GetVarId(var_name);
+}
+
+const std::vector<std::string>& MemoryManager::GetVarNames(
+    const std::string& agent_name) {
+  return GetAgentMemory(agent_name).GetVarNames();
+}
+
 VectorWrapperBase* MemoryManager::GetVectorWrapper(
     const std::string& agent_name,
     const std::string& var_name) {
   return GetAgentMemory(agent_name).GetVectorWrapper(var_name);
 }
 
+VectorWrapperBase* MemoryManager::GetVectorWrapper(
+    const std::string& agent_name,
+    size_t var_id) {
+  return GetAgentMemory(agent_name).GetVectorWrapper(var_id);
+}
+
+void MemoryManager::SetBuffered(const std::string& agent_name,
+                                const std::string& var_name) {
+  GetAgentMemory(agent_name).SetBuffered(var_name);
+}
+
+void MemoryManager::SwapBuffers(const std::string& agent_name) {
+  GetAgentMemory(agent_name).SwapBuffers();
+}
+
+void MemoryManager::ResetBuffers() {
+  AgentMap::iterator it;
+  for (it = agent_map_.begin(); it != agent_map_.end(); ++it) {
+    it->second->ResetBuffers();
+  }
+}
+
 void MemoryManager::HintPopulationSize(const std::string& agent_name,
                                        unsigned int size_hint) {
   GetAgentMemory(agent_name).HintPopulationSize(size_hint);
@@ -50,6 +83,15 @@ size_t MemoryManager::GetAgentCount() const {
   return agent_map_.size();
 }
 
+std::vector<std::string> MemoryManager::GetAgentNames() const {
+  std::vector<std::string> names;
+  AgentMap::const_iterator it;
+  for (it = agent_map_.begin(); it != agent_map_.end(); ++it) {
+    names.push_back(it->first);
+  }
+  return names;
+}
+
 bool MemoryManager::IsRegisteredAgent(const std::string& agent_name) const {
   return (agent_map_.find(agent_name) != agent_map_.end());
 }
@@ -42,10 +42,12 @@ class MemoryManager {
     //! Registers an agent type
     void RegisterAgent(std::string agent_name);
 
-    //! Registers a memory variable of a certain type for a given agent
+    //! Registers a memory variable of a certain type for a given agent.
+    //! Fixed size arrays are registered with their length as stride.
     template <typename T>
-    void RegisterAgentVar(const std::string& agent_name, std::string var_name) {
-      GetAgentMemory(agent_name).RegisterVar<T>(var_name);
+    void RegisterAgentVar(const std::string& agent_name, std::string var_name,
+                          size_t stride = 1) {
+      GetAgentMemory(agent_name).RegisterVar<T>(var_name, stride);
     }
 
     //! Registers a list of memory vars or a certain type for a given agent
@@ -59,10 +61,21 @@ class MemoryManager {
       }
     }
 
+    //! Returns the id assigned to an agent variable during registration
+    size_t GetVarId(const std::string& agent_name,
+                    const std::string& var_name);
+
+    //! Returns the names of all variables of an agent indexed by var id
+    const std::vector<std::string>& GetVarNames(const std::string& agent_name);
+
     //! Returns typeless pointer to associated vector wrapper
     VectorWrapperBase* GetVectorWrapper(const std::string& agent_name,
                                         const std::string& var_name);
 
+    //! Returns typeless pointer to vector wrapper of given variable id
+    VectorWrapperBase* GetVectorWrapper(const std::string& agent_name,
+                                        size_t var_id);
+
     //! Returns pointer to std::vector<T> for given agent variable
     template <typename T>
     std::vector<T>* GetVector(const std::string& agent_name,
@@ -70,6 +83,30 @@ class MemoryManager {
       return GetAgentMemory(agent_name).GetVector<T>(var_name);
     }
 
+    //! Returns pointer to std::vector<T> for given agent variable id
+    template <typename T>
+    std::vector<T>* GetVector(const std::string& agent_name, size_t var_id) {
+      return GetAgentMemory(agent_name).GetVector<T>(var_id);
+    }
+
+    //! Returns an appender of values to an agent variable, used to load
+    //! agents without per value lookups
+    template <typename T>
+    ColumnAppender<T> GetAppender(const std::string& agent_name,
+                                  const std::string& var_name) {
+      return GetAgentMemory(agent_name).GetAppender<T>(var_name);
+    }
+
+    //! Enables double-buffering for a registered agent variable
+    void SetBuffered(const std::string& agent_name,
+                     const std::string& var_name);
+
+    //! Publishes the write buffers of double-buffered vars of an agent
+    void SwapBuffers(const std::string& agent_name);
+
+    //! Resets write buffers of all agents to a copy of the current values
+    void ResetBuffers();
+
     //! Provides a hint at the population size of an agent type so memory
     //! utilisation can be optimised
     void HintPopulationSize(const std::string& agent_name,
@@ -78,6 +115,9 @@ class MemoryManager {
     //! Returns the number of registered agents
     size_t GetAgentCount() const;
 
+    //! Returns the names of all registered agents
+    std::vector<std::string> GetAgentNames() const;
+
     //! Checks if an agent with a given name has been registered
     bool IsRegisteredAgent(const std::string& agent_name) const;
 
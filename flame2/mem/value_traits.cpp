@@ -0,0 +1,57 @@
+/*!
+ * \file flame2/mem/value_traits.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Conversion of agent memory values to and from text
+ */
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "flame2/config.hpp"
+#include "value_traits.hpp"
+
+namespace flame { namespace mem {
+
+/*!
+ * \brief Copies the text in [begin, end) without surrounding white space
+ * into a null terminated buffer
+ * \return False if the text is empty or does not fit the buffer
+ */
+static bool copyNumber(const char* begin, const char* end,
+                       char* buffer, size_t size) {
+  while (begin < end && isspace(static_cast<unsigned char>(*begin))) ++begin;
+  while (end > begin && isspace(static_cast<unsigned char>(*(end - 1)))) --end;
+  size_t length = static_cast<size_t>(end - begin);
+  if (length == 0 || length >= size) return false;
+  memcpy(buffer, begin, length);
+  buffer[length] = '\0';
+  return true;
+}
+
+bool ParseLong(const char* begin, const char* end, long* value) {
+  char buffer[64];
+  char* last;
+  if (!copyNumber(begin, end, buffer, sizeof(buffer))) return false;
+  errno = 0;
+  *value = strtol(buffer, &last, 10);
+  return *last == '\0' && errno != ERANGE;
+}
+
+bool ParseDouble(const char* begin, const char* end, double* value) {
+  // large values written with %f have one digit per order of magnitude
+  char buffer[512];
+  char* last;
+  if (!copyNumber(begin, end, buffer, sizeof(buffer))) return false;
+  errno = 0;
+  *value = strtod(buffer, &last);
+  if (*last != '\0') return false;
+  // underflow to a denormal or zero is accepted
+  return errno != ERANGE || (*value != HUGE_VAL && *value != -HUGE_VAL);
+}
+
+}}  // namespace flame::mem
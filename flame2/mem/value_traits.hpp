@@ -0,0 +1,132 @@
+/*!
+ * \file flame2/mem/value_traits.hpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Conversion of agent memory values to and from text
+ */
+#ifndef MEM__VALUE_TRAITS_HPP_
+#define MEM__VALUE_TRAITS_HPP_
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace flame { namespace mem {
+
+//! Parses an integer from the text in [begin, end) ignoring surrounding
+//! white space. Returns false if the text is not a valid long.
+bool ParseLong(const char* begin, const char* end, long* value);
+
+//! Parses a floating point number from the text in [begin, end) ignoring
+//! surrounding white space. Returns false if the text is not a valid double.
+bool ParseDouble(const char* begin, const char* end, double* value);
+
+//! Conversion of values to and from text.
+//!
+//! Text is parsed from a character range so values can be read in place,
+//! e.g. from a memory mapped file. The built-in types are parsed without
+//! heap allocation, other types fall back to boost::lexical_cast.
+template <typename T>
+struct ValueTraits {
+  static bool Parse(const char* begin, const char* end, T* value) {
+    try {
+      *value = boost::lexical_cast<T>(std::string(begin, end));
+    } catch(const boost::bad_lexical_cast&) {
+      return false;
+    }
+    return true;
+  }
+
+  static bool Parse(const std::string& text, T* value) {
+    return Parse(text.data(), text.data() + text.size(), value);
+  }
+
+  static void Format(T value, std::string* out) {
+    out->append(boost::lexical_cast<std::string>(value));
+  }
+};
+
+template <>
+inline bool ValueTraits<int>::Parse(const char* begin, const char* end,
+                                    int* value) {
+  long l;
+  if (!ParseLong(begin, end, &l) || l < INT_MIN || l > INT_MAX) return false;
+  *value = static_cast<int>(l);
+  return true;
+}
+
+template <>
+inline bool ValueTraits<boost::int64_t>::Parse(const char* begin,
+                                               const char* end,
+                                               boost::int64_t* value) {
+  if (sizeof(long) < sizeof(boost::int64_t)) {
+    try {
+      *value = boost::lexical_cast<boost::int64_t>(std::string(begin, end));
+    } catch(const boost::bad_lexical_cast&) {
+      return false;
+    }
+    return true;
+  }
+  long l;
+  if (!ParseLong(begin, end, &l)) return false;
+  *value = static_cast<boost::int64_t>(l);
+  return true;
+}
+
+template <>
+inline bool ValueTraits<double>::Parse(const char* begin, const char* end,
+                                       double* value) {
+  return ParseDouble(begin, end, value);
+}
+
+template <>
+inline bool ValueTraits<float>::Parse(const char* begin, const char* end,
+                                      float* value) {
+  double d;
+  if (!ParseDouble(begin, end, &d)) return false;
+  if ((d > FLT_MAX || d < -FLT_MAX) && d == d &&
+      d != HUGE_VAL && d != -HUGE_VAL) return false;
+  *value = static_cast<float>(d);
+  return true;
+}
+
+//! Floating point values are written with a fixed number of decimals
+template <>
+inline void ValueTraits<double>::Format(double value, std::string* out) {
+  char buffer[512];
+  snprintf(buffer, sizeof(buffer), "%f", value);
+  out->append(buffer);
+}
+
+//! Floating point values are written with a fixed number of decimals
+template <>
+inline void ValueTraits<float>::Format(float value, std::string* out) {
+  ValueTraits<double>::Format(value, out);
+}
+
+//! uint8_t is a character type so has to be converted as a number
+template <>
+inline bool ValueTraits<boost::uint8_t>::Parse(const char* begin,
+                                               const char* end,
+                                               boost::uint8_t* value) {
+  long l;
+  if (!ParseLong(begin, end, &l) || l < 0 || l > 255) return false;
+  *value = static_cast<boost::uint8_t>(l);
+  return true;
+}
+
+//! uint8_t is a character type so has to be converted as a number
+template <>
+inline void ValueTraits<boost::uint8_t>::Format(boost::uint8_t value,
+                                                std::string* out) {
+  ValueTraits<int>::Format(value, out);
+}
+
+}}  // namespace flame::mem
+#endif  // MEM__VALUE_TRAITS_HPP_
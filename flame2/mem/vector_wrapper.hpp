@@ -23,26 +23,42 @@ namespace flame { namespace mem {
 class VectorWrapperBase {
   public:
     virtual ~VectorWrapperBase() {}
-    virtual void reserve(unsigned int n) = 0;
+    //! Reserves space for n entries
+    virtual void reserve(size_t n) = 0;
+    //! Returns the number of entries, i.e. elements divided by stride
     virtual size_t size() const = 0;
+    //! Returns the number of consecutive elements stored per entry
+    virtual size_t stride() const = 0;
+    //! Returns the size in bytes of a single element
+    virtual size_t element_size() const = 0;
+    //! Appends n entries copied from the raw elements at ptr
+    virtual void AppendRaw(const void* ptr, size_t n) = 0;
     virtual bool empty() const = 0;
     virtual void clear() = 0;
+    //! Removes the entries after the first n
+    virtual void truncate(size_t n) = 0;
 
     virtual void* GetVectorPtr() = 0;
 
     //! Append contents of vec into the internal vector
     virtual void Extend(VectorWrapperBase* vec) = 0;
 
+    //! Exchange contents with vec in constant time
+    virtual void swap(VectorWrapperBase* vec) = 0;
+
+    //! Replace contents with a copy of the contents of vec
+    virtual void assign(VectorWrapperBase* vec) = 0;
+
     //! Return a boost::any object of current type initialsed with value
     //! pointed to by raw pointer.
     virtual boost::any ConvertToBoostAny(void* ptr) = 0;
 
-    //! Returns a pointer to the Nth element in the internal
-    //! array, or NULL if the vector is empty
+    //! Returns a pointer to the first element of the Nth entry in the
+    //! internal array, or NULL if the vector is empty
     virtual void* GetRawPtr(size_t offset = 0) = 0;
 
-    //! Takes a raw pointer to the internal array element and
-    //! returns a pointer to the next next element in the array
+    //! Takes a raw pointer to the first element of an entry and
+    //! returns a pointer to the first element of the next entry
     //! or NULL if the end of the array is reached
     virtual void* StepRawPtr(void* ptr) = 0;
 
@@ -66,32 +82,59 @@ inline VectorWrapperBase* new_clone(const VectorWrapperBase& a) {
 }
 
 //! Type specific VectorWrappers
+//!
+//! Fixed size arrays are stored flat with a fixed stride, i.e. entry N
+//! occupies elements [N*stride, (N+1)*stride) of the internal vector.
 template <typename T>
 class VectorWrapper: public VectorWrapperBase {
   public:
     typedef T data_type;
     typedef std::vector<T> vector_type;
 
-    VectorWrapper() { data_type_ = &typeid(T); }
+    explicit VectorWrapper(size_t stride = 1) : stride_(stride) {
+      if (stride_ == 0) {
+        throw flame::exceptions::invalid_argument("stride must be > 0");
+      }
+      data_type_ = &typeid(T);
+    }
 
     explicit VectorWrapper(const VectorWrapper& v) : VectorWrapperBase(v) {
       data_type_ = v.data_type_;
+      stride_ = v.stride_;
       v_ = v.v_;
     }
 
-    void reserve(unsigned int n) { v_.reserve(n); }
-    size_t size() const { return v_.size(); }
+    void reserve(size_t n) { v_.reserve(n * stride_); }
+    size_t size() const { return v_.size() / stride_; }
+    size_t stride() const { return stride_; }
+    size_t element_size() const { return sizeof(T); }
+
+    void AppendRaw(const void* ptr, size_t n) {
+      const T* first = static_cast<const T*>(ptr);
+      v_.insert(v_.end(), first, first + n * stride_);
+    }
     bool empty() const { return v_.empty(); }
     void clear() { v_.clear(); }
+    void truncate(size_t n) {
+      if (n < size()) v_.erase(v_.begin() + n * stride_, v_.end());
+    }
 
     void Extend(VectorWrapperBase* vec) {
-      if (GetDataType() != vec->GetDataType()) {
-        throw flame::exceptions::invalid_type("mismatching type");
-      }
+      CheckCompatible(vec);
       vector_type *content = static_cast<vector_type*>(vec->GetVectorPtr());
       v_.insert(v_.end(), content->begin(), content->end());
     }
 
+    void swap(VectorWrapperBase* vec) {
+      CheckCompatible(vec);
+      v_.swap(*static_cast<vector_type*>(vec->GetVectorPtr()));
+    }
+
+    void assign(VectorWrapperBase* vec) {
+      CheckCompatible(vec);
+      v_ = *static_cast<vector_type*>(vec->GetVectorPtr());
+    }
+
     void* GetVectorPtr() {
       return &v_;
     }
@@ -100,10 +143,10 @@ class VectorWrapper: public VectorWrapperBase {
       if (offset == 0) {
         return (v_.empty()) ? NULL : &(v_.front());
       } else {
-        if (offset >= v_.size()) {
+        if (offset >= size()) {
           throw flame::exceptions::invalid_argument("invalid offset");
         }
-        return &v_[offset];
+        return &v_[offset * stride_];
       }
     }
 
@@ -112,10 +155,14 @@ class VectorWrapper: public VectorWrapperBase {
     }
 
     void* StepRawPtr(void* ptr) {
-      if (ptr == NULL || ptr == &(v_.back())) {
+      if (ptr == NULL) {
+        return NULL;
+      }
+      T* next = static_cast<T*>(ptr) + stride_;
+      if (next > &(v_.back())) {
         return NULL;
       }
-      return static_cast<void*>(static_cast<T*>(ptr)+1);
+      return static_cast<void*>(next);
     }
 
     //! Prints the contents of the vector to the given stream
@@ -142,13 +189,26 @@ class VectorWrapper: public VectorWrapperBase {
       }
     }
 
-    VectorWrapper<T>* clone_empty() const { return new VectorWrapper<T>(); }
+    VectorWrapper<T>* clone_empty() const {
+      return new VectorWrapper<T>(stride_);
+    }
 
     VectorWrapper<T>* clone() const { return new VectorWrapper<T>(*this); }
 
   private:
     const std::type_info *data_type_;
+    size_t stride_;  //! Number of elements per entry
     std::vector<T> v_;
+
+    //! Throws if vec does not hold the same type with the same stride
+    void CheckCompatible(VectorWrapperBase* vec) const {
+      if (GetDataType() != vec->GetDataType()) {
+        throw flame::exceptions::invalid_type("mismatching type");
+      }
+      if (stride_ != vec->stride()) {
+        throw flame::exceptions::invalid_type("mismatching stride");
+      }
+    }
 };
 
 
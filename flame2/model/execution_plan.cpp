@@ -0,0 +1,337 @@
+/*!
+ * \file flame2/model/execution_plan.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief ExecutionPlan: tasks and dependencies compiled from a model graph
+ */
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include "flame2/config.hpp"
+#include "flame2/exe/task_manager.hpp"
+#include "flame2/exceptions/model.hpp"
+#include "execution_plan.hpp"
+
+namespace flame { namespace model {
+
+//! First line of a written plan, holding the format version
+static const char * kPlanHeader = "flame2-execution-plan";
+static const int kPlanVersion = 2;
+//! Written in place of empty names
+static const char * kEmptyName = "-";
+//! Keywords of task kinds, indexed by kind
+static const char * kTaskKinds[] = { "agent_function", "message_sync",
+    "message_clear", "buffer_swap", "io_init", "io_output", "io_finalise" };
+static const size_t kTaskKindCount = sizeof(kTaskKinds) / sizeof(kTaskKinds[0]);
+
+static void throwInvalidPlan(std::string reason) {
+  throw flame::exceptions::flame_model_exception(
+      "Invalid execution plan: " + reason);
+}
+
+static void writeName(std::ostream * out, const std::string& name) {
+  if (name.empty()) *out << kEmptyName;
+  else
+    *out << name;
+}
+
+static void writeNames(std::ostream * out, const char * keyword,
+    const std::vector<std::string>& names) {
+  std::vector<std::string>::const_iterator it;
+
+  *out << keyword << " " << names.size();
+  for (it = names.begin(); it != names.end(); ++it) *out << " " << *it;
+  *out << "\n";
+}
+
+static void readKeyword(std::istream * in, const char * keyword) {
+  std::string word;
+  if (!(*in >> word) || word != keyword)
+    throwInvalidPlan(std::string("expected '") + keyword + "'");
+}
+
+static size_t readCount(std::istream * in) {
+  size_t count;
+  if (!(*in >> count)) throwInvalidPlan("expected a count");
+  return count;
+}
+
+static std::string readName(std::istream * in) {
+  std::string name;
+  if (!(*in >> name)) throwInvalidPlan("expected a name");
+  return (name == kEmptyName) ? std::string() : name;
+}
+
+static void readNames(std::istream * in, const char * keyword,
+    std::vector<std::string> * names) {
+  readKeyword(in, keyword);
+  size_t count = readCount(in);
+  names->clear();
+  for (size_t ii = 0; ii < count; ++ii) names->push_back(readName(in));
+}
+
+ExecutionPlan::ExecutionPlan()
+  : dependencyOffsets_(1, 0) {}
+
+size_t ExecutionPlan::addTask(const PlanTask& task,
+    const std::vector<size_t>& dependencies) {
+  std::vector<size_t>::const_iterator it;
+  size_t index = tasks_.size();
+
+  // Dependencies on earlier tasks only keep the plan in topological order
+  for (it = dependencies.begin(); it != dependencies.end(); ++it)
+    if (*it >= index) throwInvalidPlan("task '" + task.name +
+        "' depends on a task that does not precede it");
+
+  tasks_.push_back(task);
+  dependencies_.insert(dependencies_.end(),
+      dependencies.begin(), dependencies.end());
+  dependencyOffsets_.push_back(dependencies_.size());
+  return index;
+}
+
+size_t ExecutionPlan::getTaskCount() const {
+  return tasks_.size();
+}
+
+const ExecutionPlan::PlanTask& ExecutionPlan::getTask(size_t index) const {
+  return tasks_.at(index);
+}
+
+size_t ExecutionPlan::getDependencyCount(size_t index) const {
+  return dependencyOffsets_.at(index + 1) - dependencyOffsets_.at(index);
+}
+
+size_t ExecutionPlan::getDependency(size_t index, size_t n) const {
+  if (n >= getDependencyCount(index)) throw flame::exceptions::
+      flame_model_exception("Dependency index out of range");
+  return dependencies_[dependencyOffsets_[index] + n];
+}
+
+size_t ExecutionPlan::getEdgeCount() const {
+  return dependencies_.size();
+}
+
+void ExecutionPlan::setWrittenVariables(const VariableMap& vars) {
+  writtenVariables_ = vars;
+}
+
+const ExecutionPlan::VariableMap& ExecutionPlan::getWrittenVariables() const {
+  return writtenVariables_;
+}
+
+void ExecutionPlan::clear() {
+  tasks_.clear();
+  dependencyOffsets_.assign(1, 0);
+  dependencies_.clear();
+  writtenVariables_.clear();
+}
+
+size_t ExecutionPlan::getRangeDependency(size_t index) const {
+  const PlanTask& t = getTask(index);
+  size_t range = tasks_.size(), jj;
+
+  if (t.kind != agent_function) return range;
+  // Agent functions only access the memory of the agent they are run for,
+  // so a dependency on a function of the same agent holds for each agent
+  for (jj = dependencyOffsets_[index]; jj < dependencyOffsets_[index + 1];
+      ++jj) {
+    const PlanTask& d = tasks_[dependencies_[jj]];
+    if (d.kind == agent_function && d.parentName == t.parentName &&
+        (range == tasks_.size() || dependencies_[jj] > range))
+      range = dependencies_[jj];
+  }
+  return range;
+}
+
+void ExecutionPlan::registerWithTaskManager(
+    const FunctionMap& funcMap) const {
+  flame::exe::TaskManager& taskManager = exe::TaskManager::GetInstance();
+  std::vector<flame::exe::Task::id_type> ids;
+  std::vector<std::string>::const_iterator sit;
+  size_t ii, jj;
+
+  ids.reserve(tasks_.size());
+  // Create tasks in plan order
+  for (ii = 0; ii < tasks_.size(); ++ii) {
+    const PlanTask& t = tasks_[ii];
+    flame::exe::Task * task = 0;
+
+    if (t.kind == agent_function) {
+      std::vector<std::string> names(1, t.targetName);
+      std::vector<flame::exe::TaskFunction> funcs;
+      names.insert(names.end(),
+          t.fusedFunctions.begin(), t.fusedFunctions.end());
+      // Find function pointers from map
+      for (sit = names.begin(); sit != names.end(); ++sit) {
+        FunctionMap::const_iterator it = funcMap.find(*sit);
+        if (it == funcMap.end()) throw flame::exceptions::
+            flame_model_exception("Function '" + (*sit) +
+            "' has not been registered and therefore a task cannot be " +
+            "created");
+        funcs.push_back((*it).second);
+      }
+      task = &taskManager.CreateAgentTask(t.name, t.parentName, funcs);
+      // Allow access to variables and messages
+      for (sit = t.readOnlyVariables.begin();
+          sit != t.readOnlyVariables.end(); ++sit)
+        task->AllowAccess(*sit, false);
+      for (sit = t.writeVariables.begin();
+          sit != t.writeVariables.end(); ++sit)
+        task->AllowAccess(*sit, true);
+      for (sit = t.outputMessages.begin();
+          sit != t.outputMessages.end(); ++sit)
+        task->AllowMessagePost(*sit);
+      for (sit = t.inputMessages.begin();
+          sit != t.inputMessages.end(); ++sit)
+        task->AllowMessageRead(*sit);
+    } else if (t.kind == message_sync) {
+      task = &taskManager.CreateMessageBoardTask(t.name, t.targetName,
+          exe::MessageBoardTask::OP_SYNC);
+    } else if (t.kind == message_clear) {
+      task = &taskManager.CreateMessageBoardTask(t.name, t.targetName,
+          exe::MessageBoardTask::OP_CLEAR);
+    } else if (t.kind == buffer_swap) {
+      task = &taskManager.CreateMemoryTask(t.name, t.parentName,
+          exe::MemoryTask::OP_SWAP);
+    } else if (t.kind == io_init) {
+      task = &taskManager.CreateIOTask(t.name, "", "",
+          flame::exe::IOTask::OP_INIT);
+    } else if (t.kind == io_output) {
+      task = &taskManager.CreateIOTask(t.name, t.parentName, t.targetName,
+          flame::exe::IOTask::OP_OUTPUT);
+    } else {
+      task = &taskManager.CreateIOTask(t.name, "", "",
+          flame::exe::IOTask::OP_FIN);
+    }
+    task->set_priority(t.priority);
+    ids.push_back(task->get_task_id());
+  }
+
+  // Add dependencies by id, avoiding task name lookups
+  for (ii = 0; ii < tasks_.size(); ++ii) {
+    size_t range = getRangeDependency(ii);
+    for (jj = dependencyOffsets_[ii]; jj < dependencyOffsets_[ii + 1]; ++jj)
+      if (dependencies_[jj] == range)
+        taskManager.AddRangeDependency(ids[ii], ids[range]);
+      else
+        taskManager.AddDependency(ids[ii], ids[dependencies_[jj]]);
+  }
+
+  // Once finalised, tasks and dependencies can no longer be added
+  taskManager.Finalise();
+}
+
+void ExecutionPlan::write(std::ostream * out) const {
+  std::vector<PlanTask>::const_iterator tit;
+  std::vector<size_t>::const_iterator dit;
+  VariableMap::const_iterator vit;
+  std::set<std::string>::const_iterator sit;
+  // Enough digits for priorities to be read back unchanged
+  std::streamsize precision = out->precision(17);
+
+  *out << kPlanHeader << " " << kPlanVersion << "\n";
+  *out << "tasks " << tasks_.size() << "\n";
+  for (tit = tasks_.begin(); tit != tasks_.end(); ++tit) {
+    *out << "task " << kTaskKinds[(*tit).kind] << " ";
+    writeName(out, (*tit).name);
+    *out << " ";
+    writeName(out, (*tit).parentName);
+    *out << " ";
+    writeName(out, (*tit).targetName);
+    *out << " " << (*tit).priority << "\n";
+    writeNames(out, "ro", (*tit).readOnlyVariables);
+    writeNames(out, "rw", (*tit).writeVariables);
+    writeNames(out, "post", (*tit).outputMessages);
+    writeNames(out, "read", (*tit).inputMessages);
+    writeNames(out, "fused", (*tit).fusedFunctions);
+  }
+  // Dependencies as CSR offsets and column indices
+  *out << "offsets";
+  for (dit = dependencyOffsets_.begin(); dit != dependencyOffsets_.end();
+      ++dit) *out << " " << *dit;
+  *out << "\n";
+  *out << "dependencies " << dependencies_.size();
+  for (dit = dependencies_.begin(); dit != dependencies_.end(); ++dit)
+    *out << " " << *dit;
+  *out << "\n";
+  *out << "written " << writtenVariables_.size() << "\n";
+  for (vit = writtenVariables_.begin(); vit != writtenVariables_.end();
+      ++vit) {
+    *out << "agent " << (*vit).first << " " << (*vit).second.size();
+    for (sit = (*vit).second.begin(); sit != (*vit).second.end(); ++sit)
+      *out << " " << *sit;
+    *out << "\n";
+  }
+  *out << "end\n";
+  out->precision(precision);
+}
+
+void ExecutionPlan::read(std::istream * in) {
+  ExecutionPlan plan;
+  std::vector<PlanTask> tasks;
+  size_t ii, jj, count;
+  int version;
+
+  readKeyword(in, kPlanHeader);
+  if (!(*in >> version) || version != kPlanVersion)
+    throwInvalidPlan("unsupported version");
+
+  readKeyword(in, "tasks");
+  count = readCount(in);
+  for (ii = 0; ii < count; ++ii) {
+    PlanTask task;
+    readKeyword(in, "task");
+    std::string kind = readName(in);
+    for (jj = 0; jj < kTaskKindCount && kind != kTaskKinds[jj]; ++jj) {}
+    if (jj == kTaskKindCount) throwInvalidPlan("unknown task kind " + kind);
+    task.kind = static_cast<TaskKind>(jj);
+    task.name = readName(in);
+    task.parentName = readName(in);
+    task.targetName = readName(in);
+    if (!(*in >> task.priority)) throwInvalidPlan("expected a priority");
+    readNames(in, "ro", &task.readOnlyVariables);
+    readNames(in, "rw", &task.writeVariables);
+    readNames(in, "post", &task.outputMessages);
+    readNames(in, "read", &task.inputMessages);
+    readNames(in, "fused", &task.fusedFunctions);
+    tasks.push_back(task);
+  }
+
+  std::vector<size_t> offsets(count + 1);
+  readKeyword(in, "offsets");
+  for (ii = 0; ii <= count; ++ii) offsets[ii] = readCount(in);
+  readKeyword(in, "dependencies");
+  std::vector<size_t> dependencies(readCount(in));
+  for (ii = 0; ii < dependencies.size(); ++ii)
+    dependencies[ii] = readCount(in);
+  if (offsets[0] != 0 || offsets[count] != dependencies.size())
+    throwInvalidPlan("dependency offsets do not match dependencies");
+  for (ii = 0; ii < count; ++ii)
+    if (offsets[ii + 1] < offsets[ii])
+      throwInvalidPlan("dependency offsets are not ascending");
+
+  // Adding tasks checks they are in topological order
+  for (ii = 0; ii < count; ++ii)
+    plan.addTask(tasks[ii], std::vector<size_t>(
+        dependencies.begin() + offsets[ii],
+        dependencies.begin() + offsets[ii + 1]));
+
+  readKeyword(in, "written");
+  count = readCount(in);
+  for (ii = 0; ii < count; ++ii) {
+    readKeyword(in, "agent");
+    std::set<std::string>& vars = plan.writtenVariables_[readName(in)];
+    size_t varCount = readCount(in);
+    for (jj = 0; jj < varCount; ++jj) vars.insert(readName(in));
+  }
+  readKeyword(in, "end");
+
+  *this = plan;
+}
+
+}}  // namespace flame::model
@@ -0,0 +1,97 @@
+/*!
+ * \file flame2/model/execution_plan.hpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief ExecutionPlan: tasks and dependencies compiled from a model graph
+ */
+#ifndef MODEL__EXECUTION_PLAN_HPP_
+#define MODEL__EXECUTION_PLAN_HPP_
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include "flame2/exe/task_interface.hpp"
+
+namespace flame { namespace model {
+
+/*!
+ * \brief Tasks and dependencies of a model ready to be registered with the
+ * Task Manager
+ *
+ * Tasks are held in topological order and the dependencies of each task
+ * are stored as a row of a compressed sparse row (CSR) matrix, so a plan
+ * can be registered without building the model graph. Plans are compiled
+ * from a model graph by XGraph, written out by xparser and read back in
+ * by the generated simulation.
+ */
+class ExecutionPlan {
+  public:
+    enum TaskKind { agent_function = 0, message_sync, message_clear,
+      buffer_swap, io_init, io_output, io_finalise };
+    //! \brief Task of a plan
+    struct PlanTask {
+      TaskKind kind;
+      /*! \brief Name the task is registered with */
+      std::string name;
+      /*! \brief Agent name, empty for message and model data tasks */
+      std::string parentName;
+      /*! \brief Function, message or output variable name */
+      std::string targetName;
+      /*! \brief Critical path length used as initial task priority */
+      double priority;
+      std::vector<std::string> readOnlyVariables;
+      std::vector<std::string> writeVariables;
+      std::vector<std::string> outputMessages;
+      std::vector<std::string> inputMessages;
+      /*! \brief Functions run after targetName for each agent */
+      std::vector<std::string> fusedFunctions;
+    };
+    //! \brief Define agent name to written variables mapping
+    typedef std::map<std::string, std::set<std::string> > VariableMap;
+    //! \brief Define function name to function pointer mapping
+    typedef std::map<std::string, flame::exe::TaskFunction> FunctionMap;
+
+    ExecutionPlan();
+    //! Appends a task that depends on the given earlier tasks
+    //! \return index of the task within the plan
+    size_t addTask(const PlanTask& task,
+            const std::vector<size_t>& dependencies);
+    size_t getTaskCount() const;
+    const PlanTask& getTask(size_t index) const;
+    size_t getDependencyCount(size_t index) const;
+    //! \return index of the nth dependency of a task
+    size_t getDependency(size_t index, size_t n) const;
+    size_t getEdgeCount() const;
+    //! Returns the dependency of an agent function on the latest function
+    //! of the same agent it depends on, which only has to hold for each
+    //! agent, or getTaskCount() if there is none
+    size_t getRangeDependency(size_t index) const;
+    void setWrittenVariables(const VariableMap& vars);
+    const VariableMap& getWrittenVariables() const;
+    void clear();
+    //! Creates the tasks and dependencies of the plan with the Task
+    //! Manager and finalises it. Range dependencies are registered with
+    //! TaskManager::AddRangeDependency
+    void registerWithTaskManager(const FunctionMap& funcMap) const;
+    //! Writes the plan in a text format that read() accepts
+    void write(std::ostream * out) const;
+    //! Replaces the plan with one written by write()
+    void read(std::istream * in);
+
+  private:
+    std::vector<PlanTask> tasks_;
+    /*! \brief Start of the dependencies of each task in dependencies_,
+     *         with one more entry for the end of the last task */
+    std::vector<size_t> dependencyOffsets_;
+    /*! \brief Indices of the dependencies of all tasks */
+    std::vector<size_t> dependencies_;
+    VariableMap writtenVariables_;
+};
+
+}}  // namespace flame::model
+#endif  // MODEL__EXECUTION_PLAN_HPP_
@@ -10,6 +10,7 @@
 #include <cstdio>
 #include <string>
 #include <set>
+#include <vector>
 #include "flame2/config.hpp"
 #include "task.hpp"
 
@@ -57,9 +58,19 @@ std::string Task::getTaskName() {
     // If message clear
   } else if (taskType_ == Task::xmessage_clear) {
     name.append("MC");
+    // If agent memory buffer swap
+  } else if (taskType_ == Task::xbuffer_swap) {
+    name.append("AB_");
+    name.append(parentName_);
   }
   name.append("_");
   name.append(name_);
+  // Fused functions are listed after the first function
+  for (std::vector<std::string>::iterator it = fusedFunctions_.begin();
+      it != fusedFunctions_.end(); ++it) {
+    name.append("+");
+    name.append(*it);
+  }
 
   return name;
 }
@@ -170,4 +181,39 @@ std::set<std::string>* Task::getInputMessages() {
   return &inputMessages_;
 }
 
+/*!
+ * \brief Fuses a task into this one
+ * \param[in] task The task, which must follow this task
+ *
+ * The function of the task, and any functions already fused into it, are
+ * run after the functions of this task. Variable and message access is
+ * the union of the access of both tasks, variables written by either task
+ * are no longer read only.
+ */
+void Task::fuseTask(Task * task) {
+  std::set<std::string>::iterator it;
+
+  fusedFunctions_.push_back(task->getName());
+  fusedFunctions_.insert(fusedFunctions_.end(),
+      task->getFusedFunctions()->begin(), task->getFusedFunctions()->end());
+
+  readVariables_.insert(task->getReadVariables()->begin(),
+      task->getReadVariables()->end());
+  writeVariables_.insert(task->getWriteVariables()->begin(),
+      task->getWriteVariables()->end());
+  readOnlyVariables_.insert(task->getReadOnlyVariables()->begin(),
+      task->getReadOnlyVariables()->end());
+  for (it = writeVariables_.begin(); it != writeVariables_.end(); ++it)
+    readOnlyVariables_.erase(*it);
+
+  outputMessages_.insert(task->getOutputMessages()->begin(),
+      task->getOutputMessages()->end());
+  inputMessages_.insert(task->getInputMessages()->begin(),
+      task->getInputMessages()->end());
+}
+
+std::vector<std::string>* Task::getFusedFunctions() {
+  return &fusedFunctions_;
+}
+
 }}  // namespace flame::model
@@ -24,7 +24,7 @@ class Task {
   public:
     enum TaskType { xfunction = 0, xstate, xmessage_sync, xmessage_clear,
       io_pop_write, start_agent, finish_agent, xcondition,
-      xvariable, start_model, finish_model, xmessage};
+      xvariable, start_model, finish_model, xmessage, xbuffer_swap};
     Task(std::string parentName, std::string name, TaskType type);
     std::string getTaskName();
     void setParentName(std::string parentName);
@@ -53,6 +53,10 @@ class Task {
     std::set<std::string>* getOutputMessages();
     void addInputMessage(std::string name);
     std::set<std::string>* getInputMessages();
+    //! Appends the functions of a task that follows this one, so both
+    //! can run in a single pass over agent memory
+    void fuseTask(Task * task);
+    std::vector<std::string>* getFusedFunctions();
 
   private:
     // Agent name if function or output
@@ -81,6 +85,8 @@ class Task {
     std::set<std::string> outputMessages_;
     /*! \brief Names of messages that are input */
     std::set<std::string> inputMessages_;
+    /*! \brief Names of functions run after this one for each agent */
+    std::vector<std::string> fusedFunctions_;
 };
 }}  // namespace flame::model
 #endif  // MODEL__TASK_HPP_
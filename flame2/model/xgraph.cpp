@@ -22,7 +22,6 @@
 #include <functional>  // For greater<>
 #include <algorithm>   // For sort
 #include "flame2/config.hpp"
-#include "flame2/exe/task_manager.hpp"
 #include "xgraph.hpp"
 #include "xcondition.hpp"
 #include "xfunction.hpp"
@@ -37,6 +36,7 @@ XGraph::XGraph() {
   edge2dependency_ = new EdgeMap;
   endTask_ = 0;
   startTask_ = 0;
+  indexValid_ = true;
 }
 
 XGraph::~XGraph() {
@@ -68,6 +68,7 @@ Vertex XGraph::addVertex(Task * t) {
   TaskPtr ptr(t);
   // Add task to vertex task mapping
   vertex2task_->push_back(ptr);
+  indexVertex(v);
   // Return vertex
   return v;
 }
@@ -77,10 +78,30 @@ Vertex XGraph::addVertex(TaskPtr ptr) {
   Vertex v = add_vertex(*graph_);
   // Add task to vertex task mapping
   vertex2task_->push_back(ptr);
+  indexVertex(v);
   // Return vertex
   return v;
 }
 
+void XGraph::indexVertex(Vertex v) {
+  // Indexes are rebuilt in full when next needed
+  if (!indexValid_) return;
+  Task * t = vertex2task_->at(v).get();
+  task2vertex_.insert(std::make_pair(t, v));
+  // Keep the first vertex of a name and type, as a scan would find
+  name2vertex_.insert(std::make_pair(
+      std::make_pair(t->getName(), static_cast<int>(t->getTaskType())), v));
+}
+
+void XGraph::updateIndex() {
+  Vertex v;
+  if (indexValid_) return;
+  task2vertex_.clear();
+  name2vertex_.clear();
+  indexValid_ = true;
+  for (v = 0; v < vertex2task_->size(); ++v) indexVertex(v);
+}
+
 void XGraph::removeVertex(Vertex v) {
   // Iterators
   boost::graph_traits<Graph>::out_edge_iterator oei, oei_end;
@@ -100,6 +121,8 @@ void XGraph::removeVertex(Vertex v) {
     removeDependency(*eit);
   // Remove task from vertex to task mapping mapping
   vertex2task_->erase(vertex2task_->begin() + v);
+  // Later vertices are renumbered
+  indexValid_ = false;
   // Remove edge from graph
   boost::remove_vertex(v, *graph_);
 }
@@ -139,14 +162,24 @@ Edge XGraph::addEdge(Vertex to, Vertex from, std::string name,
 }
 
 Vertex XGraph::getVertex(Task * t) {
-  size_t ii;
   // Find index of task in vertex task mapping
   // The index corresponds to the vertex number
-  for (ii = 0; ii < vertex2task_->size(); ++ii)
-    if (vertex2task_->at(ii).get() == t) return ii;
+  updateIndex();
+  boost::unordered_map<Task *, Vertex>::iterator it = task2vertex_.find(t);
+  if (it != task2vertex_.end()) return (*it).second;
   return 0;
 }
 
+bool XGraph::findVertex(const std::string& name, Task::TaskType type,
+    Vertex * v) {
+  updateIndex();
+  boost::unordered_map<std::pair<std::string, int>, Vertex>::iterator it =
+      name2vertex_.find(std::make_pair(name, static_cast<int>(type)));
+  if (it == name2vertex_.end()) return false;
+  *v = (*it).second;
+  return true;
+}
+
 Task * XGraph::getTask(Vertex v) {
   // Return task at index v
   return vertex2task_->at(v).get();
@@ -197,10 +230,8 @@ int XGraph::generateDependencyGraph(boost::ptr_vector<XVariable> * variables) {
 Task * XGraph::generateStateGraphStatesAddStateToGraph(std::string name,
     std::string startState) {
   // Check if state has already been added
-  std::vector<TaskPtr>::iterator vit;
-  for (vit = vertex2task_->begin(); vit != vertex2task_->end(); ++vit)
-    if ((*vit).get()->getTaskType() == Task::xstate &&
-        (*vit).get()->getName() == name) return (*vit).get();
+  Vertex v;
+  if (findVertex(name, Task::xstate, &v)) return getTask(v);
 
   // Add state as a task to the task list
   Task * task = new Task(agentName_, name, Task::xstate);
@@ -255,11 +286,9 @@ void XGraph::generateStateGraphVariables(XFunction * function, Task * task) {
 }
 
 Task * XGraph::generateStateGraphMessagesAddMessageToGraph(std::string name) {
-  // Check if state has already been added
-  std::vector<TaskPtr>::iterator vit;
-  for (vit = vertex2task_->begin(); vit != vertex2task_->end(); ++vit)
-    if ((*vit).get()->getTaskType() == Task::xmessage &&
-        (*vit).get()->getName() == name) return (*vit).get();
+  // Check if message has already been added
+  Vertex v;
+  if (findVertex(name, Task::xmessage, &v)) return getTask(v);
 
   // Add state as a task to the task list
   Task * task = new Task(name, name, Task::xmessage);
@@ -331,160 +360,225 @@ void XGraph::generateTaskList(std::vector<Task*> * tasks) {
     tasks->push_back(getTask((*vit)));
 }
 
-int XGraph::registerAllowAccess(flame::exe::Task * task,
-    std::set<std::string> * vars, bool writeable) {
-  std::set<std::string>::iterator sit;
-
-  // For each variable name
-  for (sit = vars->begin(); sit != vars->end(); ++sit)
-    task->AllowAccess((*sit), writeable);
-
-  return 0;
-}
-
-int XGraph::registerAllowMessage(flame::exe::Task * task,
-    std::set<std::string> * messages, bool post) {
-  std::set<std::string>::iterator sit;
+void XGraph::computeTaskPriorities(const TaskCostMap * costs,
+    std::vector<double> * priorities) {
+  std::vector<Vertex> sorted_vertices;
+  std::vector<Vertex>::iterator vit;
+  boost::graph_traits<Graph>::out_edge_iterator oei, oei_end;
+  std::vector<double> length(boost::num_vertices(*graph_), 0.0);
 
-  // For each message
-  for (sit = messages->begin();
-      sit != messages->end(); ++sit) {
-    // Update task with appropriate access
-    // If output message then allow post
-    if (post) task->AllowMessagePost((*sit));
-    // If input message then allow read
-    else
-      task->AllowMessageRead((*sit));
+  priorities->assign(boost::num_vertices(*graph_), 0.0);
+  // Sorted vertices start with the sinks so each vertex is visited
+  // after all of its dependents
+  boost::topological_sort(*graph_, std::back_inserter(sorted_vertices));
+  for (vit = sorted_vertices.begin(); vit != sorted_vertices.end(); ++vit) {
+    Task * t = getTask(*vit);
+    size_t level = 0;
+    double longest = 0.0;
+    // Find the longest chain of dependent tasks
+    for (boost::tie(oei, oei_end) = boost::out_edges(*vit, *graph_);
+        oei != oei_end; ++oei) {
+      Vertex target = boost::target((Edge)*oei, *graph_);
+      level = std::max(level, getTask(target)->getLevel());
+      longest = std::max(longest, length[target]);
+    }
+    // Level is the number of tasks on the longest chain
+    t->setLevel(level + 1);
+    if (costs == 0) {
+      // Priority level breaks ties between chains of equal length
+      (*priorities)[*vit] = static_cast<double>(level + 1) +
+          static_cast<double>(t->getPriorityLevel()) / 100.0;
+    } else {
+      TaskCostMap::const_iterator cit = costs->find(t->getTaskName());
+      length[*vit] = longest + (cit == costs->end() ? 0.0 : (*cit).second);
+      (*priorities)[*vit] = length[*vit];
+    }
   }
-
-  return 0;
 }
 
-int XGraph::registerAgentTask(Task * t,
-    std::map<std::string, flame::exe::TaskFunction> funcMap) {
-  flame::exe::TaskManager& taskManager = exe::TaskManager::GetInstance();
-  std::map<std::string, flame::exe::TaskFunction>::iterator it;
-  int rc = 0;
-
-  // Try and find function pointer from map
-  it = funcMap.find(t->getName());
-  if (it == funcMap.end()) {
-    fprintf(stderr, "Error: function '%s' has not be registered and %s\n",
-        t->getTaskName().c_str(),
-        "therefore a task cannot be created");
-    return 3;
+/*!
+ * \brief Fuses chains of agent functions
+ *
+ * A function whose only dependency is another function of the same agent
+ * is fused into it. Both functions are then run in turn for each agent,
+ * which saves streaming agent memory through the cache twice and
+ * scheduling a second task. As the dependency is the only way to reach
+ * the fused function no other task can come between the two, and the
+ * functions can only depend on each other through the memory of the same
+ * agent, as messages need syncing in between.
+ *
+ * Dependents of the fused function become dependents of the task it was
+ * fused into.
+ */
+void XGraph::fuseAgentFunctions() {
+  VertexIterator vi, vi_end;
+  boost::graph_traits<Graph>::in_edge_iterator iei, iei_end;
+  boost::graph_traits<Graph>::out_edge_iterator oei, oei_end;
+  bool fused = true;
+
+  // Removing a vertex renumbers the vertices after it so start again
+  // after each fusion
+  while (fused) {
+    fused = false;
+    for (boost::tie(vi, vi_end) = boost::vertices(*graph_);
+        vi != vi_end; ++vi) {
+      Task * t = getTask(*vi);
+      if (t->getTaskType() != Task::xfunction ||
+          boost::in_degree(*vi, *graph_) != 1) continue;
+      boost::tie(iei, iei_end) = boost::in_edges(*vi, *graph_);
+      Vertex source = boost::source((Edge)*iei, *graph_);
+      Task * s = getTask(source);
+      if (s->getTaskType() != Task::xfunction ||
+          s->getParentName() != t->getParentName()) continue;
+
+      // Move dependents over to the source vertex
+      std::vector<std::pair<Vertex, Dependency> > dependents;
+      std::vector<std::pair<Vertex, Dependency> >::iterator dit;
+      for (boost::tie(oei, oei_end) = boost::out_edges(*vi, *graph_);
+          oei != oei_end; ++oei) {
+        EdgeMap::iterator eit = edge2dependency_->find(*oei);
+        Dependency d("", Dependency::data);
+        if (eit != edge2dependency_->end()) d = *(*eit).second;
+        dependents.push_back(
+            std::make_pair(boost::target((Edge)*oei, *graph_), d));
+      }
+      for (dit = dependents.begin(); dit != dependents.end(); ++dit)
+        if (!boost::edge(source, (*dit).first, *graph_).second)
+          addEdge(source, (*dit).first, (*dit).second.getName(),
+              (*dit).second.getDependencyType());
+
+      s->fuseTask(t);
+      removeVertex(*vi);
+      fused = true;
+      break;
+    }
   }
-
-  // Create agent task
-  flame::exe::Task& task = taskManager.CreateAgentTask(
-      t->getTaskName(), t->getParentName(), ((*it).second));
-  // Allow access to read only variables
-  rc += registerAllowAccess(&task, t->getReadOnlyVariables(), false);
-  // Allow access to read write variables
-  rc += registerAllowAccess(&task, t->getWriteVariables(), true);
-  // Add access to output messages
-  rc += registerAllowMessage(&task, t->getOutputMessages(), true);
-  // Add access to input messages
-  rc += registerAllowMessage(&task, t->getInputMessages(), false);
-  if (rc != 0) return 1;
-
-  return 0;
 }
 
-void XGraph::registerDataTask(Task * t) {
-  flame::exe::TaskManager& taskManager = exe::TaskManager::GetInstance();
-  std::string taskName = t->getTaskName();
-  std::string agentName = t->getParentName();
-  Task::TaskType taskType = t->getTaskType();
+void XGraph::generatePlanTasks(Task * t, double priority,
+    std::vector<ExecutionPlan::PlanTask> * tasks) {
+  Task::TaskType type = t->getTaskType();
   std::set<std::string>::iterator it;
-
-  // If agent var data
-  if (taskType == Task::io_pop_write) {
-    // For each write variable
+  ExecutionPlan::PlanTask task;
+
+  task.name = t->getTaskName();
+  task.parentName = t->getParentName();
+  task.targetName = t->getName();
+  task.priority = priority;
+
+  // If agent task
+  if (type == Task::xfunction || type == Task::xcondition) {
+    task.kind = ExecutionPlan::agent_function;
+    task.fusedFunctions.assign(t->getFusedFunctions()->begin(),
+        t->getFusedFunctions()->end());
+    task.readOnlyVariables.assign(t->getReadOnlyVariables()->begin(),
+        t->getReadOnlyVariables()->end());
+    task.writeVariables.assign(t->getWriteVariables()->begin(),
+        t->getWriteVariables()->end());
+    task.outputMessages.assign(t->getOutputMessages()->begin(),
+        t->getOutputMessages()->end());
+    task.inputMessages.assign(t->getInputMessages()->begin(),
+        t->getInputMessages()->end());
+    tasks->push_back(task);
+  // If agent var data then one output task for each variable
+  } else if (type == Task::io_pop_write) {
+    task.kind = ExecutionPlan::io_output;
     for (it = t->getWriteVariables()->begin();
         it != t->getWriteVariables()->end(); ++it) {
-      taskName = "AD_";
-      taskName.append(agentName);
-      taskName.append("_");
-      taskName.append((*it));
-      taskManager.CreateIOTask(taskName, agentName, (*it),
-          flame::exe::IOTask::OP_OUTPUT);
+      task.name = "AD_" + task.parentName + "_" + (*it);
+      task.targetName = (*it);
+      tasks->push_back(task);
     }
+  // If model start or finish data
+  } else if (type == Task::start_model || type == Task::finish_model) {
+    task.kind = (type == Task::start_model) ?
+        ExecutionPlan::io_init : ExecutionPlan::io_finalise;
+    tasks->push_back(task);
+  // If message task
+  } else if (type == Task::xmessage_sync || type == Task::xmessage_clear) {
+    task.kind = (type == Task::xmessage_sync) ?
+        ExecutionPlan::message_sync : ExecutionPlan::message_clear;
+    tasks->push_back(task);
+  // If memory task
+  } else if (type == Task::xbuffer_swap) {
+    task.kind = ExecutionPlan::buffer_swap;
+    tasks->push_back(task);
   }
-  // If model start data
-  if (taskType == Task::start_model)
-    taskManager.CreateIOTask(taskName, "", "",
-        flame::exe::IOTask::OP_INIT);
-  // If model finish data
-  if (taskType == Task::finish_model)
-    taskManager.CreateIOTask(taskName, "", "",
-        flame::exe::IOTask::OP_FIN);
-}
-
-int XGraph::registerMessageTask(Task * t) {
-  flame::exe::TaskManager& taskManager = exe::TaskManager::GetInstance();
-
-  // If sync task then create sync task
-  if (t->getTaskType() == Task::xmessage_sync)
-    taskManager.CreateMessageBoardTask(t->getTaskName(), t->getName(),
-        exe::MessageBoardTask::OP_SYNC);
-  // If clear task then create clear task
-  if (t->getTaskType() == Task::xmessage_clear)
-    taskManager.CreateMessageBoardTask(t->getTaskName(), t->getName(),
-        exe::MessageBoardTask::OP_CLEAR);
-
-  return 0;
 }
 
-int XGraph::registerDependencies() {
-  flame::exe::TaskManager& taskManager = exe::TaskManager::GetInstance();
-  boost::graph_traits<Graph>::edge_iterator iei, iei_end;
+int XGraph::compileExecutionPlan(ExecutionPlan * plan,
+    const TaskCostMap * costs) {
+  std::vector<Vertex> sorted_vertices;
+  std::vector<Vertex>::reverse_iterator vit;
+  boost::graph_traits<Graph>::in_edge_iterator iei, iei_end;
+  std::vector<double> priorities;
+  // Plan tasks of each vertex
+  std::vector<std::vector<size_t> > vertexTasks(boost::num_vertices(*graph_));
+  ExecutionPlan::VariableMap writtenVars;
 
-  // For each edge
-  for (boost::tie(iei, iei_end) = boost::edges(*graph_);
-      iei != iei_end; ++iei) {
-    // Get the source
-    std::string source = getTask(
-        boost::source((Edge)*iei, *graph_))->getTaskName();
-    // Get the target
-    std::string target = getTask(
-        boost::target((Edge)*iei, *graph_))->getTaskName();
-    // Add dependency
-    taskManager.AddDependency(target, source);
+  plan->clear();
+  // Critical path lengths are used as task priorities
+  computeTaskPriorities(costs, &priorities);
+
+  // Sorted vertices start with the sinks so visit them in reverse order
+  // for tasks to be added after their dependencies
+  boost::topological_sort(*graph_, std::back_inserter(sorted_vertices));
+  for (vit = sorted_vertices.rbegin();
+      vit != sorted_vertices.rend(); ++vit) {
+    std::vector<ExecutionPlan::PlanTask> tasks;
+    std::vector<ExecutionPlan::PlanTask>::iterator tit;
+    std::vector<size_t> dependencies;
+
+    // Depend on the tasks of each source vertex
+    for (boost::tie(iei, iei_end) = boost::in_edges(*vit, *graph_);
+        iei != iei_end; ++iei) {
+      std::vector<size_t>& sourceTasks =
+          vertexTasks[boost::source((Edge)*iei, *graph_)];
+      dependencies.insert(dependencies.end(),
+          sourceTasks.begin(), sourceTasks.end());
+    }
+    std::sort(dependencies.begin(), dependencies.end());
+    dependencies.erase(std::unique(dependencies.begin(), dependencies.end()),
+        dependencies.end());
+
+    generatePlanTasks(getTask(*vit), priorities[*vit], &tasks);
+    // Vertices without tasks pass their dependencies on to their dependents
+    if (tasks.empty()) vertexTasks[*vit] = dependencies;
+    for (tit = tasks.begin(); tit != tasks.end(); ++tit)
+      vertexTasks[*vit].push_back(plan->addTask((*tit), dependencies));
   }
 
+  // Variables that agent functions write can change between outputs
+  getAgentWriteVariables(&writtenVars);
+  plan->setWrittenVariables(writtenVars);
+
   return 0;
 }
 
 int XGraph::registerTasksAndDependenciesWithTaskManager(
-    std::map<std::string, flame::exe::TaskFunction> funcMap) {
-  flame::exe::TaskManager& taskManager = exe::TaskManager::GetInstance();
+    std::map<std::string, flame::exe::TaskFunction> funcMap,
+    const TaskCostMap * costs) {
+  ExecutionPlan plan;
+
+  compileExecutionPlan(&plan, costs);
+  plan.registerWithTaskManager(funcMap);
+
+  return 0;
+}
+
+void XGraph::getAgentWriteVariables(
+    std::map<std::string, std::set<std::string> > * vars) {
   std::pair<VertexIterator, VertexIterator> vp;
 
-  // For each vertex
+  // For each agent function vertex
   for (vp = boost::vertices(*graph_); vp.first != vp.second; ++vp.first) {
     Task * t = getTask(*vp.first);
-    Task::TaskType type = t->getTaskType();
-
-    // If agent task
-    if (type == Task::xfunction || type == Task::xcondition)
-      registerAgentTask(t, funcMap);
-    // If data task
-    if (type == Task::io_pop_write ||
-        type == Task::start_model || type == Task::finish_model)
-      registerDataTask(t);
-    // If message task
-    if (type == Task::xmessage_sync || type == Task::xmessage_clear)
-      registerMessageTask(t);
+    if (t->getTaskType() != Task::xfunction) continue;
+    // Add write variables to the set of the agent
+    std::set<std::string>& agentVars = (*vars)[t->getParentName()];
+    agentVars.insert(t->getWriteVariables()->begin(),
+        t->getWriteVariables()->end());
   }
-
-  // Register dependencies with the Task Manager
-  registerDependencies();
-
-  // Once finalised, tasks and dependencies can no longer be added
-  taskManager.Finalise();
-
-  return 0;
 }
 
 void clearVarWriteSet(std::string name,
@@ -588,6 +682,11 @@ void XGraph::addWriteDependencies(Vertex v, Task * t) {
   // For each write variable
   for (varit = t->getWriteVariables()->begin();
       varit != t->getWriteVariables()->end(); ++varit) {
+    // Double-buffered variables are read from a separate buffer
+    // so there is no write after read conflict. The cost is a copy
+    // of the variable per iteration, see AgentMemory::SwapBuffers()
+    if (bufferedVariables_.find(*varit) != bufferedVariables_.end())
+      continue;
     // Look at last reads
     for (wit = t->getLastReads()->begin();
         wit != t->getLastReads()->end(); ++wit) {
@@ -616,6 +715,11 @@ void XGraph::addReadDependencies(Vertex v, Task * t) {
 #endif
   for (varit = t->getReadVariables()->begin();
       varit != t->getReadVariables()->end(); ++varit) {
+    // Reads of double-buffered variables only see values from the
+    // previous iteration, only writers need to be ordered
+    if (bufferedVariables_.find(*varit) != bufferedVariables_.end() &&
+        t->getWriteVariables()->find(*varit) == t->getWriteVariables()->end())
+      continue;
     for (wit = t->getLastWrites()->begin();
         wit != t->getLastWrites()->end(); ++wit) {
       // If read variable equals last writes variable
@@ -671,10 +775,48 @@ void XGraph::addWritingVerticesToList(Vertex v, Task * t) {
   }
 }
 
+bool XGraph::accessesBufferedVariable(Task * t) {
+  std::set<std::string>::iterator varit;
+  for (varit = t->getReadVariables()->begin();
+      varit != t->getReadVariables()->end(); ++varit)
+    if (bufferedVariables_.find(*varit) != bufferedVariables_.end())
+      return true;
+  for (varit = t->getWriteVariables()->begin();
+      varit != t->getWriteVariables()->end(); ++varit)
+    if (bufferedVariables_.find(*varit) != bufferedVariables_.end())
+      return true;
+  return false;
+}
+
+void XGraph::addBufferSwapTask(std::set<Vertex> * accessingVertices) {
+  std::set<Vertex>::iterator it;
+  std::set<std::string>::iterator varit;
+  // Add swap task to publish the write buffers
+  Task * task = new Task(agentName_, "swap", Task::xbuffer_swap);
+  Vertex vertex = addVertex(task);
+  // Swap once every task accessing a buffered variable has finished
+  for (it = accessingVertices->begin(); it != accessingVertices->end(); ++it)
+    addEdge((*it), vertex, "Buffer", Dependency::variable);
+  // The swap task provides the last writes of buffered variables
+  // so that data output happens after the swap
+  for (varit = bufferedVariables_.begin();
+      varit != bufferedVariables_.end(); ++varit) {
+    clearVarWriteSet((*varit), endTask_->getLastWrites());
+    addVectorToVarWriteSet((*varit), vertex, endTask_->getLastWrites());
+  }
+}
+
 void XGraph::addDataDependencies(
     boost::ptr_vector<XVariable> * variables) {
   std::vector<Vertex>::reverse_iterator vit;
   std::vector<Vertex> sorted_vertices;
+  std::set<Vertex> bufferedAccess;
+  boost::ptr_vector<XVariable>::iterator varit;
+
+  // Find double-buffered variables
+  bufferedVariables_.clear();
+  for (varit = variables->begin(); varit != variables->end(); ++varit)
+    if ((*varit).isBuffered()) bufferedVariables_.insert((*varit).getName());
 
   // Add start and end tasks
   addStartTask(variables);
@@ -702,8 +844,16 @@ void XGraph::addDataDependencies(
       // Add vertices to variable writing vertices list
       // for writing variables
       addWritingVerticesToList(*vit, task);
+      // Keep track of functions accessing double-buffered variables
+      if ((task->getTaskType() == Task::xfunction ||
+          task->getTaskType() == Task::xcondition) &&
+          accessesBufferedVariable(task))
+        bufferedAccess.insert(*vit);
     }
   }
+
+  // Add task to swap buffers of double-buffered variables
+  if (!bufferedVariables_.empty()) addBufferSwapTask(&bufferedAccess);
 }
 
 bool setContains(std::set<std::string>* a, std::set<std::string>* find_in_a) {
@@ -749,6 +899,7 @@ void XGraph::AddVariableOutput() {
     Vertex vertex = addVertex(task);
     task->getWriteVariables()->insert((*lws->begin()).first);
     task->setName((*lws->begin()).first);
+    indexValid_ = false;
     // Check first var against other var task sets, if same then add to
     // current task and remove
     for (vwit = ++lws->begin(); vwit != lws->end();) {
@@ -803,6 +954,7 @@ void XGraph::transformConditionalStatesToConditions(
       // Change task type to a condition
       t->setTaskType(Task::xcondition);
       t->setName(boost::lexical_cast<std::string>(count++));
+      indexValid_ = false;
       t->setPriorityLevel(5);
       // Conditions read all variables (assume to help with splitting)
       for (it = variables->begin(); it != variables->end(); ++it) {
@@ -901,6 +1053,7 @@ void XGraph::removeRedundantDependencies() {
   // Make vertex2task_ point to trvertex2task
   delete vertex2task_;
   vertex2task_ = trvertex2task;
+  indexValid_ = false;
   // Clear edge2dependency_ as edges no longer valid
   EdgeMap::iterator eit;
   for (eit = edge2dependency_->begin(); eit != edge2dependency_->end(); ++eit)
@@ -909,16 +1062,12 @@ void XGraph::removeRedundantDependencies() {
 }
 
 Vertex XGraph::getMessageVertex(std::string name, Task::TaskType type) {
-  size_t ii;
-  // For each task
-  for (ii = 0; ii < vertex2task_->size(); ++ii)
-    // If find message and type then return
-    if (vertex2task_->at(ii)->getName() == name &&
-        vertex2task_->at(ii)->getTaskType() == type)
-      return ii;
+  Vertex v;
+  // If find message and type then return
+  if (findVertex(name, type, &v)) return v;
   // Otherwise create new vertex and return
   Task * t = new Task(name, name, type);
-  Vertex v = addVertex(t);
+  v = addVertex(t);
   return v;
 }
 
@@ -1145,6 +1294,8 @@ struct vertex_label_writer {
           out << "SYNC: " << t->getName() << "\"";
         else if (t->getTaskType() == Task::xmessage_clear)
           out << "CLEAR: " << t->getName() << "\"";
+        else if (t->getTaskType() == Task::xbuffer_swap)
+          out << "SWAP: " << t->getParentName() << "\"";
         else if (t->getTaskType() == Task::start_agent ||
             t->getTaskType() == Task::start_model)
           out << "Start\\n" << t->getParentName() << "\"";
@@ -1166,7 +1317,8 @@ struct vertex_label_writer {
             t->getTaskType() == Task::xstate)
           out << " shape=ellipse, style=filled, fillcolor=white";
         if (t->getTaskType() == Task::xmessage_clear ||
-            t->getTaskType() == Task::xmessage_sync) {
+            t->getTaskType() == Task::xmessage_sync ||
+            t->getTaskType() == Task::xbuffer_swap) {
           out << " shape=parallelogram, style=filled, ";
           out << "fillcolor=lightblue";
         }
@@ -12,6 +12,7 @@
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/property_map/property_map.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include <vector>
 #include <string>
 #include <map>
@@ -19,6 +20,7 @@
 #include <utility>  // for std::pair
 #include "flame2/exe/task_manager.hpp"
 #include "dependency.hpp"
+#include "execution_plan.hpp"
 #include "task.hpp"
 #include "xfunction.hpp"
 #include "xvariable.hpp"
@@ -46,6 +48,8 @@ typedef std::map<Edge, Dependency *> EdgeMap;
 
 //! Use a shared pointer to automatically handle Task pointers
 typedef boost::shared_ptr<Task> TaskPtr;
+//! \brief Define task name to run time mapping
+typedef std::map<std::string, double> TaskCostMap;
 
 class XGraph {
   public:
@@ -64,13 +68,25 @@ class XGraph {
     //!         second string for error message
     std::pair<int, std::string> checkFunctionConditions();
     void generateTaskList(std::vector<Task*> * tasks);
-    int registerAgentTask(Task * t,
-            std::map<std::string, flame::exe::TaskFunction> funcMap);
-    void registerDataTask(Task * t);
-    int registerMessageTask(Task * t);
-    int registerDependencies();
+    //! Fuses agent functions into the function they solely depend on
+    //! so both run in a single pass over agent memory
+    void fuseAgentFunctions();
+    //! Compiles the tasks and dependencies of the graph into a plan, with
+    //! task priorities set to critical path lengths weighted by the given
+    //! task run times, or counted in tasks if none are given
+    int compileExecutionPlan(ExecutionPlan * plan,
+            const TaskCostMap * costs = 0);
+    //! Registers tasks and dependencies with the Task Manager through a
+    //! compiled execution plan
     int registerTasksAndDependenciesWithTaskManager(
-            std::map<std::string, flame::exe::TaskFunction> funcMap);
+            std::map<std::string, flame::exe::TaskFunction> funcMap,
+            const TaskCostMap * costs = 0);
+    //! Computes the critical path length of each vertex
+    void computeTaskPriorities(const TaskCostMap * costs,
+            std::vector<double> * priorities);
+    //! Collects the variables written by agent functions of each agent
+    void getAgentWriteVariables(
+            std::map<std::string, std::set<std::string> > * vars);
     void setAgentName(std::string agentName);
     void import(XGraph * graph);
     std::vector<TaskPtr> * getVertexTaskMap();
@@ -96,14 +112,25 @@ class XGraph {
     std::set<Task *> endTasks_;
     Task * endTask_;
     std::string agentName_;
+    /*! \brief Names of double-buffered agent variables */
+    std::set<std::string> bufferedVariables_;
+    /*! \brief Vertex of each task, so lookups do not scan vertex2task_ */
+    boost::unordered_map<Task *, Vertex> task2vertex_;
+    /*! \brief First vertex of each task name and type */
+    boost::unordered_map<std::pair<std::string, int>, Vertex> name2vertex_;
+    /*! \brief If the indexes match vertex2task_, they are rebuilt when
+     *         needed after vertices are removed or renumbered */
+    bool indexValid_;
 
     Vertex getMessageVertex(std::string name, Task::TaskType type);
+    bool findVertex(const std::string& name, Task::TaskType type,
+            Vertex * v);
+    void indexVertex(Vertex v);
+    void updateIndex();
     void changeMessageTasksToSync();
     void addMessageClearTasks();
-    int registerAllowAccess(flame::exe::Task * task,
-            std::set<std::string> * vars, bool writeable);
-    int registerAllowMessage(flame::exe::Task * task,
-            std::set<std::string> * messages, bool post);
+    void generatePlanTasks(Task * t, double priority,
+            std::vector<ExecutionPlan::PlanTask> * tasks);
     Vertex addVertex(Task * t);
     Vertex addVertex(TaskPtr ptr);
     Edge addEdge(Vertex to, Vertex from, std::string name,
@@ -123,6 +150,8 @@ class XGraph {
     void addReadDependencies(Vertex v, Task * t);
     void addWritingVerticesToList(Vertex v, Task * t);
     void addDataDependencies(boost::ptr_vector<XVariable> * variables);
+    bool accessesBufferedVariable(Task * t);
+    void addBufferSwapTask(std::set<Vertex> * accessingVertices);
     void setStartTask(Task * task);
     void transformConditionalStatesToConditions(
             boost::ptr_vector<XVariable> * variables);
@@ -14,6 +14,7 @@
 #include <utility>
 #include "flame2/config.hpp"
 #include "flame2/mem/memory_manager.hpp"
+#include "flame2/mem/data_type.hpp"
 #include "flame2/exceptions/model.hpp"
 #include "xmachine.hpp"
 
@@ -178,7 +179,11 @@ std::pair<int, std::string> XMachine::checkFunctionConditions() {
   return functionDependencyGraph_.checkFunctionConditions();
 }
 
-void XMachine::registerWithMemoryManager() {
+/*!
+ * \brief Registers the agent and its memory with the memory manager
+ * \param[in] adts The user defined data types of the model
+ */
+void XMachine::registerWithMemoryManager(boost::ptr_vector<XADT> * adts) {
   boost::ptr_vector<XVariable>::iterator vit;
   flame::mem::MemoryManager& memoryManager =
       flame::mem::MemoryManager::GetInstance();
@@ -187,16 +192,58 @@ void XMachine::registerWithMemoryManager() {
   memoryManager.RegisterAgent(name_);
   /* Register agent memory variables */
   for (vit = variables_.begin(); vit != variables_.end(); ++vit)
-    /* Register int variable */
-    if ((*vit).getType() == "int")
-      memoryManager.RegisterAgentVar<int>(name_, (*vit).getName());
-  /* Register double variable */
-    else if ((*vit).getType() == "double")
-      memoryManager.RegisterAgentVar<double>(name_, (*vit).getName());
+    registerVariable(&(*vit), "", 1, false, adts);
   /* Population Size hint */
   memoryManager.HintPopulationSize(name_, 100);
 }
 
+/*!
+ * \brief Registers an agent memory variable with the memory manager
+ * \param[in] variable The variable
+ * \param[in] prefix Prefix of the variable name
+ * \param[in] count Number of instances per agent of the enclosing variable
+ * \param[in] buffered If the enclosing variable is double-buffered
+ * \param[in] adts The user defined data types of the model
+ *
+ * Static arrays are stored flat with their size as stride so no
+ * per-agent allocation is needed. Variables of a user defined data type are
+ * decomposed into one variable per member named "<variable>.<member>" whose
+ * stride also includes the sizes of enclosing static arrays. Dynamic arrays
+ * cannot be stored flat and are not registered.
+ */
+void XMachine::registerVariable(XVariable * variable, std::string prefix,
+    size_t count, bool buffered, boost::ptr_vector<XADT> * adts) {
+  boost::ptr_vector<XADT>::iterator ait;
+  boost::ptr_vector<XVariable>::iterator vit;
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+  std::string name = prefix + variable->getName();
+
+  if (variable->isDynamicArray() || variable->holdsDynamicArray()) return;
+  if (variable->isStaticArray()) count *= variable->getStaticArraySize();
+  buffered = buffered || variable->isBuffered();
+
+  /* Register each member of user defined data types */
+  if (variable->hasADTType()) {
+    if (adts == 0) return;
+    for (ait = adts->begin(); ait != adts->end(); ++ait)
+      if ((*ait).getName() == variable->getType())
+        for (vit = (*ait).getVariables()->begin();
+            vit != (*ait).getVariables()->end(); ++vit)
+          registerVariable(&(*vit), name + ".", count, buffered, adts);
+    return;
+  }
+
+  /* Register variable if agent memory can store its type */
+  const flame::mem::DataTypeBase * type =
+      flame::mem::DataTypeRegistry::GetInstance().GetType(
+          variable->getType());
+  if (type == 0) return;
+  type->RegisterAgentVar(name_, name, count);
+  /* Enable double-buffering if requested */
+  if (buffered) memoryManager.SetBuffered(name_, name);
+}
+
 void XMachine::addToModelGraph(XGraph * modelGraph) {
   modelGraph->import(&functionDependencyGraph_);
 }
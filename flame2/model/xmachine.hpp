@@ -15,6 +15,7 @@
 #include <set>
 #include <utility>
 #include "xvariable.hpp"
+#include "xadt.hpp"
 #include "xfunction.hpp"
 #include "xgraph.hpp"
 
@@ -45,7 +46,7 @@ class XMachine {
     std::pair<int, std::string> checkCyclicDependencies();
     std::pair<int, std::string> checkFunctionConditions();
     int generateDependencyGraph();
-    void registerWithMemoryManager();
+    void registerWithMemoryManager(boost::ptr_vector<XADT> * adts);
     void addToModelGraph(XGraph * modelGraph);
     void setID(int id);
     int getID();
@@ -58,6 +59,8 @@ class XMachine {
     std::string startState_;
     std::set<std::string> endStates_;
     XGraph functionDependencyGraph_;
+    void registerVariable(XVariable * variable, std::string prefix,
+            size_t count, bool buffered, boost::ptr_vector<XADT> * adts);
 };
 }}  // namespace flame::model
 #endif  // MODEL__XMACHINE_HPP_
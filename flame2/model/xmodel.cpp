@@ -7,23 +7,32 @@
  * \copyright GNU Lesser General Public License
  * \brief XModel: holds model information
  */
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
 #include <cstdio>
 #include <string>
 #include <vector>
 #include <set>
 #include <map>
+#include <algorithm>
 #include "flame2/config.hpp"
 #include "flame2/mb/message_board_manager.hpp"
+#include "flame2/mem/data_type.hpp"
+#include "flame2/io/io_manager.hpp"
 #include "flame2/exceptions/model.hpp"
 #include "xmodel.hpp"
 
 namespace flame { namespace model {
 
 XModel::XModel() {
-  /* Initialise list of data types */
-  addAllowedDataType("int");
-  addAllowedDataType("float");
-  addAllowedDataType("double");
+  /* Initialise list of data types from those agent memory can store */
+  std::vector<std::string> types =
+      flame::mem::DataTypeRegistry::GetInstance().GetTypeNames();
+  std::vector<std::string>::iterator it;
+  for (it = types.begin(); it != types.end(); ++it)
+    addAllowedDataType(*it);
   addAllowedDataType("char"); /* Allow? */
 }
 
@@ -76,7 +85,54 @@ void XModel::registerWithMemoryManager() {
 
   // For each agent register with memory manager
   for (agent = getAgents()->begin(); agent != getAgents()->end(); ++agent)
-    (*agent).registerWithMemoryManager();
+    (*agent).registerWithMemoryManager(&adts_);
+}
+
+//! Calls func on agent indices taken from next until count is reached,
+//! keeping the first exception thrown in error
+static void callForAgents(const boost::function<void (size_t)> * func,
+    size_t count, size_t * next, boost::mutex * mutex,
+    boost::exception_ptr * error) {
+  size_t index;
+  try {
+    for (;;) {
+      {
+        boost::lock_guard<boost::mutex> lock(*mutex);
+        if (*next >= count) return;
+        index = (*next)++;
+      }
+      (*func)(index);
+    }
+  } catch(...) {
+    *error = boost::current_exception();
+  }
+}
+
+void XModel::forEachAgentInParallel(
+    const boost::function<void (size_t)>& func) {
+  size_t ii, count = agents_.size(), next = 0;
+  size_t threads = std::min(
+      static_cast<size_t>(boost::thread::hardware_concurrency()), count);
+  if (threads < 1) threads = 1;
+  boost::mutex mutex;
+  std::vector<boost::exception_ptr> errors(threads);
+
+  // Agents are taken in turn as they differ in size, this thread
+  // takes them as well
+  boost::thread_group group;
+  for (ii = 1; ii < threads; ++ii)
+    group.create_thread(boost::bind(&callForAgents, &func, count, &next,
+        &mutex, &errors[ii]));
+  callForAgents(&func, count, &next, &mutex, &errors[0]);
+  group.join_all();
+  for (ii = 0; ii < threads; ++ii)
+    if (errors[ii]) boost::rethrow_exception(errors[ii]);
+}
+
+//! Generates the dependency graph of an agent
+static void generateAgentGraph(boost::ptr_vector<XMachine> * agents,
+    size_t index) {
+  (*agents)[index].generateDependencyGraph();
 }
 
 void XModel::generateGraph(XGraph * modelGraph) {
@@ -85,15 +141,14 @@ void XModel::generateGraph(XGraph * modelGraph) {
 
   modelGraph->setAgentName(name_);
 
+  // Agent graphs only refer to their own tasks so are generated
+  // concurrently
+  forEachAgentInParallel(boost::bind(&generateAgentGraph, &agents_, _1));
+
   // Consolidate agent graphs into a model graph
   for (agent = agents_.begin();
-      agent != agents_.end(); ++agent) {
-    // Generate agent graph
-    (*agent).generateDependencyGraph();
-    // Add to model graph
-    // (*agent)->addToModelGraph(&modelGraph);
+      agent != agents_.end(); ++agent)
     graphs.insert((*agent).getFunctionDependencyGraph());
-  }
 
   modelGraph->importGraphs(graphs);
 
@@ -102,12 +157,27 @@ void XModel::generateGraph(XGraph * modelGraph) {
 #endif
 }
 
-void XModel::registerWithTaskManager() {
+void XModel::compileExecutionPlan(ExecutionPlan * plan, bool fuseFunctions) {
   XGraph modelGraph;
 
   generateGraph(&modelGraph);
+  if (fuseFunctions) modelGraph.fuseAgentFunctions();
+  modelGraph.compileExecutionPlan(plan);
+}
+
+void XModel::registerWithTaskManager() {
+  ExecutionPlan plan;
+
+  compileExecutionPlan(&plan);
+  registerWithTaskManager(plan);
+}
+
+void XModel::registerWithTaskManager(const ExecutionPlan& plan) {
+  plan.registerWithTaskManager(funcMap_);
 
-  modelGraph.registerTasksAndDependenciesWithTaskManager(funcMap_);
+  // Variables that agent functions write can change between outputs
+  flame::io::IOManager::GetInstance().setWrittenVariables(
+      plan.getWrittenVariables());
 }
 
 void XModel::setPath(std::string path) {
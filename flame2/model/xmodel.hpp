@@ -10,6 +10,7 @@
 #ifndef MODEL__XMODEL_HPP_
 #define MODEL__XMODEL_HPP_
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/function.hpp>
 #include <string>
 #include <vector>
 #include <map>
@@ -19,6 +20,7 @@
 #include "xtimeunit.hpp"
 #include "xmessage.hpp"
 #include "xmodel_validate.hpp"
+#include "execution_plan.hpp"
 
 namespace flame { namespace model {
 
@@ -29,6 +31,13 @@ class XModel {
     int validate();
     void registerWithMemoryManager();
     void registerWithTaskManager();
+    //! Registers tasks using a plan compiled from this model, which saves
+    //! generating the model graph
+    void registerWithTaskManager(const ExecutionPlan& plan);
+    //! Compiles the model graph into a plan, by default with chains of
+    //! agent functions fused into single tasks
+    void compileExecutionPlan(ExecutionPlan * plan,
+            bool fuseFunctions = true);
     void registerAgentFunction(std::string, flame::exe::TaskFunction);
     void setPath(std::string path);
     std::string getPath();
@@ -55,6 +64,10 @@ class XModel {
     void addAllowedDataType(std::string name);
     std::vector<std::string> * getAllowedDataTypes();
     std::map<std::string, flame::exe::TaskFunction> getFuncMap();
+    //! Calls func with the index of each agent, agents are shared out
+    //! between up to one thread per core so func must only change the
+    //! agent it is given. Rethrows an exception thrown by func
+    void forEachAgentInParallel(const boost::function<void (size_t)>& func);
 #ifdef TESTBUILD
     void generateGraph(XGraph * modelGraph);
 #endif
@@ -16,6 +16,7 @@
 #include <set>
 #include <algorithm>
 #include <utility>  // for std::pair
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include "flame2/config.hpp"
@@ -76,6 +77,8 @@ int XModelValidate::validate() {
   /* Validate agents */
   for (a_it = agents_->begin(); a_it != agents_->end(); ++a_it)
     errors += validateAgent(&(*a_it));
+  /* Validate agent state graphs, which needs their functions validated */
+  errors += validateAgentStateGraphs();
   /* Validate messages */
   for (m_it = messages_->begin(); m_it != messages_->end(); ++m_it)
     errors += validateMessage(&(*m_it));
@@ -110,21 +113,43 @@ int XModelValidate::validateTimeUnits(
   return errors;
 }
 
-int XModelValidate::validateAgentStateGraph(XMachine * agent) {
+int XModelValidate::validateAgentStateGraphs() {
+  int errors = 0;
+  size_t ii;
+  std::vector<std::pair<int, std::string> > results(agents_->size());
+
+  // Agent state graphs are independent so are validated concurrently,
+  // errors are printed afterwards in agent order
+  model->forEachAgentInParallel(boost::bind(
+      &XModelValidate::validateAgentStateGraph, this, _1, &results));
+  for (ii = 0; ii < results.size(); ++ii)
+    if (results[ii].first > 0) {
+      printErr("%s", results[ii].second.c_str());
+      printErr("\tfrom agent: %s\n", (*agents_)[ii].getName().c_str());
+      errors += results[ii].first;
+    }
+  return errors;
+}
+
+void XModelValidate::validateAgentStateGraph(size_t index,
+    std::vector<std::pair<int, std::string> > * results) {
+  XMachine * agent = &(*agents_)[index];
   // return code and number of errors
   int rc, errors = 0;
   // return error (code and error message)
   std::pair<int, std::string> rerr;
+  // error messages, printed by the caller
+  std::string messages;
 
   // Validate single start state
   rc = agent->findStartEndStates();
   if (rc == 1) {
-    printErr("Error: %s agent doesn't have a start state\n",
-        agent->getName().c_str());
+    messages += "Error: " + agent->getName() +
+        " agent doesn't have a start state\n";
     ++errors;
   } else if (rc == 2) {
-    printErr("Error: %s agent has multiple possible start states\n",
-        agent->getName().c_str());
+    messages += "Error: " + agent->getName() +
+        " agent has multiple possible start states\n";
     ++errors;
   } else {
     // Generate state graph
@@ -133,17 +158,17 @@ int XModelValidate::validateAgentStateGraph(XMachine * agent) {
     rerr = agent->checkCyclicDependencies();
     if (rerr.first > 0) {
       errors += rerr.first;
-      printErr(rerr.second.c_str());
+      messages += rerr.second;
     }
     // Check functions from state with more than one
     // out going function all have conditions
     rerr = agent->checkFunctionConditions();
     if (rerr.first > 0) {
       errors += rerr.first;
-      printErr(rerr.second.c_str());
+      messages += rerr.second;
     }
   }
-  return errors;
+  (*results)[index] = std::make_pair(errors, messages);
 }
 
 int XModelValidate::validateAgent(XMachine * agent) {
@@ -178,9 +203,6 @@ int XModelValidate::validateAgent(XMachine * agent) {
     }
   }
 
-  // Validate agent state graph
-  errors += validateAgentStateGraph(agent);
-
   if (errors > 0)  printErr("\tfrom agent: %s\n", name.c_str());
 
   return errors;
@@ -286,6 +308,20 @@ int XModelValidate::processVariable(XVariable * variable) {
     }
   }
 
+  /* Validate buffered if set */
+  if (variable->isBufferedSet()) {
+    if (variable->getBufferedString() == "true") {
+      variable->setBuffered(true);
+    } else if (variable->getBufferedString() == "false") {
+      variable->setBuffered(false);
+    } else {
+      /* If buffered value is not true or false */
+      printErr("Error: variable buffered value is not 'true' or 'false': %s\n",
+          variable->getBufferedString().c_str());
+      ++errors;
+    }
+  }
+
   return errors;
 }
 
@@ -12,6 +12,7 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <utility>  // for std::pair
 #include "xmachine.hpp"
 #include "xvariable.hpp"
 #include "xadt.hpp"
@@ -57,7 +58,9 @@ class XModelValidate {
     int processTimeUnit(XTimeUnit * timeUnit);
     int validateADT(XADT * adt);
     int validateAgent(XMachine * agent);
-    int validateAgentStateGraph(XMachine * agent);
+    int validateAgentStateGraphs();
+    void validateAgentStateGraph(size_t index,
+            std::vector<std::pair<int, std::string> > * results);
     int validateAgentFunctionIOput(XFunction * xfunction, XMachine * agent);
     int validateAgentFunction(XFunction * xfunction, XMachine * agent);
     int validateAgentCommunication(XIOput * xioput, XMachine * agent);
@@ -20,6 +20,7 @@ namespace flame { namespace model {
  * Initialises XVariable as
  * fundamental (int or double)
  * variable (not constant)
+ * single buffered
  * scaler (not an array).
  */
 XVariable::XVariable()
@@ -29,7 +30,9 @@ XVariable::XVariable()
   hasADTType_(false),
   holdsDynamicArray_(false),
   constantSet_(false),
-  constant_(false) {}
+  constant_(false),
+  bufferedSet_(false),
+  buffered_(false) {}
 
 /*!
  * \brief Initialises XVariable
@@ -44,7 +47,9 @@ XVariable::XVariable(std::string name)
   hasADTType_(false),
   holdsDynamicArray_(false),
   constantSet_(false),
-  constant_(false) {}
+  constant_(false),
+  bufferedSet_(false),
+  buffered_(false) {}
 
 /*!
  * \brief Prints XVariable
@@ -140,4 +145,28 @@ bool XVariable::isConstant() {
   return constant_;
 }
 
+void XVariable::setBufferedString(std::string buffered) {
+  bufferedString_ = buffered;
+}
+
+std::string XVariable::getBufferedString() {
+  return bufferedString_;
+}
+
+void XVariable::setBufferedSet(bool set) {
+  bufferedSet_ = set;
+}
+
+bool XVariable::isBufferedSet() {
+  return bufferedSet_;
+}
+
+void XVariable::setBuffered(bool buffered) {
+  buffered_ = buffered;
+}
+
+bool XVariable::isBuffered() {
+  return buffered_;
+}
+
 }}  // namespace flame::model
@@ -38,6 +38,12 @@ class XVariable {
     bool isConstantSet();
     void setConstant(bool constant);
     bool isConstant();
+    void setBufferedString(std::string buffered);
+    std::string getBufferedString();
+    void setBufferedSet(bool set);
+    bool isBufferedSet();
+    void setBuffered(bool buffered);
+    bool isBuffered();
 
   private:
     std::string type_;
@@ -50,6 +56,9 @@ class XVariable {
     std::string constantString_;
     bool constantSet_;
     bool constant_;
+    std::string bufferedString_;
+    bool bufferedSet_;
+    bool buffered_;
 };
 }}  // namespace flame::model
 #endif  // MODEL__XVARIABLE_HPP_
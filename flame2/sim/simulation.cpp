@@ -12,13 +12,23 @@
 #include "flame2/config.hpp"
 #include "flame2/io/io_manager.hpp"
 #include "flame2/exe/fifo_task_queue.hpp"
+#include "flame2/exe/priority_task_queue.hpp"
+#include "flame2/exe/metrics.hpp"
+#include "flame2/exe/profiler.hpp"
 #include "flame2/exe/scheduler.hpp"
+#include "flame2/exe/splitting_task_queue.hpp"
 #include "flame2/exceptions/sim.hpp"
 #include "simulation.hpp"
 
 namespace flame { namespace sim {
 
-Simulation::Simulation(flame::model::Model * model, std::string pop_file) {
+const size_t Simulation::kIOSlots;
+
+Simulation::Simulation(flame::model::Model * model, std::string pop_file)
+  : traceFirst_(1), traceLast_(0),
+    minVectorSize_(exe::SplittingTaskQueue::DEFAULT_MIN_VECTOR_SIZE),
+    splitPolicy_(exe::Task::SPLIT_EVEN), outputFrequency_(1),
+    outputCompression_(0), deltaOutput_(false), timeSeriesOutput_(false) {
   flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
 
   // check model has been validated
@@ -28,18 +38,36 @@ Simulation::Simulation(flame::model::Model * model, std::string pop_file) {
   model_ = model->getXModel();
 
   model_->registerWithMemoryManager();
-  iomanager.readPop(pop_file, model_, io::IOManager::xml);
+  // population output is written in the same format as the initial pop
+  io::IOManager::FileType fileType = iomanager.getFileType(pop_file);
+  iomanager.readPop(pop_file, model_, fileType);
+  iomanager.setOutputType(fileType);
 }
 
 void Simulation::start(size_t iterations, size_t num_cores) {
   // Register agents with memory and task manager
-  model_->registerWithTaskManager();
+  if (plan_.getTaskCount() > 0) model_->registerWithTaskManager(plan_);
+  else
+    model_->registerWithTaskManager();
 
   exe::Scheduler s;
-  exe::Scheduler::QueueId q = s.CreateQueue<exe::FIFOTaskQueue>(num_cores);
-  s.AssignType(q, exe::Task::AGENT_FUNCTION);
-  s.AssignType(q, exe::Task::MB_FUNCTION);
-  s.AssignType(q, exe::Task::IO_FUNCTION);
+  createQueues(&s, num_cores);
+
+  // Write output in the background while the next iteration runs
+  flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
+  iomanager.setOutputFrequency(outputFrequency_);
+  iomanager.setOutputCompression(outputCompression_);
+  iomanager.setDeltaOutput(deltaOutput_);
+  iomanager.setTimeSeriesOutput(timeSeriesOutput_);
+  iomanager.setAsynchronousOutput(true);
+
+  exe::Profiler& profiler = exe::Profiler::GetInstance();
+  if (!traceFile_.empty()) profiler.Enable(traceFirst_, traceLast_);
+  exe::Metrics& metrics = exe::Metrics::GetInstance();
+  if (!metricsFile_.empty()) {
+    metrics.SetOutputFile(metricsFile_);
+    metrics.Enable();
+  }
 
   unsigned int ii;
   for (ii = 1; ii <= iterations; ++ii) {
@@ -48,6 +76,78 @@ void Simulation::start(size_t iterations, size_t num_cores) {
 #endif
     s.RunIteration();
   }
+
+  // Wait for pending output to be written
+  iomanager.setAsynchronousOutput(false);
+
+  if (!traceFile_.empty()) {
+    profiler.Disable();
+    profiler.WriteChromeTrace(traceFile_);
+  }
+  if (!metricsFile_.empty()) metrics.Disable();
+}
+
+void Simulation::createQueues(exe::Scheduler * s, size_t num_cores) {
+  // Tasks heading the longest chains of dependent tasks are run first
+  exe::Scheduler::QueueId q =
+      s->CreateQueue<exe::PriorityTaskQueue>(num_cores);
+  s->AssignType(q, exe::Task::AGENT_FUNCTION);
+  s->AssignType(q, exe::Task::MB_FUNCTION);
+  s->AssignType(q, exe::Task::MEM_FUNCTION);
+  // Agent tasks are split across the cores, and subtasks of tasks range
+  // dependent on them run as soon as the matching subtasks are done
+  s->SetSplittable(exe::Task::AGENT_FUNCTION);
+  s->SetMinVectorSize(exe::Task::AGENT_FUNCTION, minVectorSize_);
+  s->SetSplitPolicy(exe::Task::AGENT_FUNCTION, splitPolicy_);
+  // IO tasks run on a queue of their own so compute workers never wait
+  // for output, which is written in the background by the IO manager
+  exe::Scheduler::QueueId ioq = s->CreateQueue<exe::FIFOTaskQueue>(kIOSlots);
+  s->AssignType(ioq, exe::Task::IO_FUNCTION);
+}
+
+void Simulation::setTraceFile(std::string file_name, size_t first,
+    size_t last) {
+  traceFile_ = file_name;
+  traceFirst_ = first;
+  traceLast_ = last;
+}
+
+void Simulation::setMetricsFile(std::string file_name) {
+  metricsFile_ = file_name;
+}
+
+void Simulation::setMinVectorSize(size_t min_vector_size) {
+  if (min_vector_size < 1) throw flame::exceptions::flame_sim_exception(
+      "Minimum vector size must be > 0");
+  minVectorSize_ = min_vector_size;
+}
+
+void Simulation::setSplitPolicy(exe::Task::SplitPolicy policy) {
+  splitPolicy_ = policy;
+}
+
+void Simulation::setOutputFrequency(size_t n) {
+  if (n < 1) throw flame::exceptions::flame_sim_exception(
+      "Output frequency must be > 0");
+  outputFrequency_ = n;
+}
+
+void Simulation::setOutputCompression(int level) {
+  if (level < 0 || level > 9) throw flame::exceptions::flame_sim_exception(
+      "Output compression level must be 0 to 9");
+  outputCompression_ = level;
+}
+
+void Simulation::setDeltaOutput(bool delta) {
+  deltaOutput_ = delta;
+}
+
+void Simulation::setTimeSeriesOutput(bool enable) {
+  timeSeriesOutput_ = enable;
+}
+
+void Simulation::setExecutionPlan(const flame::model::ExecutionPlan& plan) {
+  plan_ = plan;
 }
 
 }}  // namespace flame::sim
@@ -11,6 +11,9 @@
 #define SIM__SIMULATION_HPP_
 #include <string>
 #include "flame2/model/model.hpp"
+#include "flame2/exe/task_interface.hpp"
+
+namespace flame { namespace exe { class Scheduler; }}
 
 namespace flame { namespace sim {
 
@@ -18,9 +21,52 @@ class Simulation {
   public:
     Simulation(flame::model::Model * model, std::string pop_file);
     void start(size_t iterations, size_t num_cores = 1);
+    //! Creates the task queues the simulation runs on: num_cores threads
+    //! for compute tasks and kIOSlots threads of their own for IO tasks
+    void createQueues(flame::exe::Scheduler * s, size_t num_cores);
+    //! Records task runs of the given iterations, last 0 for all, and
+    //! writes them to a Chrome trace file once the simulation ends
+    void setTraceFile(std::string file_name, size_t first = 1,
+        size_t last = 0);
+    //! Writes performance counter totals of every iteration to a CSV
+    //! file, or a JSON file if the name ends in .json
+    void setMetricsFile(std::string file_name);
+    //! Sets the minimum number of agents in each subtask when agent
+    //! tasks are split across cores
+    void setMinVectorSize(size_t min_vector_size);
+    //! Sets how the agents of split agent tasks are divided between
+    //! subtasks, by default into equal counts
+    void setSplitPolicy(flame::exe::Task::SplitPolicy policy);
+    //! Writes population output only every n iterations
+    void setOutputFrequency(size_t n);
+    //! Compresses xml population output with gzip at the given level,
+    //! 0 for no compression
+    void setOutputCompression(int level);
+    //! Writes only variables written by agent functions after the first
+    //! population output. Delta files cannot be restarted from.
+    void setDeltaOutput(bool delta);
+    //! Also writes population output as time series of each variable
+    void setTimeSeriesOutput(bool enable);
+    //! Registers tasks from a plan compiled from the model, such as the
+    //! one written by xparser, instead of generating the model graph
+    void setExecutionPlan(const flame::model::ExecutionPlan& plan);
+
+    //! Number of threads running IO tasks, in addition to num_cores
+    static const size_t kIOSlots = 2;
 
   private:
     flame::model::XModel * model_;
+    std::string traceFile_;  //! Trace file, empty if not tracing
+    size_t traceFirst_;  //! First iteration traced
+    size_t traceLast_;  //! Last iteration traced, 0 for all
+    std::string metricsFile_;  //! Metrics file, empty if not counting
+    size_t minVectorSize_;  //! Minimum agents per split agent task
+    flame::exe::Task::SplitPolicy splitPolicy_;  //! Division of split tasks
+    size_t outputFrequency_;  //! Iterations between population outputs
+    int outputCompression_;  //! Gzip level of xml output, 0 for none
+    bool deltaOutput_;  //! Only write variables written by agent functions
+    bool timeSeriesOutput_;  //! Write time series alongside population files
+    flame::model::ExecutionPlan plan_;  //! Plan, empty if not compiled
 };
 }}  // namespace flame::sim
 #endif  // SIM__SIMULATION_HPP_
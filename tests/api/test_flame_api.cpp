@@ -8,6 +8,8 @@
  * \brief Test suite for the user API (C++)
  */
 #define BOOST_TEST_DYN_LINK
+#include <cstring>
+#include <string>
 #include <vector>
 #include <boost/test/unit_test.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -104,6 +106,16 @@ BOOST_AUTO_TEST_CASE(api_test_basic) {
   }
   BOOST_CHECK(mem_iter->AtEnd());
 
+  // ids are remembered by the address of the name, which may be reused
+  mem_iter->Rewind();
+  char name[3] = "ro";
+  BOOST_CHECK_EQUAL(FLAME.GetMem<int>(name), 0);
+  std::strcpy(name, "rw");
+  BOOST_CHECK_EQUAL(FLAME.GetMem<int>(name), 10);
+  BOOST_CHECK_EQUAL(FLAME.GetMem<int>(std::string("ro")), 0);
+  std::strcpy(name, "ro");
+  BOOST_CHECK_THROW(FLAME.SetMem<int>(name, 1), e::flame_api_access_denied);
+
   // reset managers so as not to affect next test suite
   mem_mgr.Reset();
   mb_mgr.Reset();
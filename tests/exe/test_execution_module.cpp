@@ -8,14 +8,20 @@
  * \brief Test suite for the execution module
  */
 #define BOOST_TEST_DYN_LINK
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
 #include <vector>
 #include <boost/test/unit_test.hpp>
+#include "flame2/exceptions/all.hpp"
 #include "flame2/mem/memory_manager.hpp"
 #include "flame2/exe/task_manager.hpp"
 #include "flame2/exe/task_interface.hpp"
 #include "flame2/exe/fifo_task_queue.hpp"
 #include "flame2/exe/splitting_fifo_task_queue.hpp"
 #include "flame2/exe/scheduler.hpp"
+#include "flame2/exe/profiler.hpp"
 #include "flame2/api/flame2.hpp"
 
 BOOST_AUTO_TEST_SUITE(ExeModule)
@@ -150,6 +156,191 @@ BOOST_AUTO_TEST_CASE(test_task_queue) {
   BOOST_CHECK(mptr->AtEnd());
 }
 
+BOOST_AUTO_TEST_CASE(test_profiler) {
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  exe::Profiler& profiler = exe::Profiler::GetInstance();
+  BOOST_CHECK(!profiler.IsEnabled());
+  BOOST_CHECK_THROW(profiler.Enable(3, 2),
+                    flame::exceptions::invalid_argument);
+  BOOST_CHECK_THROW(profiler.Enable(1, 0, 0),
+                    flame::exceptions::invalid_argument);
+
+  // only record the first of two iterations
+  profiler.Enable(3, 3, 1024);
+  BOOST_CHECK(profiler.IsEnabled());
+  exe::Scheduler s(3);
+  exe::Scheduler::QueueId q = s.CreateQueue<exe::SplittingFIFOTaskQueue>(4);
+  s.AssignType(q, exe::Task::AGENT_FUNCTION);
+  s.SetSplittable(exe::Task::AGENT_FUNCTION);
+  s.RunIteration();
+  s.RunIteration();
+  profiler.Disable();
+
+  // every agent of every task is run once in iteration 3
+  std::vector<exe::Profiler::Record> records = profiler.GetRecords();
+  std::map<exe::Task::id_type, size_t> agents;
+  for (size_t i = 0; i < records.size(); ++i) {
+    exe::Profiler::Record& r = records[i];
+    BOOST_CHECK_EQUAL(r.iteration, (size_t)3);
+    BOOST_CHECK(r.stop >= r.start);
+    BOOST_CHECK(r.wait >= 0);
+    if (i > 0) BOOST_CHECK(r.start >= records[i - 1].start);
+    agents[r.task_id] += (r.count > 0) ? r.count : (size_t)AGENT_COUNT;
+  }
+  BOOST_CHECK_EQUAL(agents.size(), (size_t)4);
+  BOOST_CHECK_EQUAL(agents[tm.GetTask("t1").get_task_id()],
+                    (size_t)AGENT_COUNT);
+  BOOST_CHECK_EQUAL(agents[tm.GetTask("t4").get_task_id()],
+                    (size_t)AGENT_COUNT);
+
+  // trace lists each run as a complete event
+  std::string file_name = "trace_test.json";
+  profiler.WriteChromeTrace(file_name);
+  std::ifstream in(file_name.c_str());
+  std::string trace((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  in.close();
+  BOOST_CHECK_EQUAL(trace.find("{\"displayTimeUnit\":\"ms\""), (size_t)0);
+  BOOST_CHECK(trace.find("\"name\":\"t1\",\"cat\":\"agent\",\"ph\":\"X\"")
+              != std::string::npos);
+  BOOST_CHECK(trace.find("\"wait_us\":") != std::string::npos);
+  remove(file_name.c_str());
+
+  profiler.Clear();
+  BOOST_CHECK(profiler.GetRecords().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_fused_task) {
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  tm.Reset();
+
+  // t1+t3 : y = x * 10 then y = y + x in a single pass over the agents
+  std::vector<exe::TaskFunction> funcs;
+  funcs.push_back(&func_Y_10X);
+  funcs.push_back(&func_Y_XpY);
+  exe::Task &t = tm.CreateAgentTask("t1+t3", "Circle", funcs);
+  t.AllowAccess("x_int");
+  t.AllowAccess("y_dbl", true);  // write access to y
+
+  exe::Scheduler s;
+  exe::Scheduler::QueueId q = s.CreateQueue<exe::SplittingFIFOTaskQueue>(4);
+  s.AssignType(q, exe::Task::AGENT_FUNCTION);
+  s.SetSplittable(exe::Task::AGENT_FUNCTION);
+  s.RunIteration();
+
+  // each agent runs both functions in order, so y = 11x
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mem::AgentShadowPtr shadow = mgr.GetAgentShadow("Circle");
+  shadow->AllowAccess("x_int");
+  shadow->AllowAccess("y_dbl");
+  mem::MemoryIteratorPtr mptr = shadow->GetMemoryIterator();
+  for (int i = 0; i < AGENT_COUNT; i++) {
+    BOOST_CHECK_CLOSE(mptr->Get<double>("y_dbl"),
+                      11.0 * mptr->Get<int>("x_int"), 0.00001);
+    mptr->Step();
+  }
+  BOOST_CHECK(mptr->AtEnd());
+}
+
+BOOST_AUTO_TEST_CASE(test_range_dependency) {
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  tm.Reset();
+
+  // t1 : y = x * 10, then t3 : y = y + x for the same agents
+  exe::Task &t1 = tm.CreateAgentTask("t1", "Circle", func_Y_10X);
+  t1.AllowAccess("x_int");
+  t1.AllowAccess("y_dbl", true);  // write access to y
+  exe::Task &t3 = tm.CreateAgentTask("t3", "Circle", func_Y_XpY);
+  t3.AllowAccess("x_int");
+  t3.AllowAccess("y_dbl", true);  // write access to y
+  tm.AddRangeDependency("t3", "t1");
+
+  // each subtask of t3 runs once the matching subtask of t1 is done
+  exe::Scheduler s;
+  exe::Scheduler::QueueId q = s.CreateQueue<exe::SplittingFIFOTaskQueue>(4);
+  s.AssignType(q, exe::Task::AGENT_FUNCTION);
+  s.SetSplittable(exe::Task::AGENT_FUNCTION);
+  s.SetMaxTasksPerSplit(exe::Task::AGENT_FUNCTION, 8);
+  s.RunIteration();
+
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mem::AgentShadowPtr shadow = mgr.GetAgentShadow("Circle");
+  shadow->AllowAccess("x_int");
+  shadow->AllowAccess("y_dbl");
+  mem::MemoryIteratorPtr mptr = shadow->GetMemoryIterator();
+  for (int i = 0; i < AGENT_COUNT; i++) {
+    BOOST_CHECK_CLOSE(mptr->Get<double>("y_dbl"),
+                      11.0 * mptr->Get<int>("x_int"), 0.00001);
+    mptr->Step();
+  }
+  BOOST_CHECK(mptr->AtEnd());
+
+  // tasks too small to split wait for the whole of their dependency
+  s.SetMinVectorSize(exe::Task::AGENT_FUNCTION, AGENT_COUNT);
+  s.RunIteration();
+  mptr->Rewind();
+  for (int i = 0; i < AGENT_COUNT; i++) {
+    BOOST_CHECK_CLOSE(mptr->Get<double>("y_dbl"),
+                      11.0 * mptr->Get<int>("x_int"), 0.00001);
+    mptr->Step();
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_split_policy) {
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  tm.Reset();
+
+  // t1 : y = x * 10, then t3 : y = y + x for the same agents
+  exe::Task &t1 = tm.CreateAgentTask("t1", "Circle", func_Y_10X);
+  t1.AllowAccess("x_int");
+  t1.AllowAccess("y_dbl", true);  // write access to y
+  exe::Task &t3 = tm.CreateAgentTask("t3", "Circle", func_Y_XpY);
+  t3.AllowAccess("x_int");
+  t3.AllowAccess("y_dbl", true);  // write access to y
+  tm.AddRangeDependency("t3", "t1");
+
+  exe::Scheduler s;
+  exe::Scheduler::QueueId q = s.CreateQueue<exe::SplittingFIFOTaskQueue>(4);
+  exe::Scheduler::QueueId ioq = s.CreateQueue<exe::FIFOTaskQueue>(1);
+  s.AssignType(q, exe::Task::AGENT_FUNCTION);
+  s.AssignType(ioq, exe::Task::IO_FUNCTION);
+  s.SetSplittable(exe::Task::AGENT_FUNCTION);
+  BOOST_CHECK_EQUAL(s.GetSplitPolicy(exe::Task::AGENT_FUNCTION),
+                    exe::Task::SPLIT_EVEN);
+  BOOST_CHECK_THROW(s.SetSplitPolicy(exe::Task::IO_FUNCTION,
+                                     exe::Task::SPLIT_GUIDED),
+                    flame::exceptions::not_implemented);
+  BOOST_CHECK_THROW(s.SetSplitPolicy(exe::Task::MB_FUNCTION,
+                                     exe::Task::SPLIT_GUIDED),
+                    flame::exceptions::invalid_argument);
+
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mem::AgentShadowPtr shadow = mgr.GetAgentShadow("Circle");
+  shadow->AllowAccess("x_int");
+  shadow->AllowAccess("y_dbl");
+  mem::MemoryIteratorPtr mptr = shadow->GetMemoryIterator();
+
+  // guided subtasks, and balanced ones from the run times of the
+  // iteration before, cover every agent once
+  exe::Task::SplitPolicy policies[] = {
+    exe::Task::SPLIT_GUIDED, exe::Task::SPLIT_BALANCED,
+    exe::Task::SPLIT_BALANCED
+  };
+  for (size_t p = 0; p < 3; ++p) {
+    s.SetSplitPolicy(exe::Task::AGENT_FUNCTION, policies[p]);
+    BOOST_CHECK_EQUAL(s.GetSplitPolicy(exe::Task::AGENT_FUNCTION),
+                      policies[p]);
+    s.RunIteration();
+    mptr->Rewind();
+    for (int i = 0; i < AGENT_COUNT; i++) {
+      BOOST_CHECK_CLOSE(mptr->Get<double>("y_dbl"),
+                        11.0 * mptr->Get<int>("x_int"), 0.00001);
+      mptr->Step();
+    }
+    BOOST_CHECK(mptr->AtEnd());
+  }
+}
+
 BOOST_AUTO_TEST_CASE(reset_memory_manager_exemod) {
   mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
   mgr.Reset();  // reset again so as not to affect next test suite
@@ -8,6 +8,9 @@
  * \brief Test suite for the execution module
  */
 #define BOOST_TEST_DYN_LINK
+#include <cstdio>
+#include <fstream>
+#include <string>
 #include <vector>
 #include <ostream>
 #include <boost/test/unit_test.hpp>
@@ -16,6 +19,7 @@
 #include "flame2/mb/message_board_manager.hpp"
 #include "flame2/exe/task_manager.hpp"
 #include "flame2/exe/scheduler.hpp"
+#include "flame2/exe/metrics.hpp"
 #include "flame2/exe/fifo_task_queue.hpp"
 #include "flame2/exe/splitting_fifo_task_queue.hpp"
 
@@ -118,6 +122,12 @@ BOOST_AUTO_TEST_CASE(exe_test_msg_post) {
   tm.AddDependency("read", "sync");
   tm.AddDependency("clear", "read");
 
+  // Count messages and agents
+  exe::Metrics& metrics = exe::Metrics::GetInstance();
+  std::string metrics_file = "metrics_test.json";
+  metrics.SetOutputFile(metrics_file);
+  metrics.Enable();
+
   // Run
   exe::Scheduler s;
   exe::Scheduler::QueueId q = s.CreateQueue<exe::SplittingFIFOTaskQueue>(4);
@@ -139,9 +149,64 @@ BOOST_AUTO_TEST_CASE(exe_test_msg_post) {
   // Board should have been cleared in the end
   BOOST_CHECK_EQUAL(mb_mgr.GetCount("location"), (size_t)0);
 
+  // Counters are totalled over all worker threads
+  BOOST_CHECK_EQUAL(metrics.GetTotal("post.agents"), AGENT_COUNT);
+  BOOST_CHECK_EQUAL(metrics.GetTotal("read.agents"), AGENT_COUNT);
+  BOOST_CHECK_EQUAL(metrics.GetTotal("location.posted"), AGENT_COUNT);
+  BOOST_CHECK_EQUAL(metrics.GetTotal("location.synced"), AGENT_COUNT);
+  BOOST_CHECK_EQUAL(metrics.GetTotal("location.sync_bytes"),
+                    AGENT_COUNT * sizeof(location_message));
+  BOOST_CHECK_EQUAL(metrics.GetTotal("location.read"),
+                    AGENT_COUNT * AGENT_COUNT);
+  BOOST_CHECK(metrics.GetTotal("post.time_s") >= 0.0);
+  metrics.Disable();
+
+  std::ifstream in(metrics_file.c_str());
+  std::string line;
+  std::getline(in, line);
+  in.close();
+  BOOST_CHECK_EQUAL(line.find("{\"iteration\":1,\"counters\":{"), (size_t)0);
+  BOOST_CHECK(line.find("\"location.posted\":100") != std::string::npos);
+  remove(metrics_file.c_str());
+  metrics.Reset();
+
   mem_mgr.Reset();
   mb_mgr.Reset();
   tm.Reset();
 }
 
+BOOST_AUTO_TEST_CASE(exe_metrics_counter_names) {
+  exe::Metrics& metrics = exe::Metrics::GetInstance();
+  std::string metrics_file = "metrics_names_test.json";
+  std::string name = "quote\"back\\slash";
+  metrics.SetOutputFile(metrics_file);
+  metrics.Enable();
+
+  // Ids of names are cached by the thread and dropped on reset
+  metrics.Add(name, 1.0);
+  metrics.Add(name, 2.0);
+  metrics.EndIteration(1);
+  BOOST_CHECK_EQUAL(metrics.GetTotal(name), 3.0);
+  metrics.Reset();
+  metrics.Add("other", 1.0);
+  metrics.Add(name, 5.0);
+  metrics.EndIteration(2);
+  BOOST_CHECK_EQUAL(metrics.GetTotal("other"), 1.0);
+  BOOST_CHECK_EQUAL(metrics.GetTotal(name), 5.0);
+  metrics.Disable();
+
+  // Names are escaped in JSON output
+  std::ifstream in(metrics_file.c_str());
+  std::string line;
+  std::getline(in, line);
+  BOOST_CHECK(line.find("\"quote\\\"back\\\\slash\":3") !=
+              std::string::npos);
+  std::getline(in, line);
+  BOOST_CHECK(line.find("\"quote\\\"back\\\\slash\":5") !=
+              std::string::npos);
+  in.close();
+  remove(metrics_file.c_str());
+  metrics.Reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -60,6 +60,14 @@ BOOST_AUTO_TEST_CASE(test_create_task) {
                     flame::exceptions::invalid_agent);
   BOOST_CHECK_THROW(tm.CreateAgentTask("t1", "Circle", NULL),
                     flame::exceptions::invalid_argument);
+  // fused tasks need at least one function and no NULL functions
+  std::vector<exe::TaskFunction> funcs;
+  BOOST_CHECK_THROW(tm.CreateAgentTask("t1", "Circle", funcs),
+                    flame::exceptions::invalid_argument);
+  funcs.push_back(&func1);
+  funcs.push_back(NULL);
+  BOOST_CHECK_THROW(tm.CreateAgentTask("t1", "Circle", funcs),
+                    flame::exceptions::invalid_argument);
 
   tm.CreateAgentTask("outputdata", "Circle", &func1);
   tm.CreateAgentTask("inputdata", "Circle", &func1);
@@ -262,6 +270,137 @@ BOOST_AUTO_TEST_CASE(test_task_iteration) {
   tm.Reset();
 }
 
+BOOST_AUTO_TEST_CASE(test_task_priorities) {
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  tm.CreateAgentTask("t1", "Circle", &func1);
+  tm.CreateAgentTask("t2", "Circle", &func1);
+  tm.CreateAgentTask("t3", "Circle", &func1);
+  tm.CreateAgentTask("t4", "Circle", &func1);
+  tm.AddDependency("t2", "t1");
+  tm.GetTask("t1").set_priority(2.0);
+  tm.GetTask("t2").set_priority(1.0);
+  tm.GetTask("t3").set_priority(1.0);
+  tm.GetTask("t4").set_priority(3.0);
+  tm.Finalise();
+
+  exe::TaskManager::TaskId t1 = tm.get_id("t1");  // test-only routine
+  exe::TaskManager::TaskId t2 = tm.get_id("t2");  // test-only routine
+  exe::TaskManager::TaskId t3 = tm.get_id("t3");  // test-only routine
+  exe::TaskManager::TaskId t4 = tm.get_id("t4");  // test-only routine
+
+  // ready tasks are popped highest priority first
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t4);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t1);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t3);
+  BOOST_CHECK_EQUAL(tm.GetTaskCost(t1), -1.0);
+
+  // run times are summed over an iteration
+  tm.RecordTaskDuration(t1, 1.0);
+  tm.RecordTaskDuration(t3, 1.0);
+  tm.RecordTaskDuration(t3, 1.0);
+  tm.RecordTaskDuration(t4, 0.5);
+  tm.IterTaskDone(t1);
+  tm.IterTaskDone(t3);
+  tm.IterTaskDone(t4);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t2);
+  tm.RecordTaskDuration(t2, 4.0);
+  tm.IterTaskDone(t2);
+  BOOST_CHECK(tm.IterCompleted());
+
+  // priorities become critical path lengths of measured run times
+  tm.IterReset();
+  BOOST_CHECK_CLOSE(tm.GetTaskCost(t3), 2.0, 0.0001);
+  BOOST_CHECK_CLOSE(tm.GetTask(t1).get_priority(), 5.0, 0.0001);
+  BOOST_CHECK_CLOSE(tm.GetTask(t2).get_priority(), 4.0, 0.0001);
+  BOOST_CHECK_CLOSE(tm.GetTask(t3).get_priority(), 2.0, 0.0001);
+  BOOST_CHECK_CLOSE(tm.GetTask(t4).get_priority(), 0.5, 0.0001);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t1);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t3);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t4);
+
+  // later run times are blended with earlier ones
+  tm.RecordTaskDuration(t4, 1.5);
+  tm.IterTaskDone(t1);
+  tm.IterTaskDone(t3);
+  tm.IterTaskDone(t4);
+  tm.IterTaskDone(tm.IterTaskPop());
+  tm.IterReset();
+  BOOST_CHECK_CLOSE(tm.GetTaskCost(t4), 1.0, 0.0001);
+  BOOST_CHECK_CLOSE(tm.GetTaskCost(t1), 1.0, 0.0001);
+
+  // reset
+  tm.Reset();
+}
+
+BOOST_AUTO_TEST_CASE(test_range_dependencies) {
+  exe::TaskManager& tm = exe::TaskManager::GetInstance();
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mgr.RegisterAgent("Square");
+  tm.CreateAgentTask("t1", "Circle", &func1);
+  tm.CreateAgentTask("t2", "Circle", &func1);
+  tm.CreateAgentTask("t3", "Circle", &func1);
+  tm.CreateAgentTask("t4", "Square", &func1);
+  tm.CreateMemoryTask("m1", "Circle", exe::MemoryTask::OP_SWAP);
+
+  // only between agent tasks of the same agent, and one per task
+  BOOST_CHECK_THROW(tm.AddRangeDependency("t4", "t1"),
+                    flame::exceptions::invalid_argument);
+  BOOST_CHECK_THROW(tm.AddRangeDependency("m1", "t1"),
+                    flame::exceptions::invalid_argument);
+  tm.AddRangeDependency("t2", "t1");
+  BOOST_CHECK_THROW(tm.AddRangeDependency("t2", "t3"),
+                    flame::exceptions::logic_error);
+  tm.AddRangeDependency("t3", "t2");
+  tm.AddDependency("t3", "t4");
+
+  exe::TaskManager::TaskId t1 = tm.get_id("t1");  // test-only routine
+  exe::TaskManager::TaskId t2 = tm.get_id("t2");  // test-only routine
+  exe::TaskManager::TaskId t3 = tm.get_id("t3");  // test-only routine
+  exe::TaskManager::TaskId t4 = tm.get_id("t4");  // test-only routine
+  exe::TaskManager::TaskId m1 = tm.get_id("m1");  // test-only routine
+  exe::TaskManager::TaskId dep;
+  BOOST_CHECK(tm.GetRangeDependency(t2, &dep));
+  BOOST_CHECK_EQUAL(dep, t1);
+  BOOST_CHECK(!tm.GetRangeDependency(t1, &dep));
+  BOOST_CHECK_EQUAL(tm.GetDependencies(t2).count(t1), (size_t)1);
+  tm.Finalise();
+
+  // pop t1, t4 and m1
+  for (int i = 0; i < 3; ++i) tm.IterTaskPop();
+  BOOST_CHECK(!tm.IterTaskAvailable());
+
+  // t2 is ready once t1 is released to a queue
+  tm.IterReleaseRangeDependents(t1);
+  BOOST_CHECK_EQUAL(tm.IterGetReadyCount(), (size_t)1);
+  BOOST_CHECK_EQUAL(tm.IterGetPendingCount(), (size_t)1);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t2);
+
+  // t3 also waits for t4
+  tm.IterReleaseRangeDependents(t2);
+  BOOST_CHECK(!tm.IterTaskAvailable());
+  tm.IterTaskDone(t4);
+  BOOST_CHECK_EQUAL(tm.IterGetReadyCount(), (size_t)1);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t3);
+
+  // completing range dependencies does not make tasks ready again
+  tm.IterTaskDone(t3);
+  tm.IterTaskDone(t2);
+  tm.IterTaskDone(t1);
+  tm.IterTaskDone(m1);
+  BOOST_CHECK(!tm.IterTaskAvailable());
+  BOOST_CHECK(tm.IterCompleted());
+
+  // without a release, range dependencies are ordinary dependencies
+  tm.IterReset();
+  for (int i = 0; i < 3; ++i) tm.IterTaskPop();
+  BOOST_CHECK(!tm.IterTaskAvailable());
+  tm.IterTaskDone(t1);
+  BOOST_CHECK_EQUAL(tm.IterTaskPop(), t2);
+
+  // reset
+  tm.Reset();
+}
+
 BOOST_AUTO_TEST_CASE(reset_memory_manager) {
   mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
   mgr.Reset();  // reset again so as not to affect next test suite
@@ -26,6 +26,14 @@ FLAME_AGENT_FUNCTION(dummy_func) {
   return FLAME_AGENT_ALIVE;
 }
 
+// Agents with x >= 75 take far longer than the others
+FLAME_AGENT_FUNCTION(costly_func) {
+  volatile double sum = 0.0;
+  int steps = (FLAME.GetMem<int>("x") >= 75) ? 200000 : 0;
+  for (int i = 0; i < steps; ++i) sum += i * 0.5;
+  return FLAME_AGENT_ALIVE;
+}
+
 BOOST_AUTO_TEST_CASE(exe_test_task_split) {
   // Setup Agent Memory
   mem::MemoryManager& mgr_mem = mem::MemoryManager::GetInstance();
@@ -187,6 +195,89 @@ BOOST_AUTO_TEST_CASE(exe_test_task_split) {
 
   BOOST_CHECK_THROW(ts->GetTask(), e::flame_exception);  // no more
 
+
+  // Splitting into the ranges of another split task
+  exe::Task &t2 = mgr_task.CreateAgentTask("t2", "Circle", dummy_func);
+  ts = t1.SplitTask(3, 20);
+  exe::TaskSplitterHandle ts2 = t2.SplitTaskAs(*ts);
+  BOOST_REQUIRE(ts2);
+  BOOST_CHECK(ts2->IsGated());
+  BOOST_CHECK(!ts->IsGated());
+  BOOST_CHECK_EQUAL(ts2->GetNumTasks(), (size_t)3);
+  exe::Task& task1z = ts->GetTask();
+  BOOST_CHECK(!task1z.SplitTaskAs(*ts));  // subtasks are not split again
+  // ranges have to cover the whole population
+  BOOST_CHECK(!t2.SplitTaskAs(*task1z.SplitTask(2, 1)));
+
+  // gated subtasks are returned in the order they are released
+  BOOST_CHECK_THROW(ts2->GetTask(), e::flame_exception);  // none released
+  ts2->Release(2);
+  ts2->Release(0);
+  exe::Task& task2y = ts2->GetTask();
+  BOOST_CHECK_EQUAL(task2y.get_task_id(), t2.get_task_id());
+  BOOST_CHECK_EQUAL(ts2->GetSubtaskIndex(task2y), (size_t)2);
+  miter = task2y.GetMemoryIterator();
+  BOOST_CHECK_EQUAL(miter->get_count(), (size_t)33);
+  BOOST_CHECK_EQUAL(miter->get_offset(), (size_t)67);
+  exe::Task& task0y = ts2->GetTask();
+  miter = task0y.GetMemoryIterator();
+  BOOST_CHECK_EQUAL(miter->get_count(), (size_t)34);
+  BOOST_CHECK_EQUAL(miter->get_offset(), (size_t)0);
+  BOOST_CHECK_THROW(ts2->GetTask(), e::flame_exception);  // none released
+  BOOST_CHECK_THROW(ts2->GetSubtaskIndex(t2), e::invalid_argument);
+
+  // completed subtasks are recorded
+  ts2->OneTaskAssigned();
+  BOOST_CHECK(!ts2->OneTaskDone(2));
+  BOOST_CHECK_EQUAL(ts2->GetDoneSubtasks().size(), (size_t)1);
+  BOOST_CHECK_EQUAL(ts2->GetDoneSubtasks()[0], (size_t)2);
+
+  // Guided splits hand out a quarter of the agents left each time
+  ts = t1.SplitTask(4, 5, exe::Task::SPLIT_GUIDED);
+  BOOST_REQUIRE(ts);
+  const size_t guided[] = {25, 19, 14, 11, 8, 6, 5, 5, 7};
+  BOOST_REQUIRE_EQUAL(ts->GetNumTasks(), (size_t)9);
+  size_t offset = 0;
+  for (size_t i = 0; i < ts->GetNumTasks(); ++i) {
+    miter = ts->GetTask().GetMemoryIterator();
+    BOOST_CHECK_EQUAL(miter->get_offset(), offset);
+    BOOST_CHECK_EQUAL(miter->get_count(), guided[i]);
+    offset += miter->get_count();
+  }
+  BOOST_CHECK(!t1.SplitTask(4, 60, exe::Task::SPLIT_GUIDED));
+
+  // Balanced splits split evenly until run times are known
+  exe::Task &t3 = mgr_task.CreateAgentTask("t3", "Circle", costly_func);
+  t3.AllowAccess("x");
+  ts = t3.SplitTask(4, 5, exe::Task::SPLIT_BALANCED);
+  BOOST_REQUIRE_EQUAL(ts->GetNumTasks(), (size_t)4);
+  for (size_t i = 0; i < ts->GetNumTasks(); ++i) {
+    exe::Task& subtask = ts->GetTask();
+    BOOST_CHECK_EQUAL(subtask.GetMemoryIterator()->get_count(), (size_t)25);
+    subtask.Run();
+  }
+
+  // then give the costly agents ranges of their own
+  ts = t3.SplitTask(4, 5, exe::Task::SPLIT_BALANCED);
+  BOOST_REQUIRE_EQUAL(ts->GetNumTasks(), (size_t)4);
+  std::vector<size_t> counts;
+  offset = 0;
+  for (size_t i = 0; i < ts->GetNumTasks(); ++i) {
+    miter = ts->GetTask().GetMemoryIterator();
+    BOOST_CHECK_EQUAL(miter->get_offset(), offset);
+    BOOST_CHECK(miter->get_count() >= (size_t)5);
+    counts.push_back(miter->get_count());
+    offset += miter->get_count();
+  }
+  BOOST_CHECK_EQUAL(offset, (size_t)POPULATION_SIZE);
+  BOOST_CHECK(counts[0] > (size_t)50);
+  BOOST_CHECK(counts[3] < (size_t)25);
+
+  // times of the last split are forgotten once split again
+  ts = t3.SplitTask(4, 5, exe::Task::SPLIT_BALANCED);
+  BOOST_CHECK_EQUAL(ts->GetTask().GetMemoryIterator()->get_count(),
+                    (size_t)25);
+
   mgr_mem.Reset();
   mgr_task.Reset();
 }
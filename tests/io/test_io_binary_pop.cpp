@@ -0,0 +1,159 @@
+/*!
+ * \file tests/io/test_io_binary_pop.cpp
+ * \author Simon Coakley
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Test suite for binary population files and mapped input
+ */
+#define BOOST_TEST_DYN_LINK
+#ifdef STAND_ALONE
+#   define BOOST_TEST_MODULE IO Binary Pop
+#endif
+#include <boost/test/unit_test.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include "flame2/io/io_manager.hpp"
+#include "flame2/io/io_binary_pop.hpp"
+#include "flame2/io/mapped_file.hpp"
+#include "flame2/mem/memory_manager.hpp"
+
+namespace io = flame::io;
+namespace model = flame::model;
+namespace e = flame::exceptions;
+
+BOOST_AUTO_TEST_SUITE(IOBinaryPop)
+
+//! Returns the contents of a file
+static std::string readFile(const std::string& file_name) {
+  std::string data;
+  char buffer[256];
+  size_t n;
+  FILE * in = fopen(file_name.c_str(), "rb");
+  if (in == 0) return data;
+  while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    data.append(buffer, n);
+  fclose(in);
+  return data;
+}
+
+//! Writes the contents of a file
+static void writeFile(const std::string& file_name, const std::string& data) {
+  FILE * out = fopen(file_name.c_str(), "wb");
+  BOOST_REQUIRE(out != 0);
+  fwrite(data.data(), 1, data.size(), out);
+  fclose(out);
+}
+
+BOOST_AUTO_TEST_CASE(test_mapped_file) {
+  std::string file_name = "io/models/mapped.txt";
+  std::string text = "mapped file contents";
+  writeFile(file_name, text);
+
+  /* Mapped and buffered views hold the same contents */
+  io::MappedFile mapped(file_name);
+  BOOST_CHECK(mapped.is_mapped());
+  BOOST_REQUIRE_EQUAL(mapped.size(), text.size());
+  BOOST_CHECK(memcmp(mapped.data(), text.data(), text.size()) == 0);
+  io::MappedFile buffered(file_name, false);
+  BOOST_CHECK(!buffered.is_mapped());
+  BOOST_REQUIRE_EQUAL(buffered.size(), text.size());
+  BOOST_CHECK(memcmp(buffered.data(), text.data(), text.size()) == 0);
+
+  /* Empty files have no contents */
+  writeFile(file_name, "");
+  io::MappedFile empty(file_name);
+  BOOST_CHECK_EQUAL(empty.size(), (size_t)0);
+  BOOST_CHECK(empty.data() == NULL);
+
+  remove(file_name.c_str());
+  BOOST_CHECK_THROW(io::MappedFile missing(file_name), e::inaccessable_file);
+}
+
+BOOST_AUTO_TEST_CASE(test_binary_pop_mapped_and_buffered) {
+  io::IOManager& iomanager = io::IOManager::GetInstance();
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+  model::XModel model;
+  std::string dir = "io/models/array_data_its/";
+  std::string onebin = dir + "1.bin";
+  std::string corrupt = dir + "corrupt.bin";
+
+  iomanager.loadModel("io/models/array_data.xml", &model);
+  BOOST_REQUIRE_EQUAL(model.validate(), 0);
+  model.registerWithMemoryManager();
+  iomanager.readPop(dir + "0.xml", &model, io::IOManager::xml);
+  std::vector<double> pos =
+      *memoryManager.GetVector<double>("agent_a", "pos");
+  std::vector<double> ptsv =
+      *memoryManager.GetVector<double>("agent_a", "pts.v");
+
+  io::binary::IOBinaryPop writer;
+  writer.setPopPath(dir + "0.xml");
+  writer.setIteration(1);
+  writer.finaliseData();
+  std::string data = readFile(onebin);
+  BOOST_REQUIRE(data.size() > 256);
+
+  /* Header corruptions, each rejected before agent memory is touched */
+  std::vector<std::string> files;
+  std::vector<bool> bad_format;
+  files.push_back(data.substr(0, 256));  // truncated columns
+  bad_format.push_back(false);
+  files.push_back(data.substr(0, 20));  // truncated header prefix
+  bad_format.push_back(true);
+  std::string header = data;
+  boost::uint64_t header_size = data.size() + 1;
+  memcpy(&header[16], &header_size, sizeof(header_size));
+  files.push_back(header);  // header larger than the file
+  bad_format.push_back(false);
+  header = data;
+  header[0] = 'X';
+  files.push_back(header);  // not a binary pop file
+  bad_format.push_back(true);
+  header = data;
+  boost::uint32_t version = 99;
+  memcpy(&header[12], &version, sizeof(version));
+  files.push_back(header);  // unknown version
+  bad_format.push_back(true);
+
+  for (int mapped = 1; mapped >= 0; --mapped) {
+    io::binary::IOBinaryPop reader;
+    reader.setMappedInput(mapped == 1);
+
+    /* Round trip */
+    memoryManager.Reset();
+    model.registerWithMemoryManager();
+    BOOST_CHECK_NO_THROW(reader.readPop(onebin));
+    std::vector<double>* rpos =
+        memoryManager.GetVector<double>("agent_a", "pos");
+    BOOST_CHECK_EQUAL_COLLECTIONS(pos.begin(), pos.end(),
+        rpos->begin(), rpos->end());
+    std::vector<double>* rptsv =
+        memoryManager.GetVector<double>("agent_a", "pts.v");
+    BOOST_CHECK_EQUAL_COLLECTIONS(ptsv.begin(), ptsv.end(),
+        rptsv->begin(), rptsv->end());
+
+    for (size_t ii = 0; ii < files.size(); ++ii) {
+      memoryManager.Reset();
+      model.registerWithMemoryManager();
+      writeFile(corrupt, files[ii]);
+      if (bad_format[ii])
+        BOOST_CHECK_THROW(reader.readPop(corrupt), e::invalid_pop_file);
+      else
+        BOOST_CHECK_THROW(reader.readPop(corrupt), e::unparseable_file);
+      BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+          "agent_a", "pos")->size(), (size_t)0);
+    }
+  }
+
+  remove(onebin.c_str());
+  remove(corrupt.c_str());
+  memoryManager.Reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
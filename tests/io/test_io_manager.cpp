@@ -11,10 +11,15 @@
 #ifdef STAND_ALONE
 #   define BOOST_TEST_MODULE IO Model
 #endif
+#include <libxml/parser.h>
+#include <libxml/tree.h>
 #include <boost/test/unit_test.hpp>
+#include <boost/cstdint.hpp>
+#include <set>
 #include <vector>
 #include <string>
 #include <cstdio>
+#include <cstring>
 #include "flame2/io/io_manager.hpp"
 #include "flame2/mem/memory_manager.hpp"
 
@@ -187,6 +192,66 @@ BOOST_AUTO_TEST_CASE(test_writePop_model) {
   memoryManager.Reset();
 }
 
+BOOST_AUTO_TEST_CASE(test_writePop_async) {
+  flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+  model::XModel model;
+  std::string zeroxml = "io/models/all_data_its/0.xml";
+
+  // Read model
+  iomanager.loadModel("io/models/all_data.xml", &model);
+  model.registerWithMemoryManager();
+  // Read pop
+  iomanager.readPop(zeroxml, &model, io::IOManager::xml);
+
+  BOOST_CHECK_THROW(iomanager.setAsynchronousOutput(true, 0),
+      flame::exceptions::invalid_argument);
+  iomanager.setAsynchronousOutput(true);
+
+  /* Write pop data in the background */
+  std::string onexml = "io/models/all_data_its/1.xml";
+  iomanager.setIteration(1);
+  BOOST_CHECK_NO_THROW(iomanager.finaliseData());
+  /* Snapshot must not depend on agent memory */
+  memoryManager.Reset();
+  BOOST_CHECK_NO_THROW(iomanager.flushOutput());
+  iomanager.setAsynchronousOutput(false);
+
+  /* Check 0.xml and 1.xml are identical */
+  size_t differences = 1;
+  int c0, c1;
+  FILE *zeroFile, *oneFile;
+  zeroFile = fopen(zeroxml.c_str(), "r");
+  oneFile  = fopen(onexml.c_str(), "r");
+  if (zeroFile == 0) {
+    fprintf(stderr, "Warning: Could not open the file: %s\n",
+        zeroxml.c_str());
+  } else if (oneFile == 0) {
+    fprintf(stderr, "Warning: Could not open the file: %s\n",
+        onexml.c_str());
+  } else {
+    differences = 0;
+    c0 = fgetc(zeroFile);
+    c1 = fgetc(oneFile);
+    /* While at least one file is not at the end */
+    while (c0 != EOF || c1 != EOF) {
+      if (c0 != c1) differences++;
+      if (c0 != EOF) c0 = fgetc(zeroFile);
+      if (c1 != EOF) c1 = fgetc(oneFile);
+    }
+  }
+  /* Close files */
+  if (zeroFile) fclose(zeroFile);
+  if (oneFile) fclose(oneFile);
+  BOOST_CHECK(differences == 0);
+
+  /* Remove created 1.xml */
+  if (remove(onexml.c_str()) != 0)
+    fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
+        onexml.c_str());
+}
+
 BOOST_AUTO_TEST_CASE(test_writePop_1_agent_var) {
   flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
   flame::mem::MemoryManager& memoryManager =
@@ -199,28 +264,396 @@ BOOST_AUTO_TEST_CASE(test_writePop_1_agent_var) {
   model.registerWithMemoryManager();
   // Read pop
   iomanager.readPop(zeroxml, &model, io::IOManager::xml);
-  /*
-    BOOST_CHECK_THROW(iomanager.writePop("na", "int_single"),
-            std::runtime_error);
+  BOOST_CHECK_THROW(iomanager.writePop("na", "int_single"),
+      std::runtime_error);
+  BOOST_CHECK_THROW(iomanager.writePop("agent_a", "na"), std::runtime_error);
 
-    BOOST_CHECK_THROW(iomanager.writePop("agent_a", "na"), std::runtime_error);
-   */
+  /* Columns copied by output tasks are written by finaliseData */
+  std::string onexml = "io/models/all_data_its/1.xml";
+  iomanager.setIteration(1);
   BOOST_CHECK_NO_THROW(iomanager.writePop("agent_a", "int_single"));
+  std::vector<int>* ints =
+      memoryManager.GetVector<int>("agent_a", "int_single");
+  std::vector<int> copied = *ints;
+  /* Later changes to an output variable are not written */
+  for (size_t ii = 0; ii < ints->size(); ++ii) (*ints)[ii] += 1;
+  BOOST_CHECK_NO_THROW(iomanager.finaliseData());
+
+  memoryManager.Reset();
+  model.registerWithMemoryManager();
+  iomanager.readPop(onexml, &model, io::IOManager::xml);
+  ints = memoryManager.GetVector<int>("agent_a", "int_single");
+  BOOST_CHECK_EQUAL_COLLECTIONS(copied.begin(), copied.end(),
+      ints->begin(), ints->end());
+  remove(onexml.c_str());
 
-  // Check contents of 0_agent_a_int_single.xml
-  /*FILE *file;
-    zeroFile = fopen(zeroxml.c_str(), "r");
-    if (file == 0)
-            fprintf(stderr, "Warning: Could not open the file: %s\n",
-                    zeroxml.c_str());
-
-    // Remove created 0_agent_a_int_single.xml
-    if (remove("0_agent_a_int_single.xml") != 0)
-        fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
-                "0_agent_a_int_single.xml");
-   */
   /* Reset memory manager as to not affect next test suite */
   memoryManager.Reset();
 }
 
+/* Test round trip of populations through the binary format */
+//! Returns the position of the file offset of the first column in the
+//! header of a binary pop file and the element size of the column
+static size_t firstColumnOffset(const std::string& data,
+    boost::uint64_t * element_size) {
+  boost::uint64_t length;
+  /* Prefix, iteration, flags and agent count */
+  size_t pos = 48;
+  /* Agent name, population size and variable count */
+  memcpy(&length, &data[pos], sizeof(length));
+  pos += sizeof(length) + static_cast<size_t>(length) + 16;
+  /* Variable and type names */
+  for (int ii = 0; ii < 2; ++ii) {
+    memcpy(&length, &data[pos], sizeof(length));
+    pos += sizeof(length) + static_cast<size_t>(length);
+  }
+  /* Stride and element size */
+  memcpy(element_size, &data[pos + 8], sizeof(*element_size));
+  return pos + 16;
+}
+
+BOOST_AUTO_TEST_CASE(test_readPop_binary) {
+  flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+  model::XModel model;
+  std::string zeroxml = "io/models/array_data_its/0.xml";
+  std::string onebin = "io/models/array_data_its/1.bin";
+  std::string twobin = "io/models/array_data_its/2.bin";
+  std::string truncated = "io/models/array_data_its/truncated.bin";
+
+  iomanager.loadModel("io/models/array_data.xml", &model);
+  BOOST_REQUIRE_EQUAL(model.validate(), 0);
+  model.registerWithMemoryManager();
+  iomanager.readPop(zeroxml, &model, io::IOManager::xml);
+  std::vector<double> pos =
+      *memoryManager.GetVector<double>("agent_a", "pos");
+  std::vector<int> ptsid =
+      *memoryManager.GetVector<int>("agent_a", "pts.id");
+  std::vector<double> ptsv =
+      *memoryManager.GetVector<double>("agent_a", "pts.v");
+
+  /* Write binary pop straight from agent memory */
+  iomanager.setOutputType(io::IOManager::binary);
+  iomanager.setIteration(1);
+  BOOST_CHECK_NO_THROW(iomanager.finaliseData());
+  BOOST_CHECK_EQUAL(iomanager.getFileType(onebin), io::IOManager::binary);
+  BOOST_CHECK_EQUAL(iomanager.getFileType(zeroxml), io::IOManager::xml);
+
+  /* Write binary pop from a snapshot */
+  iomanager.setAsynchronousOutput(true);
+  iomanager.setIteration(2);
+  BOOST_CHECK_NO_THROW(iomanager.finaliseData());
+  iomanager.setAsynchronousOutput(false);
+  iomanager.setOutputType(io::IOManager::xml);
+
+  std::string files[] = {onebin, twobin};
+  for (size_t ii = 0; ii < 2; ++ii) {
+    memoryManager.Reset();
+    model.registerWithMemoryManager();
+    BOOST_CHECK_NO_THROW(iomanager.readPop(files[ii], &model,
+        io::IOManager::binary));
+    std::vector<double>* rpos =
+        memoryManager.GetVector<double>("agent_a", "pos");
+    BOOST_CHECK_EQUAL_COLLECTIONS(pos.begin(), pos.end(),
+        rpos->begin(), rpos->end());
+    std::vector<int>* rptsid =
+        memoryManager.GetVector<int>("agent_a", "pts.id");
+    BOOST_CHECK_EQUAL_COLLECTIONS(ptsid.begin(), ptsid.end(),
+        rptsid->begin(), rptsid->end());
+    std::vector<double>* rptsv =
+        memoryManager.GetVector<double>("agent_a", "pts.v");
+    BOOST_CHECK_EQUAL_COLLECTIONS(ptsv.begin(), ptsv.end(),
+        rptsv->begin(), rptsv->end());
+  }
+
+  /* Truncated file */
+  FILE *in = fopen(onebin.c_str(), "rb");
+  FILE *out = fopen(truncated.c_str(), "wb");
+  BOOST_REQUIRE(in != 0 && out != 0);
+  char buffer[256];
+  size_t n = fread(buffer, 1, sizeof(buffer), in);
+  fwrite(buffer, 1, n, out);
+  fclose(in);
+  fclose(out);
+  memoryManager.Reset();
+  model.registerWithMemoryManager();
+  BOOST_CHECK_THROW(iomanager.readPop(truncated, &model,
+      io::IOManager::binary), e::unparseable_file);
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "pos")->size(), 0);
+
+  /* Column that is not aligned to its element size */
+  std::string misaligned = "io/models/array_data_its/misaligned.bin";
+  std::string data;
+  in = fopen(onebin.c_str(), "rb");
+  BOOST_REQUIRE(in != 0);
+  while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) data.append(buffer, n);
+  fclose(in);
+  boost::uint64_t element_size, offset;
+  size_t offset_pos = firstColumnOffset(data, &element_size);
+  BOOST_REQUIRE(element_size > 1);
+  memcpy(&offset, &data[offset_pos], sizeof(offset));
+  offset += element_size / 2;
+  memcpy(&data[offset_pos], &offset, sizeof(offset));
+  out = fopen(misaligned.c_str(), "wb");
+  BOOST_REQUIRE(out != 0);
+  fwrite(data.data(), 1, data.size(), out);
+  fclose(out);
+  BOOST_CHECK_THROW(iomanager.readPop(misaligned, &model,
+      io::IOManager::binary), e::unparseable_file);
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "pos")->size(), 0);
+  remove(misaligned.c_str());
+
+  /* Variables that do not match agent memory */
+  memoryManager.Reset();
+  model::XModel other;
+  iomanager.loadModel("io/models/all_data.xml", &other);
+  other.registerWithMemoryManager();
+  BOOST_CHECK_THROW(iomanager.readPop(onebin, &other,
+      io::IOManager::binary), e::invalid_pop_file);
+  BOOST_CHECK_THROW(iomanager.readPop(zeroxml, &other,
+      io::IOManager::binary), e::invalid_pop_file);
+
+  remove(onebin.c_str());
+  remove(twobin.c_str());
+  remove(truncated.c_str());
+  memoryManager.Reset();
+}
+
+//! Returns the names of the variables of the first agent in a pop file
+static std::set<std::string> firstAgentVars(std::string const& file) {
+  std::set<std::string> vars;
+  xmlDocPtr doc = xmlReadFile(file.c_str(), NULL, 0);
+  if (doc == NULL) return vars;
+  xmlNodePtr node;
+  for (node = xmlDocGetRootElement(doc)->children; node; node = node->next)
+    if (node->type == XML_ELEMENT_NODE &&
+        xmlStrEqual(node->name, BAD_CAST "xagent")) break;
+  if (node != NULL)
+    for (node = node->children; node; node = node->next)
+      if (node->type == XML_ELEMENT_NODE)
+        vars.insert(reinterpret_cast<const char*>(node->name));
+  xmlFreeDoc(doc);
+  return vars;
+}
+
+BOOST_AUTO_TEST_CASE(test_writePop_frequency_compression_delta) {
+  flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+  model::XModel model;
+  std::string dir = "io/models/array_data_its/";
+
+  iomanager.loadModel("io/models/array_data.xml", &model);
+  BOOST_REQUIRE_EQUAL(model.validate(), 0);
+  model.registerWithMemoryManager();
+  iomanager.readPop(dir + "0.xml", &model, io::IOManager::xml);
+  std::vector<double> pos =
+      *memoryManager.GetVector<double>("agent_a", "pos");
+
+  io::WrittenVariables written;
+  written["agent_a"].insert("loc");
+  iomanager.setWrittenVariables(written);
+  iomanager.setDeltaOutput(true);
+  BOOST_CHECK_THROW(iomanager.setOutputFrequency(0), e::flame_io_exception);
+  BOOST_CHECK_THROW(iomanager.setOutputCompression(10),
+      e::flame_io_exception);
+  iomanager.setOutputFrequency(2);
+  iomanager.setOutputCompression(6);
+
+  /* Only every second iteration is written */
+  iomanager.setIteration(1);
+  iomanager.finaliseData();
+  FILE * f = fopen((dir + "1.xml.gz").c_str(), "rb");
+  BOOST_CHECK(f == NULL);
+  if (f) fclose(f);
+
+  /* The first output holds the whole population */
+  iomanager.setIteration(2);
+  iomanager.finaliseData();
+  f = fopen((dir + "2.xml.gz").c_str(), "rb");
+  BOOST_REQUIRE(f != NULL);
+  unsigned char magic[2] = {0, 0};
+  BOOST_CHECK_EQUAL(fread(magic, 1, 2, f), (size_t)2);
+  fclose(f);
+  if (xmlHasFeature(XML_WITH_ZLIB)) {
+    BOOST_CHECK_EQUAL(magic[0], 0x1f);
+    BOOST_CHECK_EQUAL(magic[1], 0x8b);
+  }
+  BOOST_CHECK_EQUAL(firstAgentVars(dir + "2.xml.gz").count("pos"), 1);
+
+  /* Later outputs only hold written variables */
+  iomanager.setAsynchronousOutput(true);
+  iomanager.setIteration(4);
+  iomanager.finaliseData();
+  iomanager.setAsynchronousOutput(false);
+  std::set<std::string> vars = firstAgentVars(dir + "4.xml.gz");
+  BOOST_CHECK_EQUAL(vars.count("name"), 1);
+  BOOST_CHECK_EQUAL(vars.count("loc"), 1);
+  BOOST_CHECK_EQUAL(vars.count("pos"), 0);
+
+  /* Delta output cannot be restarted from, in either format */
+  BOOST_CHECK_THROW(iomanager.readPop(dir + "4.xml.gz", &model,
+      io::IOManager::xml), e::invalid_pop_file);
+  iomanager.setOutputType(io::IOManager::binary);
+  iomanager.setIteration(6);
+  iomanager.finaliseData();
+  iomanager.setOutputType(io::IOManager::xml);
+  BOOST_CHECK_THROW(iomanager.readPop(dir + "6.bin", &model,
+      io::IOManager::binary), e::invalid_pop_file);
+  BOOST_CHECK_EQUAL(memoryManager.GetVector<double>("agent_a", "pos")->size(),
+      pos.size());
+
+  /* Compressed output is read back */
+  iomanager.setDeltaOutput(false);
+  iomanager.setOutputFrequency(1);
+  iomanager.setOutputCompression(0);
+  iomanager.setWrittenVariables(io::WrittenVariables());
+  memoryManager.Reset();
+  model.registerWithMemoryManager();
+  BOOST_CHECK_NO_THROW(iomanager.readPop(dir + "2.xml.gz", &model,
+      io::IOManager::xml));
+  std::vector<double>* rpos =
+      memoryManager.GetVector<double>("agent_a", "pos");
+  BOOST_CHECK_EQUAL_COLLECTIONS(pos.begin(), pos.end(),
+      rpos->begin(), rpos->end());
+
+  remove((dir + "2.xml.gz").c_str());
+  remove((dir + "4.xml.gz").c_str());
+  remove((dir + "6.bin").c_str());
+  memoryManager.Reset();
+}
+
+//! Output backend that records what it was asked to write
+class RecordingBackend : public io::OutputBackend {
+  public:
+    RecordingBackend() : iteration_(0), direct_(0) {}
+    void setIteration(size_t i) { iteration_ = i; }
+    std::string outputFileName() { return "recorded"; }
+    void finaliseData() { ++direct_; }
+    void writeSnapshot(io::PopSnapshot * snapshot) {
+      iterations_.push_back(snapshot->get_iteration());
+    }
+    size_t iteration_;
+    size_t direct_;
+    std::vector<size_t> iterations_;
+};
+
+BOOST_AUTO_TEST_CASE(test_writePop_timeseries) {
+  flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+  model::XModel model;
+  std::string dir = "io/models/array_data_its/";
+
+  iomanager.loadModel("io/models/array_data.xml", &model);
+  BOOST_REQUIRE_EQUAL(model.validate(), 0);
+  model.registerWithMemoryManager();
+  iomanager.readPop(dir + "0.xml", &model, io::IOManager::xml);
+  std::vector<double>* pos = memoryManager.GetVector<double>("agent_a", "pos");
+
+  /* Write two iterations, the second one from a snapshot */
+  iomanager.setOutputType(io::IOManager::timeseries);
+  iomanager.setIteration(1);
+  iomanager.finaliseData();
+  for (size_t ii = 0; ii < pos->size(); ++ii) (*pos)[ii] *= 2.0;
+  iomanager.setAsynchronousOutput(true);
+  iomanager.setIteration(2);
+  iomanager.finaliseData();
+  iomanager.setAsynchronousOutput(false);
+  iomanager.setOutputType(io::IOManager::xml);
+
+  /* One variable is read across all iterations */
+  io::timeseries::TimeSeriesReader reader(dir + "agent_a.pos.ts");
+  BOOST_CHECK_EQUAL(reader.get_type_name(), "double");
+  BOOST_CHECK_EQUAL(reader.get_stride(), (size_t)3);
+  size_t iteration, first;
+  std::vector<double> values;
+  BOOST_REQUIRE(reader.nextChunk(&iteration, &first, &values));
+  BOOST_CHECK_EQUAL(iteration, (size_t)1);
+  BOOST_CHECK_EQUAL(first, (size_t)0);
+  BOOST_REQUIRE_EQUAL(values.size(), pos->size());
+  BOOST_CHECK_CLOSE(values[0] * 2.0, (*pos)[0], 0.0001);
+  BOOST_REQUIRE(reader.nextChunk(&iteration, &first, &values));
+  BOOST_CHECK_EQUAL(iteration, (size_t)2);
+  BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+      pos->begin(), pos->end());
+  BOOST_CHECK(!reader.nextChunk(&iteration, &first, &values));
+  std::vector<int> ints;
+  BOOST_CHECK_THROW(reader.nextChunk(&iteration, &first, &ints),
+      e::flame_io_exception);
+  BOOST_CHECK_THROW(io::timeseries::TimeSeriesReader(dir + "0.xml"),
+      e::unparseable_file);
+
+  /* Custom backends replace the output type */
+  RecordingBackend backend;
+  iomanager.setOutputBackend(&backend);
+  BOOST_CHECK_EQUAL(backend.iteration_, (size_t)2);
+  iomanager.setIteration(3);
+  iomanager.finaliseData();
+  iomanager.setAsynchronousOutput(true);
+  iomanager.setIteration(4);
+  iomanager.finaliseData();
+  iomanager.setAsynchronousOutput(false);
+  iomanager.setOutputBackend(0);
+  BOOST_CHECK_EQUAL(backend.direct_, (size_t)1);
+  BOOST_REQUIRE_EQUAL(backend.iterations_.size(), (size_t)1);
+  BOOST_CHECK_EQUAL(backend.iterations_[0], (size_t)4);
+
+  const std::vector<std::string>& var_names =
+      memoryManager.GetVarNames("agent_a");
+  for (size_t ii = 0; ii < var_names.size(); ++ii)
+    remove((dir + "agent_a." + var_names[ii] + ".ts").c_str());
+  memoryManager.Reset();
+}
+
+BOOST_AUTO_TEST_CASE(test_writePop_timeseries_alongside) {
+  flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+  model::XModel model;
+  std::string dir = "io/models/array_data_its/";
+
+  iomanager.loadModel("io/models/array_data.xml", &model);
+  BOOST_REQUIRE_EQUAL(model.validate(), 0);
+  model.registerWithMemoryManager();
+  iomanager.readPop(dir + "0.xml", &model, io::IOManager::xml);
+
+  /* Time series are written in addition to the population file, both
+   * straight from memory and from snapshots */
+  iomanager.setTimeSeriesOutput(true);
+  iomanager.setIteration(1);
+  iomanager.finaliseData();
+  iomanager.setAsynchronousOutput(true);
+  iomanager.setIteration(2);
+  iomanager.finaliseData();
+  iomanager.setAsynchronousOutput(false);
+  iomanager.setTimeSeriesOutput(false);
+
+  io::timeseries::TimeSeriesReader reader(dir + "agent_a.pos.ts");
+  size_t iteration, first;
+  std::vector<double> values;
+  BOOST_CHECK(reader.nextChunk(&iteration, &first, &values));
+  BOOST_CHECK_EQUAL(iteration, (size_t)1);
+  BOOST_CHECK(reader.nextChunk(&iteration, &first, &values));
+  BOOST_CHECK_EQUAL(iteration, (size_t)2);
+
+  /* The population file can be restarted from */
+  memoryManager.Reset();
+  model.registerWithMemoryManager();
+  BOOST_CHECK_NO_THROW(iomanager.readPop(dir + "2.xml", &model,
+      io::IOManager::xml));
+  BOOST_CHECK(!memoryManager.GetVector<double>("agent_a", "pos")->empty());
+
+  const std::vector<std::string>& var_names =
+      memoryManager.GetVarNames("agent_a");
+  for (size_t ii = 0; ii < var_names.size(); ++ii)
+    remove((dir + "agent_a." + var_names[ii] + ".ts").c_str());
+  remove((dir + "1.xml").c_str());
+  remove((dir + "2.xml").c_str());
+  memoryManager.Reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -12,11 +12,17 @@
 #   define BOOST_TEST_MODULE IO Pop
 #endif
 #include <boost/test/unit_test.hpp>
+#include <libxml/xmlschemas.h>
+#include <boost/cstdint.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include <vector>
 #include <string>
 #include "flame2/io/io_manager.hpp"
 #include "flame2/io/io_xml_model.hpp"
 #include "flame2/io/io_xml_pop.hpp"
+#include "flame2/io/parallel_pop_reader.hpp"
 #include "flame2/mem/memory_manager.hpp"
 
 namespace xml = flame::io::xml;
@@ -68,10 +74,14 @@ BOOST_AUTO_TEST_CASE(test_data_schema) {
   BOOST_CHECK_NO_THROW(
       ioxmlpop.createDataSchema("io/models/all_data.xsd", &model));
 
-  /* Validate data using schema */
+  /* Check the generated data schema is a valid schema */
   std::string xsd = "io/models/all_data.xsd";
-  BOOST_CHECK_NO_THROW(
-      ioxmlpop.validateData("io/models/all_data_its/0.xml", xsd));
+  xmlSchemaParserCtxtPtr parser_ctxt = xmlSchemaNewParserCtxt(xsd.c_str());
+  BOOST_REQUIRE(parser_ctxt != NULL);
+  xmlSchemaPtr schema = xmlSchemaParse(parser_ctxt);
+  BOOST_CHECK(schema != NULL);
+  if (schema != NULL) xmlSchemaFree(schema);
+  xmlSchemaFreeParserCtxt(parser_ctxt);
   /* Remove created all_data.xsd */
   if (remove(xsd.c_str()) != 0)
     fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
@@ -180,4 +190,338 @@ BOOST_AUTO_TEST_CASE(test_read_XML_pop) {
   memoryManager.Reset();
 }
 
+/* Test pop files are validated against the data schema while read */
+BOOST_AUTO_TEST_CASE(test_read_validates_pop) {
+  xml::IOXMLPop ioxmlpop;
+  xml::IOXMLModel ioxmlmodel;
+  model::XModel model;
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+
+  ioxmlmodel.readXMLModel("io/models/all_data.xml", &model);
+  model.registerWithMemoryManager();
+
+  /* Agent is missing a variable required by the schema, the error is
+   * reported again when the cached schema is reused */
+  std::string errors[2];
+  for (size_t ii = 0; ii < 2; ++ii) {
+    try {
+      ioxmlpop.readPop("io/models/all_data_its/0_missing_variable.xml",
+          &model);
+    } catch(const e::flame_io_exception& E) {
+      errors[ii] = E.what();
+    }
+  }
+  BOOST_CHECK(!errors[0].empty());
+  BOOST_CHECK_EQUAL(errors[0], errors[1]);
+  /* The value read before the error is not kept */
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "int_single")->size(), (size_t)0);
+
+  /* A valid file that is not in the plain layout is read serially with
+   * the cached schema */
+  std::string commented = "io/models/all_data_its/0_commented.xml";
+  std::ifstream in("io/models/all_data_its/0.xml");
+  std::stringstream text;
+  text << in.rdbuf();
+  std::string content = text.str();
+  content.insert(content.find("<states>") + 8, "<!-- comment -->");
+  std::ofstream out(commented.c_str());
+  out << content;
+  out.close();
+  memoryManager.Reset();
+  model.registerWithMemoryManager();
+  BOOST_CHECK_NO_THROW(ioxmlpop.readPop(commented, &model));
+  BOOST_CHECK(memoryManager.GetVectorWrapper("agent_a", "int_single")->size()
+      > 0);
+
+  /* A file failing validation after some agents leaves agent memory as it
+   * was before reading */
+  std::string invalid = "io/models/all_data_its/0_invalid_last.xml";
+  content.replace(content.find("3333"), 4, "x");
+  out.open(invalid.c_str());
+  out << content;
+  out.close();
+  BOOST_CHECK_THROW(ioxmlpop.readPop(invalid, &model),
+      e::flame_io_exception);
+  const char * vars[] = {"int_single", "double_single"};
+  for (size_t ii = 0; ii < 2; ++ii) {
+    BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+        "agent_a", vars[ii])->size(), (size_t)3);
+    BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+        "agent_b", vars[ii])->size(), (size_t)3);
+  }
+  remove(invalid.c_str());
+  remove(commented.c_str());
+
+  memoryManager.Reset();
+}
+
+/* Test the key and hash the data schema is cached by */
+BOOST_AUTO_TEST_CASE(test_data_schema_hash) {
+  xml::IOXMLModel ioxmlmodel;
+  model::XModel model1, model2, model3;
+
+  ioxmlmodel.readXMLModel("io/models/all_data.xml", &model1);
+  ioxmlmodel.readXMLModel("io/models/all_data.xml", &model2);
+  ioxmlmodel.readXMLModel("io/models/array_data.xml", &model3);
+  BOOST_CHECK_EQUAL(xml::IOXMLPop::dataSchemaHash(&model1),
+      xml::IOXMLPop::dataSchemaHash(&model2));
+  BOOST_CHECK(xml::IOXMLPop::dataSchemaHash(&model1) !=
+      xml::IOXMLPop::dataSchemaHash(&model3));
+  BOOST_CHECK_EQUAL(xml::IOXMLPop::dataSchemaKey(&model1),
+      xml::IOXMLPop::dataSchemaKey(&model2));
+  BOOST_CHECK(xml::IOXMLPop::dataSchemaKey(&model1) !=
+      xml::IOXMLPop::dataSchemaKey(&model3));
+  BOOST_CHECK(xml::IOXMLPop::dataSchemaKey(&model3).find(
+      "agent agent_a\n") != std::string::npos);
+}
+
+/* Test reading of pop files split across threads */
+BOOST_AUTO_TEST_CASE(test_read_parallel) {
+  xml::IOXMLModel ioxmlmodel;
+  model::XModel model;
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+
+  ioxmlmodel.readXMLModel("io/models/all_data.xml", &model);
+  model.registerWithMemoryManager();
+  /* Split files into ranges as small as possible */
+  xml::ParallelPopReader reader(&model, 4, 1);
+
+  BOOST_CHECK(reader.readPop("io/models/all_data_its/0.xml"));
+  std::vector<int>* roi =
+      memoryManager.GetVector<int>("agent_a", "int_single");
+  int expectedi[] = {1, 2, 3};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expectedi, expectedi+3,
+      roi->begin(), roi->end());
+  std::vector<int>* rob =
+      memoryManager.GetVector<int>("agent_b", "int_single");
+  int expectedb[] = {1111, 2222, 3333};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expectedb, expectedb+3,
+      rob->begin(), rob->end());
+  std::vector<double>* rod =
+      memoryManager.GetVector<double>("agent_b", "double_single");
+  double expectedd[] = {11.11, 22.22, 33.33};
+  BOOST_REQUIRE_EQUAL(rod->size(), 3);
+  for (size_t ii = 0; ii < rod->size(); ++ii)
+    BOOST_CHECK_CLOSE((*rod)[ii], expectedd[ii], 0.0001);
+
+  /* Files that are left to the serial reader leave memory untouched */
+  memoryManager.Reset();
+  model.registerWithMemoryManager();
+  std::string serial[] = {"0_missing.xml", "0_malformed.xml",
+      "0_unknown_tag.xml", "0_unknown_agent.xml", "0_unknown_variable.xml",
+      "0_var_not_int.xml", "0_var_not_double.xml", "0_missing_variable.xml",
+      "0-output.xml"};
+  for (size_t ii = 0; ii < sizeof(serial) / sizeof(serial[0]); ++ii) {
+    BOOST_CHECK_MESSAGE(!reader.readPop(
+        std::string("io/models/all_data_its/") + serial[ii]), serial[ii]);
+    BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+        "agent_a", "int_single")->size(), 0);
+  }
+  memoryManager.Reset();
+
+  /* Static arrays and data types */
+  model::XModel arrays;
+  ioxmlmodel.readXMLModel("io/models/array_data.xml", &arrays);
+  BOOST_REQUIRE_EQUAL(arrays.validate(), 0);
+  arrays.registerWithMemoryManager();
+  xml::ParallelPopReader array_reader(&arrays, 4, 1);
+  BOOST_CHECK(array_reader.readPop("io/models/array_data_its/0.xml"));
+  std::vector<int>* ptsid =
+      memoryManager.GetVector<int>("agent_a", "pts.id");
+  int expectedptsid[] = {11, 12, 21, 22};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expectedptsid, expectedptsid+4,
+      ptsid->begin(), ptsid->end());
+  std::vector<double>* ptsv =
+      memoryManager.GetVector<double>("agent_a", "pts.v");
+  double expectedptsv[] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
+  BOOST_REQUIRE_EQUAL(ptsv->size(), 8);
+  for (size_t ii = 0; ii < ptsv->size(); ++ii)
+    BOOST_CHECK_CLOSE((*ptsv)[ii], expectedptsv[ii], 0.0001);
+
+  memoryManager.Reset();
+}
+
+BOOST_AUTO_TEST_CASE(test_read_write_arrays) {
+  unsigned int ii;
+  flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
+  model::XModel model;
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+
+  /* Read model xml */
+  iomanager.loadModel("io/models/array_data.xml", &model);
+  /* Validate model to process array sizes and data types */
+  BOOST_REQUIRE_EQUAL(model.validate(), 0);
+  /* Register agents with memory manager */
+  model.registerWithMemoryManager();
+
+  /* Static arrays and data type members are stored flat */
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "pos")->stride(), 3);
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "loc.id")->stride(), 1);
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "loc.v")->stride(), 2);
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "pts.id")->stride(), 2);
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "pts.v")->stride(), 4);
+
+  std::string zeroxml = "io/models/array_data_its/0.xml";
+  BOOST_CHECK_NO_THROW(iomanager.readPop(zeroxml, &model,
+      flame::io::IOManager::xml));
+  BOOST_CHECK_EQUAL(memoryManager.GetVectorWrapper(
+      "agent_a", "pts.v")->size(), 2);
+
+  /* Test pop data read in */
+  std::vector<double>* pos =
+      memoryManager.GetVector<double>("agent_a", "pos");
+  double expectedpos[] = {0.1, 0.2, 0.3, 1.1, 1.2, 1.3};
+  BOOST_CHECK_EQUAL(pos->size(), 6);
+  for (ii = 0; ii < pos->size(); ii++) {
+    BOOST_CHECK_CLOSE(*(pos->begin()+ii), *(expectedpos+ii), 0.0001);
+  }
+  std::vector<int>* ptsid =
+      memoryManager.GetVector<int>("agent_a", "pts.id");
+  int expectedptsid[] = {11, 12, 21, 22};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expectedptsid, expectedptsid+4,
+      ptsid->begin(), ptsid->end());
+  std::vector<double>* ptsv =
+      memoryManager.GetVector<double>("agent_a", "pts.v");
+  double expectedptsv[] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
+  BOOST_CHECK_EQUAL(ptsv->size(), 8);
+  for (ii = 0; ii < ptsv->size(); ii++) {
+    BOOST_CHECK_CLOSE(*(ptsv->begin()+ii), *(expectedptsv+ii), 0.0001);
+  }
+
+  /* Test pop data written out */
+  std::string onexml = "io/models/array_data_its/1.xml";
+  iomanager.setIteration(1);
+  iomanager.finaliseData();
+  /* Check 0.xml and 1.xml are identical */
+  size_t differences = 1;
+  int c0, c1;
+  FILE *zeroFile, *oneFile;
+  zeroFile = fopen(zeroxml.c_str(), "r");
+  oneFile  = fopen(onexml.c_str(), "r");
+  if (zeroFile == 0) {
+    fprintf(stderr, "Warning: Could not open the file: %s\n",
+        zeroxml.c_str());
+  } else if (oneFile == 0) {
+    fprintf(stderr, "Warning: Could not open the file: %s\n",
+        onexml.c_str());
+  } else {
+    differences = 0;
+    c0 = fgetc(zeroFile);
+    c1 = fgetc(oneFile);
+    /* While at least one file is not at the end */
+    while (c0 != EOF || c1 != EOF) {
+      if (c0 != c1) differences++;
+      if (c0 != EOF) c0 = fgetc(zeroFile);
+      if (c1 != EOF) c1 = fgetc(oneFile);
+    }
+  }
+  /* Close files */
+  if (zeroFile) fclose(zeroFile);
+  if (oneFile) fclose(oneFile);
+  BOOST_CHECK(differences == 0);
+
+  /* Remove created 1.xml */
+  if (remove(onexml.c_str()) != 0)
+    fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
+        onexml.c_str());
+
+  /* Reset memory manager as to not affect next test suite */
+  memoryManager.Reset();
+}
+
+BOOST_AUTO_TEST_CASE(test_read_write_types) {
+  flame::io::IOManager& iomanager = flame::io::IOManager::GetInstance();
+  xml::IOXMLPop ioxmlpop;
+  model::XModel model;
+  flame::mem::MemoryManager& memoryManager =
+      flame::mem::MemoryManager::GetInstance();
+
+  /* Read model xml */
+  iomanager.loadModel("io/models/types_data.xml", &model);
+  BOOST_REQUIRE_EQUAL(model.validate(), 0);
+  model.registerWithMemoryManager();
+
+  std::string zeroxml = "io/models/types_data_its/0.xml";
+  BOOST_CHECK_NO_THROW(iomanager.readPop(zeroxml, &model,
+      flame::io::IOManager::xml));
+
+  /* Test pop data read in */
+  std::vector<float>* f =
+      memoryManager.GetVector<float>("agent_a", "float_single");
+  float expectedf[] = {0.5, -1.5};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expectedf, expectedf+2, f->begin(), f->end());
+  std::vector<boost::int64_t>* l =
+      memoryManager.GetVector<boost::int64_t>("agent_a", "int64_single");
+  // 9000000000 does not fit a 32-bit long, build it from a 64-bit value
+  boost::int64_t nine_billion = static_cast<boost::int64_t>(9) * 1000000000;
+  boost::int64_t expectedl[] = {nine_billion, -nine_billion};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expectedl, expectedl+2, l->begin(), l->end());
+  std::vector<boost::uint8_t>* b =
+      memoryManager.GetVector<boost::uint8_t>("agent_a", "flag");
+  BOOST_CHECK_EQUAL(b->size(), (size_t)2);
+  BOOST_CHECK_EQUAL((*b)[0], 1);
+  BOOST_CHECK_EQUAL((*b)[1], 0);
+  std::vector<float>* fl =
+      memoryManager.GetVector<float>("agent_a", "float_list");
+  float expectedfl[] = {1.25, 2.5, 3.75, 5.0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expectedfl, expectedfl+4,
+      fl->begin(), fl->end());
+
+  /* Test pop data written out */
+  std::string onexml = "io/models/types_data_its/1.xml";
+  iomanager.setIteration(1);
+  iomanager.finaliseData();
+  /* Check 0.xml and 1.xml are identical */
+  size_t differences = 1;
+  int c0, c1;
+  FILE *zeroFile, *oneFile;
+  zeroFile = fopen(zeroxml.c_str(), "r");
+  oneFile  = fopen(onexml.c_str(), "r");
+  if (zeroFile == 0) {
+    fprintf(stderr, "Warning: Could not open the file: %s\n",
+        zeroxml.c_str());
+  } else if (oneFile == 0) {
+    fprintf(stderr, "Warning: Could not open the file: %s\n",
+        onexml.c_str());
+  } else {
+    differences = 0;
+    c0 = fgetc(zeroFile);
+    c1 = fgetc(oneFile);
+    /* While at least one file is not at the end */
+    while (c0 != EOF || c1 != EOF) {
+      if (c0 != c1) differences++;
+      if (c0 != EOF) c0 = fgetc(zeroFile);
+      if (c1 != EOF) c1 = fgetc(oneFile);
+    }
+  }
+  /* Close files */
+  if (zeroFile) fclose(zeroFile);
+  if (oneFile) fclose(oneFile);
+  BOOST_CHECK(differences == 0);
+
+  /* Remove created 1.xml */
+  if (remove(onexml.c_str()) != 0)
+    fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
+        onexml.c_str());
+
+  /* Values out of range of the data type are rejected */
+  std::string rangexml = "io/models/types_data_its/0_flag_out_of_range.xml";
+  BOOST_CHECK_THROW(iomanager.readPop(rangexml, &model,
+      flame::io::IOManager::xml), e::flame_io_exception);
+  BOOST_CHECK_THROW(ioxmlpop.readPop(rangexml, &model),
+      e::invalid_pop_file);
+
+  /* Reset memory manager as to not affect next test suite */
+  memoryManager.Reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
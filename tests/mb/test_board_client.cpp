@@ -73,6 +73,13 @@ BOOST_AUTO_TEST_CASE(mb_proxy_acl) {
   BOOST_CHECK_THROW(c->GetMessages("unknown"), e::invalid_argument);
   BOOST_CHECK_THROW(c->GetBoardWriter("unknown"), e::invalid_argument);
 
+  // Reads are only counted once enabled
+  BOOST_CHECK(c->GetReadCounts().empty());
+  c->CountReads(true);
+  c->GetMessages("m_double");
+  BOOST_CHECK_EQUAL(c->GetReadCounts().size(), (size_t)1);
+  BOOST_CHECK_EQUAL(c->GetReadCounts().count("m_double"), (size_t)1);
+
   // TESTBUILD only routine to reset list of registered boards
   mgr.Reset();
 }
@@ -64,4 +64,71 @@ BOOST_AUTO_TEST_CASE(test_register_var) {
   BOOST_CHECK_EQUAL(am.GetPopulationSize(), (size_t)4);
 }
 
+BOOST_AUTO_TEST_CASE(test_var_id) {
+  m::AgentMemory am("circle");
+
+  am.RegisterVar<int>("x_int");
+  am.RegisterVar<double>("y_dbl");
+  am.RegisterVar<double>("z_dbl");
+
+  // ids are dense and assigned in order of registration
+  BOOST_CHECK_EQUAL(am.GetVarCount(), (size_t)3);
+  BOOST_CHECK_EQUAL(am.GetVarId("x_int"), (size_t)0);
+  BOOST_CHECK_EQUAL(am.GetVarId("y_dbl"), (size_t)1);
+  BOOST_CHECK_EQUAL(am.GetVarId("z_dbl"), (size_t)2);
+  BOOST_CHECK_EQUAL(am.GetVarName(1), "y_dbl");
+  BOOST_CHECK_THROW(am.GetVarId("q_dbl"), e::invalid_variable);
+  BOOST_CHECK_THROW(am.GetVarName(3), e::invalid_variable);
+
+  // id and name access refer to the same vector
+  size_t y_id = am.GetVarId("y_dbl");
+  BOOST_CHECK_EQUAL(am.GetVector<double>(y_id),
+                    am.GetVector<double>("y_dbl"));
+  BOOST_CHECK_EQUAL(am.GetVectorWrapper(y_id),
+                    am.GetVectorWrapper("y_dbl"));
+  BOOST_CHECK_THROW(am.GetVector<int>(y_id), e::invalid_type);
+  BOOST_CHECK_THROW(am.GetVector<int>(3), e::invalid_variable);
+  BOOST_CHECK_THROW(am.GetVectorWrapper(3), e::invalid_variable);
+}
+
+BOOST_AUTO_TEST_CASE(test_buffered_var) {
+  m::AgentMemory am("circle");
+
+  am.RegisterVar<int>("x_int");
+  am.RegisterVar<double>("y_dbl");
+  BOOST_CHECK_THROW(am.SetBuffered("z_dbl"), e::invalid_variable);
+  am.SetBuffered("y_dbl");
+  BOOST_CHECK_THROW(am.SetBuffered("y_dbl"), e::logic_error);
+
+  size_t x_id = am.GetVarId("x_int");
+  size_t y_id = am.GetVarId("y_dbl");
+  BOOST_CHECK_EQUAL(am.IsBuffered(x_id), false);
+  BOOST_CHECK_EQUAL(am.IsBuffered(y_id), true);
+
+  // writes to unbuffered vars go to the same vector
+  BOOST_CHECK_EQUAL(am.GetWriteVectorWrapper(x_id),
+                    am.GetVectorWrapper(x_id));
+  BOOST_CHECK(am.GetWriteVectorWrapper(y_id) != am.GetVectorWrapper(y_id));
+  BOOST_CHECK_THROW(am.SetBuffered("x_int"), e::logic_error);
+
+  std::vector<double>* y = am.GetVector<double>(y_id);
+  std::vector<double>* y_next = static_cast<std::vector<double>*>(
+      am.GetWriteVectorWrapper(y_id)->GetVectorPtr());
+  y->push_back(1.0);
+  y->push_back(2.0);
+
+  // write buffer is a copy of the current values
+  am.ResetBuffers();
+  BOOST_CHECK_EQUAL(y_next->size(), (size_t)2);
+  (*y_next)[0] = 10.0;
+  BOOST_CHECK_EQUAL((*y)[0], 1.0);
+
+  // swapping publishes the written values
+  am.SwapBuffers();
+  BOOST_CHECK_EQUAL((*y)[0], 10.0);
+  BOOST_CHECK_EQUAL((*y)[1], 2.0);
+  BOOST_CHECK_EQUAL((*y_next)[0], 10.0);
+  BOOST_CHECK_EQUAL((*y_next)[1], 2.0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
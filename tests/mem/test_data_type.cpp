@@ -0,0 +1,96 @@
+/*!
+ * \file tests/mem/test_data_type.cpp
+ * \author Shawn Chin
+ * \date 2012
+ * \copyright Copyright (c) 2012 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2012 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Test suite for the data type registry
+ */
+#define BOOST_TEST_DYN_LINK
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+#include "flame2/mem/data_type.hpp"
+#include "flame2/exceptions/mem.hpp"
+
+namespace m = flame::mem;
+namespace e = flame::exceptions;
+
+BOOST_AUTO_TEST_SUITE(DataTypeRegistry)
+
+BOOST_AUTO_TEST_CASE(test_builtin_types) {
+  m::DataTypeRegistry& registry = m::DataTypeRegistry::GetInstance();
+  BOOST_CHECK(registry.GetType("char") == NULL);
+  BOOST_CHECK(*(registry.GetType("int")->GetDataType()) == typeid(int));
+  BOOST_CHECK(*(registry.GetType("float")->GetDataType()) == typeid(float));
+  BOOST_CHECK(*(registry.GetType("int64_t")->GetDataType()) ==
+              typeid(boost::int64_t));
+  BOOST_CHECK_EQUAL(registry.GetType("uint8_t")->get_schema_type(),
+                    "xs:unsignedByte");
+  BOOST_CHECK_THROW(registry.RegisterType<int>("int", "xs:integer"),
+                    e::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_and_format) {
+  const m::DataTypeBase* u8 =
+      m::DataTypeRegistry::GetInstance().GetType("uint8_t");
+  m::VectorWrapper<boost::uint8_t> vec;
+  m::VectorWrapper<int> ivec;
+
+  BOOST_CHECK(u8->ParseAppend("200", &vec));
+  BOOST_CHECK(!u8->ParseAppend("256", &vec));
+  BOOST_CHECK(!u8->ParseAppend("-1", &vec));
+  BOOST_CHECK(!u8->ParseAppend("x", &vec));
+  BOOST_CHECK_THROW(u8->ParseAppend("1", &ivec), e::invalid_type);
+  BOOST_CHECK_EQUAL(vec.size(), (size_t)1);
+
+  std::string out;
+  u8->Format(vec.GetRawPtr(0), 0, &out);
+  BOOST_CHECK_EQUAL(out, "200");
+
+  const m::DataTypeBase* f =
+      m::DataTypeRegistry::GetInstance().GetType("float");
+  float values[] = {0.25, 1.5};
+  out.clear();
+  f->Format(values, 1, &out);
+  BOOST_CHECK_EQUAL(out, "1.500000");
+}
+
+BOOST_AUTO_TEST_CASE(test_column_appenders) {
+  const m::DataTypeBase* i64 =
+      m::DataTypeRegistry::GetInstance().GetType("int64_t");
+  m::VectorWrapper<boost::int64_t> vec;
+  m::VectorWrapper<int> ivec;
+
+  BOOST_CHECK_THROW(i64->CreateAppender(&ivec), e::invalid_type);
+  boost::scoped_ptr<m::ColumnAppenderBase> appender(
+      i64->CreateAppender(&vec));
+  const char text[] = " 8589934592 ,x";
+  BOOST_CHECK(appender->ParseAppend(text, text + 12));
+  BOOST_CHECK(!appender->ParseAppend(text, text + 14));
+  BOOST_CHECK(!appender->ParseAppend(text, text));
+  BOOST_REQUIRE_EQUAL(vec.size(), (size_t)1);
+  BOOST_CHECK_EQUAL(*static_cast<boost::int64_t*>(vec.GetRawPtr(0)),
+                    static_cast<boost::int64_t>(1) << 33);
+
+  /* Values are parsed in place and checked against the type range */
+  int value;
+  BOOST_CHECK(m::ValueTraits<int>::Parse(text + 1, text + 2, &value));
+  BOOST_CHECK_EQUAL(value, 8);
+  BOOST_CHECK(!m::ValueTraits<int>::Parse(text, text + 12, &value));
+  /* Bytes of UTF-8 characters are not taken as white space */
+  const char utf8[] = "\xc2\xa0" "7";
+  BOOST_CHECK(!m::ValueTraits<int>::Parse(utf8, utf8 + 3, &value));
+
+  std::vector<int> column;
+  m::ColumnAppender<int> ints(&column);
+  ints.Append(3);
+  BOOST_CHECK(ints.ParseAppend(text + 1, text + 2));
+  BOOST_REQUIRE_EQUAL(column.size(), (size_t)2);
+  BOOST_CHECK_EQUAL(column[1], 8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -227,6 +227,33 @@ BOOST_AUTO_TEST_CASE(memiter_test_memoryiterator) {
   BOOST_CHECK_EQUAL(iptr->get_position(), (size_t)5);
 }
 
+BOOST_AUTO_TEST_CASE(memiter_test_var_id_access) {
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mem::AgentShadowPtr shadow = mgr.GetAgentShadow("Circle");
+  shadow->AllowAccess("x_int");
+  shadow->AllowAccess("z_dbl", true);  // writeable
+
+  mem::MemoryIteratorPtr iptr = shadow->GetMemoryIterator();
+  size_t x_id = iptr->GetVarId("x_int");
+  size_t y_id = iptr->GetVarId("y_dbl");
+  size_t z_id = iptr->GetVarId("z_dbl");
+  BOOST_CHECK_EQUAL(x_id, mgr.GetVarId("Circle", "x_int"));
+  BOOST_CHECK_THROW(iptr->GetVarId("NotVar"), e::invalid_variable);
+
+  // access checks apply to ids as well
+  BOOST_CHECK_THROW(iptr->Get<double>(y_id), e::invalid_operation);
+  BOOST_CHECK_THROW(iptr->Set<int>(x_id, 1), e::invalid_operation);
+  BOOST_CHECK_THROW(iptr->Get<double>(x_id), e::invalid_type);
+  BOOST_CHECK_THROW(iptr->Get<int>(99), e::invalid_variable);
+
+  for (int i = 0; i < 10; i++) {
+    BOOST_CHECK_EQUAL(iptr->Get<int>(x_id), i);
+    iptr->Set<double>(z_id, i * 2.0);
+    BOOST_CHECK_CLOSE(iptr->Get<double>("z_dbl"), i * 2.0, 0.00001);
+    iptr->Step();
+  }
+  BOOST_CHECK_EQUAL(iptr->AtEnd(), true);
+}
 
 BOOST_AUTO_TEST_CASE(memiter_test_sizechange) {
   mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
@@ -295,6 +322,76 @@ BOOST_AUTO_TEST_CASE(memiter_test_sizechange) {
 
 
 
+BOOST_AUTO_TEST_CASE(memiter_test_buffered_var) {
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mgr.RegisterAgent("Square");
+  mgr.RegisterAgentVar<double>("Square", "w_dbl");
+  mgr.SetBuffered("Square", "w_dbl");
+  std::vector<double>* w_ptr = mgr.GetVector<double>("Square", "w_dbl");
+  for (int i = 0; i < 5; ++i) {
+    w_ptr->push_back(i * 1.0);
+  }
+  mgr.ResetBuffers();
+
+  mem::AgentShadowPtr shadow = mgr.GetAgentShadow("Square");
+  shadow->AllowAccess("w_dbl", true);  // writeable
+
+  // writes go to the write buffer, reads still see the current values
+  mem::MemoryIteratorPtr iptr = shadow->GetMemoryIterator(1, 3);
+  while (!iptr->AtEnd()) {
+    double w = iptr->Get<double>("w_dbl");
+    iptr->Set<double>("w_dbl", w + 10.0);
+    BOOST_CHECK_EQUAL(iptr->Get<double>("w_dbl"), w);
+    iptr->Step();
+  }
+  BOOST_CHECK_EQUAL((*w_ptr)[1], 1.0);
+
+  // swapping publishes the written values
+  mgr.SwapBuffers("Square");
+  double expected[] = {0.0, 11.0, 12.0, 13.0, 4.0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected, expected + 5,
+                                w_ptr->begin(), w_ptr->end());
+}
+
+BOOST_AUTO_TEST_CASE(memiter_test_array_var) {
+  mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
+  mgr.RegisterAgent("Triangle");
+  mgr.RegisterAgentVar<double>("Triangle", "pos", 3);
+  mgr.RegisterAgentVar<int>("Triangle", "loc.id");
+  mgr.RegisterAgentVar<double>("Triangle", "loc.v", 2);
+  std::vector<double>* pos_ptr = mgr.GetVector<double>("Triangle", "pos");
+  std::vector<int>* id_ptr = mgr.GetVector<int>("Triangle", "loc.id");
+  std::vector<double>* v_ptr = mgr.GetVector<double>("Triangle", "loc.v");
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 3; ++j) pos_ptr->push_back(i * 10.0 + j);
+    id_ptr->push_back(i);
+    v_ptr->push_back(i * 1.0);
+    v_ptr->push_back(i * 2.0);
+  }
+
+  // access to a compound variable grants access to all members
+  mem::AgentShadowPtr shadow = mgr.GetAgentShadow("Triangle");
+  shadow->AllowAccess("pos", true);  // writeable
+  shadow->AllowAccess("loc");
+  BOOST_CHECK_THROW(shadow->AllowAccess("lo"), e::invalid_variable);
+  BOOST_CHECK_EQUAL(shadow->get_size(), (size_t)4);
+
+  mem::MemoryIteratorPtr iptr = shadow->GetMemoryIterator(1, 2);
+  BOOST_CHECK_THROW(iptr->Get<double>("pos", 3), e::out_of_range);
+  BOOST_CHECK_THROW(iptr->Set<double>("loc.v", 0, 1.0), e::invalid_operation);
+  while (!iptr->AtEnd()) {
+    int id = iptr->Get<int>("loc.id");
+    BOOST_CHECK_EQUAL(iptr->Get<double>("loc.v", 1), id * 2.0);
+    BOOST_CHECK_EQUAL(iptr->Get<double>("pos", 2), id * 10.0 + 2);
+    iptr->Set<double>("pos", 1, -1.0);
+    iptr->Step();
+  }
+  double expected[] = {0.0, 1.0, 2.0, 10.0, -1.0, 12.0,
+                       20.0, -1.0, 22.0, 30.0, 31.0, 32.0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected, expected + 12,
+                                pos_ptr->begin(), pos_ptr->end());
+}
+
 BOOST_AUTO_TEST_CASE(memiter_reset_memory_manager) {
   mem::MemoryManager& mgr = mem::MemoryManager::GetInstance();
   mgr.Reset();  // reset again so as not to affect next test suite
@@ -78,6 +78,9 @@ BOOST_AUTO_TEST_CASE(test_register_agent) {
   BOOST_CHECK_NO_THROW((mgr.GetVector<int>("Circle", "val")));
   BOOST_CHECK_NO_THROW((mgr.GetVector<int>("Square", "val")));
   BOOST_CHECK_NO_THROW((mgr.GetVector<double>("Circle", "y")));
+  // appenders are type checked like vectors
+  BOOST_CHECK_THROW((mgr.GetAppender<int>("Circle", "x")), e::invalid_type);
+  BOOST_CHECK_NO_THROW((mgr.GetAppender<double>("Circle", "x")));
 
   // Check capacity of vectors within
   BOOST_CHECK_EQUAL(mgr.GetVector<double>("Circle", "x")->capacity(), s1);
@@ -83,4 +83,48 @@ BOOST_AUTO_TEST_CASE(test_vector_wrapper) {
 }
 
 
+BOOST_AUTO_TEST_CASE(test_vector_wrapper_stride) {
+  BOOST_CHECK_THROW(m::VectorWrapper<int>(0),
+                    flame::exceptions::invalid_argument);
+  m::VectorWrapperBase* pd = new m::VectorWrapper<double>(3);
+  BOOST_CHECK_EQUAL(pd->stride(), (size_t)3);
+
+  std::vector<double>* vd = static_cast<std::vector<double>*>(
+                                                        pd->GetVectorPtr());
+  for (int i = 0; i < 6; ++i) {
+    vd->push_back(i * 1.0);
+  }
+  BOOST_CHECK_EQUAL(vd->size(), (size_t)6);
+  BOOST_CHECK_EQUAL(pd->size(), (size_t)2);
+
+  // raw pointers point at the first element of each entry
+  BOOST_CHECK_THROW(pd->GetRawPtr(2), flame::exceptions::invalid_argument);
+  BOOST_CHECK_EQUAL(3.0, *static_cast<double*>(pd->GetRawPtr(1)));
+  void* d = pd->GetRawPtr();
+  BOOST_CHECK_EQUAL(2.0, static_cast<double*>(d)[2]);
+  d = pd->StepRawPtr(d);
+  BOOST_CHECK_EQUAL(5.0, static_cast<double*>(d)[2]);
+  BOOST_CHECK(pd->StepRawPtr(d) == NULL);
+
+  // clones keep the stride, other strides are incompatible
+  m::VectorWrapperBase* pc = pd->clone_empty();
+  BOOST_CHECK_EQUAL(pc->stride(), (size_t)3);
+  pc->assign(pd);
+  BOOST_CHECK_EQUAL(pc->size(), (size_t)2);
+  m::VectorWrapperBase* p1 = new m::VectorWrapper<double>();
+  BOOST_CHECK_THROW(p1->Extend(pd), flame::exceptions::invalid_type);
+
+  // truncating drops whole entries
+  pc->truncate(5);
+  BOOST_CHECK_EQUAL(pc->size(), (size_t)2);
+  pc->truncate(1);
+  BOOST_CHECK_EQUAL(pc->size(), (size_t)1);
+  BOOST_CHECK_EQUAL(static_cast<std::vector<double>*>(
+      pc->GetVectorPtr())->size(), (size_t)3);
+
+  delete pd;
+  delete pc;
+  delete p1;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -12,8 +12,14 @@
 #   define BOOST_TEST_MODULE XGraph
 #endif
 #include <boost/test/unit_test.hpp>
+#include <boost/bind.hpp>
 #include <vector>
 #include <string>
+#include <sstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include "flame2/exceptions/model.hpp"
 #include "flame2/model/xgraph.hpp"
 #include "flame2/model/model.hpp"
 #include "flame2/io/io_manager.hpp"
@@ -56,6 +62,86 @@ BOOST_AUTO_TEST_CASE(test_raw_conflict) {
   BOOST_CHECK(graph.dependencyExists("f0", "f2") == true);
 }
 
+BOOST_AUTO_TEST_CASE(test_buffered_no_war_conflict) {
+  model::XGraph graph;
+
+  // Add function tasks to graph
+  model::Task * f0 = new model::Task("agent", "f0", model::Task::xfunction);
+  f0->addReadOnlyVariable("a");
+  model::Task * f1 = new model::Task("agent", "f1", model::Task::xfunction);
+  f1->addReadOnlyVariable("a");
+  model::Task * f2 = new model::Task("agent", "f2", model::Task::xfunction);
+  f2->addReadWriteVariable("a");
+  model::Task * f3 = new model::Task("agent", "f3", model::Task::xfunction);
+  f3->addReadOnlyVariable("a");
+  model::Vertex v0 = graph.addTestVertex(f0);
+  model::Vertex v1 = graph.addTestVertex(f1);
+  model::Vertex v2 = graph.addTestVertex(f2);
+  model::Vertex v3 = graph.addTestVertex(f3);
+  // Add dependencies between tasks
+  graph.addTestEdge(v0, v1, "", model::Dependency::state);
+  graph.addTestEdge(v1, v2, "", model::Dependency::state);
+  graph.addTestEdge(v2, v3, "", model::Dependency::state);
+  // Set up graph for processing with a double-buffered variable
+  boost::ptr_vector<model::XVariable> variables;
+  model::XVariable * a = new model::XVariable("a");
+  a->setBuffered(true);
+  variables.push_back(a);
+  graph.setTestStartTask(f0);
+  graph.addTestEndTask(f3);
+  graph.setAgentName("test_xgraph");
+  // Process graph
+  graph.generateDependencyGraph(&variables);
+  // Readers and writer of a buffered variable are not serialised
+  BOOST_CHECK(graph.dependencyExists("f1", "f2") == false);
+  BOOST_CHECK(graph.dependencyExists("f0", "f2") == false);
+  BOOST_CHECK(graph.dependencyExists("f2", "f3") == false);
+  // Buffers are swapped after all accesses and before data output
+  BOOST_CHECK(graph.dependencyExists("f0", "swap") == true);
+  BOOST_CHECK(graph.dependencyExists("f1", "swap") == true);
+  BOOST_CHECK(graph.dependencyExists("f2", "swap") == true);
+  BOOST_CHECK(graph.dependencyExists("f3", "swap") == true);
+  BOOST_CHECK(graph.dependencyExists("swap", "a") == true);
+}
+
+BOOST_AUTO_TEST_CASE(test_critical_path_priorities) {
+  model::XGraph graph;
+
+  // A chain of three functions and a lone function
+  model::Task * f0 = new model::Task("agent", "f0", model::Task::xfunction);
+  model::Task * f1 = new model::Task("agent", "f1", model::Task::xfunction);
+  model::Task * f2 = new model::Task("agent", "f2", model::Task::xfunction);
+  model::Task * f3 = new model::Task("agent", "f3", model::Task::xfunction);
+  model::Vertex v0 = graph.addTestVertex(f0);
+  model::Vertex v1 = graph.addTestVertex(f1);
+  model::Vertex v2 = graph.addTestVertex(f2);
+  model::Vertex v3 = graph.addTestVertex(f3);
+  graph.addTestEdge(v0, v1, "", model::Dependency::state);
+  graph.addTestEdge(v1, v2, "", model::Dependency::state);
+
+  // Without run times chain lengths are counted in tasks
+  std::vector<double> priorities;
+  graph.computeTaskPriorities(0, &priorities);
+  BOOST_CHECK_EQUAL(f0->getLevel(), (size_t)3);
+  BOOST_CHECK_EQUAL(f1->getLevel(), (size_t)2);
+  BOOST_CHECK_EQUAL(f2->getLevel(), (size_t)1);
+  BOOST_CHECK_EQUAL(f3->getLevel(), (size_t)1);
+  BOOST_CHECK(priorities[v0] > priorities[v1]);
+  BOOST_CHECK(priorities[v1] > priorities[v2]);
+  BOOST_CHECK(priorities[v0] > priorities[v3]);
+
+  // With run times the most expensive chain comes first
+  model::TaskCostMap costs;
+  costs["AF_agent_f0"] = 1.0;
+  costs["AF_agent_f1"] = 1.0;
+  costs["AF_agent_f2"] = 1.0;
+  costs["AF_agent_f3"] = 5.0;
+  graph.computeTaskPriorities(&costs, &priorities);
+  BOOST_CHECK_CLOSE(priorities[v0], 3.0, 0.0001);
+  BOOST_CHECK_CLOSE(priorities[v2], 1.0, 0.0001);
+  BOOST_CHECK_CLOSE(priorities[v3], 5.0, 0.0001);
+}
+
 BOOST_AUTO_TEST_CASE(test_xgraph) {
   flame::io::IOManager& m = flame::io::IOManager::GetInstance();
   flame::model::XModel model;
@@ -85,4 +171,190 @@ BOOST_AUTO_TEST_CASE(test_xgraph) {
       "update_infection_status", "diagnosis") == true);
 }
 
+//! Counts calls for each agent index, failing on the given index
+static void countAgentCall(std::vector<int> * calls, size_t fail,
+    size_t index) {
+  ++(*calls)[index];
+  if (index == fail) throw std::invalid_argument("Failing agent");
+}
+
+//! Maps the name of each task of a plan to the names of its dependencies
+static void getPlanDependencies(const model::ExecutionPlan& plan,
+    std::map<std::string, std::set<std::string> > * deps) {
+  size_t ii, jj;
+  for (ii = 0; ii < plan.getTaskCount(); ++ii) {
+    std::set<std::string>& names = (*deps)[plan.getTask(ii).name];
+    for (jj = 0; jj < plan.getDependencyCount(ii); ++jj)
+      names.insert(plan.getTask(plan.getDependency(ii, jj)).name);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_graph_generation) {
+  flame::io::IOManager& m = flame::io::IOManager::GetInstance();
+  flame::model::XModel model, serialModel;
+  flame::model::XGraph graph, serialGraph;
+  model::ExecutionPlan plan, serialPlan;
+  boost::ptr_vector<model::XMachine>::iterator agent;
+  std::set<model::XGraph*> graphs;
+  std::map<std::string, std::set<std::string> > deps, serialDeps;
+
+  BOOST_CHECK_NO_THROW(m.loadModel(
+      "model/models/predator_prey.xml", &model));
+  BOOST_CHECK_NO_THROW(m.loadModel(
+      "model/models/predator_prey.xml", &serialModel));
+  BOOST_CHECK(model.validate() == 0);
+  BOOST_CHECK(serialModel.validate() == 0);
+  size_t count = model.getAgents()->size();
+  BOOST_REQUIRE(count > 1);
+
+  // Every agent index is given once, exceptions reach the caller
+  std::vector<int> calls(count, 0);
+  model.forEachAgentInParallel(boost::bind(&countAgentCall, &calls,
+      count, _1));
+  BOOST_CHECK(calls == std::vector<int>(count, 1));
+  BOOST_CHECK_THROW(model.forEachAgentInParallel(
+      boost::bind(&countAgentCall, &calls, 1, _1)), std::invalid_argument);
+
+  // Agent graphs generated concurrently give the same model graph as
+  // ones generated in turn
+  model.generateGraph(&graph);
+  serialGraph.setAgentName("Predator Prey");
+  for (agent = serialModel.getAgents()->begin();
+      agent != serialModel.getAgents()->end(); ++agent) {
+    (*agent).generateDependencyGraph();
+    graphs.insert((*agent).getFunctionDependencyGraph());
+  }
+  serialGraph.importGraphs(graphs);
+  graph.compileExecutionPlan(&plan);
+  serialGraph.compileExecutionPlan(&serialPlan);
+  BOOST_CHECK_EQUAL(plan.getTaskCount(), serialPlan.getTaskCount());
+  BOOST_CHECK_EQUAL(plan.getEdgeCount(), serialPlan.getEdgeCount());
+  getPlanDependencies(plan, &deps);
+  getPlanDependencies(serialPlan, &serialDeps);
+  BOOST_CHECK(deps == serialDeps);
+  // Message vertices found by name give one sync task per message
+  std::map<std::string, int> syncs;
+  for (size_t ii = 0; ii < plan.getTaskCount(); ++ii)
+    if (plan.getTask(ii).kind == model::ExecutionPlan::message_sync)
+      ++syncs[plan.getTask(ii).targetName];
+  BOOST_CHECK_EQUAL(syncs.size(), 2u);
+  std::map<std::string, int>::iterator sit;
+  for (sit = syncs.begin(); sit != syncs.end(); ++sit)
+    BOOST_CHECK_EQUAL((*sit).second, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_fuse_agent_functions) {
+  model::XGraph graph;
+
+  // f0 -> f1 -> f2 <- f3 of agent a, and f0 -> f4 of agent b
+  model::Task * f0 = new model::Task("a", "f0", model::Task::xfunction);
+  f0->addReadOnlyVariable("x");
+  f0->addReadOnlyVariable("y");
+  model::Task * f1 = new model::Task("a", "f1", model::Task::xfunction);
+  f1->addReadWriteVariable("y");
+  model::Task * f2 = new model::Task("a", "f2", model::Task::xfunction);
+  model::Task * f3 = new model::Task("a", "f3", model::Task::xfunction);
+  model::Task * f4 = new model::Task("b", "f4", model::Task::xfunction);
+  model::Vertex v0 = graph.addTestVertex(f0);
+  model::Vertex v1 = graph.addTestVertex(f1);
+  model::Vertex v2 = graph.addTestVertex(f2);
+  model::Vertex v3 = graph.addTestVertex(f3);
+  model::Vertex v4 = graph.addTestVertex(f4);
+  graph.addTestEdge(v0, v1, "", model::Dependency::state);
+  graph.addTestEdge(v1, v2, "", model::Dependency::state);
+  graph.addTestEdge(v3, v2, "", model::Dependency::state);
+  graph.addTestEdge(v0, v4, "", model::Dependency::data);
+  graph.fuseAgentFunctions();
+
+  // Only f1 has a single dependency on a function of the same agent
+  BOOST_CHECK(f0->getFusedFunctions()->size() == 1);
+  BOOST_CHECK_EQUAL(f0->getFusedFunctions()->front(), "f1");
+  BOOST_CHECK_EQUAL(f0->getTaskName(), "AF_a_f0+f1");
+  BOOST_CHECK(graph.dependencyExists("f0", "f2") == true);
+  BOOST_CHECK(graph.dependencyExists("f3", "f2") == true);
+  BOOST_CHECK(graph.dependencyExists("f0", "f4") == true);
+  BOOST_CHECK(f3->getFusedFunctions()->empty());
+  // Variables written by any fused function are writable
+  BOOST_CHECK(f0->getWriteVariables()->count("y") == 1);
+  BOOST_CHECK(f0->getReadOnlyVariables()->count("y") == 0);
+  BOOST_CHECK(f0->getReadOnlyVariables()->count("x") == 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_execution_plan) {
+  flame::io::IOManager& m = flame::io::IOManager::GetInstance();
+  flame::model::XModel model;
+  model::ExecutionPlan plan;
+  std::map<std::string, size_t> index;
+  size_t ii, jj;
+
+  BOOST_CHECK_NO_THROW(m.loadModel(
+      "model/models/infection.xml", &model));
+  BOOST_CHECK(model.validate() == 0);
+  model.compileExecutionPlan(&plan, false);
+  BOOST_REQUIRE(plan.getTaskCount() > 0);
+
+  // Tasks only depend on tasks before them
+  for (ii = 0; ii < plan.getTaskCount(); ++ii) {
+    index[plan.getTask(ii).name] = ii;
+    for (jj = 0; jj < plan.getDependencyCount(ii); ++jj)
+      BOOST_CHECK(plan.getDependency(ii, jj) < ii);
+  }
+  BOOST_CHECK_EQUAL(index.size(), plan.getTaskCount());
+  BOOST_CHECK_THROW(plan.getDependency(0, plan.getDependencyCount(0)),
+      flame::exceptions::flame_model_exception);
+
+  // Agent functions keep their memory and message access
+  BOOST_REQUIRE(index.count("AF_Person_move") == 1);
+  const model::ExecutionPlan::PlanTask& move =
+      plan.getTask(index["AF_Person_move"]);
+  BOOST_CHECK(move.kind == model::ExecutionPlan::agent_function);
+  BOOST_CHECK_EQUAL(move.parentName, "Person");
+  BOOST_CHECK_EQUAL(move.targetName, "move");
+  BOOST_CHECK(!move.writeVariables.empty());
+  BOOST_CHECK(plan.getWrittenVariables().count("Person") == 1);
+
+  // Range dependencies are on functions of the same agent
+  size_t ranges = 0;
+  for (ii = 0; ii < plan.getTaskCount(); ++ii) {
+    size_t range = plan.getRangeDependency(ii);
+    if (range == plan.getTaskCount()) continue;
+    ++ranges;
+    BOOST_CHECK(plan.getTask(ii).kind == model::ExecutionPlan::agent_function);
+    BOOST_CHECK(plan.getTask(range).kind ==
+        model::ExecutionPlan::agent_function);
+    BOOST_CHECK_EQUAL(plan.getTask(range).parentName,
+        plan.getTask(ii).parentName);
+  }
+  BOOST_CHECK(ranges > 0);
+
+  // Every output task waits for the last writes of its variable
+  for (ii = 0; ii < plan.getTaskCount(); ++ii)
+    if (plan.getTask(ii).kind == model::ExecutionPlan::io_output)
+      BOOST_CHECK(plan.getDependencyCount(ii) > 0);
+
+  // Plans read back in are unchanged
+  std::stringstream written, rewritten;
+  model::ExecutionPlan plan2;
+  plan.write(&written);
+  BOOST_CHECK_NO_THROW(plan2.read(&written));
+  BOOST_CHECK_EQUAL(plan2.getTaskCount(), plan.getTaskCount());
+  BOOST_CHECK_EQUAL(plan2.getEdgeCount(), plan.getEdgeCount());
+  plan2.write(&rewritten);
+  BOOST_CHECK_EQUAL(rewritten.str(), written.str());
+
+  // Invalid plans are rejected
+  std::istringstream empty(""), badVersion("flame2-execution-plan 99\n"),
+      cycle("flame2-execution-plan 2\ntasks 1\n"
+          "task io_init MD_m m - 1\nro 0\nrw 0\npost 0\nread 0\nfused 0\n"
+          "offsets 0 1\ndependencies 1 0\nwritten 0\nend\n");
+  BOOST_CHECK_THROW(plan2.read(&empty),
+      flame::exceptions::flame_model_exception);
+  BOOST_CHECK_THROW(plan2.read(&badVersion),
+      flame::exceptions::flame_model_exception);
+  BOOST_CHECK_THROW(plan2.read(&cycle),
+      flame::exceptions::flame_model_exception);
+  // A failed read leaves the plan unchanged
+  BOOST_CHECK_EQUAL(plan2.getTaskCount(), plan.getTaskCount());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
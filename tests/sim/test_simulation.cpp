@@ -12,11 +12,17 @@
 #   define BOOST_TEST_MODULE Sim
 #endif
 #include <boost/test/unit_test.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <vector>
 #include <string>
+#include <sstream>
 #include "flame2/exceptions/sim.hpp"
 #include "flame2/sim/sim_manager.hpp"
 #include "flame2/io/io_manager.hpp"
+#include "flame2/io/output_backend.hpp"
+#include "flame2/exe/scheduler.hpp"
+#include "flame2/exe/task_manager.hpp"
 #include "flame2/model/model.hpp"
 #include "flame2/mb/client.hpp"
 #include "flame2/mb/message_iterator.hpp"
@@ -133,6 +139,303 @@ BOOST_AUTO_TEST_CASE(test_simulation) {
   flame::mb::MessageBoardManager::GetInstance().Reset();
 }
 
+BOOST_AUTO_TEST_CASE(test_simulation_execution_plan) {
+  flame::model::Model m("sim/models/circles/circles.xml");
+  m.registerAgentFunction("outputdata", &outputdata);
+  m.registerAgentFunction("inputdata", &inputdata);
+  m.registerAgentFunction("move", &move);
+
+  // Compile and write out a plan as xparser does, then read it back in
+  model::ExecutionPlan compiled, plan;
+  std::stringstream plan_data;
+  m.getXModel()->compileExecutionPlan(&compiled);
+  compiled.write(&plan_data);
+  plan.read(&plan_data);
+
+  sim::Simulation s(&m, "sim/models/circles/0.xml");
+  m.registerMessageType<my_location_message>("location");
+  s.setExecutionPlan(plan);
+  s.start(1);
+
+  // Tasks are registered from the plan, move only follows inputdata so
+  // both run in a single task
+  flame::exe::TaskManager& tm = flame::exe::TaskManager::GetInstance();
+  BOOST_CHECK_EQUAL(tm.GetTaskCount(), plan.getTaskCount());
+  BOOST_CHECK_NO_THROW(tm.GetTask("AF_Circle_inputdata+move"));
+  BOOST_CHECK_THROW(tm.GetTask("AF_Circle_move"),
+      flame::exceptions::invalid_argument);
+
+  if (remove("sim/models/circles/1.xml") != 0)
+    fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
+        "sim/models/circles/1.xml");
+
+  flame::mem::MemoryManager::GetInstance().Reset();
+  flame::exe::TaskManager::GetInstance().Reset();
+  flame::mb::MessageBoardManager::GetInstance().Reset();
+}
+
+// Set once the second function has run for the first Cell
+static bool first_cell_done = false;
+static boost::mutex first_cell_mutex;
+static boost::condition_variable first_cell_cond;
+// Set if the first function for the last Cell saw first_cell_done
+static bool released_early = false;
+
+FLAME_AGENT_FUNCTION(emit) {
+  FLAME.PostMessage<int>("signal", FLAME.GetMem<int>("id"));
+  return FLAME_AGENT_ALIVE;
+}
+
+FLAME_AGENT_FUNCTION(first) {
+  int id = FLAME.GetMem<int>("id");
+  if (id == 40) {
+    // the last Cell waits for the second function to reach the first Cell
+    boost::unique_lock<boost::mutex> lock(first_cell_mutex);
+    boost::system_time timeout = boost::get_system_time() +
+        boost::posix_time::seconds(10);
+    while (!first_cell_done) {
+      if (!first_cell_cond.timed_wait(lock, timeout)) break;
+    }
+    released_early = first_cell_done;
+  }
+  FLAME.SetMem<double>("a", id);
+  return FLAME_AGENT_ALIVE;
+}
+
+FLAME_AGENT_FUNCTION(second) {
+  MessageIterator iter = FLAME.GetMessageIterator("signal");
+  FLAME.SetMem<double>("b", FLAME.GetMem<double>("a") + iter.GetCount());
+  if (FLAME.GetMem<int>("id") == 1) {
+    boost::lock_guard<boost::mutex> lock(first_cell_mutex);
+    first_cell_done = true;
+    first_cell_cond.notify_all();
+  }
+  return FLAME_AGENT_ALIVE;
+}
+
+BOOST_AUTO_TEST_CASE(test_simulation_range_release) {
+  flame::model::Model m("sim/models/wavefront/wavefront.xml");
+  m.registerAgentFunction("emit", &emit);
+  m.registerAgentFunction("first", &first);
+  m.registerAgentFunction("second", &second);
+
+  model::ExecutionPlan plan;
+  m.getXModel()->compileExecutionPlan(&plan);
+
+  sim::Simulation s(&m, "sim/models/wavefront/0.xml");
+  m.registerMessageType<int>("signal");
+  s.setExecutionPlan(plan);
+  s.setMinVectorSize(10);  // four subtasks of ten Cells
+
+  // The subtask of second for the first Cells runs while first is still
+  // running for the last Cells
+  s.start(1, 4);
+  BOOST_CHECK(released_early);
+
+  flame::mem::MemoryManager& mm = flame::mem::MemoryManager::GetInstance();
+  flame::mem::AgentShadowPtr shadow = mm.GetAgentShadow("Cell");
+  shadow->AllowAccess("id");
+  shadow->AllowAccess("b");
+  flame::mem::MemoryIteratorPtr mptr = shadow->GetMemoryIterator();
+  for (; !mptr->AtEnd(); mptr->Step()) {
+    BOOST_CHECK_EQUAL(mptr->Get<double>("b"), mptr->Get<int>("id") + 1.0);
+  }
+
+  if (remove("sim/models/wavefront/1.xml") != 0)
+    fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
+        "sim/models/wavefront/1.xml");
+
+  flame::mem::MemoryManager::GetInstance().Reset();
+  flame::exe::TaskManager::GetInstance().Reset();
+  flame::mb::MessageBoardManager::GetInstance().Reset();
+}
+
+BOOST_AUTO_TEST_CASE(test_simulation_split_policy) {
+  flame::model::Model m("sim/models/wavefront/wavefront.xml");
+  m.registerAgentFunction("emit", &emit);
+  m.registerAgentFunction("first", &first);
+  m.registerAgentFunction("second", &second);
+  first_cell_done = true;  // the last Cell does not wait
+
+  model::ExecutionPlan plan;
+  m.getXModel()->compileExecutionPlan(&plan);
+
+  // Balanced splits use the run times of the first iteration in the
+  // second, guided splits create more subtasks than cores
+  flame::exe::Task::SplitPolicy policies[] = {
+    flame::exe::Task::SPLIT_BALANCED, flame::exe::Task::SPLIT_GUIDED
+  };
+  for (size_t p = 0; p < 2; ++p) {
+    sim::Simulation s(&m, "sim/models/wavefront/0.xml");
+    m.registerMessageType<int>("signal");
+    s.setExecutionPlan(plan);
+    s.setMinVectorSize(5);
+    s.setSplitPolicy(policies[p]);
+    s.start(2, 4);
+
+    flame::mem::MemoryManager& mm = flame::mem::MemoryManager::GetInstance();
+    flame::mem::AgentShadowPtr shadow = mm.GetAgentShadow("Cell");
+    shadow->AllowAccess("id");
+    shadow->AllowAccess("b");
+    flame::mem::MemoryIteratorPtr mptr = shadow->GetMemoryIterator();
+    for (; !mptr->AtEnd(); mptr->Step()) {
+      BOOST_CHECK_EQUAL(mptr->Get<double>("b"), mptr->Get<int>("id") + 1.0);
+    }
+
+    for (int i = 1; i <= 2; ++i) {
+      std::ostringstream file;
+      file << "sim/models/wavefront/" << i << ".xml";
+      if (remove(file.str().c_str()) != 0)
+        fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
+            file.str().c_str());
+    }
+
+    flame::mem::MemoryManager::GetInstance().Reset();
+    flame::exe::TaskManager::GetInstance().Reset();
+    flame::mb::MessageBoardManager::GetInstance().Reset();
+  }
+}
+
+// Number of agents the compute tasks have run for
+static size_t agents_run = 0;
+static boost::mutex agents_run_mutex;
+static boost::condition_variable agents_run_cond;
+
+FLAME_AGENT_FUNCTION(count_agent) {
+  boost::lock_guard<boost::mutex> lock(agents_run_mutex);
+  ++agents_run;
+  agents_run_cond.notify_all();
+  return FLAME_AGENT_ALIVE;
+}
+
+//! Output backend that blocks until the compute tasks have run for every
+//! agent, or a timeout passes
+class BlockingBackend : public io::OutputBackend {
+  public:
+    explicit BlockingBackend(size_t expected)
+        : expected_(expected), released_(false) {}
+    void setIteration(size_t /*i*/) {}
+    std::string outputFileName() { return "blocking"; }
+    void finaliseData() {
+      boost::unique_lock<boost::mutex> lock(agents_run_mutex);
+      boost::system_time timeout = boost::get_system_time() +
+          boost::posix_time::seconds(10);
+      while (agents_run < expected_) {
+        if (!agents_run_cond.timed_wait(lock, timeout)) break;
+      }
+      released_ = agents_run == expected_;
+    }
+    void writeSnapshot(io::PopSnapshot * /*snapshot*/) { finaliseData(); }
+    size_t expected_;
+    bool released_;  //! Compute tasks completed while output was blocked
+};
+
+BOOST_AUTO_TEST_CASE(test_simulation_io_queue) {
+  flame::model::Model m("sim/models/circles/circles.xml");
+  m.registerAgentFunction("outputdata", &outputdata);
+  m.registerAgentFunction("inputdata", &inputdata);
+  m.registerAgentFunction("move", &move);
+  sim::Simulation s(&m, "sim/models/circles/0.xml");
+
+  flame::mem::MemoryManager& mm = flame::mem::MemoryManager::GetInstance();
+  size_t agents = mm.GetVectorWrapper("Circle", "id")->size();
+  BOOST_REQUIRE(agents > 0);
+
+  // Two compute tasks and an IO task that blocks until they have run
+  flame::exe::TaskManager& tm = flame::exe::TaskManager::GetInstance();
+  tm.Reset();
+  tm.CreateAgentTask("count_1", "Circle", &count_agent).AllowAccess("id");
+  tm.CreateAgentTask("count_2", "Circle", &count_agent).AllowAccess("id");
+  tm.CreateIOTask("io_fin", "", "", flame::exe::IOTask::OP_FIN);
+
+  io::IOManager& iomanager = io::IOManager::GetInstance();
+  BlockingBackend backend(2 * agents);
+  iomanager.setAsynchronousOutput(false);
+  iomanager.setOutputFrequency(1);
+  iomanager.setDeltaOutput(false);
+  iomanager.setTimeSeriesOutput(false);
+  iomanager.setOutputBackend(&backend);
+
+  // A single compute worker is enough, as the IO task runs on its own queue
+  flame::exe::Scheduler scheduler;
+  s.createQueues(&scheduler, 1);
+  scheduler.RunIteration();
+  iomanager.setOutputBackend(0);
+  BOOST_CHECK(backend.released_);
+  BOOST_CHECK_EQUAL(agents_run, 2 * agents);
+
+  mm.Reset();
+  tm.Reset();
+  flame::mb::MessageBoardManager::GetInstance().Reset();
+}
+
+BOOST_AUTO_TEST_CASE(test_simulation_output_options) {
+  flame::model::Model m("sim/models/circles/circles.xml");
+  m.registerAgentFunction("outputdata", &outputdata);
+  m.registerAgentFunction("inputdata", &inputdata);
+  m.registerAgentFunction("move", &move);
+
+  sim::Simulation s(&m, "sim/models/circles/0.xml");
+  m.registerMessageType<my_location_message>("location");
+  BOOST_CHECK_THROW(s.setOutputFrequency(0), e::flame_sim_exception);
+  BOOST_CHECK_THROW(s.setOutputCompression(10), e::flame_sim_exception);
+
+  // Only the second iteration is written, compressed and in full as it is
+  // the first output
+  s.setOutputFrequency(2);
+  s.setOutputCompression(6);
+  s.setDeltaOutput(true);
+  s.start(2);
+  FILE * f = fopen("sim/models/circles/1.xml.gz", "rb");
+  BOOST_CHECK(f == NULL);
+  if (f) fclose(f);
+  flame::mem::MemoryManager::GetInstance().Reset();
+  BOOST_CHECK_NO_THROW(
+      sim::Simulation s2(&m, "sim/models/circles/2.xml.gz"));
+
+  if (remove("sim/models/circles/2.xml.gz") != 0)
+    fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
+        "sim/models/circles/2.xml.gz");
+
+  flame::mem::MemoryManager::GetInstance().Reset();
+  flame::exe::TaskManager::GetInstance().Reset();
+  flame::mb::MessageBoardManager::GetInstance().Reset();
+}
+
+BOOST_AUTO_TEST_CASE(test_simulation_timeseries_output) {
+  flame::model::Model m("sim/models/circles/circles.xml");
+  m.registerAgentFunction("outputdata", &outputdata);
+  m.registerAgentFunction("inputdata", &inputdata);
+  m.registerAgentFunction("move", &move);
+
+  sim::Simulation s(&m, "sim/models/circles/0.xml");
+  m.registerMessageType<my_location_message>("location");
+  s.setTimeSeriesOutput(true);
+  s.start(1);
+
+  // Time series are written next to the population file
+  io::timeseries::TimeSeriesReader reader("sim/models/circles/Circle.x.ts");
+  size_t iteration, first;
+  std::vector<double> values;
+  BOOST_CHECK(reader.nextChunk(&iteration, &first, &values));
+  BOOST_CHECK_EQUAL(iteration, (size_t)1);
+  FILE * f = fopen("sim/models/circles/1.xml", "r");
+  BOOST_CHECK(f != NULL);
+  if (f) fclose(f);
+
+  const char * vars[] = {"id", "x", "y", "fx", "fy", "radius"};
+  for (size_t ii = 0; ii < 6; ++ii)
+    remove((std::string("sim/models/circles/Circle.") + vars[ii] +
+        ".ts").c_str());
+  if (remove("sim/models/circles/1.xml") != 0)
+    fprintf(stderr, "Warning: Could not delete the generated file: %s\n",
+        "sim/models/circles/1.xml");
+
+  flame::mem::MemoryManager::GetInstance().Reset();
+  flame::exe::TaskManager::GetInstance().Reset();
+  flame::mb::MessageBoardManager::GetInstance().Reset();
+}
+
 //! Check exception throwing of unvalidated model being added to a simulation
 BOOST_AUTO_TEST_CASE(unvalidated_model) {
   // unvalidated model
@@ -0,0 +1,39 @@
+/*!
+ * \file xparser2/gen_execution_plan.cpp
+ * \author Simon Coakley
+ * \date January 2013
+ * \copyright Copyright (c) 2013 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2013 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Generator for the compiled execution plan of a model
+ */
+#include <string>
+#include <sstream>
+#include "gen_execution_plan.hpp"
+
+namespace xparser { namespace codegen {
+
+GenExecutionPlan::GenExecutionPlan(const flame::model::ExecutionPlan& plan) {
+  std::ostringstream out;
+  plan.write(&out);
+  plan_ = out.str();
+}
+
+void GenExecutionPlan::Generate(Printer* printer) const {
+  std::istringstream lines(plan_);
+  std::string line;
+
+  printer->Print("// Execution plan compiled from the model graph\n");
+  printer->Print("static const char execution_plan[] =\n");
+  printer->Indent();
+  printer->Indent();
+  // Plans only hold names, numbers and spaces so need no escaping
+  while (std::getline(lines, line)) {
+    printer->Print("\"$LINE$\\n\"\n", "LINE", line);
+  }
+  printer->Print(";\n");
+  printer->Outdent();
+  printer->Outdent();
+}
+
+}}  // namespace xparser::codegen
@@ -0,0 +1,34 @@
+/*!
+ * \file xparser2/gen_execution_plan.hpp
+ * \author Simon Coakley
+ * \date January 2013
+ * \copyright Copyright (c) 2013 STFC Rutherford Appleton Laboratory
+ * \copyright Copyright (c) 2013 University of Sheffield
+ * \copyright GNU Lesser General Public License
+ * \brief Generator for the compiled execution plan of a model
+ */
+#ifndef XPARSER__CODEGEN__GEN_EXECUTION_PLAN_HPP_
+#define XPARSER__CODEGEN__GEN_EXECUTION_PLAN_HPP_
+#include <string>
+#include "flame2/model/execution_plan.hpp"
+#include "code_generator.hpp"
+
+namespace xparser { namespace codegen {
+
+/*! \brief Generates the execution plan of a model as a string constant
+ *
+ * The plan is compiled when the model is parsed so simulations can
+ * register their tasks without generating the model graph.
+ */
+class GenExecutionPlan : public CodeGenerator {
+  public:
+    explicit GenExecutionPlan(const flame::model::ExecutionPlan& plan);
+    //! Prints the generated code to the printer instance
+    void Generate(Printer* printer) const;
+
+  private:
+    std::string plan_;  //! written plan
+};
+
+}}  // namespace xparser::codegen
+#endif  // XPARSER__CODEGEN__GEN_EXECUTION_PLAN_HPP_
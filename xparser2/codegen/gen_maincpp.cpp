@@ -18,11 +18,16 @@ GenMainCpp::GenMainCpp() {
   // System headers used
   RequireSysHeader("ctime");
   RequireSysHeader("cstdio");
+  RequireSysHeader("cstdlib");
   RequireSysHeader("string");
   RequireSysHeader("iostream");
+  RequireSysHeader("sstream");
+  RequireSysHeader("sys/resource.h");
   // flame headers
   RequireHeader("flame2/sim/simulation.hpp");  // used in main_footer.cpp.tmpl
   RequireHeader("flame2/exceptions/io.hpp");
+  RequireHeader("flame2/exceptions/model.hpp");
+  RequireHeader("flame2/model/execution_plan.hpp");
 }
 
 void GenMainCpp::Generate(Printer* printer) const {
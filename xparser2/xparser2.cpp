@@ -16,6 +16,7 @@
  *      - message send/recv
  *    - register messages
  *    - registed datatypes
+ *    - execution plan compiled from the model graph
  * 2. message_datatypes.hpp
  * 3. Makefile
  * 4. data.xsd (TODO)
@@ -37,6 +38,7 @@
 #include "codegen/gen_agent.hpp"
 #include "codegen/gen_agentfunc.hpp"
 #include "codegen/gen_message_registration.hpp"
+#include "codegen/gen_execution_plan.hpp"
 #include "utils.hpp"
 #include "file_generator.hpp"
 
@@ -114,6 +116,11 @@ void build_output(m::XModel* model) {
   generate_messages(model, &maincpp, "message_datatypes.hpp");
   makefile.AddHeaderFile("message_datatypes.hpp");
 
+  // Compile the model graph into an execution plan
+  m::ExecutionPlan plan;
+  model->compileExecutionPlan(&plan);
+  maincpp.Insert(gen::GenExecutionPlan(plan));
+
   // Umbrella header file which all model function files should include
   static const char* common_header_name = "flame_api.hpp";
   gen::GenHeaderFile common_header;  // flame_model.hpp generator